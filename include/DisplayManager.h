@@ -41,6 +41,7 @@ struct PlaybackInfo {
     uint8_t timeSignatureDen;
     bool isPlaying;
     bool isPaused;
+    int8_t shuttle;          // -1 = scrubbing back, +1 = scrubbing forward, 0 = not shuttling
     uint16_t channelMutes;   // Bitmask for 16 channels
     PlaybackMenuOption selectedOption;
     bool optionActive;       // Whether the option is being edited
@@ -52,6 +53,37 @@ struct PlaybackInfo {
     uint16_t sysexCount;     // Number of SysEx messages (for MT-32 indication)
 };
 
+struct SdDiagnosticsInfo {
+    const char* cardName;    // Product name from the card's CID
+    uint32_t readCount;      // Buffer refills timed so far
+    uint32_t p50Micros;      // Median read latency
+    uint32_t p99Micros;      // 99th percentile read latency
+    uint32_t maxMicros;      // Slowest read seen
+    uint16_t prefetchBytes;  // Lookahead each track keeps buffered
+    bool marginal;           // Latency too high for reliable playback
+    uint32_t readErrors;     // Failed seeks/reads (each retry counts)
+    uint32_t clockHz;        // SPI clock the card runs at
+    uint32_t benchBytesPerSec; // Raw read throughput measured at boot
+    uint32_t midiDropped;    // UI (Core 0) MIDI messages dropped for lack of queue room
+    uint8_t page;            // 0 = latency, 1 = bus and MIDI queue
+};
+
+enum SysExSendState {
+    SYSEX_SEND_READY,        // File open, waiting for PLAY
+    SYSEX_SEND_RUNNING,
+    SYSEX_SEND_DONE
+};
+
+struct SysExSendInfo {
+    const char* filename;
+    SysExSendState state;
+    uint32_t bytesDone;      // File bytes sent (or skipped between messages)
+    uint32_t totalBytes;
+    uint32_t bytesPerSec;    // Average since the send started, gaps included
+    uint32_t seconds;        // Running: time left at that rate; done: time taken
+    uint8_t gapMs;           // Pause after each message
+};
+
 class DisplayManager {
 public:
     DisplayManager();
@@ -63,7 +95,7 @@ public:
     DisplayMode getMode() { return currentMode; }
 
     // File browser display
-    void showFileBrowser(FileBrowser* browser);
+    void showFileBrowser(FileBrowser* browser, bool auditioning);
 
     // Playback display
     void showPlayback(const PlaybackInfo& info);
@@ -77,20 +109,30 @@ public:
     void showChannelSettingsMenu(uint8_t selectedChannel, uint16_t channelMutes, uint16_t channelSolos, uint8_t* channelPrograms, uint8_t* channelPan, uint8_t* channelVolume, int8_t* channelTranspose, uint8_t* channelVelocity, uint8_t currentOption, bool optionActive);
 
     // Track Settings menu display
-    void showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTempo, uint8_t velocityScale, bool sysexEnabled, uint8_t currentOption, bool optionActive, bool bpmEditingWhole);
+    void showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTempo, uint8_t velocityScale, bool sysexEnabled, uint8_t currentOption, bool optionActive, bool bpmEditingWhole,
+                               uint8_t selectedScene, uint8_t definedScenes, int8_t activeScene,
+                               uint8_t selectedPart, uint8_t partState);
 
     // MIDI Settings menu display
     void showMidiSettingsMenu(bool thruEnabled, bool keyboardEnabled, uint8_t keyboardChannel, uint8_t keyboardVelocity, uint8_t currentOption, bool optionActive);
 
     // Clock Settings menu display
-    void showClockSettingsMenu(bool clockEnabled, bool optionActive);
+    void showClockSettingsMenu(bool clockEnabled, bool tapPhaseAlign, const char* launchText, uint32_t launchErrorMicros,
+                               uint8_t currentOption, bool optionActive);
 
     // Routing menu display
-    void showRoutingMenu(uint8_t selectedChannel, uint8_t* channelRouting, uint8_t currentOption, bool optionActive);
+    void showRoutingMenu(uint8_t selectedChannel, uint8_t* channelRouting, uint8_t currentOption, bool optionActive,
+                         const uint8_t* portLoad, uint8_t portCount, uint8_t saturatedPorts, uint8_t layerCount);
 
     // Visualizer display
     void showVisualizer(uint8_t* channelActivity, uint8_t* channelPeak);
 
+    // SD card read latency profile
+    void showDiagnostics(const SdDiagnosticsInfo& info);
+
+    // .syx transfer
+    void showSysExSend(const SysExSendInfo& info);
+
     // Utility displays
     void showMessage(const char* line1, const char* line2 = nullptr);
     void showError(const char* error);
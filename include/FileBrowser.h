@@ -7,6 +7,7 @@
 #define MAX_FILES 256
 #define MAX_PATH_LENGTH 128
 #define MAX_FILENAME_LENGTH 64
+#define SETLIST_UP_ENTRY ".."  // Last entry of a setlist listing, leads back to its folder
 
 struct FileEntry {
     char filename[MAX_FILENAME_LENGTH];
@@ -38,6 +39,17 @@ public:
     // File operations
     bool openFile(FatFile* file);
 
+    // Setlists (.set): a text file with one song per line, relative to the
+    // setlist's folder or absolute; blank lines and '#' comments are skipped.
+    // A setlist is listed and entered like a folder, and lists its songs in
+    // setlist order (missing ones left out), then SETLIST_UP_ENTRY.
+    bool isSetlist() { return setlistActive; }
+    uint16_t getSetlistSongCount() { return setlistActive ? fileCount - 1 : 0; }
+    bool isSetlistFile(const char* filename);
+
+    // SysEx dumps (.syx) are listed with the songs; they are sent, not played
+    bool isSysExFile(const char* filename);
+
 private:
     SdFat* sd;
     FileEntry files[MAX_FILES];
@@ -45,9 +57,11 @@ private:
     uint16_t currentIndex;
     char currentPath[MAX_PATH_LENGTH];
     char rootPath[MAX_PATH_LENGTH];
+    bool setlistActive;  // Listing is the setlist at currentPath
 
     void sortFiles();
     bool isMidiFile(const char* filename);
+    bool loadSetlist();
 };
 
 #endif // FILE_BROWSER_H
@@ -0,0 +1,26 @@
+#ifndef FILE_IDENTITY_H
+#define FILE_IDENTITY_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+
+// Content identity of a file, independent of its name and folder: the size
+// plus a CRC-32 of the first and last sector (the first one holds the MIDI
+// header). Cheap enough to compute on every load - two sector reads - and it
+// survives renames, moves and copies between cards.
+#define FILE_IDENTITY_SAMPLE_BYTES 512
+
+struct FileIdentity {
+    uint32_t size;   // File size in bytes
+    uint32_t hash;   // CRC-32 of the sampled sectors
+
+    bool operator==(const FileIdentity& other) const {
+        return size == other.size && hash == other.hash;
+    }
+    bool operator!=(const FileIdentity& other) const { return !(*this == other); }
+};
+
+// Leaves the file position undefined - seek before reading again
+bool computeFileIdentity(FatFile* file, FileIdentity& identity);
+
+#endif // FILE_IDENTITY_H
@@ -14,6 +14,19 @@ enum Button {
     BTN_PANIC       // GP18 - MIDI Panic button
 };
 
+// Edge direction for queued button events
+enum ButtonEdge {
+    EDGE_PRESS = 0,
+    EDGE_RELEASE
+};
+
+// One debounced button edge captured by the GPIO interrupt
+struct ButtonEvent {
+    Button button;
+    ButtonEdge edge;
+    uint64_t timestampMicros;  // Hardware timer (time_us_64) at the moment of the edge
+};
+
 class InputHandler {
 public:
     InputHandler();
@@ -22,24 +35,38 @@ public:
     Button readButtonWithRepeat();  // For held button acceleration
     bool isButtonHeld(Button btn);  // Check if a specific button is currently held
 
+    // Raw edge queue access (presses and releases, oldest first)
+    bool readEvent(ButtonEvent& event);
+
+    // Hardware timestamp of the press most recently returned by readButton()/readButtonWithRepeat()
+    // Use this instead of millis() when timing matters (tap tempo)
+    uint64_t getLastPressMicros() { return lastPressMicros; }
+
+    // Number of edges lost because the queue was full (should stay 0)
+    uint32_t getDroppedEventCount() { return droppedEvents; }
+
 private:
-    // Debouncing for individual buttons
-    unsigned long lastPlayTime;
-    unsigned long lastStopTime;
-    unsigned long lastLeftTime;
-    unsigned long lastRightTime;
-    unsigned long lastModeTime;
-    unsigned long lastOkTime;
-    unsigned long lastPanicTime;
-
-    // Button states for edge detection
-    bool lastPlayState;
-    bool lastStopState;
-    bool lastLeftState;
-    bool lastRightState;
-    bool lastModeState;
-    bool lastOkState;
-    bool lastPanicState;
+    static const uint8_t BUTTON_COUNT = 7;
+    static const uint8_t EVENT_QUEUE_SIZE = 32;  // Must be a power of 2
+
+    // GPIO edge interrupt (shared by all button pins)
+    static InputHandler* instance;
+    static void handleEdgeInterrupt();
+    void captureEdges();  // Scan pins and queue debounced edges (runs in interrupt context)
+
+    // Edge queue - single producer (interrupt) / single consumer (loop), both on Core 0
+    ButtonEvent eventQueue[EVENT_QUEUE_SIZE];
+    volatile uint8_t queueHead;  // Written by producer only
+    volatile uint8_t queueTail;  // Written by consumer only
+    volatile uint32_t droppedEvents;
+
+    // Debounce state (owned by captureEdges)
+    bool pressedState[BUTTON_COUNT];       // Debounced level (true = pressed)
+    uint64_t lastEdgeMicros[BUTTON_COUNT]; // Time of last accepted edge for bounce rejection
+
+    // Press lockout (owned by readButton)
+    uint64_t lastPressAcceptedMicros[BUTTON_COUNT];
+    uint64_t lastPressMicros;
 
     // Button hold and repeat state
     Button currentHeldButton;
@@ -49,6 +76,7 @@ private:
 
     // Timing constants
     static const uint16_t BUTTON_DEBOUNCE = 150;     // 150ms debounce for MX switches (prevent accidental double-press)
+    static const uint32_t BOUNCE_WINDOW_MICROS = 5000;  // Ignore contact bounce for 5ms after an accepted edge
     static const uint16_t HOLD_THRESHOLD = 250;      // 250ms before repeat starts
     static const uint16_t REPEAT_DELAY_INITIAL = 80;  // Initial repeat delay (ms)
     static const uint16_t REPEAT_DELAY_FAST = 30;     // Fast repeat delay (ms)
@@ -0,0 +1,32 @@
+#ifndef LENGTH_CACHE_H
+#define LENGTH_CACHE_H
+
+#include <stdint.h>
+#include "FileIdentity.h"
+
+// ============================================================================
+// FILE LENGTH CACHE FORMAT
+// Shared by the firmware (main.cpp) and the host-side prebuilder
+// (tools/cache_prebuilder) so both always read and write the same layout.
+//
+// Text file, one record per line:
+//   VERSION,<CACHE_VERSION>
+//   <size>,<hash>,<length_ticks>,<sysex_count>
+//
+// size and hash (8 hex digits) are the file's FileIdentity, so an entry
+// follows the song through renames and moves, and equal names in
+// different folders no longer share an entry.
+// ============================================================================
+
+#define MAX_CACHE_ENTRIES 500
+#define CACHE_DIR_PATH "/.cache"
+#define CACHE_FILE_PATH "/.cache/cache"
+#define CACHE_VERSION 4  // Increment this when cache format changes or calculation logic improves
+
+struct FileLengthCacheEntry {
+    FileIdentity identity;   // Content identity (size + sampled-sector hash)
+    uint32_t lengthTicks;
+    uint16_t sysexCount;     // Number of SysEx messages (for MT-32 detection)
+};
+
+#endif // LENGTH_CACHE_H
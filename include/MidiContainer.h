@@ -0,0 +1,89 @@
+#ifndef MIDI_CONTAINER_H
+#define MIDI_CONTAINER_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+
+// Containers a song can be stored in. The parser reads the Standard MIDI File
+// inside through MidiContainer, which maps SMF offsets onto the card:
+//   SMF  (.mid/.midi) - the file itself
+//   RMID (.rmi)       - RIFF wrapper; the SMF is the "data" chunk, read in place
+//   MLZ  (.mlz)       - LZ4 frame of the SMF in independent MLZ_BLOCK_SIZE blocks,
+//                       followed by a skippable frame indexing the blocks, so any
+//                       position is one block decode away (tools/mlz_pack writes these)
+enum MidiContainerType {
+    CONTAINER_NONE = 0,
+    CONTAINER_SMF,
+    CONTAINER_RMID,
+    CONTAINER_MLZ
+};
+
+#define MLZ_BLOCK_SIZE 512          // Uncompressed bytes per block (one track buffer)
+#define MLZ_CACHE_BLOCKS 4          // Decoded blocks kept - tracks read from different places
+#define MLZ_MAX_SMF_SIZE (1UL << 24)
+#define LZ4_FRAME_MAGIC 0x184D2204UL
+#define MLZ_INDEX_MAGIC 0x184D2A5DUL  // Skippable frame: uint32 offset per block, then the block count
+#define LZ4_BLOCK_UNCOMPRESSED 0x80000000UL  // Block size flag: stored as is
+
+// Decode one LZ4 block; returns the decoded size, or -1 on corrupt input
+int lz4DecodeBlock(const uint8_t* src, uint16_t srcSize, uint8_t* dst, uint16_t dstCapacity);
+
+class MidiContainer {
+public:
+    MidiContainer();
+
+    // Detect the container from the first bytes and position at the SMF start
+    bool open(FatFile* file);
+    void close();
+    MidiContainerType getType() { return type; }
+
+    // FatFile-style access to the SMF bytes (-1 = SD error or corrupt block)
+    int read(void* buffer, size_t count);
+    bool seekSet(uint32_t pos);
+    uint32_t curPosition() { return position; }
+    uint32_t fileSize() { return smfSize; }
+    int available() { return (position < smfSize) ? (int)(smfSize - position) : 0; }
+
+    // Bytes from pos that cost at most one block decode (a track refill reads no further)
+    uint32_t contiguousBytes(uint32_t pos) {
+        if (type != CONTAINER_MLZ) return (pos < smfSize) ? smfSize - pos : 0;
+        return MLZ_BLOCK_SIZE - (pos % MLZ_BLOCK_SIZE);
+    }
+
+    uint32_t getCardBytesRead() { return cardBytesRead; }  // Since open()
+    uint32_t getBlocksDecoded() { return blocksDecoded; }
+
+private:
+    FatFile* file;
+    MidiContainerType type;
+    uint32_t dataOffset;  // RMID: file offset of the SMF
+    uint32_t smfSize;
+    uint32_t position;
+    uint32_t cardBytesRead;
+
+    // MLZ
+    uint32_t blockCount;
+    uint32_t indexOffset;   // File offset of the first index entry
+    bool blockChecksums;    // Frame has a 4-byte checksum after every block (skipped)
+    struct CachedBlock {
+        uint32_t index;       // Block number (0xFFFFFFFF = empty slot)
+        uint32_t nextOffset;  // File offset of the following block header
+        uint32_t lastUse;
+        uint16_t size;
+        uint8_t data[MLZ_BLOCK_SIZE];
+    };
+    CachedBlock cache[MLZ_CACHE_BLOCKS];
+    uint32_t useCounter;
+    uint32_t blocksDecoded;
+    uint8_t scratch[MLZ_BLOCK_SIZE];  // Compressed block as read from the card
+
+    bool readAt(uint32_t offset, void* buffer, uint16_t count);
+    uint32_t readLE32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    bool openRmid();
+    bool openMlz();
+    const CachedBlock* loadBlock(uint32_t index);
+};
+
+#endif // MIDI_CONTAINER_H
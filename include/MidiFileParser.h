@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <SdFat.h>
+#include "SdHealth.h"
+#include "MidiContainer.h"
 
 // MIDI event types
 #define MIDI_NOTE_OFF 0x80
@@ -108,7 +110,7 @@ struct MidiEvent {
 };
 
 struct MidiFileInfo {
-    uint16_t format;         // 0=single track, 1=multi track, 2=multi song
+    uint16_t format;         // 0=single track, 1=multi track, 2=multi song (one track plays at a time)
     uint16_t numTracks;      // Number of tracks
     uint16_t ticksPerQuarter;// PPQN (Pulses Per Quarter Note)
     uint32_t tempo;          // Microseconds per quarter note
@@ -120,6 +122,12 @@ struct MidiFileInfo {
 // Per-track state with buffering
 #define TRACK_BUFFER_SIZE 512
 
+// SD read error handling
+#define SD_READ_RETRIES 4              // Attempts for a refill the track can't continue without
+#define SD_RETRY_BACKOFF_MICROS 250    // Wait before the second attempt, doubled for each further one
+#define SD_DEFER_BACKOFF_MICROS 2000   // A failed prefetch or deferred event is retried after this
+#define SD_READ_GIVE_UP_MS 2000        // A track still unreadable after this long is ended
+
 struct TrackState {
     uint32_t trackStartPos;  // Start position of track data in file
     uint32_t trackEndPos;    // End position of this track
@@ -135,6 +143,65 @@ struct TrackState {
     uint16_t bufferPos;      // Current position in buffer
     uint16_t bufferSize;     // How much valid data in buffer
     uint32_t bufferFilePos;  // File position of start of buffer
+
+    // Read error recovery
+    bool readFailed;         // A refill failed every retry - bytes read since are invalid
+    bool deferred;           // Next event could not be read, retry at retryAtMicros
+    uint32_t retryAtMicros;  // No prefetch or retry before this time
+    uint32_t deferredSinceMs;// When the track first stalled (0 = not stalled)
+
+    // Where nextEvent was read from (for checkpoints)
+    uint32_t eventStartPos;
+    uint32_t eventStartTick;
+    uint8_t eventStartStatus;
+};
+
+// Chase: the controller state a seek has to re-send so the song sounds as it
+// would have at the new position. Only values a song can't do without are kept.
+#define CHASE_CONTROLLER_COUNT 9
+#define CHASE_NONE 0xFF            // No value seen for this program/controller yet
+#define CHASE_BEND_NONE 0xFFFF
+extern const uint8_t CHASE_CONTROLLERS[CHASE_CONTROLLER_COUNT];  // Bank select first, in send order
+
+struct ChaseState {
+    uint8_t program[16];
+    uint8_t controller[16][CHASE_CONTROLLER_COUNT];  // Indexed like CHASE_CONTROLLERS
+    uint16_t pitchBend[16];                          // 14-bit raw value (data2 << 7 | data1)
+};
+
+// Checkpoints: parser state captured while events are read in order, so a
+// seek restarts from the nearest one instead of re-parsing from tick 0.
+// Spacing starts at CHECKPOINT_SPACING_QUARTERS and doubles whenever the
+// table fills (every other entry is dropped), so any song length fits.
+#define MAX_CHECKPOINTS 16
+#define CHECKPOINT_SPACING_QUARTERS 8
+
+struct ParserCheckpoint {
+    uint32_t tick;                       // Time of the next event readNextEvent() returns
+    uint32_t tempo;
+    uint8_t numerator;
+    uint8_t denominator;
+    uint16_t endedTracks;                // Bit n = track n has nothing left to read
+    uint32_t trackPosition[MAX_TRACKS];  // Start of each track's pending event
+    uint32_t trackTick[MAX_TRACKS];      // Track time before that event
+    uint8_t runningStatus[MAX_TRACKS];
+    ChaseState chase;                    // Controller state of everything before tick
+};
+
+// Setlists keep what open() and the metadata scans learn about a song in RAM,
+// so it reopens without reading the header, the length cache or the track
+// starts. Heads are the first bytes of every track, as the buffers held them.
+#define PRELOAD_HEAD_BYTES 256  // Per track, at most
+
+struct ParserPreload {
+    MidiFileInfo fileInfo;               // Header and initial tempo
+    uint32_t fileLengthTicks;
+    uint16_t sysexCount;
+    uint8_t numTracks;
+    uint32_t trackStartPos[MAX_TRACKS];
+    uint32_t trackLength[MAX_TRACKS];
+    uint16_t headSize[MAX_TRACKS];       // 0 = read from the card as usual
+    uint8_t* heads;                      // Track heads back to back (owned by the caller)
 };
 
 class MidiFileParser {
@@ -143,6 +210,7 @@ public:
     ~MidiFileParser();
 
     bool open(const char* filename, FatFile* file);
+    bool openPreloaded(FatFile* file, const ParserPreload& preload);  // No header or head reads
     void close();
     bool readNextEvent(MidiEvent& event);
     bool reset();  // Returns false if seek fails
@@ -151,6 +219,7 @@ public:
     uint32_t getTotalTicks();
     uint32_t getFileLengthTicks() { return fileLengthTicks; }
     bool isEndOfFile();
+    bool isWaitingForCard();  // No event available yet, but a track is waiting out an SD error
 
     // Update file length based on playback (track max time seen)
     void updateFileLengthFromPlayback(uint32_t ticks) {
@@ -172,8 +241,50 @@ public:
     // Scan for initial tempo (call after open, before cache check)
     void scanForInitialTempo();
 
+    // SD read latency profiling and lookahead
+    void setHealthMonitor(SdHealth* monitor) { healthMonitor = monitor; }
+    uint16_t getPrefetchThreshold() { return prefetchThreshold; }
+    bool prefetch();  // Refill one track running low on buffered bytes (call when idle, needs a monitor)
+
+    // Seeking: restore the latest checkpoint at or before tick (reset() if there
+    // is none). Returns the tick the parser now stands at, or -1 on an SD error.
+    int32_t seekToCheckpoint(uint32_t tick);
+    int32_t getCheckpointTick(uint32_t tick);  // Latest checkpoint at or before tick (-1 = none)
+    uint8_t getCheckpointCount() { return checkpointCount; }
+
+    // Format 2: every track is an independent song/pattern and only the
+    // selected one plays. Switching rewinds that track alone - from its
+    // buffered start when it is still there, so no SD read and no reload.
+    bool isMultiSequence() { return fileInfo.format == 2 && numTracks > 1; }
+    uint8_t getSequenceCount() { return isMultiSequence() ? numTracks : 1; }
+    uint8_t getActiveSequence() { return activeSequence; }
+    bool selectSequence(uint8_t index);  // False if not format 2, out of range or on an SD error
+    uint32_t getSequenceLengthTicks(uint8_t index);  // 0 until calculateFileLengthNow()
+    uint32_t getSequenceTempo(uint8_t index);        // First tempo of the sequence (us per quarter)
+
+    // Per-track (MTrk) mute: note messages of silenced tracks are stepped over
+    // while reading, without building a MidiEvent. Their delta times, controllers
+    // and meta events are still read, so timing, tempo and chase are unchanged.
+    void setSilencedTracks(uint16_t mask) { silencedTracks = mask; }  // Bit n = track n
+    uint16_t getSilencedTracks() { return silencedTracks; }
+    uint32_t getSkippedNoteCount() { return skippedNotes; }  // Since open()
+
+    // Chase state of every event returned before the one returned last
+    // (the caller's pending event has not been played yet)
+    const ChaseState& getChaseState();
+
+    // Preload capture: call right after a load, once the tempo and length are
+    // known. Format 2 files are not captured (their sequences need the scan).
+    uint16_t getPreloadHeadBytes();  // Size of the heads capturePreload() copies
+    bool capturePreload(ParserPreload& preload, uint8_t* heads);
+
+    // Container the SMF was read from, and card bytes fetched since open()
+    MidiContainerType getContainerType() { return container.getType(); }
+    uint32_t getCardBytesRead() { return container.getCardBytesRead(); }
+
 private:
     FatFile* midiFile;
+    MidiContainer container;  // SMF view of midiFile (RMID / MLZ unwrapped)
     MidiFileInfo fileInfo;
 
     // Multi-track support
@@ -182,6 +293,27 @@ private:
     bool allTracksEnded;
     uint32_t fileLengthTicks; // Total length of file in ticks
     uint16_t sysexCount;      // Number of SysEx messages found during scan
+    SdHealth* healthMonitor;  // Receives the latency of every buffer refill (optional)
+    uint16_t prefetchThreshold; // Tracks with fewer buffered bytes get topped up
+
+    // Format 2 sequences (filled by the metadata pass in calculateFileLength)
+    uint8_t activeSequence;
+    uint32_t sequenceLengthTicks[MAX_TRACKS];
+    uint32_t sequenceTempo[MAX_TRACKS];  // 0 = no tempo event, 120 BPM
+
+    // Per-track mute
+    uint16_t silencedTracks;  // Bit n = skip note messages of track n
+    uint32_t skippedNotes;
+
+    // Checkpoints and chase
+    ParserCheckpoint checkpoints[MAX_CHECKPOINTS];
+    uint8_t checkpointCount;
+    uint32_t checkpointSpacing;  // Ticks between checkpoints (0 = not set for this file yet)
+    ChaseState chase;
+    uint8_t unchasedType;        // Event returned last, folded into chase on the next read (0 = none)
+    uint8_t unchasedChannel;
+    uint8_t unchasedData1;
+    uint8_t unchasedData2;
 
     // Helper functions
     uint32_t readVariableLength();
@@ -191,7 +323,17 @@ private:
     uint8_t read8();
     bool readMidiHeader();
     bool initializeTracks();
+    void initTrack(uint8_t trackNum, uint32_t startPos, uint32_t length);
+    void primeTracks();  // Fill empty buffers and read the first event of every track
     bool readTrackEvent(uint8_t trackNum, MidiEvent& event);
+    bool parseTrackEvent(uint8_t trackNum, MidiEvent& event);
+    void retryDeferredTracks();
+    bool isBackingOff(const TrackState* track);
+    void captureCheckpoint(uint32_t tick);
+    bool restoreCheckpoint(const ParserCheckpoint& checkpoint);
+    void clearCheckpoints();
+    void clearChase();
+    void updateChase(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2);
 
     // Buffered reading for specific track
     uint8_t readTrackByte(uint8_t trackNum);
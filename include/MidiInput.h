@@ -3,7 +3,39 @@
 
 #include <Arduino.h>
 #include <MIDI.h>
+#include <pico/mutex.h>
 #include "MidiOutput.h"
+#include "MidiPlayer.h"
+
+#define MAX_REMOTE_MAPPINGS 32
+
+// Incoming message type that triggers a remote-control action
+enum RemoteTrigger {
+    REMOTE_TRIGGER_NOTE = 0,    // Note On (velocity > 0); matching Note Offs are swallowed
+    REMOTE_TRIGGER_CC,          // Control Change crossing 64 upwards (footswitch press)
+    REMOTE_TRIGGER_PROGRAM      // Program Change
+};
+
+// Player command performed when a mapping matches
+enum RemoteAction {
+    REMOTE_ACTION_NONE = 0,
+    REMOTE_ACTION_PLAY_PAUSE,   // Toggle play/pause (plays loaded song when stopped)
+    REMOTE_ACTION_STOP,
+    REMOTE_ACTION_NEXT,         // Next song (performed by Core 0 - needs the file browser)
+    REMOTE_ACTION_PREV,         // Previous song (performed by Core 0)
+    REMOTE_ACTION_MUTE,         // Toggle mute, param = channel 1-16
+    REMOTE_ACTION_TEMPO,        // Tempo nudge, param = signed step in tenth-percent (10 = 1.0%)
+    REMOTE_ACTION_SCENE         // Recall channel scene, param = scene 1-8
+};
+
+struct RemoteMapping {
+    uint8_t trigger;    // RemoteTrigger
+    uint8_t channel;    // 1-16, 0 = any channel
+    uint8_t number;     // Note, controller or program number
+    uint8_t action;     // RemoteAction
+    int16_t param;      // Action parameter (see RemoteAction)
+    bool latched;       // CC edge detection: true while controller value >= 64
+};
 
 class MidiInput {
 public:
@@ -32,6 +64,26 @@ public:
     }
     uint8_t getKeyboardVelocity() { return keyboardVelocity; }
 
+    // Remote control: mapped MIDI IN messages drive the player directly on Core 1
+    // Mapped messages are consumed (not passed to Thru/Keyboard)
+    void setRemoteTarget(MidiPlayer* targetPlayer, mutex_t* targetMutex);
+    void setRemoteEnabled(bool enabled) { remoteEnabled = enabled; }  // Off: mapped messages are swallowed, nothing happens
+    bool isRemoteEnabled() { return remoteEnabled; }
+    void clearRemoteMappings();
+    bool addRemoteMapping(uint8_t trigger, uint8_t channel, uint8_t number, uint8_t action, int16_t param);
+    uint8_t getRemoteMappingCount() { return remoteMappingCount; }
+
+    // Requests that must be completed on Core 0 (poll from loop())
+    int8_t takeSongStepRequest(uint32_t& requestMicros); // -1 = previous, +1 = next, 0 = none
+    bool takeTempoChanged();                            // True once after a remote tempo nudge
+    bool takeSceneChanged();                            // True once after a remote scene recall
+
+    // Control-to-action latency (message parsed -> command applied), microseconds
+    void recordRemoteLatency(uint32_t latencyMicros);
+    uint32_t getLastRemoteLatencyMicros() { return lastRemoteLatencyMicros; }
+    uint32_t getMaxRemoteLatencyMicros() { return maxRemoteLatencyMicros; }
+    uint32_t getRemoteCommandCount() { return remoteCommandCount; }
+
 private:
     MIDI_NAMESPACE::MidiInterface<MIDI_NAMESPACE::SerialMIDI<HardwareSerial>>* midiIn;
     MidiOutput* midiOut;
@@ -42,6 +94,23 @@ private:
     uint8_t keyboardChannel;    // Channel for keyboard mode (1-16)
     uint8_t keyboardVelocity;   // Velocity scale for keyboard mode (1-100, 50=default)
 
+    // Remote control
+    MidiPlayer* player;
+    mutex_t* playerMutex;
+    volatile bool remoteEnabled;            // Written by Core 0
+    RemoteMapping remoteMappings[MAX_REMOTE_MAPPINGS];
+    volatile uint8_t remoteMappingCount;
+    volatile int8_t pendingSongStep;        // Written by Core 1, cleared by Core 0
+    volatile uint32_t pendingSongStepMicros;
+    volatile bool tempoChanged;
+    volatile bool sceneChanged;
+    volatile uint32_t lastRemoteLatencyMicros;
+    volatile uint32_t maxRemoteLatencyMicros;
+    volatile uint32_t remoteCommandCount;
+
+    bool handleRemoteControl(midi::MidiType type, byte channel, byte data1, byte data2, uint32_t readMicros);
+    void applyRemoteAction(const RemoteMapping& mapping, uint32_t readMicros);
+
     // MIDI message handlers
     void handleNoteOn(byte channel, byte note, byte velocity);
     void handleNoteOff(byte channel, byte note, byte velocity);
@@ -4,31 +4,81 @@
 #include <Arduino.h>
 #include <MIDI.h>
 
+// Output ports: port 0 is the hardware UART (Serial1, DIN OUT),
+// ports 1.. are PIO state-machine UARTs on MIDI_OUT2_TX_PIN / MIDI_OUT3_TX_PIN
+#define MIDI_OUT_PORT_COUNT 3
+#define MIDI_PORT_TX_QUEUE_SIZE 256   // Bytes buffered per PIO port (must be a power of 2)
+#define MIDI_PORT_BYTES_PER_SEC 3125  // 31250 baud / 10 bits per byte
+#define MIDI_PORT_STATS_WINDOW_MS 1000
+#define MIDI_SUBMIT_QUEUE_SIZE 1024   // Bytes of Core 0 messages waiting for the writer (must be a power of 2)
+#define MIDI_FLUSH_TIMEOUT_MS 250     // Longest Core 0 waits for the writer to empty the queue
+
+// Channel routing value: 255 = original channel on port 0,
+// otherwise (port << 4) | channel (0-15). Values 0-15 are port 0, as before.
+#define MIDI_ROUTE_ORIGINAL 255
+#define MIDI_ROUTE_MAX ((MIDI_OUT_PORT_COUNT << 4) - 1)
+#define MIDI_ROUTE_ALL_MASK ((1ULL << (MIDI_OUT_PORT_COUNT * 16)) - 1)  // Every valid destination bit
+inline uint8_t midiRoute(uint8_t port, uint8_t channel) { return (uint8_t)((port << 4) | (channel & 0x0F)); }
+inline uint8_t midiRoutePort(uint8_t route) { return route >> 4; }
+inline uint8_t midiRouteChannel(uint8_t route) { return route & 0x0F; }
+
+struct MidiPortStats {
+    uint32_t bytesSent;           // Total bytes put on the wire since begin()
+    uint32_t bytesDropped;        // Bytes discarded because the TX queue was full
+    uint8_t utilizationPercent;   // Share of link bandwidth used over the last window
+    uint8_t peakUtilizationPercent;
+};
+
+// Core 1 is the only core that writes to the ports. Sends made on Core 1
+// (player, MIDI in/thru) go straight out; sends made on Core 0 (UI panic,
+// program/volume/pan, player calls under playerMutex) are copied whole into a
+// submission queue and written by Core 1 before its next message, so messages
+// never interleave on the wire and Core 0 never waits on a UART. A submitted
+// message waits in the queue while its PIO port is full instead of being dropped
+// there, and Core 1 keeps writing the queue while Core 0 holds playerMutex.
 class MidiOutput {
 public:
     MidiOutput();
     void begin();
 
-    // MIDI message sending
-    void sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity);
-    void sendNoteOff(uint8_t channel, uint8_t note, uint8_t velocity);
-    void sendControlChange(uint8_t channel, uint8_t cc, uint8_t value);
-    void sendProgramChange(uint8_t channel, uint8_t program);
-    void sendPitchBend(uint8_t channel, int16_t bend);
-    void sendAfterTouch(uint8_t channel, uint8_t pressure);
-    void sendPolyAfterTouch(uint8_t channel, uint8_t note, uint8_t pressure);
-    void sendSysEx(const uint8_t* data, uint16_t length);
-
-    // MIDI Clock and Transport messages
+    // Write messages submitted by Core 0, then move queued bytes from the PIO
+    // port queues into the state machines (non-blocking). Call frequently from Core 1.
+    void service();
+
+    // MIDI message sending (port = output port, 0 = main DIN OUT). Nothing is
+    // range-checked here, on the playback hot path: channel must be 1-16, data
+    // bytes 0-127 and bend -8192..8191. The player masks file data once per event
+    // at its sink boundary; MIDI IN data and UI values are in range by construction.
+    void sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port = 0);
+    void sendNoteOff(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port = 0);
+    void sendControlChange(uint8_t channel, uint8_t cc, uint8_t value, uint8_t port = 0);
+    void sendProgramChange(uint8_t channel, uint8_t program, uint8_t port = 0);
+    void sendPitchBend(uint8_t channel, int16_t bend, uint8_t port = 0);
+    void sendAfterTouch(uint8_t channel, uint8_t pressure, uint8_t port = 0);
+    void sendPolyAfterTouch(uint8_t channel, uint8_t note, uint8_t pressure, uint8_t port = 0);
+    void sendSysEx(const uint8_t* data, uint16_t length, uint8_t port = 0);
+
+    // MIDI Clock and Transport messages (sent on every port)
     void sendClock();      // 0xF8 - MIDI Clock tick (24 per quarter note)
     void sendStart();      // 0xFA - Start playback
     void sendContinue();   // 0xFB - Continue from pause
     void sendStop();       // 0xFC - Stop playback
 
-    // Utility functions
+    // Utility functions (all ports)
     void allNotesOff();
+    void allSoundOff();  // All Notes Off + All Sound Off (the PANIC button)
     void panic();
 
+    // Per-port statistics
+    MidiPortStats getPortStats(uint8_t port);
+
+    // Bytes Core 0 can still submit before sends are dropped; a SysEx of
+    // n bytes takes n + 4. Lets a long transfer wait for the writer instead.
+    uint16_t getSubmitRoom() {
+        return MIDI_SUBMIT_QUEUE_SIZE - 1 - ((submitHead - submitTail) & (MIDI_SUBMIT_QUEUE_SIZE - 1));
+    }
+    uint32_t getSubmitDropped() { return submitDropped; }  // Core 0 messages the queue had no room for
+
     // Visualizer support
     void setNoteOnCallback(void (*callback)(uint8_t channel, uint8_t note, uint8_t velocity));
     void setNoteOffCallback(void (*callback)(uint8_t channel, uint8_t note));
@@ -39,6 +89,50 @@ private:
     void (*noteOnCallback)(uint8_t channel, uint8_t note, uint8_t velocity);
     void (*noteOffCallback)(uint8_t channel, uint8_t note);
     void (*controlChangeCallback)(uint8_t channel, uint8_t cc, uint8_t value);
+
+    // PIO port state (index 0 = port 1)
+    struct PioPort {
+        SerialPIO* serial;
+        uint8_t queue[MIDI_PORT_TX_QUEUE_SIZE];
+        uint16_t head;           // Next write position
+        uint16_t tail;           // Next byte to transmit
+        uint8_t runningStatus;   // Last channel status byte queued (0 = none)
+    };
+    PioPort pioPorts[MIDI_OUT_PORT_COUNT - 1];
+    spin_lock_t* portLock;   // Guards stats (read by Core 0)
+
+    // Core 0 submission queue - single producer (Core 0 loop) / single consumer (Core 1).
+    // Records are [port, status, data...]; SysEx has a 16-bit length after the status.
+    uint8_t submitQueue[MIDI_SUBMIT_QUEUE_SIZE];
+    volatile uint16_t submitHead;  // Written by Core 0 only
+    volatile uint16_t submitTail;  // Written by Core 1 only
+    volatile uint32_t submitDropped;  // Written by Core 0 only
+    uint8_t submitStaging[MIDI_SUBMIT_QUEUE_SIZE];  // A SysEx record that wraps, made whole for the writers (Core 1)
+
+    // Utilization accounting
+    MidiPortStats stats[MIDI_OUT_PORT_COUNT];
+    uint32_t windowBytes[MIDI_OUT_PORT_COUNT];
+    unsigned long windowStartMs;
+
+    // Every send goes through post*: queued when called on Core 0, written on Core 1
+    void postChannelMessage(uint8_t port, uint8_t status, uint8_t data1, uint8_t data2);
+    void postSysEx(const uint8_t* data, uint16_t length, uint8_t port);
+    void postRealTime(uint8_t status);
+    bool submit(uint8_t port, const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint16_t length);
+    void drainSubmissions();
+    void countDropped(uint8_t port, uint32_t messages, uint32_t bytes);
+
+    // Wire writers (Core 1 only)
+    void writeChannelMessage(uint8_t port, uint8_t status, uint8_t data1, uint8_t data2);
+    void writeSysEx(const uint8_t* data, uint16_t length, uint8_t port);
+    void writeRealTime(uint8_t status);
+    void sendChannelMessage(uint8_t port, uint8_t status, uint8_t data1, uint8_t data2, uint8_t length);
+    void pumpPorts();              // Feed the PIO state machines from the port queues
+    uint16_t portRoom(uint8_t port);  // Bytes a PIO port queue can still take
+    bool flushPort(uint8_t port);  // Busy-wait until a port's queue is empty (false: Core 0 gave up)
+    bool queueBytes(uint8_t port, const uint8_t* data, uint16_t length, uint8_t newRunningStatus, bool useRunningStatus);
+    void countBytes(uint8_t port, uint32_t bytes);
+    void updateUtilization();
 };
 
 #endif // MIDI_OUTPUT_H
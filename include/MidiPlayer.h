@@ -6,19 +6,95 @@
 #include "MidiOutput.h"
 #include <SdFat.h>
 
+#define MAX_SCENES 8
+
+// Snapshot of every per-channel setting, recalled as one unit
+struct ChannelScene {
+    uint16_t mutes;           // Effective mute bitmask (solo already applied)
+    uint16_t solos;           // Solo bitmask (UI state, restored with the scene)
+    uint8_t programs[16];     // 0-127, 128 = use MIDI file
+    uint8_t volumes[16];      // 0-127, 255 = use MIDI file
+    uint8_t pan[16];          // 0-127, 255 = use MIDI file
+    int8_t transpose[16];     // Semitones
+    uint8_t velocities[16];   // 0 = use MIDI file, 1-200
+    uint8_t routing[16];      // 255 = original, else (port << 4) | channel
+    uint64_t layers[16];      // Extra destinations
+};
+
+// What update() does with events that are already late when it reaches them
+// (after an SD stall, a long SysEx or a held mutex)
+enum CatchUpPolicy {
+    CATCHUP_SEND_ALL = 0,   // Send the whole backlog at once
+    CATCHUP_DROP_STALE,     // Drop late continuous controller data, keep notes and state changes
+    CATCHUP_COLLAPSE,       // Send only the last value of each late controller
+    CATCHUP_STRETCH,        // Restart the song clock at the backlog and win the time back gradually
+    CATCHUP_POLICY_COUNT
+};
+
+struct CatchUpStats {
+    uint32_t stallCount;       // Times playback fell more than the stale limit behind
+    uint32_t budgetBreaks;     // Times update() ran out of its time budget with events still due
+    uint32_t lastLagMicros;    // How far behind the most recent stall started
+    uint32_t maxLagMicros;     // Worst lateness seen
+    uint32_t droppedEvents;    // Late events discarded
+    uint32_t collapsedEvents;  // Late controller values replaced by a later one
+    uint64_t stretchedMicros;  // Backlog re-timed instead of sent as a burst (64-bit: the total can pass 71 minutes)
+};
+
+// Transport requests queued by Core 0 and carried out by update() on Core 1
+enum TransportCommand {
+    TRANSPORT_NONE = 0,
+    TRANSPORT_PLAY,
+    TRANSPORT_PAUSE,
+    TRANSPORT_STOP,
+    TRANSPORT_SKIP,         // Relative seek, param = milliseconds (negative = rewind)
+    TRANSPORT_SHUTTLE_START,// Silence and hold playback while skips move the position
+    TRANSPORT_SHUTTLE_END   // Chase controller state and resume if it was playing
+};
+
+// Quantized song change: where a queued launch switches to the next song
+enum LaunchQuantize {
+    LAUNCH_NOW = 0,   // No launch - PREV/NEXT stop and load at once
+    LAUNCH_BEAT,      // Next quarter note
+    LAUNCH_BAR,       // Next bar of the current time signature
+    LAUNCH_QUANTIZE_COUNT
+};
+
+// A song prepared while another plays: everything the switch needs, so it
+// reads no settings and only the container header from the card. The caller
+// keeps the struct, the open file and the preloaded heads until the switch.
+struct SongLaunch {
+    FatFile* file;
+    ParserPreload preload;
+    ChannelScene channels;    // Applied like a scene recall (overrides sent to the new destinations)
+    uint16_t trackMutes;
+    uint16_t trackSolos;
+    uint8_t velocityScale;
+    bool sysexEnabled;
+    uint16_t tempoPercent;
+};
+
 enum PlayerState {
     STATE_STOPPED,
     STATE_PLAYING,
     STATE_PAUSED
 };
 
-class MidiPlayer {
+// The player is a template on its output sink, so every send is a direct,
+// inlinable call - no virtual dispatch. Production uses MidiOutput (the
+// MidiPlayer typedef below); MidiSinks.h has counting/recording sinks for
+// benchmarks. A sink provides the MidiOutput send* methods the player calls.
+// Instantiations are explicit, at the end of MidiPlayer.cpp.
+template <class Sink>
+class MidiPlayerT {
 public:
-    MidiPlayer(MidiOutput* output);
-    ~MidiPlayer();
+    MidiPlayerT(Sink* output);
+    ~MidiPlayerT();
 
     // File operations
     bool loadFile(FatFile* file);
+    bool loadPreloaded(FatFile* file, const ParserPreload& preload);  // Setlist song kept in RAM
+    bool loadPreview(FatFile* file);  // Audition: played as loaded, with no length or tempo scan
     void unloadFile();
 
     // Playback control
@@ -27,13 +103,37 @@ public:
     void stop(bool resetToBeginning = true);
     void update(); // Call this frequently in main loop
 
-    // Navigation
+    // Queued transport: returns at once, update() applies it on its next pass.
+    // Play/pause/stop replace each other (last press wins); skips add up.
+    void requestTransport(TransportCommand command, int32_t param = 0);
+    bool isTransportPending() { return pendingTransport != TRANSPORT_NONE || pendingSkipMs != 0; }
+    uint32_t getLastTransportLatencyMicros() { return lastTransportLatencyMicros; } // Request -> applied
+    uint32_t getMaxTransportLatencyMicros() { return maxTransportLatencyMicros; }
+
+    // Navigation (seeks restart from the parser's nearest checkpoint and chase
+    // programs/controllers when playback resumes)
     void fastForward(uint32_t milliseconds);
     void rewind(uint32_t milliseconds);
     void seek(uint32_t milliseconds);
+    bool isShuttling() { return shuttling; }
+
+    // Quantized launch: keep playing and switch to the prepared song at the next
+    // beat or bar. The old song plays up to the boundary, the new one starts at
+    // it (MIDI Start in place of that clock pulse). Stop, pause and seeks cancel it.
+    bool queueLaunch(const SongLaunch* launch, LaunchQuantize quantize);
+    void cancelLaunch() { pendingLaunch = nullptr; }
+    bool isLaunchPending() { return pendingLaunch != nullptr; }
+    bool takeLaunched(); // True once after a switch (stopped if the new song failed to open)
+    uint32_t getLastLaunchErrorMicros() { return lastLaunchErrorMicros; } // Boundary -> new song running
+    uint32_t getMaxLaunchErrorMicros() { return maxLaunchErrorMicros; }
+
+    // Format 2 files: switch to another sequence (track), from its start.
+    // Keeps playing if it was playing; only that track's buffer is touched.
+    bool selectSequence(uint8_t index);
 
     // Tempo control
-    void setTempoPercent(uint16_t percent); // 50-200%
+    void setTempoPercent(uint16_t percent); // 500-2000 = 50.0-200.0% (tenths of a percent)
+    void alignBeatPhase(uint64_t beatMicros); // Nudge playback so a beat falls at this time_us_64() instant
     uint16_t getTempoPercent() { return tempoPercent; }
     uint16_t getCurrentBPM();
 
@@ -48,25 +148,53 @@ public:
     bool isChannelMuted(uint8_t channel);
     uint16_t getChannelMutes() { return channelMutes; }
 
+    // Track (MTrk) mute/solo, for parts that share a channel. The parser skips
+    // the silenced tracks' notes; any solo silences every other track.
+    void setTrackMutes(uint16_t mutes); // Bit n = track n
+    void setTrackSolos(uint16_t solos);
+    uint16_t getTrackMutes() { return trackMutes; }
+    uint16_t getTrackSolos() { return trackSolos; }
+
     // Program change override (auto-detects based on non-zero programs)
-    void setChannelPrograms(uint8_t* programs); // Set user's program settings for auto-override
+    void setChannelPrograms(const uint8_t* programs); // Set user's program settings for auto-override
 
     // Volume and Pan overrides
-    void setChannelVolumes(uint8_t* volumes); // Set user's volume settings (0-127, 255 = use MIDI file)
-    void setChannelPan(uint8_t* pan); // Set user's pan settings (0-127, 255 = use MIDI file)
+    void setChannelVolumes(const uint8_t* volumes); // Set user's volume settings (0-127, 255 = use MIDI file)
+    void setChannelPan(const uint8_t* pan); // Set user's pan settings (0-127, 255 = use MIDI file)
 
     // Transpose override
-    void setChannelTranspose(int8_t* transpose); // Set user's transpose settings in semitones (-24 to +24)
+    void setChannelTranspose(const int8_t* transpose); // Set user's transpose settings in semitones (-24 to +24)
 
     // Per-channel velocity scale override
-    void setChannelVelocityScales(uint8_t* velocities); // Set user's velocity scale settings (0 = use MIDI file, 1-200, 100 = normal)
+    void setChannelVelocityScales(const uint8_t* velocities); // Set user's velocity scale settings (0 = use MIDI file, 1-200, 100 = normal)
 
     // Routing override
-    void setChannelRouting(uint8_t* routing); // Set user's routing settings (255 = use original, 0-15 = route to that channel)
+    void setChannelRouting(uint8_t* routing); // Set user's routing settings (255 = use original, else (port << 4) | channel, see MidiOutput.h)
+
+    // Fan-out layering: extra destinations per channel on top of routing
+    void setChannelLayers(const uint64_t* layers); // Bit (port << 4) | channel set = also send there
+    uint8_t getProjectedPortLoad(uint8_t port); // Demand in % of link bandwidth at current fan-out (can exceed 100)
+    bool isPortSaturating(uint8_t port); // True if the port's projected demand is near or above capacity
+
+    // Scenes: switch every channel setting at once, sending only what differs
+    bool storeScene(uint8_t index, const ChannelScene& scene);
+    bool getScene(uint8_t index, ChannelScene& scene);
+    bool recallScene(uint8_t index); // False if the scene is empty
+    void clearScenes();
+    uint8_t getDefinedScenes() { return sceneDefinedMask; } // Bit n = scene n stored
+    int8_t getActiveScene() { return activeScene; }         // -1 = none recalled
+
+    // Overload handling
+    void setCatchUpPolicy(CatchUpPolicy policy);
+    CatchUpPolicy getCatchUpPolicy() { return catchUpPolicy; }
+    CatchUpStats getCatchUpStats() { return catchUpStats; }
+    void resetCatchUpStats();
 
     // Status getters
     PlayerState getState() { return state; }
+    bool isLoaded() { return midiFile != nullptr; }
     uint32_t getCurrentTimeMs();
+    uint32_t getPositionTicks() { return ticksElapsed; }
     uint32_t getTotalTimeMs();
     MidiFileInfo getFileInfo() { return parser.getFileInfo(); }
     bool hasReachedEnd() { return reachedEnd; } // True if file ended naturally
@@ -75,6 +203,7 @@ public:
     // MIDI Clock and Transport
     void setClockEnabled(bool enabled) { clockEnabled = enabled; }
     bool getClockEnabled() { return clockEnabled; }
+    uint64_t getClockPulsesSent() { return clockPulsesSent; } // Since song position 0
 
     // SysEx Control
     void setSysexEnabled(bool enabled) { sysexEnabled = enabled; }
@@ -83,27 +212,108 @@ public:
     // MIDI Device Control
     void resetMidiDevice(); // Comprehensive MIDI reset for song changes
 
+    // Send one event through mutes, overrides and routing right now, ignoring
+    // its timestamp (dispatch benchmarks; playback goes through update())
+    void dispatch(const MidiEvent& event) { sendMidiEvent(event); }
+
+    // Program/volume/pan overrides as messages, through routing and layers
+    // (an offline render starts with them; live, the UI sends them on load and
+    // the next play() waits until they are on the wire)
+    void sendOverrideSetup();
+    void releaseHeldNotes();  // Note Off for each note still sounding, to every copy it went to
+
 private:
-    MidiOutput* midiOut;
+    Sink* midiOut;
     MidiFileParser parser;
     FatFile* midiFile;  // Pointer to avoid duplicating file handles
     PlayerState state;
 
     // Timing
-    uint32_t ticksElapsed;
-    uint32_t lastUpdateMicros;
-    uint32_t microsecondsPerTick;
-    uint16_t tempoPercent; // 100 = normal speed
+    // Wall time comes from the RP2040 64-bit hardware timer (time_us_64), which never wraps in practice.
+    // Ticks are derived with an exact rational rate so no rounding error accumulates:
+    //   ticks = microseconds * tickRateScale / tickPeriodScaled
+    // The sub-tick remainder is carried in tickAccumulator between updates.
+    uint32_t ticksElapsed;     // 32-bit like event times: 5 days at 960 PPQ, 300 BPM and 200% tempo
+    uint64_t lastUpdateMicros;
+    uint64_t tickAccumulator;  // Fractional tick carried between updates (units: microseconds * tickRateScale)
+    uint64_t tickRateScale;    // tempoPercent * ticksPerQuarter
+    uint64_t tickPeriodScaled; // Tempo (microseconds per quarter note) * 1000
+    uint16_t ticksPerQuarter;  // Cached from file header (avoids copying MidiFileInfo in update())
+    uint16_t tempoPercent; // Tenths of a percent, 1000 = normal speed
+    int64_t pendingPhaseMicros; // Phase correction still to apply (positive = advance song clock)
+    int64_t stretchDebtMicros;  // STRETCH lag still to win back (kept apart from tap phase)
+    uint64_t wireIdleMicros;    // When cleanup messages queued so far will have left the ports
+
+    // Queued transport
+    TransportCommand pendingTransport;
+    int32_t pendingSkipMs;
+    uint64_t transportRequestMicros; // Time of the oldest request not yet applied
+    uint32_t lastTransportLatencyMicros;
+    uint32_t maxTransportLatencyMicros;
+
+    // Shuttle and chase
+    bool shuttling;           // Between SHUTTLE_START and SHUTTLE_END
+    bool shuttleResume;       // Was playing when the shuttle started
+    bool chasePending;        // Position moved - send the chase state before the next note
+    bool preloadedStart;      // Parser and nextEvent stand at tick 0 as loadPreloaded()/loadPreview() left them
+
+    // Quantized launch
+    const SongLaunch* pendingLaunch; // Switch to this at launchTicks (nullptr = none)
+    uint32_t launchTicks;
+    uint32_t meterOriginTicks;       // Last time signature change - bars count from here
+    bool launched;                   // Switch done, not yet taken by Core 0
+    uint32_t lastLaunchErrorMicros;
+    uint32_t maxLaunchErrorMicros;
 
     // Channel control
     uint16_t channelMutes; // Bitmask for 16 channels
+    uint16_t trackMutes;   // Bitmask for 16 tracks
+    uint16_t trackSolos;
     uint8_t velocityScale; // 1-100, where 50 = default, 100 = max velocity
     uint8_t channelVelocities[16]; // Per-channel velocity 0-200% (100 = normal)
     uint8_t userChannelPrograms[16]; // User's program settings: 0-127 = override MIDI file, 128 = use MIDI file
     uint8_t userChannelVolumes[16]; // User's volume settings: 0-127 = override MIDI file, 255 = use MIDI file
     uint8_t userChannelPan[16]; // User's pan settings: 0-127 = override MIDI file, 255 = use MIDI file
     int8_t userChannelTranspose[16]; // User's transpose settings in semitones: -24 to +24
-    uint8_t userChannelRouting[16]; // User's routing settings: 255 = use original channel, 0-15 = route to that channel
+    uint8_t userChannelRouting[16]; // User's routing settings: 255 = use original channel, else (port << 4) | channel
+    uint64_t userChannelLayers[16]; // User's extra destinations: bit (port << 4) | channel
+
+    // Fan-out (rebuilt by rebuildDestinations() whenever routing or layers change)
+    uint64_t channelDestMask[16];   // All destinations for each source channel
+
+    // Note tracking so every copy of a note gets its Note Off
+    uint32_t heldNotes[16][4];        // Bitset of sounding source notes per channel
+    uint8_t heldNoteOutput[16][128];  // Note number actually sent (after transpose)
+    uint8_t heldNoteTrack[16][128];   // Track that played it (released when the track is silenced)
+    uint64_t heldDestMask[16];        // Destinations that received Note Ons still sounding
+    uint64_t controlledDestMask;      // Destinations the song moved controllers or bend on
+
+    // Bandwidth accounting (source bytes per channel, projected through the fan-out)
+    uint32_t channelBytesWindow[16];
+    uint16_t channelByteRate[16];     // Bytes/second over the last window
+    uint64_t loadWindowStartMicros;
+    uint8_t projectedPortLoad[MIDI_OUT_PORT_COUNT];
+
+    // Scenes
+    ChannelScene scenes[MAX_SCENES];
+    uint8_t sceneDefinedMask;
+    int8_t activeScene;
+
+    // Overload handling
+    CatchUpPolicy catchUpPolicy;
+    CatchUpStats catchUpStats;
+    uint32_t staleTicks;      // Lateness (in ticks) beyond which an event counts as stale
+    bool fallingBehind;       // Inside a stall (counted once per stall)
+    uint32_t prefetchIdleTicks; // Gap before the next event long enough to prefetch in
+
+    // COLLAPSE: latest late controller values, sent before the channel's next other event
+    uint16_t collapsedChannels;              // Channels with values waiting
+    uint32_t collapsedControllers[16][4];    // Bitset of waiting controller numbers
+    uint8_t collapsedControllerValue[16][128];
+    uint16_t collapsedBendMask;
+    uint16_t collapsedBend[16];              // 14-bit raw value (data2 << 7 | data1)
+    uint16_t collapsedPressureMask;
+    uint8_t collapsedPressure[16];
 
     // Event queue for timing
     MidiEvent nextEvent;
@@ -112,18 +322,47 @@ private:
 
     // MIDI Clock and Transport
     bool clockEnabled;
-    uint32_t lastClockMicros;
+    uint64_t clockPulsesSent; // Clock pulses since song position 0 (phase-locked to ticksElapsed)
     PlayerState lastTransportState; // Track state changes for transport messages
 
     // SysEx Control
     bool sysexEnabled; // True = send SysEx messages, False = filter them out
 
     // Helper functions
-    void calculateMicrosecondsPerTick();
+    void beginLoad(FatFile* file);  // Playback state every load starts from
+    void calculateTickRate();
+    void resyncClock();
     void sendMidiEvent(const MidiEvent& event);
     void stopAllNotes();
+    void reserveWireTime(uint32_t bytesPerPort);
+    void resumeAfterCleanup();
+    void serviceTransport();
+    void moveTo(uint32_t targetTicks);       // Seek with silence/resume around it
+    bool seekToTicks(uint32_t targetTicks);  // Reposition the parser (false on SD error)
+    void sendChase();
+    void launchSong(uint64_t boundaryMicros);
+    void applyChannelScene(const ChannelScene& scene);
+    void rebuildDestinations();
+    bool isNoteHeld(uint8_t channel, uint8_t note);
+    void clearHeldNote(uint8_t channel, uint8_t note);
+    void releaseHeldNote(uint8_t channel, uint8_t note);
+    void applyTrackSilence();
+    void resetSongControllers();  // CC 121 + centred bend where the song moved them (launch)
+    void clearNoteTracking();
+    void updateProjectedLoad();
+    void updateBandwidthWindow(uint64_t nowMicros);
+    bool isCatchUpDroppable(const MidiEvent& event);
+    void collapseLateEvent(const MidiEvent& event);
+    void flushCollapsed(uint8_t channel);
+    void flushAllCollapsed();
+    void clearCollapsed();
+    void sendToDestinations(uint64_t destinations, uint8_t type, uint8_t data1, uint8_t data2);
+    uint64_t ticksToMicroseconds(uint32_t ticks);
     uint32_t ticksToMilliseconds(uint32_t ticks);
     uint32_t millisecondsToTicks(uint32_t ms);
 };
 
+typedef MidiPlayerT<MidiOutput> MidiPlayer;
+extern template class MidiPlayerT<MidiOutput>;
+
 #endif // MIDI_PLAYER_H
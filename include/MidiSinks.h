@@ -0,0 +1,111 @@
+#ifndef MIDI_SINKS_H
+#define MIDI_SINKS_H
+
+#include <Arduino.h>
+
+// Output sinks for MidiPlayerT other than the real MidiOutput. They take the
+// same send* calls but never touch the hardware, so the player can be timed
+// or checked in isolation. Build with -DMIDI_DISPATCH_BENCHMARK=1 to
+// instantiate the player on CountingMidiSink and run the boot benchmark.
+#ifndef MIDI_DISPATCH_BENCHMARK
+#define MIDI_DISPATCH_BENCHMARK 0
+#endif
+
+// Counts messages and wire bytes per port - cheapest possible sink, so a
+// benchmark measures the player's own per-event work
+class CountingMidiSink {
+public:
+    CountingMidiSink() { reset(); }
+
+    void reset() {
+        messages = 0;
+        noteOns = 0;
+        sysexBytes = 0;
+        for (uint8_t i = 0; i < 4; i++) portBytes[i] = 0;
+    }
+
+    void sendNoteOn(uint8_t, uint8_t, uint8_t, uint8_t port = 0) { noteOns++; count(port, 3); }
+    void sendNoteOff(uint8_t, uint8_t, uint8_t, uint8_t port = 0) { count(port, 3); }
+    void sendControlChange(uint8_t, uint8_t, uint8_t, uint8_t port = 0) { count(port, 3); }
+    void sendProgramChange(uint8_t, uint8_t, uint8_t port = 0) { count(port, 2); }
+    void sendPitchBend(uint8_t, int16_t, uint8_t port = 0) { count(port, 3); }
+    void sendAfterTouch(uint8_t, uint8_t, uint8_t port = 0) { count(port, 2); }
+    void sendPolyAfterTouch(uint8_t, uint8_t, uint8_t, uint8_t port = 0) { count(port, 3); }
+    void sendSysEx(const uint8_t*, uint16_t length, uint8_t port = 0) { sysexBytes += length; count(port, length + 2); }
+
+    void sendClock() { messages++; }
+    void sendStart() { messages++; }
+    void sendContinue() { messages++; }
+    void sendStop() { messages++; }
+
+    uint32_t messages;
+    uint32_t noteOns;
+    uint32_t sysexBytes;
+    uint32_t portBytes[4];
+
+private:
+    void count(uint8_t port, uint32_t bytes) {
+        messages++;
+        portBytes[port & 3] += bytes;
+    }
+};
+
+// Keeps the last RECORDING_SINK_SIZE channel messages in a ring, for
+// checking exactly what the player emitted (routing, overrides, order)
+#define RECORDING_SINK_SIZE 64
+
+struct RecordedMidiMessage {
+    uint8_t port;
+    uint8_t status;    // Type | (channel - 1), or the real-time byte
+    uint8_t data1;
+    uint8_t data2;
+};
+
+class RecordingMidiSink {
+public:
+    RecordingMidiSink() { clear(); }
+
+    void clear() { head = 0; total = 0; }
+    uint32_t getTotal() { return total; }
+    uint8_t getCount() { return total < RECORDING_SINK_SIZE ? total : RECORDING_SINK_SIZE; }
+
+    // Oldest first: 0 .. getCount() - 1
+    const RecordedMidiMessage& get(uint8_t index) {
+        uint8_t start = total < RECORDING_SINK_SIZE ? 0 : head;
+        return ring[(start + index) % RECORDING_SINK_SIZE];
+    }
+
+    void sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port = 0) { record(port, 0x90, channel, note, velocity); }
+    void sendNoteOff(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port = 0) { record(port, 0x80, channel, note, velocity); }
+    void sendControlChange(uint8_t channel, uint8_t cc, uint8_t value, uint8_t port = 0) { record(port, 0xB0, channel, cc, value); }
+    void sendProgramChange(uint8_t channel, uint8_t program, uint8_t port = 0) { record(port, 0xC0, channel, program, 0); }
+    void sendPitchBend(uint8_t channel, int16_t bend, uint8_t port = 0) {
+        uint16_t raw = (uint16_t)(bend + 8192);
+        record(port, 0xE0, channel, raw & 0x7F, (raw >> 7) & 0x7F);
+    }
+    void sendAfterTouch(uint8_t channel, uint8_t pressure, uint8_t port = 0) { record(port, 0xD0, channel, pressure, 0); }
+    void sendPolyAfterTouch(uint8_t channel, uint8_t note, uint8_t pressure, uint8_t port = 0) { record(port, 0xA0, channel, note, pressure); }
+    void sendSysEx(const uint8_t*, uint16_t length, uint8_t port = 0) { record(port, 0xF0, 1, length & 0x7F, (length >> 7) & 0x7F); }
+
+    void sendClock() { record(0, 0xF8, 1, 0, 0); }
+    void sendStart() { record(0, 0xFA, 1, 0, 0); }
+    void sendContinue() { record(0, 0xFB, 1, 0, 0); }
+    void sendStop() { record(0, 0xFC, 1, 0, 0); }
+
+private:
+    RecordedMidiMessage ring[RECORDING_SINK_SIZE];
+    uint8_t head;
+    uint32_t total;
+
+    void record(uint8_t port, uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2) {
+        RecordedMidiMessage& m = ring[head];
+        m.port = port;
+        m.status = type < 0xF0 ? (uint8_t)(type | ((channel - 1) & 0x0F)) : type;
+        m.data1 = data1;
+        m.data2 = data2;
+        head = (head + 1) % RECORDING_SINK_SIZE;
+        total++;
+    }
+};
+
+#endif // MIDI_SINKS_H
@@ -0,0 +1,57 @@
+#ifndef SD_HEALTH_H
+#define SD_HEALTH_H
+
+#include <Arduino.h>
+
+// Read latency profile of the inserted SD card.
+// The parser times every track buffer refill (seek + read). Latencies go into
+// power-of-two buckets, so percentiles need no sample storage or sorting.
+#define SD_LATENCY_BUCKETS 16           // Bucket 0 < 64us, bucket n < 64us << n, the last one takes the rest
+#define SD_MARGINAL_MIN_READS 100       // Percentiles are not trusted before this many reads
+#define SD_MARGINAL_P99_MICROS 4000     // 99th percentile above this flags the card as marginal
+#define SD_MARGINAL_MAX_MICROS 50000    // So does any single read this slow
+#define SD_PREFETCH_BYTES_PER_SEC 3125  // A track can't usefully stream faster than one MIDI link
+#define SD_PREFETCH_MIN_BYTES 64
+
+class SdHealth {
+public:
+    SdHealth();
+    void reset();
+    void recordRead(uint32_t latencyMicros, uint32_t bytes);
+
+    uint32_t getReadCount() { return readCount; }
+    uint32_t getMaxMicros() { return maxMicros; }
+    uint32_t getAverageMicros();
+    uint32_t getPercentileMicros(uint8_t percent); // Upper bound of the bucket holding that percentile
+    uint32_t getBucketCount(uint8_t bucket);
+    bool isMarginal();
+
+    // Bytes a track should keep buffered to ride out the worst stall seen so far
+    uint16_t getRecommendedPrefetchBytes(uint16_t bufferSize);
+
+    // Read errors (see MidiFileParser::fillTrackBuffer) - any error marks the card marginal
+    void recordReadError() { readErrors++; }
+    void recordRecovery() { recoveredReads++; }   // A retry succeeded
+    void recordDeferral() { deferredEvents++; }   // A track paused until the card answers again
+    void recordLostTrack() { lostTracks++; }      // A track was ended after SD_READ_GIVE_UP_MS
+    void requestReinit() { reinitRequested = true; }
+    bool takeReinitRequest();                     // Returns and clears the request
+    uint32_t getReadErrors() { return readErrors; }
+    uint32_t getRecoveredReads() { return recoveredReads; }
+    uint32_t getDeferredEvents() { return deferredEvents; }
+    uint32_t getLostTracks() { return lostTracks; }
+
+private:
+    uint32_t buckets[SD_LATENCY_BUCKETS];
+    uint32_t readCount;
+    uint32_t maxMicros;
+    uint64_t totalMicros;
+
+    uint32_t readErrors;
+    uint32_t recoveredReads;
+    uint32_t deferredEvents;
+    uint32_t lostTracks;
+    bool reinitRequested;
+};
+
+#endif // SD_HEALTH_H
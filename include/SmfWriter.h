@@ -0,0 +1,80 @@
+#ifndef SMF_WRITER_H
+#define SMF_WRITER_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+
+// Writes a Standard MIDI File to the card. It is also a MidiPlayerT sink (the
+// MidiOutput send* methods), so an offline render runs the song through the
+// player's own event path and records what would have gone out on the wire.
+//
+// One MTrk per output port: each track keeps only the sends to its port and
+// notes which other ports were used, so a render takes one pass per port in
+// use - usually just one. The first track also carries the tempo map. Tracks
+// after the first start with a MIDI Port meta event (FF 21). Bytes go to the
+// card in SMF_WRITER_BUFFER_SIZE batches.
+#define SMF_WRITER_BUFFER_SIZE 512  // One SD sector per write
+#define SMF_META_MIDI_PORT 0x21
+
+class SmfWriter {
+public:
+    SmfWriter();
+
+    bool begin(FatFile* file, uint16_t ticksPerQuarter);  // Writes MThd; the format and track count come in finish()
+    void beginTrack(uint8_t port);
+    bool endTrack();  // End of Track at the current tick, then the MTrk length is filled in
+    bool finish();    // Format 0 for one track, 1 for more
+
+    // Events from here on are at this absolute tick (never earlier than the last one)
+    void setTick(uint32_t tick) { if (tick > currentTick) currentTick = tick; }
+    void writeTempo(uint32_t microsPerQuarter);
+    void writeTimeSignature(uint8_t numerator, uint8_t denominator);
+
+    // MidiPlayerT sink interface (channel is 1-based, as for MidiOutput)
+    void sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port = 0) { channelMessage(port, 0x90, channel, note, velocity, 3); }
+    void sendNoteOff(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port = 0) { channelMessage(port, 0x80, channel, note, velocity, 3); }
+    void sendControlChange(uint8_t channel, uint8_t cc, uint8_t value, uint8_t port = 0) { channelMessage(port, 0xB0, channel, cc, value, 3); }
+    void sendProgramChange(uint8_t channel, uint8_t program, uint8_t port = 0) { channelMessage(port, 0xC0, channel, program, 0, 2); }
+    void sendPitchBend(uint8_t channel, int16_t bend, uint8_t port = 0) {
+        uint16_t raw = (uint16_t)(bend + 8192);
+        channelMessage(port, 0xE0, channel, raw & 0x7F, (raw >> 7) & 0x7F, 3);
+    }
+    void sendAfterTouch(uint8_t channel, uint8_t pressure, uint8_t port = 0) { channelMessage(port, 0xD0, channel, pressure, 0, 2); }
+    void sendPolyAfterTouch(uint8_t channel, uint8_t note, uint8_t pressure, uint8_t port = 0) { channelMessage(port, 0xA0, channel, note, pressure, 3); }
+    void sendSysEx(const uint8_t* data, uint16_t length, uint8_t port = 0);
+
+    // Transport and clock have no place in a file
+    void sendClock() {}
+    void sendStart() {}
+    void sendContinue() {}
+    void sendStop() {}
+
+    uint8_t getPortsUsed() { return portsUsed; }  // Bit per port that was sent to, in any pass
+    uint16_t getTrackCount() { return trackCount; }
+    uint32_t getBytesWritten() { return flushedBytes + used; }
+    bool isOk() { return ok; }
+
+private:
+    FatFile* file;
+    uint8_t buffer[SMF_WRITER_BUFFER_SIZE];
+    uint16_t used;
+    uint32_t flushedBytes;    // File offset of buffer[0]
+    uint32_t trackStart;      // File offset of the current MTrk's first event
+    uint16_t trackCount;
+    uint8_t trackPort;
+    uint8_t portsUsed;
+    uint8_t runningStatus;    // 0 = none (after meta and SysEx events)
+    uint32_t currentTick;
+    uint32_t lastTick;        // Tick of the last event written to the current track
+    bool ok;
+
+    void put(uint8_t value);
+    void putVarLength(uint32_t value);
+    void putDelta();
+    void putMeta(uint8_t type, const uint8_t* data, uint8_t length);
+    bool flush();
+    bool patch(uint32_t offset, const uint8_t* data, uint8_t length);
+    void channelMessage(uint8_t port, uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2, uint8_t length);
+};
+
+#endif // SMF_WRITER_H
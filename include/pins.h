@@ -20,6 +20,11 @@
 #define MIDI_RX_PIN 1     // GP1 - MIDI IN receive (shared UART)
 #define MIDI_BAUD_RATE 31250
 
+// Additional MIDI OUT ports (PIO UARTs, TX only)
+// Wire each like the main output: GPx --[220R]--> Tip, 3.3V --[220R]--> Ring
+#define MIDI_OUT2_TX_PIN 2  // GP2 - MIDI OUT port B
+#define MIDI_OUT3_TX_PIN 3  // GP3 - MIDI OUT port C
+
 // Button Pins (new PCB layout - no encoder)
 #define BTN_PLAY_PIN 19         // GP19 - Play button
 #define BTN_STOP_PIN 17         // GP17 - Stop button
@@ -97,7 +97,7 @@ void DisplayManager::showConfirmation(const char* message, bool yesSelected) {
     display.display();
 }
 
-void DisplayManager::showFileBrowser(FileBrowser* browser) {
+void DisplayManager::showFileBrowser(FileBrowser* browser, bool auditioning) {
     if (!browser) return;
 
     display.clearDisplay();
@@ -112,7 +112,7 @@ void DisplayManager::showFileBrowser(FileBrowser* browser) {
     FileEntry* current = browser->getCurrentFile();
     if (current) {
         if (current->isDirectory) {
-            display.print("[D]");
+            display.print(browser->isSetlistFile(current->filename) ? "[S]" : "[D]");
         }
 
         int remainingWidth = 21 - 6;
@@ -128,7 +128,7 @@ void DisplayManager::showFileBrowser(FileBrowser* browser) {
     }
 
     display.setCursor(0, 12);
-    display.print("OK:Select MODE:Back");
+    display.print(auditioning ? "PREVIEW   STOP:End" : "OK:Select MODE:Back");
 
     display.setCursor(0, 24);
     const char* path = browser->getCurrentPath();
@@ -291,7 +291,15 @@ void DisplayManager::showPlayback(const PlaybackInfo& info) {
     int16_t stateX = modeX + modeWidth + 3;
     int16_t stateY = y;
 
-    if (info.isPlaying) {
+    if (info.shuttle > 0) {
+        // Draw fast-forward triangles (►►)
+        display.fillTriangle(stateX, stateY, stateX, stateY + 6, stateX + 3, stateY + 3, SSD1306_WHITE);
+        display.fillTriangle(stateX + 4, stateY, stateX + 4, stateY + 6, stateX + 7, stateY + 3, SSD1306_WHITE);
+    } else if (info.shuttle < 0) {
+        // Draw rewind triangles (◄◄)
+        display.fillTriangle(stateX + 3, stateY, stateX + 3, stateY + 6, stateX, stateY + 3, SSD1306_WHITE);
+        display.fillTriangle(stateX + 7, stateY, stateX + 7, stateY + 6, stateX + 4, stateY + 3, SSD1306_WHITE);
+    } else if (info.isPlaying) {
         // Draw play triangle (►)
         display.fillTriangle(stateX, stateY, stateX, stateY + 6, stateX + 4, stateY + 3, SSD1306_WHITE);
     } else if (info.isPaused) {
@@ -754,7 +762,9 @@ void DisplayManager::showChannelSettingsMenu(uint8_t selectedChannel, uint16_t c
     display.display();
 }
 
-void DisplayManager::showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTempo, uint8_t velocityScale, bool sysexEnabled, uint8_t currentOption, bool optionActive, bool bpmEditingWhole) {
+void DisplayManager::showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTempo, uint8_t velocityScale, bool sysexEnabled, uint8_t currentOption, bool optionActive, bool bpmEditingWhole,
+                                           uint8_t selectedScene, uint8_t definedScenes, int8_t activeScene,
+                                           uint8_t selectedPart, uint8_t partState) {
     display.clearDisplay();
     display.setTextSize(1);
 
@@ -795,13 +805,45 @@ void DisplayManager::showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTe
     display.print(deleteText);
     display.setTextColor(SSD1306_WHITE);
 
+    // Part (track) number and its mute state: X = unmuted, O = muted, S = solo
+    int16_t partX = 82;
+    display.setCursor(partX, y0);
+    display.print("P");
+    bool partSelected = (currentOption == 2);
+    int16_t partWidth = 16;
+
+    if (partSelected && optionActive) {
+        display.fillRect(partX + 6, y0 - 1, partWidth, 9, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+    } else if (partSelected) {
+        display.drawRect(partX + 6, y0 - 1, partWidth, 9, SSD1306_WHITE);
+    }
+    display.setCursor(partX + 8, y0);
+    if (selectedPart < 9) display.print(" ");
+    display.print(selectedPart + 1);
+    display.setTextColor(SSD1306_WHITE);
+
+    int16_t partMuteX = partX + 24;
+    bool partMuteSelected = (currentOption == 3);
+    int16_t partMuteWidth = 10;
+
+    if (partMuteSelected && optionActive) {
+        display.fillRect(partMuteX, y0 - 1, partMuteWidth, 9, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+    } else if (partMuteSelected) {
+        display.drawRect(partMuteX, y0 - 1, partMuteWidth, 9, SSD1306_WHITE);
+    }
+    display.setCursor(partMuteX + 2, y0);
+    display.print(partState == 2 ? "S" : (partState == 1 ? "O" : "X"));
+    display.setTextColor(SSD1306_WHITE);
+
     // Line 1: BPM and Velocity
     int16_t y1 = 11;
 
     // BPM option
     display.setCursor(0, y1);
     display.print("BPM:");
-    bool bpmSelected = (currentOption == 2);
+    bool bpmSelected = (currentOption == 4);
 
     int16_t bpmWidth = 42;  // Wide enough for "120.50" (6 chars * 6px + padding)
 
@@ -847,7 +889,7 @@ void DisplayManager::showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTe
     int16_t velX = 72;  // Moved right to avoid BPM overlap
     display.setCursor(velX, y1);
     display.print("Ve:");
-    bool velSelected = (currentOption == 3);
+    bool velSelected = (currentOption == 5);
 
     int16_t velWidth = 18;
 
@@ -866,11 +908,26 @@ void DisplayManager::showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTe
     }
     display.setTextColor(SSD1306_WHITE);
 
+    // Render (export) button
+    int16_t renderX = 110;
+    bool renderSelected = (currentOption == 8);
+    int16_t renderWidth = 18;
+
+    if (renderSelected && optionActive) {
+        display.fillRect(renderX, y1 - 1, renderWidth, 9, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+    } else if (renderSelected) {
+        display.drawRect(renderX, y1 - 1, renderWidth, 9, SSD1306_WHITE);
+    }
+    display.setCursor(renderX + 1, y1);
+    display.print("EXP");
+    display.setTextColor(SSD1306_WHITE);
+
     // Line 2: SysEx option
     int16_t y2 = 21;
     display.setCursor(0, y2);
     display.print("SysEx:");
-    bool sysexSelected = (currentOption == 4);
+    bool sysexSelected = (currentOption == 6);
 
     int16_t sysexWidth = 18;
 
@@ -884,6 +941,29 @@ void DisplayManager::showTrackSettingsMenu(uint32_t targetBPM, bool useDefaultTe
     display.print(sysexEnabled ? "ON" : "OFF");
     display.setTextColor(SSD1306_WHITE);
 
+    // Scene option: number, then '*' = active, '-' = empty
+    int16_t sceneX = 66;
+    display.setCursor(sceneX, y2);
+    display.print("Scn:");
+    bool sceneSelected = (currentOption == 7);
+
+    int16_t sceneWidth = 18;
+
+    if (sceneSelected && optionActive) {
+        display.fillRect(sceneX + 24, y2 - 1, sceneWidth, 9, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+    } else if (sceneSelected) {
+        display.drawRect(sceneX + 24, y2 - 1, sceneWidth, 9, SSD1306_WHITE);
+    }
+    display.setCursor(sceneX + 26, y2);
+    display.print(selectedScene + 1);
+    if (activeScene == selectedScene) {
+        display.print("*");
+    } else if (!(definedScenes & (1 << selectedScene))) {
+        display.print("-");
+    }
+    display.setTextColor(SSD1306_WHITE);
+
     display.display();
 }
 
@@ -961,7 +1041,7 @@ void DisplayManager::showMidiSettingsMenu(bool thruEnabled, bool keyboardEnabled
     display.setCursor(86, y2);
     display.print("V:");
 
-    bool velSelected = (currentOption == 3);
+    bool velSelected = (currentOption == 5);
     int16_t velWidth = 18;
 
     if (velSelected && optionActive) {
@@ -978,7 +1058,8 @@ void DisplayManager::showMidiSettingsMenu(bool thruEnabled, bool keyboardEnabled
     display.display();
 }
 
-void DisplayManager::showClockSettingsMenu(bool clockEnabled, bool optionActive) {
+void DisplayManager::showClockSettingsMenu(bool clockEnabled, bool tapPhaseAlign, const char* launchText, uint32_t launchErrorMicros,
+                                           uint8_t currentOption, bool optionActive) {
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
@@ -992,23 +1073,73 @@ void DisplayManager::showClockSettingsMenu(bool clockEnabled, bool optionActive)
     display.setCursor(0, y1);
     display.print("ClkOut:");
 
+    bool clockSelected = (currentOption == 0);
     const char* clockText = clockEnabled ? "ON " : "OFF";
     int16_t clockWidth = 18;
 
-    if (optionActive) {
-        display.fillRect(48, y1 - 1, clockWidth, 9, SSD1306_WHITE);
+    if (clockSelected && optionActive) {
+        display.fillRect(54, y1 - 1, clockWidth, 9, SSD1306_WHITE);
         display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
-    } else {
-        display.drawRect(48, y1 - 1, clockWidth, 9, SSD1306_WHITE);
+    } else if (clockSelected) {
+        display.drawRect(54, y1 - 1, clockWidth, 9, SSD1306_WHITE);
     }
-    display.setCursor(50, y1);
+    display.setCursor(56, y1);
     display.print(clockText);
     display.setTextColor(SSD1306_WHITE);
 
+    // Tap tempo phase alignment setting
+    int16_t y2 = 23;
+    display.setCursor(0, y2);
+    display.print("TapSync:");
+
+    bool syncSelected = (currentOption == 1);
+    const char* syncText = tapPhaseAlign ? "ON " : "OFF";
+    int16_t syncWidth = 18;
+
+    if (syncSelected && optionActive) {
+        display.fillRect(54, y2 - 1, syncWidth, 9, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+    } else if (syncSelected) {
+        display.drawRect(54, y2 - 1, syncWidth, 9, SSD1306_WHITE);
+    }
+    display.setCursor(56, y2);
+    display.print(syncText);
+    display.setTextColor(SSD1306_WHITE);
+
+    // Quantized launch setting (right column)
+    display.setCursor(78, y1);
+    display.print("Go:");
+
+    bool launchSelected = (currentOption == 2);
+    int16_t launchWidth = 28;
+
+    if (launchSelected && optionActive) {
+        display.fillRect(98, y1 - 1, launchWidth, 9, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+    } else if (launchSelected) {
+        display.drawRect(98, y1 - 1, launchWidth, 9, SSD1306_WHITE);
+    }
+    display.setCursor(100, y1);
+    display.print(launchText);
+    display.setTextColor(SSD1306_WHITE);
+
+    // Timing of the last launch: boundary to new song running
+    if (launchErrorMicros > 0) {
+        char text[10];
+        if (launchErrorMicros < 10000) {
+            snprintf(text, sizeof(text), "+%luus", (unsigned long)launchErrorMicros);
+        } else {
+            snprintf(text, sizeof(text), "+%lums", (unsigned long)(launchErrorMicros / 1000));
+        }
+        display.setCursor(80, y2);
+        display.print(text);
+    }
+
     display.display();
 }
 
-void DisplayManager::showRoutingMenu(uint8_t selectedChannel, uint8_t* channelRouting, uint8_t currentOption, bool optionActive) {
+void DisplayManager::showRoutingMenu(uint8_t selectedChannel, uint8_t* channelRouting, uint8_t currentOption, bool optionActive,
+                                     const uint8_t* portLoad, uint8_t portCount, uint8_t saturatedPorts, uint8_t layerCount) {
     display.clearDisplay();
     display.setTextSize(1);
 
@@ -1074,7 +1205,7 @@ void DisplayManager::showRoutingMenu(uint8_t selectedChannel, uint8_t* channelRo
     display.print(">");
 
     bool routeSelected = (currentOption == 3);
-    int16_t routeWidth = 18;
+    int16_t routeWidth = 24;
 
     if (routeSelected && optionActive) {
         display.fillRect(42, y1 - 1, routeWidth, 9, SSD1306_WHITE);
@@ -1084,14 +1215,34 @@ void DisplayManager::showRoutingMenu(uint8_t selectedChannel, uint8_t* channelRo
     }
     display.setCursor(44, y1);
 
-    // Display routing value: 255 = "--" (no routing), 0-15 = channel number
-    if (channelRouting[selectedChannel] == 255) {
+    // Display routing value: 255 = "--" (no routing), else port letter + channel (A1..C16)
+    uint8_t route = channelRouting[selectedChannel];
+    if (route == 255) {
         display.print("--");
     } else {
-        display.print(channelRouting[selectedChannel] + 1);
+        display.print((char)('A' + (route >> 4)));
+        display.print((route & 0x0F) + 1);
     }
     display.setTextColor(SSD1306_WHITE);
 
+    // Layered copies (fan-out) set in the .cfg file
+    if (layerCount > 0) {
+        display.setCursor(70, y1);
+        display.print("+");
+        display.print(layerCount);
+    }
+
+    // Line 2: Per-port link utilization (% of 31250 baud over the last second)
+    // "!" marks a port the current fan-out is projected to saturate
+    int16_t y2 = 22;
+    display.setCursor(0, y2);
+    for (uint8_t port = 0; port < portCount && portLoad; port++) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "%c%u%%%s", 'A' + port, portLoad[port],
+                 (saturatedPorts & (1 << port)) ? "! " : " ");
+        display.print(buf);
+    }
+
     display.display();
 }
 
@@ -1189,3 +1340,131 @@ void DisplayManager::showVisualizer(uint8_t* channelActivity, uint8_t* channelPe
 
     display.display();
 }
+
+// Latency as milliseconds with one decimal ("0.8", "12.4"), whole ms from 100 up
+static void formatLatency(uint32_t micros, char* buffer, size_t size) {
+    uint32_t tenths = (micros + 50) / 100;
+    if (tenths >= 1000) {
+        snprintf(buffer, size, "%lu", (unsigned long)(tenths / 10));
+    } else {
+        snprintf(buffer, size, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+    }
+}
+
+void DisplayManager::showDiagnostics(const SdDiagnosticsInfo& info) {
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+
+    // Title with card name, status on the right
+    display.setCursor(0, 0);
+    display.print("SD ");
+    display.print(info.cardName);
+
+    char line[24];
+
+    if (info.page == 1) {
+        // Bus page: negotiated clock, boot benchmark and UI sends the MIDI queue dropped
+        display.setCursor(104, 0);
+        display.print("BUS");
+
+        snprintf(line, sizeof(line), "Clock %lu MHz", (unsigned long)(info.clockHz / 1000000));
+        display.setCursor(0, 9);
+        display.print(line);
+
+        snprintf(line, sizeof(line), "Boot read %lu KB/s", (unsigned long)(info.benchBytesPerSec / 1024));
+        display.setCursor(0, 17);
+        display.print(line);
+
+        snprintf(line, sizeof(line), "MIDI drops %lu", (unsigned long)info.midiDropped);
+        display.setCursor(0, 25);
+        display.print(line);
+
+        display.display();
+        return;
+    }
+
+    if (info.readCount == 0 && info.readErrors == 0) {
+        display.setCursor(0, 12);
+        display.print("No reads yet");
+        display.display();
+        return;
+    }
+
+    if (info.marginal) {
+        // Inverted so a bad card stands out
+        display.fillRect(79, 0, 49, 9, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+        display.setCursor(80, 1);
+        display.print("MARGINAL");
+        display.setTextColor(SSD1306_WHITE);
+    } else {
+        display.setCursor(116, 0);
+        display.print("OK");
+    }
+
+    char p50[8], p99[8], worst[8];
+    formatLatency(info.p50Micros, p50, sizeof(p50));
+    formatLatency(info.p99Micros, p99, sizeof(p99));
+    formatLatency(info.maxMicros, worst, sizeof(worst));
+
+    // Percentiles (ms)
+    snprintf(line, sizeof(line), "p50 %s p99 %s ms", p50, p99);
+    display.setCursor(0, 9);
+    display.print(line);
+
+    // Worst case and sample count
+    snprintf(line, sizeof(line), "Max %s ms n=%lu", worst, (unsigned long)info.readCount);
+    display.setCursor(0, 17);
+    display.print(line);
+
+    // Lookahead sized from the worst case, and read errors if there were any
+    if (info.readErrors > 0) {
+        snprintf(line, sizeof(line), "Ahead %uB Err %lu", info.prefetchBytes, (unsigned long)info.readErrors);
+    } else {
+        snprintf(line, sizeof(line), "Lookahead %u B", info.prefetchBytes);
+    }
+    display.setCursor(0, 25);
+    display.print(line);
+
+    display.display();
+}
+
+void DisplayManager::showSysExSend(const SysExSendInfo& info) {
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+
+    char line[24];
+    snprintf(line, sizeof(line), "SYX %.17s", info.filename ? info.filename : "");
+    display.setCursor(0, 0);
+    display.print(line);
+
+    // Line 2: size before the send, then progress, rate and time
+    unsigned long minutes = info.seconds / 60;
+    unsigned long seconds = info.seconds % 60;
+    if (info.state == SYSEX_SEND_READY) {
+        snprintf(line, sizeof(line), "%luB  PLAY:Send", (unsigned long)info.totalBytes);
+    } else if (info.state == SYSEX_SEND_RUNNING) {
+        unsigned percent = info.totalBytes ? (unsigned)((uint64_t)info.bytesDone * 100 / info.totalBytes) : 100;
+        snprintf(line, sizeof(line), "%3u%% %4luB/s %lu:%02lu", percent, (unsigned long)info.bytesPerSec, minutes, seconds);
+    } else {
+        snprintf(line, sizeof(line), "Done %4luB/s %lu:%02lu", (unsigned long)info.bytesPerSec, minutes, seconds);
+    }
+    display.setCursor(0, 11);
+    display.print(line);
+
+    // Line 3: message gap, adjustable at any time with LEFT/RIGHT
+    int16_t y = 22;
+    display.setCursor(0, y);
+    display.print("Gap:");
+    display.drawRect(24, y - 1, 34, 9, SSD1306_WHITE);
+    snprintf(line, sizeof(line), "%3ums", info.gapMs);
+    display.setCursor(26, y);
+    display.print(line);
+
+    display.setCursor(66, y);
+    display.print(info.state == SYSEX_SEND_RUNNING ? "STOP:Abort" : "STOP:Back");
+
+    display.display();
+}
@@ -4,6 +4,7 @@ FileBrowser::FileBrowser() {
     sd = nullptr;
     fileCount = 0;
     currentIndex = 0;
+    setlistActive = false;
     strcpy(currentPath, "/");
     strcpy(rootPath, "/MIDI");
 }
@@ -28,10 +29,10 @@ bool FileBrowser::isMidiFile(const char* filename) {
     size_t len = strlen(filename);
     if (len < 4) return false;
 
-    // Check for .mid extension
+    // Check for .mid, .rmi (RIFF MIDI) and .mlz (compressed, see MidiContainer.h) extensions
     if (len >= 4) {
         const char* ext = filename + len - 4;
-        if (strcasecmp(ext, ".mid") == 0) {
+        if (strcasecmp(ext, ".mid") == 0 || strcasecmp(ext, ".rmi") == 0 || strcasecmp(ext, ".mlz") == 0) {
             return true;
         }
     }
@@ -47,11 +48,22 @@ bool FileBrowser::isMidiFile(const char* filename) {
     return false;
 }
 
+bool FileBrowser::isSetlistFile(const char* filename) {
+    size_t len = strlen(filename);
+    return len >= 4 && strcasecmp(filename + len - 4, ".set") == 0;
+}
+
+bool FileBrowser::isSysExFile(const char* filename) {
+    size_t len = strlen(filename);
+    return len >= 4 && strcasecmp(filename + len - 4, ".syx") == 0;
+}
+
 bool FileBrowser::scanCurrentDirectory() {
     if (!sd) return false;
 
     fileCount = 0;
     currentIndex = 0;
+    setlistActive = false;
 
     FatFile dir;
     if (!dir.open(currentPath)) {
@@ -74,8 +86,8 @@ bool FileBrowser::scanCurrentDirectory() {
         snprintf(entry.fullPath, MAX_PATH_LENGTH, "%s/%s",
                  currentPath, entry.filename);
 
-        // Check if directory
-        entry.isDirectory = file.isDir();
+        // Check if directory (setlists are entered like one)
+        entry.isDirectory = file.isDir() || isSetlistFile(entry.filename);
         entry.fileSize = file.fileSize();
 
         // Skip hidden files and current directory marker
@@ -90,8 +102,8 @@ bool FileBrowser::scanCurrentDirectory() {
             continue;
         }
 
-        // Only add MIDI files or directories
-        if (entry.isDirectory || isMidiFile(entry.filename)) {
+        // Only add MIDI files, SysEx dumps or directories
+        if (entry.isDirectory || isMidiFile(entry.filename) || isSysExFile(entry.filename)) {
             fileCount++;
         }
 
@@ -151,6 +163,12 @@ void FileBrowser::enterDirectory() {
     FileEntry* current = getCurrentFile();
     if (!current || !current->isDirectory) return;
 
+    if (setlistActive && strcmp(current->filename, SETLIST_UP_ENTRY) == 0) {
+        goUp();
+        return;
+    }
+    bool setlist = isSetlistFile(current->filename);
+
     // Build new path
     if (strcmp(currentPath, "/") == 0) {
         snprintf(currentPath, MAX_PATH_LENGTH, "/%s", current->filename);
@@ -159,7 +177,75 @@ void FileBrowser::enterDirectory() {
                  currentPath, current->filename);
     }
 
-    scanCurrentDirectory();
+    if (setlist) {
+        loadSetlist();
+    } else {
+        scanCurrentDirectory();
+    }
+}
+
+bool FileBrowser::loadSetlist() {
+    fileCount = 0;
+    currentIndex = 0;
+    setlistActive = true;
+
+    // Relative song paths start from the setlist's folder
+    char folder[MAX_PATH_LENGTH];
+    strncpy(folder, currentPath, MAX_PATH_LENGTH - 1);
+    folder[MAX_PATH_LENGTH - 1] = '\0';
+    char* lastSlash = strrchr(folder, '/');
+    if (lastSlash && lastSlash != folder) {
+        *lastSlash = '\0';
+    }
+
+    FatFile list;
+    bool opened = list.open(currentPath, O_RDONLY);
+    char line[MAX_PATH_LENGTH];
+    while (opened && fileCount < MAX_FILES - 1) {
+        int len = list.fgets(line, sizeof(line));
+        if (len <= 0) break;
+
+        // Trim line ending and surrounding spaces
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+            line[--len] = '\0';
+        }
+        char* path = line;
+        while (*path == ' ') path++;
+        if (*path == '\0' || *path == '#') continue;
+
+        FileEntry& entry = files[fileCount];
+        if (path[0] == '/') {
+            snprintf(entry.fullPath, MAX_PATH_LENGTH, "%s", path);
+        } else {
+            snprintf(entry.fullPath, MAX_PATH_LENGTH, "%s/%s", folder, path);
+        }
+        const char* name = strrchr(entry.fullPath, '/');
+        name = name ? name + 1 : entry.fullPath;
+        strncpy(entry.filename, name, MAX_FILENAME_LENGTH - 1);
+        entry.filename[MAX_FILENAME_LENGTH - 1] = '\0';
+
+        // Songs that are missing or not MIDI are left out
+        FatFile song;
+        if (!isMidiFile(entry.filename) || !song.open(entry.fullPath, O_RDONLY)) {
+            continue;
+        }
+        entry.isDirectory = false;
+        entry.fileSize = song.fileSize();
+        song.close();
+        fileCount++;
+    }
+    if (opened) {
+        list.close();
+    }
+
+    FileEntry& up = files[fileCount++];
+    strcpy(up.filename, SETLIST_UP_ENTRY);
+    strncpy(up.fullPath, folder, MAX_PATH_LENGTH - 1);
+    up.fullPath[MAX_PATH_LENGTH - 1] = '\0';
+    up.isDirectory = true;
+    up.fileSize = 0;
+
+    return opened;
 }
 
 void FileBrowser::goUp() {
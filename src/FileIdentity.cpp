@@ -0,0 +1,35 @@
+#include "FileIdentity.h"
+#include "Crc32.h"
+
+// Fold one sample of the file into the hash; false on a short read
+static bool hashRange(FatFile* file, uint32_t position, uint32_t length, uint32_t& crc) {
+    uint8_t buffer[FILE_IDENTITY_SAMPLE_BYTES];
+    if (length > sizeof(buffer)) length = sizeof(buffer);
+
+    if (!file->seekSet(position)) return false;
+    if (file->read(buffer, length) != (int)length) return false;
+
+    crc = crc32Update(crc, buffer, length);
+    return true;
+}
+
+bool computeFileIdentity(FatFile* file, FileIdentity& identity) {
+    if (!file || !file->isOpen()) return false;
+
+    identity.size = file->fileSize();
+    uint32_t crc = 0;
+
+    // First sector (MIDI header and start of the first track)
+    uint32_t headLength = identity.size < FILE_IDENTITY_SAMPLE_BYTES ? identity.size : FILE_IDENTITY_SAMPLE_BYTES;
+    if (!hashRange(file, 0, headLength, crc)) return false;
+
+    // Last sector, unless the first one already covered the whole file
+    if (identity.size > FILE_IDENTITY_SAMPLE_BYTES) {
+        uint32_t tailStart = identity.size - FILE_IDENTITY_SAMPLE_BYTES;
+        if (tailStart < FILE_IDENTITY_SAMPLE_BYTES) tailStart = FILE_IDENTITY_SAMPLE_BYTES;
+        if (!hashRange(file, tailStart, identity.size - tailStart, crc)) return false;
+    }
+
+    identity.hash = crc;
+    return true;
+}
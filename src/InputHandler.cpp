@@ -1,22 +1,32 @@
 #include "InputHandler.h"
 #include "pins.h"
+#include <pico/time.h>
+#include <atomic>
+
+// Pin for each Button value (index = Button - 1)
+static const uint8_t buttonPins[] = {
+    BTN_PLAY_PIN,
+    BTN_STOP_PIN,
+    BTN_LEFT_PIN,
+    BTN_RIGHT_PIN,
+    BTN_MODE_PIN,
+    BTN_OK_PIN,
+    BTN_PANIC_PIN
+};
+
+InputHandler* InputHandler::instance = nullptr;
 
 InputHandler::InputHandler() {
-    lastPlayTime = 0;
-    lastStopTime = 0;
-    lastLeftTime = 0;
-    lastRightTime = 0;
-    lastModeTime = 0;
-    lastOkTime = 0;
-    lastPanicTime = 0;
-
-    lastPlayState = HIGH;
-    lastStopState = HIGH;
-    lastLeftState = HIGH;
-    lastRightState = HIGH;
-    lastModeState = HIGH;
-    lastOkState = HIGH;
-    lastPanicState = HIGH;
+    queueHead = 0;
+    queueTail = 0;
+    droppedEvents = 0;
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        pressedState[i] = false;
+        lastEdgeMicros[i] = 0;
+        lastPressAcceptedMicros[i] = 0;
+    }
+    lastPressMicros = 0;
 
     // Initialize hold/repeat state
     currentHeldButton = BTN_NONE;
@@ -27,97 +37,95 @@ InputHandler::InputHandler() {
 
 void InputHandler::begin() {
     // Initialize all button pins with internal pullup resistors
-    pinMode(BTN_PLAY_PIN, INPUT_PULLUP);
-    pinMode(BTN_STOP_PIN, INPUT_PULLUP);
-    pinMode(BTN_LEFT_PIN, INPUT_PULLUP);
-    pinMode(BTN_RIGHT_PIN, INPUT_PULLUP);
-    pinMode(BTN_MODE_PIN, INPUT_PULLUP);
-    pinMode(BTN_OK_PIN, INPUT_PULLUP);
-    pinMode(BTN_PANIC_PIN, INPUT_PULLUP);
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        pinMode(buttonPins[i], INPUT_PULLUP);
+    }
+
+    // Seed debounced state so buttons held during boot don't produce a phantom press
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        pressedState[i] = (digitalRead(buttonPins[i]) == LOW);
+    }
+
+    // Capture edges in hardware time - the loop may be busy for many milliseconds
+    // (display flush, file load) and polling would miss or late-stamp presses
+    instance = this;
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        attachInterrupt(digitalPinToInterrupt(buttonPins[i]), handleEdgeInterrupt, CHANGE);
+    }
 }
 
-Button InputHandler::readButton() {
-    unsigned long currentTime = millis();
+void InputHandler::handleEdgeInterrupt() {
+    if (instance) {
+        instance->captureEdges();
+    }
+}
 
-    // Check all buttons with debouncing and edge detection
+void InputHandler::captureEdges() {
+    uint64_t now = time_us_64();
+
+    // One handler serves all pins - compare every pin against its debounced state
     // Buttons are active LOW (pressed = LOW, released = HIGH)
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        bool pressed = (digitalRead(buttonPins[i]) == LOW);
+        if (pressed == pressedState[i]) continue;
 
-    // Play Button (GP19)
-    bool playState = digitalRead(BTN_PLAY_PIN);
-    if (playState == LOW && lastPlayState == HIGH) {
-        if (currentTime - lastPlayTime >= BUTTON_DEBOUNCE) {
-            lastPlayTime = currentTime;
-            lastPlayState = playState;
-            return BTN_PLAY;
-        }
-    }
-    lastPlayState = playState;
-
-    // Stop Button (GP17)
-    bool stopState = digitalRead(BTN_STOP_PIN);
-    if (stopState == LOW && lastStopState == HIGH) {
-        if (currentTime - lastStopTime >= BUTTON_DEBOUNCE) {
-            lastStopTime = currentTime;
-            lastStopState = stopState;
-            return BTN_STOP;
-        }
-    }
-    lastStopState = stopState;
-
-    // Left Button (GP16)
-    bool leftState = digitalRead(BTN_LEFT_PIN);
-    if (leftState == LOW && lastLeftState == HIGH) {
-        if (currentTime - lastLeftTime >= BUTTON_DEBOUNCE) {
-            lastLeftTime = currentTime;
-            lastLeftState = leftState;
-            return BTN_LEFT;
-        }
-    }
-    lastLeftState = leftState;
-
-    // Right Button (GP20)
-    bool rightState = digitalRead(BTN_RIGHT_PIN);
-    if (rightState == LOW && lastRightState == HIGH) {
-        if (currentTime - lastRightTime >= BUTTON_DEBOUNCE) {
-            lastRightTime = currentTime;
-            lastRightState = rightState;
-            return BTN_RIGHT;
-        }
-    }
-    lastRightState = rightState;
-
-    // Mode Button (GP24)
-    bool modeState = digitalRead(BTN_MODE_PIN);
-    if (modeState == LOW && lastModeState == HIGH) {
-        if (currentTime - lastModeTime >= BUTTON_DEBOUNCE) {
-            lastModeTime = currentTime;
-            lastModeState = modeState;
-            return BTN_MODE;
-        }
-    }
-    lastModeState = modeState;
-
-    // OK Button (GP15)
-    bool okState = digitalRead(BTN_OK_PIN);
-    if (okState == LOW && lastOkState == HIGH) {
-        if (currentTime - lastOkTime >= BUTTON_DEBOUNCE) {
-            lastOkTime = currentTime;
-            lastOkState = okState;
-            return BTN_OK;
+        // Contact bounce: ignore further edges shortly after an accepted one
+        if (now - lastEdgeMicros[i] < BOUNCE_WINDOW_MICROS) continue;
+
+        pressedState[i] = pressed;
+        lastEdgeMicros[i] = now;
+
+        uint8_t head = queueHead;
+        uint8_t next = (head + 1) & (EVENT_QUEUE_SIZE - 1);
+        if (next == queueTail) {
+            droppedEvents = droppedEvents + 1;  // Queue full - consumer has stalled
+            continue;
         }
+
+        eventQueue[head].button = static_cast<Button>(i + 1);
+        eventQueue[head].edge = pressed ? EDGE_PRESS : EDGE_RELEASE;
+        eventQueue[head].timestampMicros = now;
+
+        // Publish the entry only after it is fully written
+        std::atomic_signal_fence(std::memory_order_release);
+        queueHead = next;
     }
-    lastOkState = okState;
-
-    // Panic Button (GP18)
-    bool panicState = digitalRead(BTN_PANIC_PIN);
-    if (panicState == LOW && lastPanicState == HIGH) {
-        if (currentTime - lastPanicTime >= BUTTON_DEBOUNCE) {
-            lastPanicTime = currentTime;
-            lastPanicState = panicState;
-            return BTN_PANIC;
+}
+
+bool InputHandler::readEvent(ButtonEvent& event) {
+    // Reconcile any edge the bounce window swallowed (e.g. a release that settled
+    // inside the window and produced no further interrupt)
+    noInterrupts();
+    captureEdges();
+    interrupts();
+
+    uint8_t tail = queueTail;
+    if (tail == queueHead) return false;
+
+    std::atomic_signal_fence(std::memory_order_acquire);
+    event = eventQueue[tail];
+    std::atomic_signal_fence(std::memory_order_release);
+    queueTail = (tail + 1) & (EVENT_QUEUE_SIZE - 1);
+    return true;
+}
+
+Button InputHandler::readButton() {
+    // Return the next press from the queue - releases only update held state,
+    // which isButtonHeld() reads directly from the pin
+    ButtonEvent event;
+    while (readEvent(event)) {
+        if (event.edge != EDGE_PRESS) continue;
+
+        // Reject accidental double-presses using hardware timestamps
+        uint8_t index = event.button - 1;
+        if (lastPressAcceptedMicros[index] != 0 &&
+            event.timestampMicros - lastPressAcceptedMicros[index] < static_cast<uint64_t>(BUTTON_DEBOUNCE) * 1000) {
+            continue;
         }
+        lastPressAcceptedMicros[index] = event.timestampMicros;
+        lastPressMicros = event.timestampMicros;
+        return event.button;
     }
-    lastPanicState = panicState;
 
     return BTN_NONE;
 }
@@ -190,14 +198,6 @@ Button InputHandler::readButtonWithRepeat() {
 }
 
 bool InputHandler::isButtonHeld(Button btn) {
-    switch (btn) {
-        case BTN_PLAY:  return digitalRead(BTN_PLAY_PIN) == LOW;
-        case BTN_STOP:  return digitalRead(BTN_STOP_PIN) == LOW;
-        case BTN_LEFT:  return digitalRead(BTN_LEFT_PIN) == LOW;
-        case BTN_RIGHT: return digitalRead(BTN_RIGHT_PIN) == LOW;
-        case BTN_MODE:  return digitalRead(BTN_MODE_PIN) == LOW;
-        case BTN_OK:    return digitalRead(BTN_OK_PIN) == LOW;
-        case BTN_PANIC: return digitalRead(BTN_PANIC_PIN) == LOW;
-        default:        return false;
-    }
+    if (btn == BTN_NONE || btn > BUTTON_COUNT) return false;
+    return digitalRead(buttonPins[btn - 1]) == LOW;
 }
@@ -0,0 +1,275 @@
+#include "MidiContainer.h"
+
+int lz4DecodeBlock(const uint8_t* src, uint16_t srcSize, uint8_t* dst, uint16_t dstCapacity) {
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + dstCapacity;
+
+    while (ip < ipEnd) {
+        uint8_t token = *ip++;
+
+        // Literals
+        uint32_t length = token >> 4;
+        if (length == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ipEnd) return -1;
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+        }
+        if (length > (uint32_t)(ipEnd - ip) || length > (uint32_t)(opEnd - op)) return -1;
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
+
+        // The last sequence of a block is literals only
+        if (ip >= ipEnd) break;
+
+        // Match
+        if (ipEnd - ip < 2) return -1;
+        uint16_t offset = (uint16_t)(ip[0] | (ip[1] << 8));
+        ip += 2;
+        if (offset == 0 || offset > op - dst) return -1;
+
+        length = (token & 0x0F) + 4;
+        if ((token & 0x0F) == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ipEnd) return -1;
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+        }
+        if (length > (uint32_t)(opEnd - op)) return -1;
+
+        // Byte copy - the match may overlap the bytes being written
+        const uint8_t* match = op - offset;
+        while (length--) {
+            *op++ = *match++;
+        }
+    }
+
+    return (int)(op - dst);
+}
+
+MidiContainer::MidiContainer() {
+    file = nullptr;
+    close();
+}
+
+void MidiContainer::close() {
+    file = nullptr;
+    type = CONTAINER_NONE;
+    dataOffset = 0;
+    smfSize = 0;
+    position = 0;
+    cardBytesRead = 0;
+    blockCount = 0;
+    indexOffset = 0;
+    blockChecksums = false;
+    useCounter = 0;
+    blocksDecoded = 0;
+    for (uint8_t i = 0; i < MLZ_CACHE_BLOCKS; i++) {
+        cache[i].index = 0xFFFFFFFFUL;
+        cache[i].lastUse = 0;
+        cache[i].size = 0;
+    }
+}
+
+bool MidiContainer::open(FatFile* f) {
+    close();
+    if (!f) return false;
+    file = f;
+
+    uint8_t magic[4];
+    if (!readAt(0, magic, 4)) {
+        // Too short for any container - let the MThd check reject it
+        type = CONTAINER_SMF;
+        smfSize = file->fileSize();
+        return true;
+    }
+
+    bool ok;
+    if (memcmp(magic, "RIFF", 4) == 0) {
+        ok = openRmid();
+    } else if (readLE32(magic) == LZ4_FRAME_MAGIC) {
+        ok = openMlz();
+    } else {
+        type = CONTAINER_SMF;
+        smfSize = file->fileSize();
+        ok = true;
+    }
+
+    if (!ok) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MidiContainer::readAt(uint32_t offset, void* buffer, uint16_t count) {
+    if (!file->seekSet(offset)) return false;
+    int bytesRead = file->read(buffer, count);
+    if (bytesRead > 0) cardBytesRead += bytesRead;
+    return bytesRead == (int)count;
+}
+
+// RIFF "RMID" form: the SMF is the payload of the "data" chunk
+bool MidiContainer::openRmid() {
+    uint8_t header[12];
+    if (!readAt(0, header, 12) || memcmp(header + 8, "RMID", 4) != 0) return false;
+
+    uint32_t fileEnd = file->fileSize();
+    uint32_t pos = 12;
+    while (pos + 8 <= fileEnd) {
+        uint8_t chunk[8];
+        if (!readAt(pos, chunk, 8)) return false;
+        uint32_t chunkSize = readLE32(chunk + 4);
+
+        if (memcmp(chunk, "data", 4) == 0) {
+            type = CONTAINER_RMID;
+            dataOffset = pos + 8;
+            smfSize = fileEnd - dataOffset;
+            if (chunkSize < smfSize) smfSize = chunkSize;
+            return true;
+        }
+
+        // Chunks are padded to an even length
+        uint32_t next = pos + 8 + chunkSize + (chunkSize & 1);
+        if (next <= pos) return false;
+        pos = next;
+    }
+
+    return false;
+}
+
+// LZ4 frame written by mlz_pack: independent blocks, content size present,
+// and the skippable index frame as the last thing in the file
+bool MidiContainer::openMlz() {
+    uint8_t header[15];
+    if (!readAt(0, header, sizeof(header))) return false;
+
+    uint8_t flags = header[4];
+    bool versionOk = (flags >> 6) == 1;
+    bool independent = flags & 0x20;
+    bool hasContentSize = flags & 0x08;
+    bool hasDictionary = flags & 0x01;
+    if (!versionOk || !independent || !hasContentSize || hasDictionary) return false;
+    blockChecksums = flags & 0x10;
+
+    // 64-bit content size; anything this player can hold fits the low word
+    if (readLE32(header + 10) != 0) return false;
+    smfSize = readLE32(header + 6);
+    if (smfSize == 0 || smfSize > MLZ_MAX_SMF_SIZE) return false;
+
+    // Trailer: block count, preceded by one offset per block and the frame header
+    uint32_t fileEnd = file->fileSize();
+    uint8_t word[4];
+    if (fileEnd < 4 || !readAt(fileEnd - 4, word, 4)) return false;
+    blockCount = readLE32(word);
+    if (blockCount != (smfSize + MLZ_BLOCK_SIZE - 1) / MLZ_BLOCK_SIZE) return false;
+
+    uint32_t indexBytes = blockCount * 4 + 4;
+    if (fileEnd < sizeof(header) + indexBytes + 8) return false;
+    uint8_t frame[8];
+    uint32_t frameStart = fileEnd - indexBytes - 8;
+    if (!readAt(frameStart, frame, 8)) return false;
+    if (readLE32(frame) != MLZ_INDEX_MAGIC || readLE32(frame + 4) != indexBytes) return false;
+
+    type = CONTAINER_MLZ;
+    indexOffset = frameStart + 8;
+    return true;
+}
+
+// Decoded block from the cache, reading and decoding it on a miss
+const MidiContainer::CachedBlock* MidiContainer::loadBlock(uint32_t index) {
+    CachedBlock* victim = &cache[0];
+    uint32_t headerOffset = 0;
+
+    for (uint8_t i = 0; i < MLZ_CACHE_BLOCKS; i++) {
+        if (cache[i].index == index) {
+            cache[i].lastUse = ++useCounter;
+            return &cache[i];
+        }
+        // Sequential reads find the previous block cached and skip the index
+        if (index > 0 && cache[i].index == index - 1) {
+            headerOffset = cache[i].nextOffset;
+        }
+        if (cache[i].lastUse < victim->lastUse) {
+            victim = &cache[i];
+        }
+    }
+
+    if (headerOffset == 0) {
+        uint8_t entry[4];
+        if (!readAt(indexOffset + index * 4, entry, 4)) return nullptr;
+        headerOffset = readLE32(entry);
+    }
+
+    uint8_t word[4];
+    if (!readAt(headerOffset, word, 4)) return nullptr;
+    uint32_t blockHeader = readLE32(word);
+    uint32_t storedSize = blockHeader & ~LZ4_BLOCK_UNCOMPRESSED;
+    if (storedSize == 0 || storedSize > MLZ_BLOCK_SIZE) return nullptr;
+
+    uint32_t expected = smfSize - index * MLZ_BLOCK_SIZE;
+    if (expected > MLZ_BLOCK_SIZE) expected = MLZ_BLOCK_SIZE;
+
+    // Invalidate first so a failed decode never leaves stale data under this index
+    victim->index = 0xFFFFFFFFUL;
+
+    if (blockHeader & LZ4_BLOCK_UNCOMPRESSED) {
+        if (storedSize != expected || !readAt(headerOffset + 4, victim->data, storedSize)) return nullptr;
+    } else {
+        if (!readAt(headerOffset + 4, scratch, storedSize)) return nullptr;
+        if (lz4DecodeBlock(scratch, storedSize, victim->data, MLZ_BLOCK_SIZE) != (int)expected) return nullptr;
+    }
+
+    victim->index = index;
+    victim->size = expected;
+    victim->nextOffset = headerOffset + 4 + storedSize + (blockChecksums ? 4 : 0);
+    victim->lastUse = ++useCounter;
+    blocksDecoded++;
+    return victim;
+}
+
+int MidiContainer::read(void* buffer, size_t count) {
+    if (!file) return -1;
+
+    uint32_t left = smfSize - (position < smfSize ? position : smfSize);
+    if (count > left) count = left;
+    if (count == 0) return 0;
+
+    if (type != CONTAINER_MLZ) {
+        if (!file->seekSet(dataOffset + position)) return -1;
+        int bytesRead = file->read(buffer, count);
+        if (bytesRead < 0) return -1;
+        cardBytesRead += bytesRead;
+        position += bytesRead;
+        return bytesRead;
+    }
+
+    uint8_t* out = (uint8_t*)buffer;
+    size_t done = 0;
+    while (done < count) {
+        const CachedBlock* block = loadBlock(position / MLZ_BLOCK_SIZE);
+        if (!block) return -1;
+
+        uint16_t offset = position % MLZ_BLOCK_SIZE;
+        size_t chunk = block->size - offset;
+        if (chunk > count - done) chunk = count - done;
+        memcpy(out + done, block->data + offset, chunk);
+        done += chunk;
+        position += chunk;
+    }
+
+    return (int)done;
+}
+
+bool MidiContainer::seekSet(uint32_t pos) {
+    if (!file || pos > smfSize) return false;
+    position = pos;
+    return true;
+}
@@ -1,13 +1,30 @@
 #include "MidiFileParser.h"
 
+const uint8_t CHASE_CONTROLLERS[CHASE_CONTROLLER_COUNT] = {
+    0, 32,       // Bank select MSB/LSB - must reach the synth before the program change
+    1, 7, 10, 11, 64, 91, 93  // Modulation, volume, pan, expression, sustain, reverb, chorus
+};
+
 MidiFileParser::MidiFileParser() {
     midiFile = nullptr;
     numTracks = 0;
     allTracksEnded = false;
     fileLengthTicks = 0;
     sysexCount = 0;
+    healthMonitor = nullptr;
+    prefetchThreshold = 0;
+    checkpointCount = 0;
+    checkpointSpacing = 0;
+    silencedTracks = 0;
+    skippedNotes = 0;
+    activeSequence = 0;
+    memset(sequenceLengthTicks, 0, sizeof(sequenceLengthTicks));
+    memset(sequenceTempo, 0, sizeof(sequenceTempo));
+    clearChase();
     memset(&fileInfo, 0, sizeof(MidiFileInfo));
-    memset(tracks, 0, sizeof(tracks));
+    for (uint8_t i = 0; i < MAX_TRACKS; i++) {
+        tracks[i] = TrackState();  // Zeroed, with each buffered event constructed
+    }
     fileInfo.tempo = 500000; // Default 120 BPM
     fileInfo.numerator = 4;
     fileInfo.denominator = 4;
@@ -39,9 +56,14 @@ void MidiFileParser::close() {
     }
 
     midiFile = nullptr;
+    container.close();
     numTracks = 0;
     allTracksEnded = false;
     fileLengthTicks = 0;
+    activeSequence = 0;
+    fileInfo.format = 0;
+    clearCheckpoints();
+    clearChase();
 }
 
 bool MidiFileParser::open(const char* filename, FatFile* file) {
@@ -54,11 +76,26 @@ bool MidiFileParser::open(const char* filename, FatFile* file) {
     fileInfo.numerator = 4;
     fileInfo.denominator = 4;
     memset(fileInfo.trackName, 0, sizeof(fileInfo.trackName));
+    skippedNotes = 0;
+
+    // Unwrap RMID / MLZ; everything below reads plain SMF offsets
+    if (!container.open(file)) {
+        return false;
+    }
 
     if (!readMidiHeader()) {
         return false;
     }
 
+    // Checkpoints belong to the previous file; the first one is taken at tick 0
+    clearCheckpoints();
+    clearChase();
+
+    // Format 2 starts on its first sequence; lengths and tempos come from calculateFileLength()
+    activeSequence = 0;
+    memset(sequenceLengthTicks, 0, sizeof(sequenceLengthTicks));
+    memset(sequenceTempo, 0, sizeof(sequenceTempo));
+
     if (!initializeTracks()) {
         return false;
     }
@@ -71,10 +108,80 @@ bool MidiFileParser::open(const char* filename, FatFile* file) {
     return true;
 }
 
+bool MidiFileParser::openPreloaded(FatFile* file, const ParserPreload& preload) {
+    if (preload.numTracks == 0 || preload.numTracks > MAX_TRACKS) return false;
+
+    midiFile = file;
+    allTracksEnded = false;
+    skippedNotes = 0;
+    if (!container.open(file)) {
+        return false;
+    }
+
+    // Header, tempo and length as the original load found them
+    fileInfo = preload.fileInfo;
+    numTracks = preload.numTracks;
+    fileLengthTicks = preload.fileLengthTicks;
+    sysexCount = preload.sysexCount;
+
+    clearCheckpoints();
+    clearChase();
+    activeSequence = 0;
+    memset(sequenceLengthTicks, 0, sizeof(sequenceLengthTicks));
+    memset(sequenceTempo, 0, sizeof(sequenceTempo));
+
+    const uint8_t* head = preload.heads;
+    for (uint8_t i = 0; i < numTracks; i++) {
+        initTrack(i, preload.trackStartPos[i], preload.trackLength[i]);
+        if (preload.headSize[i] > 0) {
+            memcpy(tracks[i].buffer, head, preload.headSize[i]);
+            tracks[i].bufferSize = preload.headSize[i];
+            head += preload.headSize[i];
+        }
+    }
+
+    primeTracks();
+    return true;
+}
+
+uint16_t MidiFileParser::getPreloadHeadBytes() {
+    uint16_t total = 0;
+    for (uint8_t i = 0; i < numTracks; i++) {
+        // Only a buffer that still starts at the track start is a head
+        if (tracks[i].bufferFilePos != 0 || tracks[i].readFailed) continue;
+        total += (tracks[i].bufferSize < PRELOAD_HEAD_BYTES) ? tracks[i].bufferSize : PRELOAD_HEAD_BYTES;
+    }
+    return total;
+}
+
+bool MidiFileParser::capturePreload(ParserPreload& preload, uint8_t* heads) {
+    if (!midiFile || numTracks == 0 || isMultiSequence()) return false;
+
+    preload.fileInfo = fileInfo;
+    preload.fileLengthTicks = fileLengthTicks;
+    preload.sysexCount = sysexCount;
+    preload.numTracks = numTracks;
+    preload.heads = heads;
+
+    uint8_t* head = heads;
+    for (uint8_t i = 0; i < numTracks; i++) {
+        preload.trackStartPos[i] = tracks[i].trackStartPos;
+        preload.trackLength[i] = tracks[i].trackEndPos;
+        preload.headSize[i] = 0;
+        if (tracks[i].bufferFilePos != 0 || tracks[i].readFailed) continue;
+
+        uint16_t size = (tracks[i].bufferSize < PRELOAD_HEAD_BYTES) ? tracks[i].bufferSize : PRELOAD_HEAD_BYTES;
+        memcpy(head, tracks[i].buffer, size);
+        preload.headSize[i] = size;
+        head += size;
+    }
+    return true;
+}
+
 uint8_t MidiFileParser::read8() {
     uint8_t val = 0;
-    if (midiFile && midiFile->available()) {
-        midiFile->read(&val, 1);
+    if (midiFile && container.available()) {
+        container.read(&val, 1);
     }
     return val;
 }
@@ -117,7 +224,7 @@ bool MidiFileParser::readMidiHeader() {
 
     // Read "MThd"
     char header[4];
-    midiFile->read(header, 4);
+    container.read(header, 4);
     if (strncmp(header, "MThd", 4) != 0) {
         return false;
     }
@@ -151,7 +258,7 @@ bool MidiFileParser::initializeTracks() {
     for (uint8_t i = 0; i < numTracks; i++) {
         // Read "MTrk"
         char header[4];
-        midiFile->read(header, 4);
+        container.read(header, 4);
         if (strncmp(header, "MTrk", 4) != 0) {
             return false;
         }
@@ -159,39 +266,58 @@ bool MidiFileParser::initializeTracks() {
         // Read track length
         uint32_t trackLength = read32();
 
-        // Initialize track state
-        tracks[i].trackStartPos = midiFile->curPosition();
-        tracks[i].filePosition = 0; // Relative to track start
-        tracks[i].trackEndPos = trackLength;
-        tracks[i].currentTick = 0;
-        tracks[i].runningStatus = 0;
-        tracks[i].endOfTrack = false;
-        tracks[i].eventReady = false;
-        // nextEvent initialized by MidiEvent constructor
-
-        // Initialize buffer
-        tracks[i].bufferPos = 0;
-        tracks[i].bufferSize = 0;
-        tracks[i].bufferFilePos = 0;
+        initTrack(i, container.curPosition(), trackLength);
 
         // Skip to next track for now
-        if (!midiFile->seekSet(tracks[i].trackStartPos + trackLength)) {
+        if (!container.seekSet(tracks[i].trackStartPos + trackLength)) {
             // Seek failed - SD card error
             return false;
         }
     }
 
+    primeTracks();
+    return true;
+}
+
+void MidiFileParser::initTrack(uint8_t trackNum, uint32_t startPos, uint32_t length) {
+    TrackState* track = &tracks[trackNum];
+    track->trackStartPos = startPos;
+    track->filePosition = 0; // Relative to track start
+    track->trackEndPos = length;
+    track->currentTick = 0;
+    track->runningStatus = 0;
+    track->endOfTrack = false;
+    track->eventReady = false;
+    // nextEvent initialized by MidiEvent constructor
+
+    // Initialize buffer
+    track->bufferPos = 0;
+    track->bufferSize = 0;
+    track->bufferFilePos = 0;
+    track->readFailed = false;
+    track->deferred = false;
+    track->retryAtMicros = 0;
+    track->deferredSinceMs = 0;
+}
+
+void MidiFileParser::primeTracks() {
     // Now pre-read first event from each track
     for (uint8_t i = 0; i < numTracks; i++) {
-        // Fill initial buffer for this track
-        fillTrackBuffer(i);
+        // Fill initial buffer for this track (preloaded tracks already hold their head)
+        if (tracks[i].bufferSize == 0) {
+            fillTrackBuffer(i);
+        }
+
+        // Format 2: the other sequences keep their buffered start for a quick switch
+        if (isMultiSequence() && i != activeSequence) {
+            tracks[i].endOfTrack = true;
+            continue;
+        }
 
         if (readTrackEvent(i, tracks[i].nextEvent)) {
             tracks[i].eventReady = true;
         }
     }
-
-    return true;
 }
 
 bool MidiFileParser::readTrackEvent(uint8_t trackNum, MidiEvent& event) {
@@ -206,25 +332,86 @@ bool MidiFileParser::readTrackEvent(uint8_t trackNum, MidiEvent& event) {
         return false;
     }
 
-    // Read delta time using buffered read
-    event.deltaTime = readTrackVariableLength(trackNum);
-    track->currentTick += event.deltaTime;
-    event.absoluteTime = track->currentTick;
-    event.trackNumber = trackNum;
+    uint32_t startPosition = track->filePosition;
+    uint32_t startTick = track->currentTick;
+    uint8_t startRunningStatus = track->runningStatus;
 
-    // Read event type using buffered read
-    uint8_t statusByte = readTrackByte(trackNum);
+    bool ok = parseTrackEvent(trackNum, event);
 
-    // Handle running status
-    if (statusByte < 0x80) {
-        statusByte = track->runningStatus;
-        // Unread the byte
-        track->bufferPos--;
-        track->filePosition--;
-    } else {
-        track->runningStatus = statusByte;
+    if (track->readFailed) {
+        // The card failed mid-event - rewind and read the whole event again later.
+        // The other tracks keep playing from their buffers meanwhile.
+        track->filePosition = startPosition;
+        track->currentTick = startTick;
+        track->runningStatus = startRunningStatus;
+        track->bufferPos = 0;
+        track->bufferSize = 0;
+        track->endOfTrack = false;
+        track->readFailed = false;
+        track->deferred = true;
+        if (track->deferredSinceMs == 0) {
+            track->deferredSinceMs = millis() | 1;  // Never 0 while stalled
+        }
+        if (healthMonitor) {
+            healthMonitor->recordDeferral();
+        }
+        return false;
+    }
+
+    track->deferredSinceMs = 0;
+    track->eventStartPos = startPosition;
+    track->eventStartTick = startTick;
+    track->eventStartStatus = startRunningStatus;
+    return ok;
+}
+
+bool MidiFileParser::parseTrackEvent(uint8_t trackNum, MidiEvent& event) {
+    TrackState* track = &tracks[trackNum];
+
+    uint32_t startTick = track->currentTick;
+    uint32_t startBuffer = track->bufferFilePos;
+    bool silenced = (silencedTracks & (1 << trackNum)) != 0;
+    uint8_t statusByte;
+
+    for (;;) {
+        // Read delta time and event type using buffered reads
+        track->currentTick += readTrackVariableLength(trackNum);
+        statusByte = readTrackByte(trackNum);
+        if (track->readFailed) return false;
+
+        // Handle running status
+        if (statusByte < 0x80) {
+            statusByte = track->runningStatus;
+            // Unread the byte
+            track->bufferPos--;
+            track->filePosition--;
+        } else {
+            track->runningStatus = statusByte;
+        }
+
+        // Silenced track: step over note messages in place, only their delta
+        // time is kept. Stop once the buffer has been refilled (or would need
+        // to be) so one call never costs more than one SD read - a note read
+        // there is built as usual and dropped by readNextEvent().
+        uint8_t type = statusByte & 0xF0;
+        if (!silenced || (type != MIDI_NOTE_OFF && type != MIDI_NOTE_ON && type != MIDI_POLY_AFTERTOUCH) ||
+            track->bufferFilePos != startBuffer || track->bufferSize - track->bufferPos < 2) {
+            break;
+        }
+        track->bufferPos += 2;
+        track->filePosition += 2;
+        skippedNotes++;
+
+        if (track->filePosition >= track->trackEndPos) {
+            track->endOfTrack = true;  // Track data ran out without an End of Track
+            return false;
+        }
     }
 
+    event.deltaTime = track->currentTick - startTick;
+    event.absoluteTime = track->currentTick;
+    event.trackNumber = trackNum;
+
     event.type = statusByte & 0xF0;
     event.channel = statusByte & 0x0F;
     event.isMetaEvent = false;
@@ -342,26 +529,63 @@ bool MidiFileParser::readTrackEvent(uint8_t trackNum, MidiEvent& event) {
 bool MidiFileParser::readNextEvent(MidiEvent& event) {
     if (allTracksEnded) return false;
 
+    retryDeferredTracks();
+
+    // The event returned last has been consumed by now
+    if (unchasedType != 0) {
+        updateChase(unchasedType, unchasedChannel, unchasedData1, unchasedData2);
+        unchasedType = 0;
+    }
+
     // Find the track with the earliest next event
-    int8_t earliestTrack = -1;
-    uint32_t earliestTime = 0xFFFFFFFF;
+    int8_t earliestTrack;
+    uint32_t earliestTime;
+
+    for (;;) {
+        earliestTrack = -1;
+        earliestTime = 0xFFFFFFFF;
+
+        for (uint8_t i = 0; i < numTracks; i++) {
+            if (tracks[i].eventReady && !tracks[i].endOfTrack) {
+                if (tracks[i].nextEvent.absoluteTime < earliestTime) {
+                    earliestTime = tracks[i].nextEvent.absoluteTime;
+                    earliestTrack = i;
+                }
+            }
+        }
 
-    for (uint8_t i = 0; i < numTracks; i++) {
-        if (tracks[i].eventReady && !tracks[i].endOfTrack) {
-            if (tracks[i].nextEvent.absoluteTime < earliestTime) {
-                earliestTime = tracks[i].nextEvent.absoluteTime;
-                earliestTrack = i;
+        if (earliestTrack == -1) {
+            // A stalled track may still have events - only the end once it recovers or is given up
+            if (!isWaitingForCard()) {
+                allTracksEnded = true;
             }
+            return false;
         }
-    }
 
-    if (earliestTrack == -1) {
-        allTracksEnded = true;
-        return false;
+        // Everything before earliestTime has been returned - a clean point to restart from
+        if (checkpointSpacing != 0 && !isWaitingForCard() &&
+            (checkpointCount == 0 || earliestTime >= checkpoints[checkpointCount - 1].tick + checkpointSpacing)) {
+            captureCheckpoint(earliestTime);
+        }
+
+        // A note from a track silenced after it was read (or read at a buffer end) is dropped here
+        const MidiEvent& pending = tracks[earliestTrack].nextEvent;
+        if (!(silencedTracks & (1 << earliestTrack)) || pending.isMetaEvent ||
+            (pending.type != MIDI_NOTE_OFF && pending.type != MIDI_NOTE_ON && pending.type != MIDI_POLY_AFTERTOUCH)) {
+            break;
+        }
+        skippedNotes++;
+        tracks[earliestTrack].eventReady = readTrackEvent(earliestTrack, tracks[earliestTrack].nextEvent);
     }
 
     // Return the earliest event
     event = tracks[earliestTrack].nextEvent;
+    if (!event.isMetaEvent && event.type >= MIDI_NOTE_OFF && event.type < MIDI_SYSEX) {
+        unchasedType = event.type;
+        unchasedChannel = event.channel;
+        unchasedData1 = event.data1;
+        unchasedData2 = event.data2;
+    }
 
     // Read next event from that track (uses buffered reading, no seek needed!)
     if (readTrackEvent(earliestTrack, tracks[earliestTrack].nextEvent)) {
@@ -376,8 +600,13 @@ bool MidiFileParser::readNextEvent(MidiEvent& event) {
 bool MidiFileParser::reset() {
     if (!midiFile) return false;
 
+    // Format 2: only the selected sequence plays - rewind it alone
+    if (isMultiSequence()) {
+        return selectSequence(activeSequence);
+    }
+
     // Seek back to start and re-initialize
-    if (!midiFile->seekSet(0)) {
+    if (!container.seekSet(0)) {
         // Seek failed - SD card error
         return false;
     }
@@ -385,9 +614,214 @@ bool MidiFileParser::reset() {
     readMidiHeader();
     initializeTracks();
     allTracksEnded = false;
+    clearChase();  // Back at tick 0 - checkpoints stay valid for the same file
     return true;
 }
 
+// ============================================================================
+// CHECKPOINTS AND CHASE
+// ============================================================================
+
+void MidiFileParser::clearCheckpoints() {
+    checkpointCount = 0;
+    // Two bars of 4/4 at the start - coarser once the table fills
+    checkpointSpacing = (uint32_t)(fileInfo.ticksPerQuarter ? fileInfo.ticksPerQuarter : 96) * CHECKPOINT_SPACING_QUARTERS;
+}
+
+void MidiFileParser::clearChase() {
+    memset(chase.program, CHASE_NONE, sizeof(chase.program));
+    memset(chase.controller, CHASE_NONE, sizeof(chase.controller));
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        chase.pitchBend[ch] = CHASE_BEND_NONE;
+    }
+    unchasedType = 0;
+}
+
+void MidiFileParser::updateChase(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2) {
+    if (channel >= 16) return;
+
+    switch (type) {
+        case MIDI_PROGRAM_CHANGE:
+            chase.program[channel] = data1;
+            break;
+
+        case MIDI_PITCH_BEND:
+            chase.pitchBend[channel] = (uint16_t)((data2 << 7) | data1);
+            break;
+
+        case MIDI_CONTROL_CHANGE:
+            if (data1 == 121) {
+                // Reset All Controllers - the song set them back itself
+                memset(chase.controller[channel], CHASE_NONE, CHASE_CONTROLLER_COUNT);
+                chase.pitchBend[channel] = CHASE_BEND_NONE;
+                break;
+            }
+            for (uint8_t i = 0; i < CHASE_CONTROLLER_COUNT; i++) {
+                if (CHASE_CONTROLLERS[i] == data1) {
+                    chase.controller[channel][i] = data2;
+                    break;
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+const ChaseState& MidiFileParser::getChaseState() {
+    return chase;
+}
+
+void MidiFileParser::captureCheckpoint(uint32_t tick) {
+    if (checkpointCount == MAX_CHECKPOINTS) {
+        // Table full - keep every other checkpoint and space new ones twice as far apart
+        for (uint8_t i = 0; i < MAX_CHECKPOINTS / 2; i++) {
+            checkpoints[i] = checkpoints[i * 2];
+        }
+        checkpointCount = MAX_CHECKPOINTS / 2;
+        checkpointSpacing *= 2;
+        if (tick < checkpoints[checkpointCount - 1].tick + checkpointSpacing) return;
+    }
+
+    ParserCheckpoint& checkpoint = checkpoints[checkpointCount];
+    checkpoint.tick = tick;
+    checkpoint.tempo = fileInfo.tempo;
+    checkpoint.numerator = fileInfo.numerator;
+    checkpoint.denominator = fileInfo.denominator;
+    checkpoint.endedTracks = 0;
+    for (uint8_t i = 0; i < numTracks; i++) {
+        TrackState* track = &tracks[i];
+        if (!track->eventReady || track->endOfTrack) {
+            checkpoint.endedTracks |= (1 << i);
+            continue;
+        }
+        checkpoint.trackPosition[i] = track->eventStartPos;
+        checkpoint.trackTick[i] = track->eventStartTick;
+        checkpoint.runningStatus[i] = track->eventStartStatus;
+    }
+    checkpoint.chase = chase;
+    checkpointCount++;
+}
+
+bool MidiFileParser::restoreCheckpoint(const ParserCheckpoint& checkpoint) {
+    if (!midiFile) return false;
+
+    fileInfo.tempo = checkpoint.tempo;
+    fileInfo.numerator = checkpoint.numerator;
+    fileInfo.denominator = checkpoint.denominator;
+
+    for (uint8_t i = 0; i < numTracks; i++) {
+        TrackState* track = &tracks[i];
+        track->nextEvent = MidiEvent();  // Frees any SysEx data
+        track->eventReady = false;
+        track->readFailed = false;
+        track->deferred = false;
+        track->retryAtMicros = 0;
+        track->deferredSinceMs = 0;
+
+        if (checkpoint.endedTracks & (1 << i)) {
+            track->endOfTrack = true;
+            continue;  // Buffer left alone (a format 2 sequence keeps its start)
+        }
+        track->endOfTrack = false;
+        track->bufferPos = 0;
+        track->bufferSize = 0;
+        track->bufferFilePos = 0;
+        track->filePosition = checkpoint.trackPosition[i];
+        track->currentTick = checkpoint.trackTick[i];
+        track->runningStatus = checkpoint.runningStatus[i];
+    }
+
+    // Re-read each track's pending event, exactly as it stood at the checkpoint
+    for (uint8_t i = 0; i < numTracks; i++) {
+        if (tracks[i].endOfTrack) continue;
+        fillTrackBuffer(i);
+        tracks[i].eventReady = readTrackEvent(i, tracks[i].nextEvent);
+    }
+
+    allTracksEnded = false;
+    chase = checkpoint.chase;
+    unchasedType = 0;
+    return true;
+}
+
+int32_t MidiFileParser::getCheckpointTick(uint32_t tick) {
+    for (int8_t i = (int8_t)checkpointCount - 1; i >= 0; i--) {
+        if (checkpoints[i].tick <= tick) return (int32_t)checkpoints[i].tick;
+    }
+    return -1;
+}
+
+int32_t MidiFileParser::seekToCheckpoint(uint32_t tick) {
+    for (int8_t i = (int8_t)checkpointCount - 1; i >= 0; i--) {
+        if (checkpoints[i].tick <= tick) {
+            return restoreCheckpoint(checkpoints[i]) ? (int32_t)checkpoints[i].tick : -1;
+        }
+    }
+    return reset() ? 0 : -1;
+}
+
+// ============================================================================
+// FORMAT 2 SEQUENCES
+// ============================================================================
+
+bool MidiFileParser::selectSequence(uint8_t index) {
+    if (!midiFile || !isMultiSequence() || index >= numTracks) return false;
+
+    // Checkpoints and chase describe the sequence they were taken in
+    if (index != activeSequence) {
+        activeSequence = index;
+        clearCheckpoints();
+    }
+    clearChase();
+
+    for (uint8_t i = 0; i < numTracks; i++) {
+        TrackState* track = &tracks[i];
+        track->nextEvent = MidiEvent();  // Frees any SysEx data
+        track->eventReady = false;
+        track->endOfTrack = (i != index);
+        track->currentTick = 0;
+        track->readFailed = false;
+        track->deferred = false;
+        track->retryAtMicros = 0;
+        track->deferredSinceMs = 0;
+    }
+
+    // Each sequence starts with its own tempo and meter
+    fileInfo.tempo = sequenceTempo[index] ? sequenceTempo[index] : 500000;
+    fileInfo.numerator = 4;
+    fileInfo.denominator = 4;
+    if (sequenceLengthTicks[index] != 0) {
+        fileLengthTicks = sequenceLengthTicks[index];
+    }
+
+    TrackState* track = &tracks[index];
+    track->filePosition = 0;
+    track->runningStatus = 0;
+    allTracksEnded = false;
+
+    if (track->bufferFilePos == 0 && track->bufferSize > 0) {
+        // The start of the sequence is still buffered - no SD read
+        track->bufferPos = 0;
+    } else {
+        track->bufferPos = 0;
+        track->bufferSize = 0;
+        if (!fillTrackBuffer(index)) return false;
+    }
+
+    track->eventReady = readTrackEvent(index, track->nextEvent);
+    return true;
+}
+
+uint32_t MidiFileParser::getSequenceLengthTicks(uint8_t index) {
+    return (index < MAX_TRACKS) ? sequenceLengthTicks[index] : 0;
+}
+
+uint32_t MidiFileParser::getSequenceTempo(uint8_t index) {
+    return (index < MAX_TRACKS && sequenceTempo[index]) ? sequenceTempo[index] : 500000;
+}
+
 uint32_t MidiFileParser::getTotalTicks() {
     // Return the maximum tick from all tracks
     uint32_t maxTick = 0;
@@ -403,44 +837,157 @@ bool MidiFileParser::isEndOfFile() {
     return allTracksEnded;
 }
 
+// True while a track waits out the backoff after a failed read (retryAtMicros 0 = no error)
+bool MidiFileParser::isBackingOff(const TrackState* track) {
+    return track->retryAtMicros != 0 && (int32_t)(micros() - track->retryAtMicros) < 0;
+}
+
+bool MidiFileParser::isWaitingForCard() {
+    for (uint8_t i = 0; i < numTracks; i++) {
+        if (tracks[i].deferred && !tracks[i].endOfTrack) return true;
+    }
+    return false;
+}
+
+// Retry tracks whose next event hit an SD error, once their backoff has passed.
+// A recovered event is late; the player's catch-up policy decides how it goes out.
+void MidiFileParser::retryDeferredTracks() {
+    for (uint8_t i = 0; i < numTracks; i++) {
+        TrackState* track = &tracks[i];
+        if (!track->deferred || track->endOfTrack) continue;
+        if (isBackingOff(track)) continue;
+
+        track->deferred = false;
+        track->eventReady = readTrackEvent(i, track->nextEvent);
+
+        if (track->deferred && millis() - track->deferredSinceMs > SD_READ_GIVE_UP_MS) {
+            // Card never came back for this track - end it rather than stall the song
+            track->deferred = false;
+            track->endOfTrack = true;
+            track->eventReady = false;
+            if (healthMonitor) {
+                healthMonitor->recordLostTrack();
+            }
+        }
+    }
+}
+
 // Buffered reading functions to minimize SD card seeks
+// Unread bytes are kept and moved to the front, so the same call serves both
+// the refill of an empty buffer and a prefetch top-up of a partly used one.
 bool MidiFileParser::fillTrackBuffer(uint8_t trackNum) {
     if (trackNum >= numTracks) return false;
 
     TrackState* track = &tracks[trackNum];
 
-    // Calculate how much we can read
-    uint32_t absoluteFilePos = track->trackStartPos + track->filePosition;
-    uint32_t trackBytesLeft = track->trackEndPos - track->filePosition;
+    uint16_t remaining = (track->bufferPos < track->bufferSize) ? (track->bufferSize - track->bufferPos) : 0;
+    if (remaining > 0 && track->bufferPos > 0) {
+        memmove(track->buffer, track->buffer + track->bufferPos, remaining);
+    }
+    track->bufferSize = remaining;
+    track->bufferPos = 0;
+    track->bufferFilePos = track->filePosition;
 
-    if (trackBytesLeft == 0) {
-        track->bufferSize = 0;
-        return false;
+    // Calculate how much we can read
+    uint32_t readPos = track->filePosition + remaining;
+    uint32_t absoluteFilePos = track->trackStartPos + readPos;
+    uint32_t trackBytesLeft = (track->trackEndPos > readPos) ? (track->trackEndPos - readPos) : 0;
+    uint16_t space = TRACK_BUFFER_SIZE - remaining;
+
+    // Nothing left, or the track claims more data than the file holds (truncated file)
+    if (trackBytesLeft == 0 || space == 0 || absoluteFilePos >= container.fileSize()) {
+        return (track->bufferSize > 0);
     }
 
-    // Seek to position and read a chunk
-    if (!midiFile->seekSet(absoluteFilePos)) {
-        // Seek failed - SD card error
-        track->bufferSize = 0;
-        return false;
+    uint16_t bytesToRead = (trackBytesLeft > space) ? space : trackBytesLeft;
+
+    // Compressed songs: stop at the block boundary so a refill decodes one block
+    uint32_t contiguous = container.contiguousBytes(absoluteFilePos);
+    if (bytesToRead > contiguous) bytesToRead = contiguous;
+
+    // A prefetch still has data to play - try once and come back later on failure.
+    // An empty buffer stops the track, so retry now with a short backoff.
+    uint8_t attempts = (remaining > 0) ? 1 : SD_READ_RETRIES;
+    uint32_t backoffMicros = SD_RETRY_BACKOFF_MICROS;
+
+    for (uint8_t attempt = 0; attempt < attempts; attempt++) {
+        if (attempt > 0) {
+            delayMicroseconds(backoffMicros);
+            backoffMicros <<= 1;
+        }
+
+        unsigned long readStart = micros();
+
+        // Seek to position and read a chunk
+        int bytesRead = -1;
+        if (container.seekSet(absoluteFilePos)) {
+            bytesRead = container.read(track->buffer + remaining, bytesToRead);
+        }
+
+        if (bytesRead >= 0) {
+            if (healthMonitor) {
+                healthMonitor->recordRead(micros() - readStart, bytesRead);
+                if (attempt > 0) healthMonitor->recordRecovery();
+            }
+            track->bufferSize += bytesRead;
+            track->retryAtMicros = 0;
+            return (track->bufferSize > 0);
+        }
+
+        // Seek or read failed - SD card error
+        if (healthMonitor) {
+            healthMonitor->recordReadError();
+        }
     }
 
-    uint16_t bytesToRead = (trackBytesLeft > TRACK_BUFFER_SIZE) ? TRACK_BUFFER_SIZE : trackBytesLeft;
-    track->bufferSize = midiFile->read(track->buffer, bytesToRead);
-    track->bufferPos = 0;
-    track->bufferFilePos = track->filePosition;
+    track->retryAtMicros = (micros() + SD_DEFER_BACKOFF_MICROS) | 1;  // Never 0 while backing off
+    if (remaining == 0) {
+        // Bytes handed out from here on would be garbage
+        track->readFailed = true;
+        if (healthMonitor) {
+            healthMonitor->requestReinit();
+        }
+    }
 
     return (track->bufferSize > 0);
 }
 
+// Top up the emptiest track that has dropped below the prefetch threshold.
+// One read per call keeps the time spent between events bounded.
+bool MidiFileParser::prefetch() {
+    if (!midiFile || !healthMonitor) return false;
+
+    // Deep enough to cover the worst stall this card has shown so far
+    prefetchThreshold = healthMonitor->getRecommendedPrefetchBytes(TRACK_BUFFER_SIZE);
+
+    int8_t emptiest = -1;
+    uint16_t fewest = prefetchThreshold;
+    for (uint8_t i = 0; i < numTracks; i++) {
+        TrackState* track = &tracks[i];
+        if (track->endOfTrack) continue;
+        if (isBackingOff(track)) continue;  // Recent read error
+
+        uint16_t buffered = (track->bufferPos < track->bufferSize) ? (track->bufferSize - track->bufferPos) : 0;
+        if (track->filePosition + buffered >= track->trackEndPos) continue;  // Rest of the track is already in memory
+
+        if (buffered < fewest) {
+            fewest = buffered;
+            emptiest = i;
+        }
+    }
+
+    if (emptiest < 0) return false;
+    return fillTrackBuffer(emptiest);
+}
+
 uint8_t MidiFileParser::readTrackByte(uint8_t trackNum) {
     if (trackNum >= numTracks) return 0;
 
     TrackState* track = &tracks[trackNum];
 
-    // Check if we need to refill buffer
+    // Check if we need to refill buffer (not again once a refill has failed)
     if (track->bufferPos >= track->bufferSize) {
-        if (!fillTrackBuffer(trackNum)) {
+        if (track->readFailed || !fillTrackBuffer(trackNum)) {
             return 0; // End of track
         }
     }
@@ -474,67 +1021,69 @@ void MidiFileParser::scanForInitialTempo() {
 
     bool foundTempo = false;
 
-    // Only scan track 0 - simpler and faster
-    // Reset track 0 to start
-    tracks[0].filePosition = 0;
-    tracks[0].currentTick = 0;
-    tracks[0].bufferPos = 0;
-    tracks[0].bufferSize = 0;
-    tracks[0].endOfTrack = false;
-    tracks[0].runningStatus = 0;
+    // Only scan track 0 - simpler and faster (format 2: the selected sequence)
+    uint8_t t = isMultiSequence() ? activeSequence : 0;
+
+    // Reset the track to start
+    tracks[t].filePosition = 0;
+    tracks[t].currentTick = 0;
+    tracks[t].bufferPos = 0;
+    tracks[t].bufferSize = 0;
+    tracks[t].endOfTrack = false;
+    tracks[t].runningStatus = 0;
 
     // Fill buffer
-    if (fillTrackBuffer(0)) {
+    if (fillTrackBuffer(t)) {
         // Manually parse events without creating MidiEvent objects (avoids heap allocations)
         for (uint8_t i = 0; i < 100; i++) {
             // Check if we've reached the end of track data
-            if (tracks[0].filePosition >= (tracks[0].trackEndPos - tracks[0].trackStartPos)) {
+            if (tracks[t].filePosition >= tracks[t].trackEndPos) {
                 break;
             }
 
-            // Read delta time
-            uint32_t deltaTime = readTrackVariableLength(0);
+            // Skip delta time
+            readTrackVariableLength(t);
 
             // Read status byte
-            uint8_t status = readTrackByte(0);
+            uint8_t status = readTrackByte(t);
 
             // Handle running status
             if (status < 0x80) {
                 // Check if this is actually a failed read vs. running status
-                if (status == 0 && tracks[0].bufferSize == 0) {
+                if (status == 0 && tracks[t].bufferSize == 0) {
                     break;  // No more data
                 }
                 // This is a data byte, use running status
-                status = tracks[0].runningStatus;
+                status = tracks[t].runningStatus;
 
                 // Put the data byte back by rewinding file position
-                if (tracks[0].filePosition > 0) {
-                    tracks[0].filePosition--;
+                if (tracks[t].filePosition > 0) {
+                    tracks[t].filePosition--;
                     // Also rewind buffer position if possible
-                    if (tracks[0].bufferPos > 0) {
-                        tracks[0].bufferPos--;
+                    if (tracks[t].bufferPos > 0) {
+                        tracks[t].bufferPos--;
                     } else {
                         // At start of buffer, need to invalidate buffer to force refill
-                        tracks[0].bufferSize = 0;
+                        tracks[t].bufferSize = 0;
                     }
                 }
             } else {
                 // Update running status (but not for meta/sysex)
                 if (status < 0xF0) {
-                    tracks[0].runningStatus = status;
+                    tracks[t].runningStatus = status;
                 }
             }
 
             // Check if this is a meta event (0xFF)
             if (status == 0xFF) {
-                uint8_t metaType = readTrackByte(0);
-                uint32_t length = readTrackVariableLength(0);
+                uint8_t metaType = readTrackByte(t);
+                uint32_t length = readTrackVariableLength(t);
 
                 // Check if it's a tempo event
                 if (metaType == META_TEMPO && length == 3) {
-                    uint32_t tempo = readTrackByte(0) << 16;
-                    tempo |= readTrackByte(0) << 8;
-                    tempo |= readTrackByte(0);
+                    uint32_t tempo = readTrackByte(t) << 16;
+                    tempo |= readTrackByte(t) << 8;
+                    tempo |= readTrackByte(t);
 
                     // Validate tempo is in reasonable range
                     if (tempo >= 100000 && tempo <= 10000000) {
@@ -545,14 +1094,14 @@ void MidiFileParser::scanForInitialTempo() {
                 } else {
                     // Skip other meta events
                     for (uint32_t j = 0; j < length; j++) {
-                        readTrackByte(0);
+                        readTrackByte(t);
                     }
                 }
             } else if (status == 0xF0 || status == 0xF7) {
                 // SysEx event - skip it without allocating memory
-                uint32_t length = readTrackVariableLength(0);
+                uint32_t length = readTrackVariableLength(t);
                 for (uint32_t j = 0; j < length; j++) {
-                    readTrackByte(0);
+                    readTrackByte(t);
                 }
             } else {
                 // Regular MIDI event - skip data bytes
@@ -568,12 +1117,12 @@ void MidiFileParser::scanForInitialTempo() {
 
                 // Skip data bytes
                 for (uint8_t j = 0; j < dataBytes; j++) {
-                    readTrackByte(0);
+                    readTrackByte(t);
                 }
             }
 
             // Check if we've reached end of track
-            if (tracks[0].endOfTrack) {
+            if (tracks[t].endOfTrack) {
                 break;
             }
         }
@@ -585,7 +1134,7 @@ void MidiFileParser::scanForInitialTempo() {
 
     // Re-initialize all tracks to restore proper state
     // This is much safer than trying to save/restore track buffers
-    if (!midiFile->seekSet(0)) {
+    if (!container.seekSet(0)) {
         return;  // Seek failed
     }
     readMidiHeader();
@@ -617,11 +1166,12 @@ void MidiFileParser::calculateFileLength() {
 
         // Track absolute time without creating MidiEvent objects
         uint32_t absoluteTime = 0;
+        sequenceTempo[i] = 0;  // First valid tempo of this track (format 2 sequences)
 
         // Read through all events manually
         while (!tracks[i].endOfTrack) {
             // Check if we've reached the end of track data
-            if (tracks[i].filePosition >= (tracks[i].trackEndPos - tracks[i].trackStartPos)) {
+            if (tracks[i].filePosition >= tracks[i].trackEndPos) {
                 break;
             }
 
@@ -640,15 +1190,12 @@ void MidiFileParser::calculateFileLength() {
             uint8_t status = readTrackByte(i);
 
             // Handle running status
-            bool isRunningStatus = false;
             if (status < 0x80) {
                 // Check if this is actually a failed read (0 with empty buffer) vs. running status
                 if (status == 0 && tracks[i].bufferSize == 0) {
                     break;  // No more data
                 }
                 // This is a data byte, use running status
-                isRunningStatus = true;
-                uint8_t dataByte = status;  // Save the data byte
                 status = tracks[i].runningStatus;
 
                 // Put the data byte back by rewinding file position
@@ -681,6 +1228,16 @@ void MidiFileParser::calculateFileLength() {
                     break;
                 }
 
+                if (metaType == META_TEMPO && length == 3 && sequenceTempo[i] == 0) {
+                    uint32_t tempo = readTrackByte(i) << 16;
+                    tempo |= readTrackByte(i) << 8;
+                    tempo |= readTrackByte(i);
+                    if (tempo >= 100000 && tempo <= 10000000) {
+                        sequenceTempo[i] = tempo;
+                    }
+                    continue;
+                }
+
                 // Skip meta data
                 for (uint32_t j = 0; j < length; j++) {
                     readTrackByte(i);
@@ -712,6 +1269,7 @@ void MidiFileParser::calculateFileLength() {
         }
 
         // Update max length
+        sequenceLengthTicks[i] = absoluteTime;
         if (absoluteTime > fileLengthTicks) {
             fileLengthTicks = absoluteTime;
         }
@@ -725,8 +1283,13 @@ void MidiFileParser::calculateFileLength() {
         tracks[i].bufferSize = 0;
     }
 
+    // Format 2 plays one sequence at a time - its length is the song length
+    if (isMultiSequence()) {
+        fileLengthTicks = sequenceLengthTicks[activeSequence];
+    }
+
     // Re-initialize all tracks to ensure clean state
-    if (midiFile->seekSet(0)) {
+    if (container.seekSet(0)) {
         readMidiHeader();
         initializeTracks();
     }
@@ -1,5 +1,7 @@
 #include "MidiInput.h"
 #include "pins.h"
+#include "RAII.h"
+#include <pico/time.h>
 
 // Use the same MIDI instance as MidiOutput (declared in MidiOutput.cpp)
 extern MIDI_NAMESPACE::MidiInterface<MIDI_NAMESPACE::SerialMIDI<HardwareSerial>> MIDI;
@@ -11,6 +13,18 @@ MidiInput::MidiInput(MidiOutput* output) {
     keyboardEnabled = false;
     keyboardChannel = 1;  // Default to channel 1
     keyboardVelocity = 50;  // Default to 50 (normal velocity)
+
+    player = nullptr;
+    playerMutex = nullptr;
+    remoteEnabled = true;
+    remoteMappingCount = 0;
+    pendingSongStep = 0;
+    pendingSongStepMicros = 0;
+    tempoChanged = false;
+    sceneChanged = false;
+    lastRemoteLatencyMicros = 0;
+    maxRemoteLatencyMicros = 0;
+    remoteCommandCount = 0;
 }
 
 void MidiInput::begin() {
@@ -21,11 +35,17 @@ void MidiInput::begin() {
 void MidiInput::update() {
     // Read and process MIDI messages
     if (midiIn->read()) {
+        uint32_t readMicros = time_us_32();
         midi::MidiType type = midiIn->getType();
         byte channel = midiIn->getChannel();
         byte data1 = midiIn->getData1();
         byte data2 = midiIn->getData2();
 
+        // Remote control mappings take priority - matched messages are consumed
+        if (remoteMappingCount > 0 && handleRemoteControl(type, channel, data1, data2, readMicros)) {
+            return;
+        }
+
         // Handle based on mode
         if (thruEnabled) {
             // MIDI Thru mode - pass everything through
@@ -95,3 +115,167 @@ void MidiInput::update() {
         }
     }
 }
+
+void MidiInput::setRemoteTarget(MidiPlayer* targetPlayer, mutex_t* targetMutex) {
+    player = targetPlayer;
+    playerMutex = targetMutex;
+}
+
+void MidiInput::clearRemoteMappings() {
+    remoteMappingCount = 0;
+}
+
+bool MidiInput::addRemoteMapping(uint8_t trigger, uint8_t channel, uint8_t number, uint8_t action, int16_t param) {
+    if (remoteMappingCount >= MAX_REMOTE_MAPPINGS) return false;
+    if (channel > 16 || number > 127 || action == REMOTE_ACTION_NONE) return false;
+
+    // Fill the entry before publishing it - Core 1 may be scanning the table
+    RemoteMapping& mapping = remoteMappings[remoteMappingCount];
+    mapping.trigger = trigger;
+    mapping.channel = channel;
+    mapping.number = number;
+    mapping.action = action;
+    mapping.param = param;
+    mapping.latched = false;
+    remoteMappingCount = remoteMappingCount + 1;
+    return true;
+}
+
+bool MidiInput::handleRemoteControl(midi::MidiType type, byte channel, byte data1, byte data2, uint32_t readMicros) {
+    bool consumed = false;
+
+    // Several mappings may share one message (e.g. one pedal muting two channels)
+    for (uint8_t i = 0; i < remoteMappingCount; i++) {
+        RemoteMapping& mapping = remoteMappings[i];
+        if (mapping.channel != 0 && mapping.channel != channel) continue;
+        if (mapping.number != data1) continue;
+
+        switch (mapping.trigger) {
+            case REMOTE_TRIGGER_NOTE:
+                if (type == midi::NoteOn || type == midi::NoteOff) {
+                    consumed = true;
+                    if (type == midi::NoteOn && data2 > 0) {
+                        applyRemoteAction(mapping, readMicros);
+                    }
+                }
+                break;
+
+            case REMOTE_TRIGGER_CC:
+                if (type == midi::ControlChange) {
+                    consumed = true;
+                    // Fire on the press edge only - footswitches send 127 then 0
+                    bool pressed = (data2 >= 64);
+                    if (pressed && !mapping.latched) {
+                        applyRemoteAction(mapping, readMicros);
+                    }
+                    mapping.latched = pressed;
+                }
+                break;
+
+            case REMOTE_TRIGGER_PROGRAM:
+                if (type == midi::ProgramChange) {
+                    consumed = true;
+                    applyRemoteAction(mapping, readMicros);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return consumed;
+}
+
+void MidiInput::applyRemoteAction(const RemoteMapping& mapping, uint32_t readMicros) {
+    if (!remoteEnabled) return;
+
+    // Song changes need the file browser and settings loader on Core 0
+    if (mapping.action == REMOTE_ACTION_NEXT || mapping.action == REMOTE_ACTION_PREV) {
+        pendingSongStepMicros = readMicros;
+        pendingSongStep = (mapping.action == REMOTE_ACTION_NEXT) ? 1 : -1;
+        return;
+    }
+
+    if (!player || !playerMutex) return;
+
+    // Everything else is applied right here on Core 1, between scheduler updates.
+    // Checked again under the mutex: Core 0 turns remote control off and then
+    // takes the mutex, so nothing it waited out slips in afterwards
+    {
+        ScopedMutex lock(playerMutex);
+        if (!remoteEnabled) return;
+
+        switch (mapping.action) {
+            case REMOTE_ACTION_PLAY_PAUSE:
+                if (player->getState() == STATE_PLAYING) {
+                    player->pause();
+                } else if (player->isLoaded()) {
+                    player->play();
+                }
+                break;
+
+            case REMOTE_ACTION_STOP:
+                player->stop();
+                break;
+
+            case REMOTE_ACTION_MUTE:
+                if (mapping.param >= 1 && mapping.param <= 16) {
+                    player->toggleMuteChannel(mapping.param - 1);
+                }
+                break;
+
+            case REMOTE_ACTION_TEMPO:
+                {
+                    // setTempoPercent() clamps to 50.0% - 200.0%
+                    int32_t percent = static_cast<int32_t>(player->getTempoPercent()) + mapping.param;
+                    if (percent < 0) percent = 0;
+                    player->setTempoPercent(static_cast<uint16_t>(percent));
+                    tempoChanged = true;
+                }
+                break;
+
+            case REMOTE_ACTION_SCENE:
+                if (mapping.param >= 1 && mapping.param <= MAX_SCENES) {
+                    if (player->recallScene(mapping.param - 1)) {
+                        sceneChanged = true;
+                    }
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    recordRemoteLatency(time_us_32() - readMicros);
+}
+
+int8_t MidiInput::takeSongStepRequest(uint32_t& requestMicros) {
+    int8_t step = pendingSongStep;
+    if (step != 0) {
+        requestMicros = pendingSongStepMicros;
+        pendingSongStep = 0;
+    }
+    return step;
+}
+
+bool MidiInput::takeTempoChanged() {
+    if (!tempoChanged) return false;
+    tempoChanged = false;
+    return true;
+}
+
+bool MidiInput::takeSceneChanged() {
+    if (!sceneChanged) return false;
+    sceneChanged = false;
+    return true;
+}
+
+void MidiInput::recordRemoteLatency(uint32_t latencyMicros) {
+    lastRemoteLatencyMicros = latencyMicros;
+    if (latencyMicros > maxRemoteLatencyMicros) {
+        maxRemoteLatencyMicros = latencyMicros;
+    }
+    remoteCommandCount = remoteCommandCount + 1;
+}
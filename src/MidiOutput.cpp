@@ -1,13 +1,33 @@
 #include "MidiOutput.h"
 #include "pins.h"
+#include <atomic>
 
 MIDI_CREATE_INSTANCE(HardwareSerial, Serial1, MIDI);
 
+// Extra output ports are TX-only PIO UARTs
+static SerialPIO midiOutB(MIDI_OUT2_TX_PIN, SerialPIO::NOPIN);
+static SerialPIO midiOutC(MIDI_OUT3_TX_PIN, SerialPIO::NOPIN);
+static SerialPIO* const pioSerials[MIDI_OUT_PORT_COUNT - 1] = { &midiOutB, &midiOutC };
+
 MidiOutput::MidiOutput() {
     midi = &MIDI;
     noteOnCallback = nullptr;
     noteOffCallback = nullptr;
     controlChangeCallback = nullptr;
+    portLock = nullptr;
+    windowStartMs = 0;
+    submitHead = 0;
+    submitTail = 0;
+    submitDropped = 0;
+
+    for (uint8_t i = 0; i < MIDI_OUT_PORT_COUNT - 1; i++) {
+        pioPorts[i].serial = pioSerials[i];
+        pioPorts[i].head = 0;
+        pioPorts[i].tail = 0;
+        pioPorts[i].runningStatus = 0;
+    }
+    memset(stats, 0, sizeof(stats));
+    memset(windowBytes, 0, sizeof(windowBytes));
 }
 
 void MidiOutput::begin() {
@@ -18,100 +38,456 @@ void MidiOutput::begin() {
 
     midi->begin(MIDI_CHANNEL_OMNI);
     midi->turnThruOff();
+
+    portLock = spin_lock_init(spin_lock_claim_unused(true));
+    for (uint8_t i = 0; i < MIDI_OUT_PORT_COUNT - 1; i++) {
+        pioPorts[i].serial->begin(MIDI_BAUD_RATE);
+    }
+    windowStartMs = millis();
 }
 
-void MidiOutput::sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity) {
-    if (channel < 1 || channel > 16 || note > 127 || velocity > 127) return;
-    midi->sendNoteOn(note, velocity, channel);
+// ============================================================================
+// PIO PORT LAYER
+// Each extra port has its own byte queue and running-status state. Senders
+// only queue; pumpPorts() feeds the 8-deep PIO TX FIFO without blocking, so a
+// busy port never stalls the player or the other outputs.
+// ============================================================================
+
+bool MidiOutput::queueBytes(uint8_t port, const uint8_t* data, uint16_t length,
+                            uint8_t newRunningStatus, bool useRunningStatus) {
+    if (port == 0 || port >= MIDI_OUT_PORT_COUNT || !portLock) return false;
+    PioPort& p = pioPorts[port - 1];
+
+    uint32_t save = spin_lock_blocking(portLock);
 
-    // Notify note on callback for visualizer
-    if (noteOnCallback && velocity > 0) {
-        noteOnCallback(channel - 1, note, velocity); // Convert to 0-based channel
+    // Running status: omit the status byte when it repeats the previous one
+    if (useRunningStatus && length > 1 && data[0] == p.runningStatus) {
+        data++;
+        length--;
     }
+
+    uint16_t used = (p.head - p.tail) & (MIDI_PORT_TX_QUEUE_SIZE - 1);
+    if (used + length >= MIDI_PORT_TX_QUEUE_SIZE) {
+        // Never queue a partial message - drop it whole and let the receiver
+        // see the next complete one (status byte resent, as state is unknown)
+        p.runningStatus = 0;
+        stats[port].bytesDropped += length;
+        spin_unlock(portLock, save);
+        return false;
+    }
+
+    for (uint16_t i = 0; i < length; i++) {
+        p.queue[p.head] = data[i];
+        p.head = (p.head + 1) & (MIDI_PORT_TX_QUEUE_SIZE - 1);
+    }
+    if (newRunningStatus != 0xFF) {
+        p.runningStatus = newRunningStatus;
+    }
+
+    spin_unlock(portLock, save);
+
+    pumpPorts();
+    return true;
+}
+
+void MidiOutput::service() {
+    if (!portLock) return;
+    drainSubmissions();
+    pumpPorts();
 }
 
-void MidiOutput::sendNoteOff(uint8_t channel, uint8_t note, uint8_t velocity) {
-    if (channel < 1 || channel > 16 || note > 127 || velocity > 127) return;
-    midi->sendNoteOff(note, velocity, channel);
+void MidiOutput::pumpPorts() {
+    if (!portLock) return;
+
+    // Only Core 1 moves the port queues, so the PIO FIFO is fed with interrupts
+    // on; the lock is taken just to publish the counts Core 0 reads
+    uint32_t moved[MIDI_OUT_PORT_COUNT - 1];
+    for (uint8_t i = 0; i < MIDI_OUT_PORT_COUNT - 1; i++) {
+        PioPort& p = pioPorts[i];
+        moved[i] = 0;
+        int room = p.serial->availableForWrite();
+        while (room > 0 && p.tail != p.head) {
+            p.serial->write(p.queue[p.tail]);
+            p.tail = (p.tail + 1) & (MIDI_PORT_TX_QUEUE_SIZE - 1);
+            room--;
+            moved[i]++;
+        }
+    }
 
-    // Notify note off callback for visualizer
-    if (noteOffCallback) {
-        noteOffCallback(channel - 1, note); // Convert to 0-based channel
+    uint32_t save = spin_lock_blocking(portLock);
+    for (uint8_t i = 0; i < MIDI_OUT_PORT_COUNT - 1; i++) {
+        if (moved[i]) {
+            stats[i + 1].bytesSent += moved[i];
+            windowBytes[i + 1] += moved[i];
+        }
     }
+    updateUtilization();
+    spin_unlock(portLock, save);
+}
+
+uint16_t MidiOutput::portRoom(uint8_t port) {
+    if (port == 0 || port >= MIDI_OUT_PORT_COUNT || !portLock) return 0;
+    PioPort& p = pioPorts[port - 1];
+    uint32_t save = spin_lock_blocking(portLock);
+    uint16_t used = (p.head - p.tail) & (MIDI_PORT_TX_QUEUE_SIZE - 1);
+    spin_unlock(portLock, save);
+    return MIDI_PORT_TX_QUEUE_SIZE - 1 - used;
 }
 
-void MidiOutput::sendControlChange(uint8_t channel, uint8_t cc, uint8_t value) {
-    if (channel < 1 || channel > 16 || cc > 127 || value > 127) return;
-    midi->sendControlChange(cc, value, channel);
+void MidiOutput::countBytes(uint8_t port, uint32_t bytes) {
+    if (!portLock) return;
+    uint32_t save = spin_lock_blocking(portLock);
+    stats[port].bytesSent += bytes;
+    windowBytes[port] += bytes;
+    spin_unlock(portLock, save);
+}
+
+// Caller holds portLock
+void MidiOutput::updateUtilization() {
+    unsigned long now = millis();
+    unsigned long elapsed = now - windowStartMs;
+    if (elapsed < MIDI_PORT_STATS_WINDOW_MS) return;
+
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        uint32_t capacity = (uint32_t)MIDI_PORT_BYTES_PER_SEC * elapsed / 1000;
+        uint32_t percent = capacity ? (windowBytes[port] * 100) / capacity : 0;
+        if (percent > 100) percent = 100;
+        stats[port].utilizationPercent = (uint8_t)percent;
+        if (percent > stats[port].peakUtilizationPercent) {
+            stats[port].peakUtilizationPercent = (uint8_t)percent;
+        }
+        windowBytes[port] = 0;
+    }
+    windowStartMs = now;
+}
+
+MidiPortStats MidiOutput::getPortStats(uint8_t port) {
+    MidiPortStats result;
+    memset(&result, 0, sizeof(result));
+    if (port >= MIDI_OUT_PORT_COUNT || !portLock) return result;
+
+    uint32_t save = spin_lock_blocking(portLock);
+    result = stats[port];
+    spin_unlock(portLock, save);
+    return result;
+}
+
+void MidiOutput::sendChannelMessage(uint8_t port, uint8_t status, uint8_t data1, uint8_t data2, uint8_t length) {
+    uint8_t msg[3] = { status, data1, data2 };
+    queueBytes(port, msg, length, status, true);
+}
+
+// ============================================================================
+// SUBMISSION LAYER
+// Core 1 owns the wire. A send on Core 0 only copies the complete message into
+// submitQueue; Core 1 writes the queue out before any message of its own (and
+// from service()), so each core's messages keep their order and whole messages
+// are the unit on every port. A message for a full PIO port stays queued until
+// the port drains; only a full submission queue drops (and counts) messages.
+// ============================================================================
+
+// Channel message length by status nibble (0x8n-0xEn)
+static inline uint8_t channelMessageLength(uint8_t status) {
+    uint8_t type = status & 0xF0;
+    return (type == 0xC0 || type == 0xD0) ? 2 : 3;
+}
+
+bool MidiOutput::submit(uint8_t port, const uint8_t* header, uint8_t headerLength,
+                        const uint8_t* data, uint16_t length) {
+    uint16_t head = submitHead;
+    uint16_t used = (head - submitTail) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+    uint32_t needed = 1 + headerLength + length;
+    if (used + needed >= MIDI_SUBMIT_QUEUE_SIZE) {
+        // Writer is behind - drop the whole message rather than wait on it
+        countDropped(port, 1, headerLength + length);
+        return false;
+    }
+
+    submitQueue[head] = port;
+    head = (head + 1) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+    for (uint8_t i = 0; i < headerLength; i++) {
+        submitQueue[head] = header[i];
+        head = (head + 1) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        submitQueue[head] = data[i];
+        head = (head + 1) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+    }
+
+    // Publish the record only after it is fully written
+    std::atomic_thread_fence(std::memory_order_release);
+    submitHead = head;
+    return true;
+}
+
+// Core 0 only (submitDropped has a single writer)
+void MidiOutput::countDropped(uint8_t port, uint32_t messages, uint32_t bytes) {
+    submitDropped = submitDropped + messages;
+    if (portLock) {
+        uint32_t save = spin_lock_blocking(portLock);
+        stats[port].bytesDropped += bytes;
+        spin_unlock(portLock, save);
+    }
+}
+
+void MidiOutput::drainSubmissions() {
+    uint16_t tail = submitTail;
+    if (tail == submitHead) return;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    while (tail != submitHead) {
+        uint8_t port = submitQueue[tail];
+        uint8_t status = submitQueue[(tail + 1) & (MIDI_SUBMIT_QUEUE_SIZE - 1)];
+
+        // A full PIO port would drop the message - leave it queued until the port has room
+        if (status < 0xF0 && port != 0 && portRoom(port) < 3) {
+            pumpPorts();
+            if (portRoom(port) < 3) return;
+        }
+        tail = (tail + 2) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+
+        if (status == 0xF0) {
+            uint16_t length = submitQueue[tail] | (submitQueue[(tail + 1) & (MIDI_SUBMIT_QUEUE_SIZE - 1)] << 8);
+            tail = (tail + 2) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+            // The writers need the message in one piece - copy it out only if the record wraps
+            const uint8_t* data = &submitQueue[tail];
+            if (tail + length > MIDI_SUBMIT_QUEUE_SIZE) {
+                for (uint16_t i = 0; i < length; i++) {
+                    submitStaging[i] = submitQueue[(tail + i) & (MIDI_SUBMIT_QUEUE_SIZE - 1)];
+                }
+                data = submitStaging;
+            }
+            writeSysEx(data, length, port);
+            tail = (tail + length) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+        } else if (status >= 0xF8) {
+            writeRealTime(status);
+        } else {
+            uint8_t data1 = submitQueue[tail];
+            uint8_t data2 = 0;
+            tail = (tail + 1) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+            if (channelMessageLength(status) == 3) {
+                data2 = submitQueue[tail];
+                tail = (tail + 1) & (MIDI_SUBMIT_QUEUE_SIZE - 1);
+            }
+            writeChannelMessage(port, status, data1, data2);
+        }
 
-    // Notify control change callback for visualizer (CC7=Volume, CC11=Expression)
-    if (controlChangeCallback) {
-        controlChangeCallback(channel - 1, cc, value); // Convert to 0-based channel
+        // Free the space as each message goes out so Core 0 can keep submitting
+        std::atomic_thread_fence(std::memory_order_release);
+        submitTail = tail;
     }
 }
 
-void MidiOutput::sendProgramChange(uint8_t channel, uint8_t program) {
-    if (channel < 1 || channel > 16 || program > 127) {
+void MidiOutput::postChannelMessage(uint8_t port, uint8_t status, uint8_t data1, uint8_t data2) {
+    if (port >= MIDI_OUT_PORT_COUNT) return;
+    if (rp2040.cpuid() == 0) {
+        uint8_t msg[3] = { status, data1, data2 };
+        submit(port, msg, channelMessageLength(status), nullptr, 0);
         return;
     }
-    midi->sendProgramChange(program, channel);
+    drainSubmissions();
+    writeChannelMessage(port, status, data1, data2);
 }
 
-void MidiOutput::sendPitchBend(uint8_t channel, int16_t bend) {
-    if (channel < 1 || channel > 16) return;
-    midi->sendPitchBend(bend, channel);
+void MidiOutput::postSysEx(const uint8_t* data, uint16_t length, uint8_t port) {
+    if (port >= MIDI_OUT_PORT_COUNT || !data || length == 0) return;
+    if (rp2040.cpuid() == 0) {
+        uint8_t header[3] = { 0xF0, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8) };
+        submit(port, header, sizeof(header), data, length);
+        return;
+    }
+    drainSubmissions();
+    writeSysEx(data, length, port);
 }
 
-void MidiOutput::sendAfterTouch(uint8_t channel, uint8_t pressure) {
-    if (channel < 1 || channel > 16 || pressure > 127) return;
-    midi->sendAfterTouch(pressure, channel);
+void MidiOutput::postRealTime(uint8_t status) {
+    if (rp2040.cpuid() == 0) {
+        submit(0, &status, 1, nullptr, 0);
+        return;
+    }
+    drainSubmissions();
+    writeRealTime(status);
 }
 
-void MidiOutput::sendPolyAfterTouch(uint8_t channel, uint8_t note, uint8_t pressure) {
-    if (channel < 1 || channel > 16 || note > 127 || pressure > 127) return;
-    midi->sendAfterTouch(pressure, channel, note);
+// ============================================================================
+// WIRE WRITERS (Core 1)
+// ============================================================================
+
+void MidiOutput::writeChannelMessage(uint8_t port, uint8_t status, uint8_t data1, uint8_t data2) {
+    uint8_t type = status & 0xF0;
+    uint8_t channel = (status & 0x0F) + 1;
+    uint8_t length = channelMessageLength(status);
+
+    if (port == 0) {
+        switch (type) {
+            case 0x80: midi->sendNoteOff(data1, data2, channel); break;
+            case 0x90: midi->sendNoteOn(data1, data2, channel); break;
+            case 0xA0: midi->sendAfterTouch(data2, channel, data1); break;
+            case 0xB0: midi->sendControlChange(data1, data2, channel); break;
+            case 0xC0: midi->sendProgramChange(data1, channel); break;
+            case 0xD0: midi->sendAfterTouch(data1, channel); break;
+            case 0xE0: midi->sendPitchBend((int)((data2 << 7) | data1) - 8192, channel); break;
+        }
+        countBytes(0, length);
+    } else {
+        sendChannelMessage(port, status, data1, data2, length);
+    }
+
+    // Visualizer callbacks (0-based channel)
+    if (type == 0x90 && noteOnCallback && data2 > 0) {
+        noteOnCallback(channel - 1, data1, data2);
+    } else if (type == 0x80 && noteOffCallback) {
+        noteOffCallback(channel - 1, data1);
+    } else if (type == 0xB0 && controlChangeCallback) {
+        controlChangeCallback(channel - 1, data1, data2); // CC7=Volume, CC11=Expression
+    }
 }
 
-void MidiOutput::sendSysEx(const uint8_t* data, uint16_t length) {
-    midi->sendSysEx(length, data, true);
+void MidiOutput::writeSysEx(const uint8_t* data, uint16_t length, uint8_t port) {
+    if (port == 0) {
+        midi->sendSysEx(length, data, true);
+        countBytes(0, length);
+        return;
+    }
+
+    // SysEx can be longer than the port queue - feed it in chunks, waiting
+    // for the PIO to drain (the same wire-time cost Serial1 pays by blocking)
+    uint16_t offset = 0;
+    while (offset < length) {
+        uint16_t chunk = length - offset;
+        if (chunk > MIDI_PORT_TX_QUEUE_SIZE / 2) chunk = MIDI_PORT_TX_QUEUE_SIZE / 2;
+        // SysEx cancels running status; the 0 is stored once the first chunk is queued
+        while (!queueBytes(port, data + offset, chunk, 0, false)) {
+            pumpPorts();
+        }
+        offset += chunk;
+    }
 
     // NO delay - modern USB MIDI and software synths don't need it
     // The 5ms delay was still causing 80ms+ blocking when combined with USB buffering
     // If you have real MT-32 hardware and experience glitches, add back a 1-2ms delay
 }
 
+void MidiOutput::writeRealTime(uint8_t status) {
+    midi->sendRealTime((midi::MidiType)status);
+    countBytes(0, 1);
+
+    // Real-time bytes do not affect running status
+    for (uint8_t port = 1; port < MIDI_OUT_PORT_COUNT; port++) {
+        queueBytes(port, &status, 1, 0xFF, false);
+    }
+}
+
+// ============================================================================
+// PUBLIC SENDERS (either core)
+// ============================================================================
+
+void MidiOutput::sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port) {
+    postChannelMessage(port, 0x90 | (channel - 1), note, velocity);
+}
+
+void MidiOutput::sendNoteOff(uint8_t channel, uint8_t note, uint8_t velocity, uint8_t port) {
+    postChannelMessage(port, 0x80 | (channel - 1), note, velocity);
+}
+
+void MidiOutput::sendControlChange(uint8_t channel, uint8_t cc, uint8_t value, uint8_t port) {
+    postChannelMessage(port, 0xB0 | (channel - 1), cc, value);
+}
+
+void MidiOutput::sendProgramChange(uint8_t channel, uint8_t program, uint8_t port) {
+    postChannelMessage(port, 0xC0 | (channel - 1), program, 0);
+}
+
+void MidiOutput::sendPitchBend(uint8_t channel, int16_t bend, uint8_t port) {
+    uint16_t value = (uint16_t)(bend + 8192);
+    postChannelMessage(port, 0xE0 | (channel - 1), value & 0x7F, (value >> 7) & 0x7F);
+}
+
+void MidiOutput::sendAfterTouch(uint8_t channel, uint8_t pressure, uint8_t port) {
+    postChannelMessage(port, 0xD0 | (channel - 1), pressure, 0);
+}
+
+void MidiOutput::sendPolyAfterTouch(uint8_t channel, uint8_t note, uint8_t pressure, uint8_t port) {
+    postChannelMessage(port, 0xA0 | (channel - 1), note, pressure);
+}
+
+void MidiOutput::sendSysEx(const uint8_t* data, uint16_t length, uint8_t port) {
+    postSysEx(data, length, port);
+}
+
 void MidiOutput::sendClock() {
-    midi->sendRealTime(midi::Clock);
+    postRealTime(0xF8);
 }
 
 void MidiOutput::sendStart() {
-    midi->sendRealTime(midi::Start);
+    postRealTime(0xFA);
 }
 
 void MidiOutput::sendContinue() {
-    midi->sendRealTime(midi::Continue);
+    postRealTime(0xFB);
 }
 
 void MidiOutput::sendStop() {
-    midi->sendRealTime(midi::Stop);
+    postRealTime(0xFC);
 }
 
 void MidiOutput::allNotesOff() {
-    for (uint8_t ch = 1; ch <= 16; ch++) {
-        sendControlChange(ch, 123, 0); // All Notes Off
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        for (uint8_t ch = 1; ch <= 16; ch++) {
+            sendControlChange(ch, 123, 0, port); // All Notes Off
+        }
+    }
+}
+
+void MidiOutput::allSoundOff() {
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        for (uint8_t ch = 1; ch <= 16; ch++) {
+            sendControlChange(ch, 123, 0, port); // All Notes Off
+            sendControlChange(ch, 120, 0, port); // All Sound Off
+        }
     }
 }
 
 void MidiOutput::panic() {
-    for (uint8_t ch = 1; ch <= 16; ch++) {
-        sendControlChange(ch, 120, 0); // All Sound Off
-        sendControlChange(ch, 123, 0); // All Notes Off
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        bool stalled = false;
+        for (uint8_t ch = 1; ch <= 16 && !stalled; ch++) {
+            sendControlChange(ch, 120, 0, port); // All Sound Off
+            sendControlChange(ch, 123, 0, port); // All Notes Off
+
+            // Send note offs for all possible notes
+            for (uint8_t note = 0; note < 128; note++) {
+                sendNoteOff(ch, note, 0, port);
+                // Panic floods a PIO port faster than its queue drains - wait rather than drop
+                if ((note & 31) == 31 && !flushPort(port)) {
+                    // The writer is stuck - skip the rest of this port (2 CCs and
+                    // 128 note offs per channel) and count it as dropped
+                    uint32_t skipped = (127 - note) + (16 - ch) * 130;
+                    countDropped(port, skipped, skipped * 3);
+                    stalled = true;
+                    break;
+                }
+            }
+        }
+    }
+}
 
-        // Send note offs for all possible notes
-        for (uint8_t note = 0; note < 128; note++) {
-            sendNoteOff(ch, note, 0);
+bool MidiOutput::flushPort(uint8_t port) {
+    if (rp2040.cpuid() == 0) {
+        // Core 1 writes the queue out - wait for it (it services the queue even while
+        // this core holds playerMutex), but not forever if it never does
+        unsigned long start = millis();
+        while (submitTail != submitHead) {
+            if (millis() - start >= MIDI_FLUSH_TIMEOUT_MS) return false;
+            delayMicroseconds(10);
         }
+        return true;
+    }
+    if (port == 0 || port >= MIDI_OUT_PORT_COUNT) return true;
+    while (pioPorts[port - 1].tail != pioPorts[port - 1].head) {
+        pumpPorts();
     }
+    return true;
 }
 
 void MidiOutput::setNoteOnCallback(void (*callback)(uint8_t channel, uint8_t note, uint8_t velocity)) {
@@ -1,21 +1,71 @@
 #include "MidiPlayer.h"
+#include "MidiSinks.h"
+#include "SmfWriter.h"
+#include <pico/time.h>
 
-MidiPlayer::MidiPlayer(MidiOutput* output) {
+// Tap phase alignment bends the song clock by at most 1/PHASE_NUDGE_DIVISOR of real time
+static constexpr uint64_t PHASE_NUDGE_DIVISOR = 16;
+
+// Destinations in a mask that are on one output port
+static inline uint32_t destinationsOnPort(uint64_t destinations, uint8_t port) {
+    return __builtin_popcount(static_cast<uint32_t>((destinations >> (port * 16)) & 0xFFFF));
+}
+
+// Catch-up: an event more than this late when update() reaches it is stale
+static constexpr uint32_t CATCHUP_STALE_MS = 20;
+
+// Seeking: most events read silently per seek (~10 minutes of dense MIDI)
+static constexpr uint32_t MAX_EVENTS_PER_SEEK = 50000;
+
+// SD lookahead: track buffers are topped up only when the next event is further away than this
+static constexpr uint32_t PREFETCH_IDLE_MS = 5;
+
+// Fan-out bandwidth accounting: per-channel byte rates are sampled over this window,
+// and a port whose projected demand reaches FANOUT_WARN_PERCENT is flagged
+static constexpr uint64_t BANDWIDTH_WINDOW_MICROS = 1000000;
+static constexpr uint8_t FANOUT_WARN_PERCENT = 90;
+
+template <class Sink>
+MidiPlayerT<Sink>::MidiPlayerT(Sink* output) {
     midiOut = output;
     midiFile = nullptr;  // Initialize file pointer
     state = STATE_STOPPED;
     ticksElapsed = 0;
     lastUpdateMicros = 0;
+    tickAccumulator = 0;
+    tickRateScale = 0;
+    tickPeriodScaled = 0;
+    ticksPerQuarter = 0;
     tempoPercent = 100;
+    pendingPhaseMicros = 0;
+    stretchDebtMicros = 0;
+    wireIdleMicros = 0;
+    controlledDestMask = 0;
+    pendingTransport = TRANSPORT_NONE;
+    pendingSkipMs = 0;
+    transportRequestMicros = 0;
+    lastTransportLatencyMicros = 0;
+    maxTransportLatencyMicros = 0;
+    shuttling = false;
+    shuttleResume = false;
+    chasePending = false;
+    preloadedStart = false;
+    pendingLaunch = nullptr;
+    launchTicks = 0;
+    meterOriginTicks = 0;
+    launched = false;
+    lastLaunchErrorMicros = 0;
+    maxLaunchErrorMicros = 0;
     channelMutes = 0;
+    trackMutes = 0;
+    trackSolos = 0;
     velocityScale = 50; // Default: 50 = normal MIDI velocity
     eventReady = false;
     reachedEnd = false;
-    microsecondsPerTick = 0;
 
     // MIDI Clock and Transport
     clockEnabled = false;
-    lastClockMicros = 0;
+    clockPulsesSent = 0;
     lastTransportState = STATE_STOPPED;
 
     // SysEx Control
@@ -28,25 +78,61 @@ MidiPlayer::MidiPlayer(MidiOutput* output) {
         userChannelVolumes[i] = 255;  // 255 = use MIDI file, 0-127 = override
         userChannelPan[i] = 255;      // 255 = use MIDI file, 0-127 = override
         userChannelTranspose[i] = 0;  // 0 = no transpose, -24 to +24 = transpose in semitones
-        userChannelRouting[i] = 255;  // 255 = use original channel, 0-15 = route to that channel
+        userChannelRouting[i] = MIDI_ROUTE_ORIGINAL;  // 255 = use original channel, else (port << 4) | channel
+        userChannelLayers[i] = 0;     // No extra destinations
+        channelBytesWindow[i] = 0;
+        channelByteRate[i] = 0;
     }
+    loadWindowStartMicros = 0;
+    clearNoteTracking();
+    rebuildDestinations();
+    clearScenes();
+
+    catchUpPolicy = CATCHUP_SEND_ALL;
+    staleTicks = 0;
+    prefetchIdleTicks = 0;
+    resetCatchUpStats();
+    clearCollapsed();
 }
 
-MidiPlayer::~MidiPlayer() {
+template <class Sink>
+MidiPlayerT<Sink>::~MidiPlayerT() {
     unloadFile();
 }
 
-bool MidiPlayer::loadFile(FatFile* file) {
-    if (!file) return false;
-
+template <class Sink>
+void MidiPlayerT<Sink>::beginLoad(FatFile* file) {
     // Stop current playback
     stop();
 
     // Reset playback position for new file (in case stop() returned early)
     ticksElapsed = 0;
+    tickAccumulator = 0;
+    pendingPhaseMicros = 0;
+    stretchDebtMicros = 0;
+    controlledDestMask = 0;  // The load resets the device
+    clearCollapsed();  // Late controller values belong to the old position
+
+    resetCatchUpStats();
+
+    // Requests made for the previous song don't apply to this one
+    pendingTransport = TRANSPORT_NONE;
+    pendingSkipMs = 0;
+    shuttling = false;
+    chasePending = false;
+    preloadedStart = false;
+    pendingLaunch = nullptr;
+    launched = false;
+    meterOriginTicks = 0;
 
     // Store pointer to file (caller retains ownership)
     midiFile = file;
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::loadFile(FatFile* file) {
+    if (!file) return false;
+    beginLoad(file);
 
     // Open the parser
     if (!parser.open("", midiFile)) {
@@ -63,29 +149,200 @@ bool MidiPlayer::loadFile(FatFile* file) {
     return true;
 }
 
-void MidiPlayer::unloadFile() {
+template <class Sink>
+bool MidiPlayerT<Sink>::loadPreloaded(FatFile* file, const ParserPreload& preload) {
+    if (!file) return false;
+    beginLoad(file);
+
+    if (!parser.openPreloaded(midiFile, preload)) {
+        midiFile = nullptr;
+        return false;
+    }
+
+    // Nothing rescans this file after the load, so play() can start from here
+    // instead of rewinding (which would re-read every track start from the card)
+    eventReady = parser.readNextEvent(nextEvent);
+    preloadedStart = true;
+
+    return true;
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::loadPreview(FatFile* file) {
+    if (!loadFile(file)) return false;
+
+    // Nothing scans the file before play(), so it starts from the track heads just read
+    preloadedStart = true;
+    return true;
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::selectSequence(uint8_t index) {
+    if (!isLoaded() || !parser.isMultiSequence()) return false;
+
+    bool wasPlaying = (state == STATE_PLAYING);
+    stop(false);  // Notes off - the parser is rewound below, not reset
+    shuttling = false;
+
+    if (!parser.selectSequence(index)) {
+        return false;  // SD error - stays stopped
+    }
+    ticksElapsed = 0;
+    tickAccumulator = 0;
+    chasePending = false;
+    pendingPhaseMicros = 0;
+    stretchDebtMicros = 0;
+    reachedEnd = false;
+    clearCollapsed();
+    eventReady = parser.readNextEvent(nextEvent);
+    calculateTickRate();  // The sequence has its own tempo
+
+    if (wasPlaying) {
+        play();
+    }
+    return true;
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::queueLaunch(const SongLaunch* launch, LaunchQuantize quantize) {
+    if (!launch || !launch->file || state != STATE_PLAYING || quantize == LAUNCH_NOW || ticksPerQuarter == 0) {
+        return false;
+    }
+
+    uint32_t unit = ticksPerQuarter;
+    if (quantize == LAUNCH_BAR) {
+        MidiFileInfo info = parser.getFileInfo();
+        if (info.numerator > 0 && info.denominator > 0) {
+            unit = static_cast<uint32_t>(ticksPerQuarter) * 4 * info.numerator / info.denominator;
+        }
+        if (unit == 0) unit = ticksPerQuarter;
+    }
+
+    // Strictly after the current position - events on the current tick may be out already
+    uint32_t origin = (meterOriginTicks <= ticksElapsed) ? meterOriginTicks : 0;
+    launchTicks = origin + ((ticksElapsed - origin) / unit + 1) * unit;
+    pendingLaunch = launch;
+    launched = false;
+    return true;
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::takeLaunched() {
+    bool result = launched;
+    launched = false;
+    return result;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::launchSong(uint64_t boundaryMicros) {
+    const SongLaunch& launch = *pendingLaunch;
+    pendingLaunch = nullptr;
+    launched = true;
+
+    // Only what the old song holds or moved is reset: a blanket All Notes Off
+    // would put 48 bytes per port on the wire ahead of the new song's first beat
+    releaseHeldNotes();
+    resetSongControllers();
+    parser.close();
+
+    // Track silence first - the parser applies it while priming the tracks
+    trackMutes = launch.trackMutes;
+    trackSolos = launch.trackSolos;
+    applyTrackSilence();
+
+    midiFile = launch.file;
+    if (!parser.openPreloaded(midiFile, launch.preload)) {
+        midiFile = nullptr;
+        eventReady = false;
+        state = STATE_STOPPED;
+        if (clockEnabled) {
+            midiOut->sendStop();
+        }
+        return;
+    }
+
+    ticksElapsed = 0;
+    pendingPhaseMicros = 0;
+    stretchDebtMicros = 0;
+    meterOriginTicks = 0;
+    chasePending = false;
+    preloadedStart = false;
+    reachedEnd = false;
+    fallingBehind = false;
+    clearCollapsed();
+
+    setVelocityScale(launch.velocityScale);
+    sysexEnabled = launch.sysexEnabled;
+    applyChannelScene(launch.channels);
+    activeScene = -1;
+    tempoPercent = launch.tempoPercent;
+    tickPeriodScaled = 0;  // No fraction to carry over from the old song
+    calculateTickRate();
+
+    eventReady = parser.readNextEvent(nextEvent);
+
+    // Start takes the place of the boundary pulse; the next pulse is the new song's first
+    if (clockEnabled) {
+        midiOut->sendStart();
+    }
+    clockPulsesSent = 0;
+
+    uint64_t error = time_us_64() - boundaryMicros;
+    lastLaunchErrorMicros = error > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : static_cast<uint32_t>(error);
+    if (lastLaunchErrorMicros > maxLaunchErrorMicros) {
+        maxLaunchErrorMicros = lastLaunchErrorMicros;
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::unloadFile() {
     // Stop playback without resetting (skip wasted SD card I/O)
-    // NOTE: Caller should wait ~10ms after stop() before calling this
-    // to ensure Core 1 has exited update()
+    // NOTE: Caller must hold the player mutex, so Core 1 is not inside update()
     stop(false);
 
     // Close parser - this properly cleans up all track state including SysEx data
     parser.close();
+    preloadedStart = false;
     midiFile = nullptr;  // Clear pointer (caller owns the file, will close it)
 }
 
-void MidiPlayer::calculateMicrosecondsPerTick() {
+template <class Sink>
+void MidiPlayerT<Sink>::calculateTickRate() {
     MidiFileInfo info = parser.getFileInfo();
-    uint32_t tempo = info.tempo; // microseconds per quarter note
 
-    // Apply tempo adjustment (tenth-percent precision: 1000 = 100.0%)
-    // Use 64-bit arithmetic to prevent overflow (tempo can be up to 4 billion)
-    tempo = static_cast<uint32_t>((static_cast<uint64_t>(tempo) * 1000) / tempoPercent);
+    // Rate is kept as an exact ratio instead of a truncated microseconds-per-tick value
+    // ticks = microseconds * (tempoPercent * ticksPerQuarter) / (tempo * 1000)
+    // (tenth-percent precision: 1000 = 100.0%, tempo is microseconds per quarter note)
+    uint64_t newPeriod = static_cast<uint64_t>(info.tempo) * 1000;
+    uint64_t newScale = static_cast<uint64_t>(tempoPercent) * info.ticksPerQuarter;
 
-    microsecondsPerTick = tempo / info.ticksPerQuarter;
+    // Preserve the fraction of the current tick across tempo changes (16-bit fixed point)
+    if (tickPeriodScaled != 0 && newPeriod != 0) {
+        uint64_t fraction = (tickAccumulator << 16) / tickPeriodScaled;
+        tickAccumulator = (fraction * newPeriod) >> 16;
+    } else {
+        tickAccumulator = 0;
+    }
+
+    tickPeriodScaled = newPeriod;
+    tickRateScale = newScale;
+    ticksPerQuarter = info.ticksPerQuarter;
+    staleTicks = millisecondsToTicks(CATCHUP_STALE_MS);
+    prefetchIdleTicks = millisecondsToTicks(PREFETCH_IDLE_MS);
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::resyncClock() {
+    // Next clock pulse is the first one at or after the current song position
+    if (ticksPerQuarter == 0) {
+        clockPulsesSent = 0;
+        return;
+    }
+    clockPulsesSent = (static_cast<uint64_t>(ticksElapsed) * 24 + ticksPerQuarter - 1) / ticksPerQuarter;
 }
 
-void MidiPlayer::play() {
+template <class Sink>
+void MidiPlayerT<Sink>::play() {
     if (state == STATE_PLAYING) return;
 
     // Clear end flag when starting playback
@@ -93,14 +350,15 @@ void MidiPlayer::play() {
 
     // Always stop all notes before starting/resuming playback
     // This prevents hanging notes from previous playback
+    // (the song starts once they are on the wire, see resumeAfterCleanup)
     stopAllNotes();
 
-    // Small delay to ensure all MIDI messages are sent
-    delay(10);
-
     bool wasStoppedAtStart = (state == STATE_STOPPED && ticksElapsed == 0);
 
-    if (wasStoppedAtStart) {
+    if (wasStoppedAtStart && preloadedStart) {
+        // Setlist song or preview: already at the start with its track heads read
+        chasePending = false;
+    } else if (wasStoppedAtStart) {
         // Start from beginning only if we're at position 0
         if (!parser.reset()) {
             // Reset failed - SD card error
@@ -108,12 +366,16 @@ void MidiPlayer::play() {
             return;
         }
         eventReady = parser.readNextEvent(nextEvent);
+        chasePending = false;
+    } else if (chasePending) {
+        // Otherwise, resume from current position (ticksElapsed is preserved),
+        // restoring the controller state a seek skipped over
+        sendChase();
     }
-    // Otherwise, resume from current position (ticksElapsed is preserved)
+    preloadedStart = false;
 
     state = STATE_PLAYING;
-    lastUpdateMicros = micros();
-    lastClockMicros = micros();
+    resumeAfterCleanup();
 
     // Send MIDI Clock transport message
     if (clockEnabled) {
@@ -125,10 +387,12 @@ void MidiPlayer::play() {
     }
 }
 
-void MidiPlayer::pause() {
+template <class Sink>
+void MidiPlayerT<Sink>::pause() {
     if (state != STATE_PLAYING) return;
 
     state = STATE_PAUSED;
+    pendingLaunch = nullptr;
 
     // Send MIDI Clock stop message
     if (clockEnabled) {
@@ -137,15 +401,15 @@ void MidiPlayer::pause() {
 
     // Stop all playing notes to prevent stuck notes
     stopAllNotes();
-    // Small delay to ensure all MIDI messages are sent
-    delay(10);
     // ticksElapsed is preserved for resume
 }
 
-void MidiPlayer::stop(bool resetToBeginning) {
+template <class Sink>
+void MidiPlayerT<Sink>::stop(bool resetToBeginning) {
     if (state == STATE_STOPPED) return;
 
     state = STATE_STOPPED;
+    pendingLaunch = nullptr;
 
     // Send MIDI Clock stop message
     if (clockEnabled) {
@@ -155,91 +419,289 @@ void MidiPlayer::stop(bool resetToBeginning) {
     // Stop all playing notes
     stopAllNotes();
 
-    // Small delay to ensure all MIDI messages are sent
-    delay(10);
-
     // Only reset parser if requested (skip for unload to avoid wasted SD card I/O)
     if (resetToBeginning) {
         // Reset parser to beginning
         if (parser.reset()) {
             ticksElapsed = 0;  // Reset position when explicitly stopped
+            tickAccumulator = 0;
+            chasePending = false;
+            pendingPhaseMicros = 0;
+            stretchDebtMicros = 0;
+            meterOriginTicks = 0;
+            clearCollapsed();  // Late controller values belong to the old position
             eventReady = parser.readNextEvent(nextEvent);
         }
         // If reset fails, keep current position (SD card may have error)
     }
 }
 
-void MidiPlayer::stopAllNotes() {
+template <class Sink>
+void MidiPlayerT<Sink>::stopAllNotes() {
     if (!midiOut) return;
 
-    // Send All Notes Off (CC 123) to all 16 channels
+    // Send All Notes Off (CC 123) to all 16 channels on every output port
     // This is much faster than panic mode and sufficient for normal playback
-    for (uint8_t ch = 1; ch <= 16; ch++) {
-        midiOut->sendControlChange(ch, 123, 0); // All Notes Off
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        for (uint8_t ch = 1; ch <= 16; ch++) {
+            midiOut->sendControlChange(ch, 123, 0, port); // All Notes Off
+        }
+    }
+    clearNoteTracking();
+    reserveWireTime(16 * 3);
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::reserveWireTime(uint32_t bytesPerPort) {
+    // Ports transmit in parallel, so cleanup costs its per-port byte count in wire time
+    uint64_t now = time_us_64();
+    if (wireIdleMicros < now) wireIdleMicros = now;
+    wireIdleMicros += static_cast<uint64_t>(bytesPerPort) * 1000000 / MIDI_PORT_BYTES_PER_SEC;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::resumeAfterCleanup() {
+    // Start the song clock when the cleanup messages have been sent instead of
+    // sleeping: update() simply has nothing to do until lastUpdateMicros
+    uint64_t now = time_us_64();
+    lastUpdateMicros = (wireIdleMicros > now) ? wireIdleMicros : now;
+    resyncClock();
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::requestTransport(TransportCommand command, int32_t param) {
+    if (!isTransportPending()) {
+        transportRequestMicros = time_us_64();
+    }
+
+    if (command == TRANSPORT_SKIP) {
+        pendingSkipMs += param;
+    } else if (command != TRANSPORT_NONE) {
+        pendingTransport = command;
+        if (command == TRANSPORT_STOP) {
+            pendingSkipMs = 0; // Stop returns to the start anyway
+        }
     }
 }
 
-void MidiPlayer::resetMidiDevice() {
+template <class Sink>
+void MidiPlayerT<Sink>::serviceTransport() {
+    if (!isTransportPending()) return;
+
+    TransportCommand command = pendingTransport;
+    int32_t skipMs = pendingSkipMs;
+    pendingTransport = TRANSPORT_NONE;
+    pendingSkipMs = 0;
+
+    switch (command) {
+        case TRANSPORT_PLAY:
+            if (isLoaded()) play();
+            break;
+
+        case TRANSPORT_PAUSE:
+            pause();
+            break;
+
+        case TRANSPORT_STOP:
+            shuttling = false;
+            stop();
+            break;
+
+        case TRANSPORT_SHUTTLE_START:
+            if (!shuttling && isLoaded()) {
+                shuttling = true;
+                shuttleResume = (state == STATE_PLAYING);
+                pause();  // Silent while the position moves; skips below don't resume
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (skipMs > 0) {
+        fastForward(static_cast<uint32_t>(skipMs));
+    } else if (skipMs < 0) {
+        rewind(static_cast<uint32_t>(-skipMs));
+    }
+
+    // Shuttle end comes after the final skip so playback resumes at the landing point
+    if (command == TRANSPORT_SHUTTLE_END && shuttling) {
+        shuttling = false;
+        if (shuttleResume) {
+            play();  // Chases the controller state first
+        }
+    }
+
+    // Press-to-sound: silence starts with the first cleanup byte, playback when
+    // the song clock starts after the cleanup has been sent
+    uint64_t applied = time_us_64();
+    if (state == STATE_PLAYING && lastUpdateMicros > applied) {
+        applied = lastUpdateMicros;
+    }
+    uint64_t latency = applied - transportRequestMicros;
+    lastTransportLatencyMicros = latency > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : static_cast<uint32_t>(latency);
+    if (lastTransportLatencyMicros > maxTransportLatencyMicros) {
+        maxTransportLatencyMicros = lastTransportLatencyMicros;
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::resetMidiDevice() {
     if (!midiOut) return;
 
     // Comprehensive MIDI reset for switching between songs
     // This clears notes, controllers, and sound state
-    for (uint8_t ch = 1; ch <= 16; ch++) {
-        midiOut->sendControlChange(ch, 120, 0); // All Sound Off (immediate silence)
-        midiOut->sendControlChange(ch, 123, 0); // All Notes Off
-        midiOut->sendControlChange(ch, 121, 0); // Reset All Controllers
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        for (uint8_t ch = 1; ch <= 16; ch++) {
+            midiOut->sendControlChange(ch, 120, 0, port); // All Sound Off (immediate silence)
+            midiOut->sendControlChange(ch, 123, 0, port); // All Notes Off
+            midiOut->sendControlChange(ch, 121, 0, port); // Reset All Controllers
+        }
     }
+    clearNoteTracking();
 
-    // Small delay to ensure messages are processed
-    delay(10);
+    // A song started right after this waits until the reset is on the wire
+    reserveWireTime(16 * 9);
 }
 
-void MidiPlayer::update() {
+template <class Sink>
+void MidiPlayerT<Sink>::update() {
+    // Transport requests from Core 0 are applied here, between events
+    serviceTransport();
+
     if (state != STATE_PLAYING) return;
-    if (!eventReady) {
+    if (!eventReady && parser.isWaitingForCard()) {
+        // A track is riding out an SD error - keep the song clock running until it recovers
+        eventReady = parser.readNextEvent(nextEvent);
+    }
+    if (!eventReady && !parser.isWaitingForCard() && !pendingLaunch) {
         // End of file - set flag before stopping
+        // (with a launch queued the song clock runs on to the boundary instead)
         reachedEnd = true;
         stop();
         return;
     }
 
     // CRITICAL: Guard against division by zero if tempo not yet calculated
-    if (microsecondsPerTick == 0) return;
+    if (tickPeriodScaled == 0 || tickRateScale == 0) return;
+
+    uint64_t currentMicros = time_us_64();
+    if (currentMicros < lastUpdateMicros) return; // Cleanup from play()/seek still on the wire
+    uint64_t elapsedMicros = currentMicros - lastUpdateMicros;
+    lastUpdateMicros = currentMicros;
+    updateBandwidthWindow(currentMicros);
+
+    // Apply tap phase alignment and STRETCH debt gradually (~6% rate bend at
+    // most between them) so the song position moves continuously instead of jumping
+    if (pendingPhaseMicros != 0 || stretchDebtMicros != 0) {
+        int64_t budget = static_cast<int64_t>(elapsedMicros / PHASE_NUDGE_DIVISOR);
+        int64_t step = pendingPhaseMicros;
+        if (step > budget) step = budget;
+        if (step < -budget) step = -budget;
+        pendingPhaseMicros -= step;
+        budget -= (step < 0) ? -step : step;
+
+        int64_t stretchStep = stretchDebtMicros < budget ? stretchDebtMicros : budget;
+        stretchDebtMicros -= stretchStep;
+        elapsedMicros = static_cast<uint64_t>(static_cast<int64_t>(elapsedMicros) + step + stretchStep);
+    }
 
-    uint32_t currentMicros = micros();
+    // Convert elapsed time to ticks exactly - the remainder stays in the accumulator
+    // so no time is lost or gained no matter how long the player runs
+    tickAccumulator += elapsedMicros * tickRateScale;
+    uint64_t ticksPassed = tickAccumulator / tickPeriodScaled;
+    tickAccumulator -= ticksPassed * tickPeriodScaled;
+    ticksElapsed += static_cast<uint32_t>(ticksPassed);
+
+    // Queued launch: finish the old song up to the boundary, switch, and carry
+    // the time already past the boundary into the new song
+    if (pendingLaunch && ticksElapsed >= launchTicks) {
+        uint64_t pastMicros = ticksToMicroseconds(ticksElapsed - launchTicks) + tickAccumulator / tickRateScale;
+        if (clockEnabled) {
+            while (clockPulsesSent * ticksPerQuarter < static_cast<uint64_t>(launchTicks) * 24) {
+                midiOut->sendClock();
+                clockPulsesSent++;
+            }
+        }
+        while (eventReady && nextEvent.absoluteTime < launchTicks) {
+            sendMidiEvent(nextEvent);
+            eventReady = parser.readNextEvent(nextEvent);
+        }
 
-    // Send MIDI Clock ticks (24 per quarter note)
-    if (clockEnabled) {
-        uint16_t bpm = getCurrentBPM();
-        // Guard against division by zero if BPM is invalid
-        if (bpm == 0) bpm = 120; // Default to 120 BPM
-        // Calculate microseconds per clock tick: (60,000,000 / BPM) / 24
-        uint32_t microsecondsPerClock = (60000000 / bpm) / 24;
+        launchSong(currentMicros - pastMicros);
+        if (state != STATE_PLAYING || tickPeriodScaled == 0 || tickRateScale == 0) return;
 
-        if (currentMicros - lastClockMicros >= microsecondsPerClock) {
-            midiOut->sendClock();
-            lastClockMicros = currentMicros;
+        // The new song starts at the boundary, or once the controller reset is on the wire
+        uint64_t startMicros = currentMicros - pastMicros;
+        if (wireIdleMicros > startMicros) startMicros = wireIdleMicros;
+        if (startMicros > currentMicros) {
+            lastUpdateMicros = startMicros;
+            pastMicros = 0;
+        } else {
+            pastMicros = currentMicros - startMicros;
         }
-    }
 
-    uint32_t elapsedMicros = currentMicros - lastUpdateMicros;
+        tickAccumulator = pastMicros * tickRateScale;
+        ticksPassed = tickAccumulator / tickPeriodScaled;
+        tickAccumulator -= ticksPassed * tickPeriodScaled;
+        ticksElapsed = static_cast<uint32_t>(ticksPassed);
+    }
 
-    // Calculate how many ticks have passed
-    uint32_t ticksPassed = elapsedMicros / microsecondsPerTick;
+    // How far behind is the oldest due event? Checked before the clock goes out,
+    // so a STRETCH rewind never leaves pulses sent ahead of the song
+    if (eventReady && nextEvent.absoluteTime <= ticksElapsed && ticksElapsed - nextEvent.absoluteTime > staleTicks) {
+        uint64_t lag = ticksToMicroseconds(ticksElapsed - nextEvent.absoluteTime);
+        uint32_t lagMicros = lag > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : static_cast<uint32_t>(lag);
+        if (!fallingBehind) {
+            fallingBehind = true;
+            catchUpStats.stallCount++;
+            catchUpStats.lastLagMicros = lagMicros;
+        }
+        if (lagMicros > catchUpStats.maxLagMicros) {
+            catchUpStats.maxLagMicros = lagMicros;
+        }
 
-    if (ticksPassed > 0) {
-        ticksElapsed += ticksPassed;
+        if (catchUpPolicy == CATCHUP_STRETCH) {
+            // Put the song clock back at the backlog so it plays with its own timing,
+            // then win the lost time back through the phase nudge (at most 1/16 faster).
+            // Not behind the last clock pulse already sent - slaves can't be taken back.
+            uint32_t rewindTo = nextEvent.absoluteTime;
+            if (clockEnabled && ticksPerQuarter > 0 && clockPulsesSent > 0) {
+                uint32_t clockedTicks = static_cast<uint32_t>(((clockPulsesSent - 1) * ticksPerQuarter + 23) / 24);
+                if (rewindTo < clockedTicks) rewindTo = clockedTicks;
+            }
+            if (rewindTo < ticksElapsed) {
+                uint64_t debt = ticksToMicroseconds(ticksElapsed - rewindTo) + tickAccumulator / tickRateScale;
+                ticksElapsed = rewindTo;
+                tickAccumulator = 0;
+                stretchDebtMicros += static_cast<int64_t>(debt);
+                catchUpStats.stretchedMicros += debt;
+            }
+        }
+    } else {
+        fallingBehind = false;
+    }
 
-        // Update lastUpdateMicros by the exact amount of microseconds consumed
-        // This preserves fractional microseconds for accurate timing
-        lastUpdateMicros += ticksPassed * microsecondsPerTick;
+    // Send MIDI Clock ticks (24 per quarter note)
+    // Pulses are locked to song position rather than a free-running interval, so the
+    // clock follows tempo changes exactly and never drifts against the sequence
+    if (clockEnabled && ticksPerQuarter > 0) {
+        uint64_t clockPosition = static_cast<uint64_t>(ticksElapsed) * 24 +
+                                 (tickAccumulator * 24) / tickPeriodScaled;
+        while (clockPulsesSent * ticksPerQuarter <= clockPosition) {
+            midiOut->sendClock();
+            clockPulsesSent++;
+        }
+    }
 
+    if (ticksPassed > 0 || (eventReady && nextEvent.absoluteTime <= ticksElapsed)) {
         // Process events that should happen by now
         // CRITICAL: Limit TIME spent in update() to avoid holding mutex too long
         // This prevents blocking Core 0 (UI thread) for extended periods
         // Large SysEx messages can take a long time, so use time-based limit instead of event count
-        unsigned long updateStartMicros = micros();
-        constexpr unsigned long MAX_UPDATE_TIME_MICROS = 15000;  // Max 15ms per update call (reduced from 50ms for better UI responsiveness)
+        uint64_t updateStartMicros = time_us_64();
+        constexpr uint64_t MAX_UPDATE_TIME_MICROS = 15000;  // Max 15ms per update call (reduced from 50ms for better UI responsiveness)
 
         while (eventReady && nextEvent.absoluteTime <= ticksElapsed) {
             // Check if we should stop (allows fast exit when switching tracks)
@@ -249,14 +711,31 @@ void MidiPlayer::update() {
 
             // CRITICAL: Check time budget BEFORE processing event
             // This prevents starting a large SysEx if already over budget
-            unsigned long elapsed = micros() - updateStartMicros;
+            uint64_t elapsed = time_us_64() - updateStartMicros;
             if (elapsed > MAX_UPDATE_TIME_MICROS) {
                 // Out of time - yield to Core 0 now
+                catchUpStats.budgetBreaks++;
                 break;
             }
 
-            // Send the MIDI event
-            sendMidiEvent(nextEvent);
+            bool stale = (ticksElapsed - nextEvent.absoluteTime > staleTicks);
+            if (stale && catchUpPolicy == CATCHUP_DROP_STALE && isCatchUpDroppable(nextEvent)) {
+                catchUpStats.droppedEvents++;
+            } else if (stale && catchUpPolicy == CATCHUP_COLLAPSE && isCatchUpDroppable(nextEvent)) {
+                collapseLateEvent(nextEvent);
+            } else {
+                // Anything held back for this channel was earlier in the song - send it first
+                if (collapsedChannels) {
+                    if (nextEvent.isMetaEvent || nextEvent.type == MIDI_SYSEX || nextEvent.channel >= 16) {
+                        if (!nextEvent.isMetaEvent) flushAllCollapsed();
+                    } else {
+                        flushCollapsed(nextEvent.channel);
+                    }
+                }
+
+                // Send the MIDI event
+                sendMidiEvent(nextEvent);
+            }
 
             // SysEx data automatically freed by MidiEvent destructor
 
@@ -268,61 +747,63 @@ void MidiPlayer::update() {
                 break;
             }
         }
+
+        // Caught up - controller values still held back can go out now
+        if (collapsedChannels && (!eventReady || nextEvent.absoluteTime > ticksElapsed ||
+                                  ticksElapsed - nextEvent.absoluteTime <= staleTicks)) {
+            flushAllCollapsed();
+        }
+    }
+
+    // Quiet stretch ahead - top up a track buffer now so a slow card read
+    // lands here instead of in the middle of a busy passage
+    if (state == STATE_PLAYING && eventReady && nextEvent.absoluteTime > ticksElapsed &&
+        nextEvent.absoluteTime - ticksElapsed > prefetchIdleTicks) {
+        parser.prefetch();
     }
 }
 
-void MidiPlayer::sendMidiEvent(const MidiEvent& event) {
+template <class Sink>
+void MidiPlayerT<Sink>::sendMidiEvent(const MidiEvent& event) {
     if (!midiOut) return;
 
     // Handle tempo changes during playback
     if (event.isMetaEvent && event.data1 == META_TEMPO) {
         // Parser has already updated fileInfo.tempo when it read this event
         // Now we need to recalculate timing to match the new tempo
-        calculateMicrosecondsPerTick();
+        calculateTickRate();
         return; // Don't send meta events as MIDI
     }
 
+    // A time signature change starts a bar (quantized launches count bars from it)
+    if (event.isMetaEvent && event.data1 == META_TIME_SIGNATURE) {
+        meterOriginTicks = event.absoluteTime;
+        return;
+    }
+
     if (event.isMetaEvent) return; // Don't send other meta events
 
     // CRITICAL: Validate channel is in valid range (0-15)
     // Corrupted MIDI files could have invalid channels causing buffer overruns
     if (event.channel >= 16) return;
 
-    uint8_t channel = event.channel + 1; // Convert to 1-based
-
-    // Apply routing if configured
-    if (userChannelRouting[event.channel] != 255) {
-        // Route to different channel (0-15 in routing array = channels 1-16)
-        channel = userChannelRouting[event.channel] + 1;
-    }
-
-    // Check if channel is muted
-    if (channelMutes & (1 << event.channel)) {
-        // Channel is muted, don't send note on/off
-        if (event.type == MIDI_NOTE_ON || event.type == MIDI_NOTE_OFF) {
-            return;
-        }
-    }
+    const uint8_t src = event.channel;
+    // A note the parser built before its track was silenced counts as muted too
+    bool muted = (channelMutes & (1 << src)) || (parser.getSilencedTracks() & (1 << event.trackNumber));
 
-    switch (event.type) {
-        case MIDI_NOTE_OFF:
-            {
-                // Apply transpose
-                int16_t transposedNote = event.data1 + userChannelTranspose[event.channel];
-                if (transposedNote < 0) transposedNote = 0;
-                if (transposedNote > 127) transposedNote = 127;
-                midiOut->sendNoteOff(channel, static_cast<uint8_t>(transposedNote), event.data2);
-            }
-            break;
+    // Destinations come precomputed from routing + layers (see rebuildDestinations)
+    uint64_t destinations = channelDestMask[src];
+    uint8_t type = event.type;
+    uint8_t data1 = event.data1;
+    uint8_t data2 = event.data2;
+    uint16_t messageBytes = 3;
 
+    switch (type) {
         case MIDI_NOTE_ON:
-            if (event.data2 == 0) {
-                // Velocity 0 = note off
-                int16_t transposedNote = event.data1 + userChannelTranspose[event.channel];
-                if (transposedNote < 0) transposedNote = 0;
-                if (transposedNote > 127) transposedNote = 127;
-                midiOut->sendNoteOff(channel, static_cast<uint8_t>(transposedNote), 0);
-            } else {
+            if (event.data2 != 0) {
+                // Channel is muted, don't send note on
+                if (muted) return;
+
                 // Scale velocity based on global velocityScale setting
                 // velocityScale: 50 = use MIDI file velocity as-is (no change)
                 //                100 = max velocity (127 for all notes)
@@ -334,124 +815,650 @@ void MidiPlayer::sendMidiEvent(const MidiEvent& event) {
                 uint16_t scaledVelocity = (static_cast<uint16_t>(event.data2) * static_cast<uint16_t>(velocityScale) * 2) / 100;
 
                 // Also apply per-channel velocity scale if set (0 = use global only)
-                if (channelVelocities[event.channel] != 0) {
+                if (channelVelocities[src] != 0) {
                     // channelVelocities: 100 = normal, 50 = half, 200 = double
-                    scaledVelocity = (scaledVelocity * channelVelocities[event.channel]) / 100;
+                    scaledVelocity = (scaledVelocity * channelVelocities[src]) / 100;
                 }
 
                 if (scaledVelocity > 127) scaledVelocity = 127;
                 if (scaledVelocity < 1) scaledVelocity = 1;
 
                 // Apply transpose
-                int16_t transposedNote = event.data1 + userChannelTranspose[event.channel];
+                int16_t transposedNote = event.data1 + userChannelTranspose[src];
                 if (transposedNote < 0) transposedNote = 0;
                 if (transposedNote > 127) transposedNote = 127;
 
-                midiOut->sendNoteOn(channel, static_cast<uint8_t>(transposedNote), static_cast<uint8_t>(scaledVelocity));
+                uint8_t sourceNote = event.data1 & 0x7F;
+                if (isNoteHeld(src, sourceNote)) {
+                    // Retrigger: release the previous copies first so none is left hanging
+                    // if the destinations or transpose changed in between
+                    releaseHeldNote(src, sourceNote);
+                }
+                data1 = static_cast<uint8_t>(transposedNote);
+                data2 = static_cast<uint8_t>(scaledVelocity);
+
+                // Remember where this note went so its Note Off reaches every copy
+                heldNotes[src][sourceNote >> 5] |= (1UL << (sourceNote & 31));
+                heldNoteOutput[src][sourceNote] = data1;
+                heldNoteTrack[src][sourceNote] = event.trackNumber;
+                heldDestMask[src] |= destinations;
+                break;
             }
-            break;
+            // Velocity 0 = note off
+            type = MIDI_NOTE_OFF;
+            data2 = 0;
+            // fall through
 
-        case MIDI_POLY_AFTERTOUCH:
-            midiOut->sendPolyAfterTouch(channel, event.data1, event.data2);
+        case MIDI_NOTE_OFF:
+            {
+                uint8_t sourceNote = event.data1 & 0x7F;
+                if (isNoteHeld(src, sourceNote)) {
+                    // Send to everything that got the Note On, with the note number it used,
+                    // even if routing, layers, transpose or mute changed since
+                    data1 = heldNoteOutput[src][sourceNote];
+                    destinations = heldDestMask[src];
+                    clearHeldNote(src, sourceNote);
+                } else {
+                    // Channel is muted, don't send note off for notes it never played
+                    if (muted) return;
+
+                    // Apply transpose
+                    int16_t transposedNote = event.data1 + userChannelTranspose[src];
+                    if (transposedNote < 0) transposedNote = 0;
+                    if (transposedNote > 127) transposedNote = 127;
+                    data1 = static_cast<uint8_t>(transposedNote);
+                }
+            }
             break;
 
         case MIDI_CONTROL_CHANGE:
             // Check if user has overridden volume (CC7) or pan (CC10)
-            if (event.data1 == 7 && userChannelVolumes[event.channel] < 128) {
+            if (event.data1 == 7 && userChannelVolumes[src] < 128) {
                 // User has set volume override (0-127) - ignore MIDI file volume changes
-                break;
-            } else if (event.data1 == 10 && userChannelPan[event.channel] < 128) {
+                return;
+            } else if (event.data1 == 10 && userChannelPan[src] < 128) {
                 // User has set pan override (0-127) - ignore MIDI file pan changes
-                break;
-            } else {
-                // Allow MIDI file to control this CC message
-                midiOut->sendControlChange(channel, event.data1, event.data2);
+                return;
             }
+            // Allow MIDI file to control this CC message
             break;
 
         case MIDI_PROGRAM_CHANGE:
             // Auto-detect override: if user has set a valid program (0-127), ignore MIDI file
             // We use 128 as "not set" to allow MIDI file to control this channel
-            if (userChannelPrograms[event.channel] < 128) {
+            if (userChannelPrograms[src] < 128) {
                 // User has set a program (0-127) - ignore MIDI file program changes
                 // User's manual settings will be sent at playback start
-                break;
-            } else {
-                // User hasn't set a program (128) - allow MIDI file to control
-                midiOut->sendProgramChange(channel, event.data1);
+                return;
             }
+            // User hasn't set a program (128) - allow MIDI file to control
+            messageBytes = 2;
             break;
 
         case MIDI_CHANNEL_AFTERTOUCH:
-            midiOut->sendAfterTouch(channel, event.data1);
+            messageBytes = 2;
             break;
 
+        case MIDI_SYSEX:
+            // Filter SysEx if disabled (prevents MT-32 detuning and patch modifications)
+            if (!sysexEnabled) return;
+            if (!event.sysexData || event.sysexLength == 0) return;
+            messageBytes = event.sysexLength;
+            break;
+
+        default:
+            break;
+    }
+
+    // Bandwidth accounting is per source channel; the projection multiplies by fan-out
+    channelBytesWindow[src] += messageBytes;
+
+    // Controller state a launch has to reset before the next song plays here
+    if (type == MIDI_CONTROL_CHANGE || type == MIDI_PITCH_BEND ||
+        type == MIDI_CHANNEL_AFTERTOUCH || type == MIDI_POLY_AFTERTOUCH) {
+        controlledDestMask |= destinations;
+    }
+
+    // Sink boundary: a corrupt file can carry data bytes with the top bit set.
+    // Masked once here so no sink has to range-check each copy (channel and
+    // port come from the destination bits and are always valid)
+    data1 &= 0x7F;
+    data2 &= 0x7F;
+
+    // Emit one copy per destination bit: bit index = (port << 4) | channel
+    while (destinations) {
+        uint8_t route = static_cast<uint8_t>(__builtin_ctzll(destinations));
+        destinations &= destinations - 1;
+        uint8_t port = midiRoutePort(route);
+        uint8_t channel = midiRouteChannel(route) + 1; // Convert to 1-based
+
+        switch (type) {
+            case MIDI_NOTE_OFF:
+                midiOut->sendNoteOff(channel, data1, data2, port);
+                break;
+
+            case MIDI_NOTE_ON:
+                midiOut->sendNoteOn(channel, data1, data2, port);
+                break;
+
+            case MIDI_POLY_AFTERTOUCH:
+                midiOut->sendPolyAfterTouch(channel, data1, data2, port);
+                break;
+
+            case MIDI_CONTROL_CHANGE:
+                midiOut->sendControlChange(channel, data1, data2, port);
+                break;
+
+            case MIDI_PROGRAM_CHANGE:
+                midiOut->sendProgramChange(channel, data1, port);
+                break;
+
+            case MIDI_CHANNEL_AFTERTOUCH:
+                midiOut->sendAfterTouch(channel, data1, port);
+                break;
+
+            case MIDI_PITCH_BEND:
+                {
+                    int16_t bend = (data2 << 7) | data1;
+                    bend -= 8192; // Convert to signed
+                    midiOut->sendPitchBend(channel, bend, port);
+                }
+                break;
+
+            case MIDI_SYSEX:
+                // Hardware MIDI transmission at 31.25kbaud takes ~80ms for 265 bytes
+                // SysEx is not channel data - send it once per port, not once per layer
+                midiOut->sendSysEx(event.sysexData, event.sysexLength, port);
+                destinations &= ~(0xFFFFULL << (port * 16));
+                break;
+        }
+    }
+}
+
+// ============================================================================
+// FAN-OUT ROUTING
+// Each source channel maps to a 64-bit destination mask, bit (port << 4) | channel.
+// The mask is rebuilt only when routing or layers change, so the per-event
+// cost is one loop over the set bits.
+// ============================================================================
+
+template <class Sink>
+void MidiPlayerT<Sink>::rebuildDestinations() {
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        uint8_t route = userChannelRouting[ch];
+        uint8_t primary = (route == MIDI_ROUTE_ORIGINAL) ? ch : route;
+        channelDestMask[ch] = (1ULL << primary) | (userChannelLayers[ch] & MIDI_ROUTE_ALL_MASK);
+    }
+    updateProjectedLoad();
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::setChannelLayers(const uint64_t* layers) {
+    if (!layers) return; // Null pointer check
+    for (uint8_t i = 0; i < 16; i++) {
+        userChannelLayers[i] = layers[i] & MIDI_ROUTE_ALL_MASK;
+    }
+    rebuildDestinations();
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::isNoteHeld(uint8_t channel, uint8_t note) {
+    return heldNotes[channel][note >> 5] & (1UL << (note & 31));
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::clearHeldNote(uint8_t channel, uint8_t note) {
+    heldNotes[channel][note >> 5] &= ~(1UL << (note & 31));
+    if ((heldNotes[channel][0] | heldNotes[channel][1] | heldNotes[channel][2] | heldNotes[channel][3]) == 0) {
+        heldDestMask[channel] = 0;  // Nothing sounding - forget old destinations
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::releaseHeldNote(uint8_t channel, uint8_t note) {
+    uint64_t destinations = heldDestMask[channel];
+    uint8_t outputNote = heldNoteOutput[channel][note];
+    while (destinations) {
+        uint8_t route = static_cast<uint8_t>(__builtin_ctzll(destinations));
+        destinations &= destinations - 1;
+        midiOut->sendNoteOff(midiRouteChannel(route) + 1, outputNote, 0, midiRoutePort(route));
+    }
+    clearHeldNote(channel, note);
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::releaseHeldNotes() {
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        for (uint8_t word = 0; word < 4; word++) {
+            uint32_t bits = heldNotes[ch][word];
+            while (bits) {
+                uint8_t note = static_cast<uint8_t>((word << 5) | __builtin_ctz(bits));
+                bits &= bits - 1;
+                releaseHeldNote(ch, note);
+            }
+        }
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::resetSongControllers() {
+    // Sustain, modulation, bend and the like would carry into the next song on the
+    // same channels. Reset All Controllers leaves volume, pan and programs alone.
+    uint64_t destinations = controlledDestMask;
+    controlledDestMask = 0;
+    if (!midiOut || !destinations) return;
+
+    uint32_t busiest = 0;
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        uint32_t bytes = destinationsOnPort(destinations, port) * 6;
+        if (bytes > busiest) busiest = bytes;
+    }
+    while (destinations) {
+        uint8_t route = static_cast<uint8_t>(__builtin_ctzll(destinations));
+        destinations &= destinations - 1;
+        uint8_t channel = midiRouteChannel(route) + 1;
+        uint8_t port = midiRoutePort(route);
+        midiOut->sendControlChange(channel, 121, 0, port);  // Reset All Controllers
+        midiOut->sendPitchBend(channel, 0, port);
+    }
+    reserveWireTime(busiest);
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::clearNoteTracking() {
+    memset(heldNotes, 0, sizeof(heldNotes));
+    memset(heldDestMask, 0, sizeof(heldDestMask));
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::updateProjectedLoad() {
+    // Demand on each port if every channel keeps its recent byte rate with the
+    // current fan-out (running status is ignored, so this errs on the high side)
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        uint32_t bytesPerSecond = 0;
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            uint16_t copies = __builtin_popcountll((channelDestMask[ch] >> (port * 16)) & 0xFFFF);
+            bytesPerSecond += (uint32_t)channelByteRate[ch] * copies;
+        }
+        uint32_t percent = (bytesPerSecond * 100) / MIDI_PORT_BYTES_PER_SEC;
+        projectedPortLoad[port] = percent > 255 ? 255 : (uint8_t)percent;
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::updateBandwidthWindow(uint64_t nowMicros) {
+    uint64_t elapsed = nowMicros - loadWindowStartMicros;
+    if (elapsed < BANDWIDTH_WINDOW_MICROS) return;
+
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        uint64_t rate = (uint64_t)channelBytesWindow[ch] * 1000000ULL / elapsed;
+        channelByteRate[ch] = rate > 0xFFFF ? 0xFFFF : (uint16_t)rate;
+        channelBytesWindow[ch] = 0;
+    }
+    loadWindowStartMicros = nowMicros;
+    updateProjectedLoad();
+}
+
+template <class Sink>
+uint8_t MidiPlayerT<Sink>::getProjectedPortLoad(uint8_t port) {
+    if (port >= MIDI_OUT_PORT_COUNT) return 0;
+    return projectedPortLoad[port];
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::isPortSaturating(uint8_t port) {
+    if (port >= MIDI_OUT_PORT_COUNT) return false;
+    return projectedPortLoad[port] >= FANOUT_WARN_PERCENT;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::setCatchUpPolicy(CatchUpPolicy policy) {
+    if (policy >= CATCHUP_POLICY_COUNT) policy = CATCHUP_SEND_ALL;
+    if (catchUpPolicy == CATCHUP_COLLAPSE && policy != CATCHUP_COLLAPSE) {
+        flushAllCollapsed();
+    }
+    catchUpPolicy = policy;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::resetCatchUpStats() {
+    memset(&catchUpStats, 0, sizeof(catchUpStats));
+    fallingBehind = false;
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::isCatchUpDroppable(const MidiEvent& event) {
+    // Only continuous data that a later value makes meaningless. Notes, programs,
+    // SysEx, switches (bank, pedals), RPN/NRPN sequences and mode messages are never skipped.
+    if (event.isMetaEvent || event.channel >= 16) return false;
+    switch (event.type) {
         case MIDI_PITCH_BEND:
+        case MIDI_CHANNEL_AFTERTOUCH:
+        case MIDI_POLY_AFTERTOUCH:
+            return true;
+
+        case MIDI_CONTROL_CHANGE:
             {
-                int16_t bend = (event.data2 << 7) | event.data1;
-                bend -= 8192; // Convert to signed
-                midiOut->sendPitchBend(channel, bend);
+                uint8_t cc = event.data1;
+                if (cc == 0 || cc == 32) return false;               // Bank select
+                if (cc == 6 || cc == 38) return false;               // Data entry
+                if (cc >= 64 && cc <= 69) return false;              // Pedals and switches
+                if (cc >= 96 && cc <= 101) return false;             // Data inc/dec, NRPN, RPN
+                if (cc >= 120) return false;                         // Channel mode messages
+                return true;
             }
-            break;
 
-        case MIDI_SYSEX:
-            // Filter SysEx if disabled (prevents MT-32 detuning and patch modifications)
-            if (!sysexEnabled) break;
+        default:
+            return false;
+    }
+}
 
-            if (event.sysexData && event.sysexLength > 0) {
-                // Hardware MIDI transmission at 31.25kbaud takes ~80ms for 265 bytes
-                // This is unavoidable with hardware MIDI, but won't crash with fixed memory leak
-                midiOut->sendSysEx(event.sysexData, event.sysexLength);
+template <class Sink>
+void MidiPlayerT<Sink>::collapseLateEvent(const MidiEvent& event) {
+    uint8_t ch = event.channel;
+    bool replaced = false;
+
+    switch (event.type) {
+        case MIDI_CONTROL_CHANGE:
+            {
+                uint8_t cc = event.data1 & 0x7F;
+                uint32_t bit = 1UL << (cc & 31);
+                replaced = (collapsedControllers[ch][cc >> 5] & bit) != 0;
+                collapsedControllers[ch][cc >> 5] |= bit;
+                collapsedControllerValue[ch][cc] = event.data2;
             }
             break;
+
+        case MIDI_PITCH_BEND:
+            replaced = (collapsedBendMask & (1 << ch)) != 0;
+            collapsedBendMask |= (1 << ch);
+            collapsedBend[ch] = (static_cast<uint16_t>(event.data2) << 7) | event.data1;
+            break;
+
+        case MIDI_CHANNEL_AFTERTOUCH:
+            replaced = (collapsedPressureMask & (1 << ch)) != 0;
+            collapsedPressureMask |= (1 << ch);
+            collapsedPressure[ch] = event.data1;
+            break;
+
+        default:
+            // Late poly pressure is per note and already past - nothing worth keeping
+            catchUpStats.droppedEvents++;
+            return;
+    }
+
+    collapsedChannels |= (1 << ch);
+    if (replaced) {
+        catchUpStats.collapsedEvents++;
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::flushCollapsed(uint8_t channel) {
+    if (!(collapsedChannels & (1 << channel))) return;
+    collapsedChannels &= ~(1 << channel);
+
+    // Replay through sendMidiEvent() so overrides, routing and layers still apply
+    MidiEvent event;
+    event.channel = channel;
+
+    event.type = MIDI_CONTROL_CHANGE;
+    for (uint8_t word = 0; word < 4; word++) {
+        uint32_t bits = collapsedControllers[channel][word];
+        collapsedControllers[channel][word] = 0;
+        while (bits) {
+            uint8_t cc = static_cast<uint8_t>((word << 5) | __builtin_ctz(bits));
+            bits &= bits - 1;
+            event.data1 = cc;
+            event.data2 = collapsedControllerValue[channel][cc];
+            sendMidiEvent(event);
+        }
+    }
+
+    if (collapsedBendMask & (1 << channel)) {
+        collapsedBendMask &= ~(1 << channel);
+        event.type = MIDI_PITCH_BEND;
+        event.data1 = collapsedBend[channel] & 0x7F;
+        event.data2 = (collapsedBend[channel] >> 7) & 0x7F;
+        sendMidiEvent(event);
+    }
+
+    if (collapsedPressureMask & (1 << channel)) {
+        collapsedPressureMask &= ~(1 << channel);
+        event.type = MIDI_CHANNEL_AFTERTOUCH;
+        event.data1 = collapsedPressure[channel];
+        event.data2 = 0;
+        sendMidiEvent(event);
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::flushAllCollapsed() {
+    while (collapsedChannels) {
+        flushCollapsed(static_cast<uint8_t>(__builtin_ctz(collapsedChannels)));
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::clearCollapsed() {
+    collapsedChannels = 0;
+    collapsedBendMask = 0;
+    collapsedPressureMask = 0;
+    memset(collapsedControllers, 0, sizeof(collapsedControllers));
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::storeScene(uint8_t index, const ChannelScene& scene) {
+    if (index >= MAX_SCENES) return false;
+    scenes[index] = scene;
+    sceneDefinedMask |= (1 << index);
+    return true;
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::getScene(uint8_t index, ChannelScene& scene) {
+    if (index >= MAX_SCENES || !(sceneDefinedMask & (1 << index))) return false;
+    scene = scenes[index];
+    return true;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::clearScenes() {
+    sceneDefinedMask = 0;
+    activeScene = -1;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::sendToDestinations(uint64_t destinations, uint8_t type, uint8_t data1, uint8_t data2) {
+    while (destinations) {
+        uint8_t route = static_cast<uint8_t>(__builtin_ctzll(destinations));
+        destinations &= destinations - 1;
+        uint8_t channel = midiRouteChannel(route) + 1;
+        uint8_t port = midiRoutePort(route);
+        if (type == MIDI_PROGRAM_CHANGE) {
+            midiOut->sendProgramChange(channel, data1, port);
+        } else {
+            midiOut->sendControlChange(channel, data1, data2, port);
+        }
     }
 }
 
-void MidiPlayer::setTempoPercent(uint16_t percent) {
+template <class Sink>
+void MidiPlayerT<Sink>::sendOverrideSetup() {
+    if (!midiOut) return;
+    uint32_t portBytes[MIDI_OUT_PORT_COUNT] = {};
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        uint32_t bytes = 0;
+        if (userChannelPrograms[ch] < 128) {
+            sendToDestinations(channelDestMask[ch], MIDI_PROGRAM_CHANGE, userChannelPrograms[ch], 0);
+            bytes += 2;
+        }
+        if (userChannelVolumes[ch] < 128) {
+            sendToDestinations(channelDestMask[ch], MIDI_CONTROL_CHANGE, 7, userChannelVolumes[ch]);
+            bytes += 3;
+        }
+        if (userChannelPan[ch] < 128) {
+            sendToDestinations(channelDestMask[ch], MIDI_CONTROL_CHANGE, 10, userChannelPan[ch]);
+            bytes += 3;
+        }
+        for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+            portBytes[port] += bytes * destinationsOnPort(channelDestMask[ch], port);
+        }
+    }
+
+    // Notes wait until the busiest port has sent its share
+    uint32_t busiest = 0;
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        if (portBytes[port] > busiest) busiest = portBytes[port];
+    }
+    reserveWireTime(busiest);
+}
+
+template <class Sink>
+bool MidiPlayerT<Sink>::recallScene(uint8_t index) {
+    if (index >= MAX_SCENES || !(sceneDefinedMask & (1 << index))) return false;
+    applyChannelScene(scenes[index]);
+    activeScene = index;
+    return true;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::applyChannelScene(const ChannelScene& scene) {
+    // Remember what the outputs have been told so far
+    uint64_t oldDestMask[16];
+    uint8_t oldPrograms[16];
+    uint8_t oldVolumes[16];
+    uint8_t oldPan[16];
+    memcpy(oldDestMask, channelDestMask, sizeof(oldDestMask));
+    memcpy(oldPrograms, userChannelPrograms, sizeof(oldPrograms));
+    memcpy(oldVolumes, userChannelVolumes, sizeof(oldVolumes));
+    memcpy(oldPan, userChannelPan, sizeof(oldPan));
+    uint16_t newlyMuted = scene.mutes & ~channelMutes;
+
+    // Swap the tables in one go (caller holds the player mutex, so update() never sees a mix)
+    setChannelPrograms(scene.programs);
+    setChannelVolumes(scene.volumes);
+    setChannelPan(scene.pan);
+    setChannelTranspose(scene.transpose);
+    setChannelVelocityScales(scene.velocities);
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        uint8_t route = scene.routing[ch];
+        userChannelRouting[ch] = (route > MIDI_ROUTE_MAX) ? MIDI_ROUTE_ORIGINAL : route;
+        userChannelLayers[ch] = scene.layers[ch] & MIDI_ROUTE_ALL_MASK;
+    }
+    channelMutes = scene.mutes;
+    rebuildDestinations();
+
+    if (!midiOut) return;
+
+    // Send only the differences: a changed value goes to every destination,
+    // an unchanged one only to destinations the channel did not reach before.
+    // Held notes keep their Note Off targets through heldDestMask.
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        if (newlyMuted & (1 << ch)) {
+            sendToDestinations(oldDestMask[ch] | heldDestMask[ch], MIDI_CONTROL_CHANGE, 123, 0);
+            memset(heldNotes[ch], 0, sizeof(heldNotes[ch]));
+            heldDestMask[ch] = 0;
+        }
+
+        uint64_t allDest = channelDestMask[ch];
+        uint64_t addedDest = allDest & ~oldDestMask[ch];
+
+        if (userChannelPrograms[ch] < 128) {
+            uint64_t dest = (userChannelPrograms[ch] != oldPrograms[ch]) ? allDest : addedDest;
+            sendToDestinations(dest, MIDI_PROGRAM_CHANGE, userChannelPrograms[ch], 0);
+        }
+        if (userChannelVolumes[ch] < 128) {
+            uint64_t dest = (userChannelVolumes[ch] != oldVolumes[ch]) ? allDest : addedDest;
+            sendToDestinations(dest, MIDI_CONTROL_CHANGE, 7, userChannelVolumes[ch]);
+        }
+        if (userChannelPan[ch] < 128) {
+            uint64_t dest = (userChannelPan[ch] != oldPan[ch]) ? allDest : addedDest;
+            sendToDestinations(dest, MIDI_CONTROL_CHANGE, 10, userChannelPan[ch]);
+        }
+    }
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::setTempoPercent(uint16_t percent) {
     // Clamp to 50.0% - 200.0% (tenth-percent precision)
     if (percent < 500) percent = 500;
     if (percent > 2000) percent = 2000;
 
     tempoPercent = percent;
-    calculateMicrosecondsPerTick();
+    calculateTickRate();
 }
 
-void MidiPlayer::setVelocityScale(uint8_t scale) {
+template <class Sink>
+void MidiPlayerT<Sink>::alignBeatPhase(uint64_t beatMicros) {
+    if (tickPeriodScaled == 0 || tickRateScale == 0 || ticksPerQuarter == 0) return;
+
+    // Song position at beatMicros in 16.16 fixed-point ticks
+    // (beatMicros may be slightly before or after the last update)
+    int64_t period = static_cast<int64_t>(tickPeriodScaled);
+    int64_t scale = static_cast<int64_t>(tickRateScale);
+    // STRETCH debt still owed counts as already played: the song is behind on purpose
+    // and the nudge takes it back to its own timeline, which is what the tap aligns to
+    int64_t deltaScaled = (static_cast<int64_t>(beatMicros - lastUpdateMicros) + stretchDebtMicros) * scale;
+    int64_t position = (static_cast<int64_t>(ticksElapsed) << 16) +
+                       static_cast<int64_t>((tickAccumulator << 16) / tickPeriodScaled) +
+                       (deltaScaled / period) * 65536 + ((deltaScaled % period) * 65536) / period;
+    if (position < 0) return;
+
+    // Distance to the nearest beat: positive = song is ahead of the tap, negative = behind
+    int64_t beat = static_cast<int64_t>(ticksPerQuarter) << 16;
+    int64_t phase = position % beat;
+    int64_t error = (phase < beat / 2) ? phase : phase - beat;
+
+    // Convert to microseconds at the current rate and replace any tap correction still in
+    // flight (the new measurement already includes whatever part of it was applied);
+    // the STRETCH debt is left to run out on its own
+    int64_t errorMicros = ((error / 256) * period / scale) / 256;
+    pendingPhaseMicros = -errorMicros;
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::setVelocityScale(uint8_t scale) {
     if (scale < 1) scale = 1;
     if (scale > 100) scale = 100;
 
     velocityScale = scale;
 }
 
-void MidiPlayer::setChannelPrograms(uint8_t* programs) {
+template <class Sink>
+void MidiPlayerT<Sink>::setChannelPrograms(const uint8_t* programs) {
     if (!programs) return; // Null pointer check
     for (uint8_t i = 0; i < 16; i++) {
         userChannelPrograms[i] = programs[i];
     }
 }
 
-void MidiPlayer::setChannelVolumes(uint8_t* volumes) {
+template <class Sink>
+void MidiPlayerT<Sink>::setChannelVolumes(const uint8_t* volumes) {
     if (!volumes) return; // Null pointer check
     for (uint8_t i = 0; i < 16; i++) {
         userChannelVolumes[i] = volumes[i];
     }
 }
 
-void MidiPlayer::setChannelPan(uint8_t* pan) {
+template <class Sink>
+void MidiPlayerT<Sink>::setChannelPan(const uint8_t* pan) {
     if (!pan) return; // Null pointer check
     for (uint8_t i = 0; i < 16; i++) {
         userChannelPan[i] = pan[i];
     }
 }
 
-void MidiPlayer::setChannelTranspose(int8_t* transpose) {
+template <class Sink>
+void MidiPlayerT<Sink>::setChannelTranspose(const int8_t* transpose) {
     if (!transpose) return; // Null pointer check
     for (uint8_t i = 0; i < 16; i++) {
         userChannelTranspose[i] = transpose[i];
     }
 }
 
-void MidiPlayer::setChannelVelocityScales(uint8_t* velocities) {
+template <class Sink>
+void MidiPlayerT<Sink>::setChannelVelocityScales(const uint8_t* velocities) {
     if (!velocities) return; // Null pointer check
     for (uint8_t i = 0; i < 16; i++) {
         // Clamp value to valid range (0 = use MIDI file, 1-200)
@@ -461,14 +1468,20 @@ void MidiPlayer::setChannelVelocityScales(uint8_t* velocities) {
     }
 }
 
-void MidiPlayer::setChannelRouting(uint8_t* routing) {
+template <class Sink>
+void MidiPlayerT<Sink>::setChannelRouting(uint8_t* routing) {
     if (!routing) return; // Null pointer check
     for (uint8_t i = 0; i < 16; i++) {
-        userChannelRouting[i] = routing[i];
+        // Reject destinations on ports that don't exist
+        uint8_t value = routing[i];
+        if (value > MIDI_ROUTE_MAX) value = MIDI_ROUTE_ORIGINAL;
+        userChannelRouting[i] = value;
     }
+    rebuildDestinations();
 }
 
-uint16_t MidiPlayer::getCurrentBPM() {
+template <class Sink>
+uint16_t MidiPlayerT<Sink>::getCurrentBPM() {
     MidiFileInfo info = parser.getFileInfo();
     uint32_t tempo = info.tempo; // microseconds per quarter note
 
@@ -482,22 +1495,32 @@ uint16_t MidiPlayer::getCurrentBPM() {
     return 60000000 / tempo;
 }
 
-void MidiPlayer::muteChannel(uint8_t channel) {
+template <class Sink>
+void MidiPlayerT<Sink>::muteChannel(uint8_t channel) {
     if (channel >= 16) return;
     channelMutes |= (1 << channel);
 
-    // Stop any playing notes on this channel
+    // Stop any playing notes on this channel (at every destination it plays on)
     if (midiOut) {
-        midiOut->sendControlChange(channel + 1, 123, 0);
+        uint64_t destinations = channelDestMask[channel] | heldDestMask[channel];
+        while (destinations) {
+            uint8_t route = static_cast<uint8_t>(__builtin_ctzll(destinations));
+            destinations &= destinations - 1;
+            midiOut->sendControlChange(midiRouteChannel(route) + 1, 123, 0, midiRoutePort(route));
+        }
     }
+    memset(heldNotes[channel], 0, sizeof(heldNotes[channel]));
+    heldDestMask[channel] = 0;
 }
 
-void MidiPlayer::unmuteChannel(uint8_t channel) {
+template <class Sink>
+void MidiPlayerT<Sink>::unmuteChannel(uint8_t channel) {
     if (channel >= 16) return;
     channelMutes &= ~(1 << channel);
 }
 
-void MidiPlayer::toggleMuteChannel(uint8_t channel) {
+template <class Sink>
+void MidiPlayerT<Sink>::toggleMuteChannel(uint8_t channel) {
     if (isChannelMuted(channel)) {
         unmuteChannel(channel);
     } else {
@@ -505,76 +1528,123 @@ void MidiPlayer::toggleMuteChannel(uint8_t channel) {
     }
 }
 
-bool MidiPlayer::isChannelMuted(uint8_t channel) {
+template <class Sink>
+bool MidiPlayerT<Sink>::isChannelMuted(uint8_t channel) {
     if (channel >= 16) return false;
     return channelMutes & (1 << channel);
 }
 
-uint32_t MidiPlayer::ticksToMilliseconds(uint32_t ticks) {
+template <class Sink>
+void MidiPlayerT<Sink>::setTrackMutes(uint16_t mutes) {
+    trackMutes = mutes;
+    applyTrackSilence();
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::setTrackSolos(uint16_t solos) {
+    trackSolos = solos;
+    applyTrackSilence();
+}
+
+template <class Sink>
+void MidiPlayerT<Sink>::applyTrackSilence() {
+    // Any solo silences every track that isn't soloed, otherwise the mutes apply
+    uint16_t silenced = trackSolos ? static_cast<uint16_t>(~trackSolos) : trackMutes;
+    uint16_t newlySilenced = silenced & ~parser.getSilencedTracks();
+    parser.setSilencedTracks(silenced);
+
+    // The parser now skips these tracks' Note Offs - release what they left sounding
+    if (!newlySilenced || !midiOut) return;
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        for (uint8_t word = 0; word < 4; word++) {
+            uint32_t bits = heldNotes[ch][word];
+            while (bits) {
+                uint8_t note = static_cast<uint8_t>((word << 5) | __builtin_ctz(bits));
+                bits &= bits - 1;
+                if (newlySilenced & (1 << heldNoteTrack[ch][note])) {
+                    releaseHeldNote(ch, note);
+                }
+            }
+        }
+    }
+}
+
+template <class Sink>
+uint64_t MidiPlayerT<Sink>::ticksToMicroseconds(uint32_t ticks) {
     // Guard against division by zero
-    if (microsecondsPerTick == 0) return 0;
+    if (tickRateScale == 0) return 0;
 
-    // Use 64-bit arithmetic to prevent overflow for long files
-    uint64_t microseconds = (uint64_t)ticks * microsecondsPerTick;
-    return (uint32_t)(microseconds / 1000);
+    // Split the division so ticks * tickPeriodScaled can't overflow 64 bits
+    uint64_t whole = ticks / tickRateScale;
+    uint64_t part = ticks % tickRateScale;
+    return whole * tickPeriodScaled + (part * tickPeriodScaled) / tickRateScale;
 }
 
-uint32_t MidiPlayer::millisecondsToTicks(uint32_t ms) {
+template <class Sink>
+uint32_t MidiPlayerT<Sink>::ticksToMilliseconds(uint32_t ticks) {
+    return static_cast<uint32_t>(ticksToMicroseconds(ticks) / 1000);
+}
+
+template <class Sink>
+uint32_t MidiPlayerT<Sink>::millisecondsToTicks(uint32_t ms) {
     // Guard against division by zero
-    if (microsecondsPerTick == 0) return 0;
+    if (tickPeriodScaled == 0) return 0;
 
-    // Use 64-bit arithmetic to prevent overflow
-    uint64_t ticks = ((uint64_t)ms * 1000) / microsecondsPerTick;
-    return (uint32_t)ticks;
+    // Same overflow-safe split as ticksToMicroseconds()
+    uint64_t microseconds = static_cast<uint64_t>(ms) * 1000;
+    uint64_t whole = microseconds / tickPeriodScaled;
+    uint64_t part = microseconds % tickPeriodScaled;
+    return static_cast<uint32_t>(whole * tickRateScale + (part * tickRateScale) / tickPeriodScaled);
 }
 
-uint32_t MidiPlayer::getCurrentTimeMs() {
-    if (state != STATE_PLAYING) {
+template <class Sink>
+uint32_t MidiPlayerT<Sink>::getCurrentTimeMs() {
+    if (state != STATE_PLAYING || tickRateScale == 0) {
         // When stopped/paused, return time based on current tick position
         return ticksToMilliseconds(ticksElapsed);
     }
 
-    // When playing, add fractional time for smoother display
-    uint32_t currentMicros = micros();
-    uint32_t elapsedMicros = currentMicros - lastUpdateMicros;
+    // When playing, add the carried sub-tick remainder and time since the last update for smoother display
+    uint64_t now = time_us_64();
+    uint64_t sinceUpdate = (now > lastUpdateMicros) ? now - lastUpdateMicros : 0;
+    uint64_t fractionalMicros = tickAccumulator / tickRateScale + sinceUpdate;
 
-    // Calculate fractional milliseconds since last tick update
-    uint32_t fractionalMs = elapsedMicros / 1000;
-
-    // Add to tick-based time
-    return ticksToMilliseconds(ticksElapsed) + fractionalMs;
+    return static_cast<uint32_t>((ticksToMicroseconds(ticksElapsed) + fractionalMicros) / 1000);
 }
 
-uint32_t MidiPlayer::getTotalTimeMs() {
+template <class Sink>
+uint32_t MidiPlayerT<Sink>::getTotalTimeMs() {
     // Use the pre-calculated file length (scanned at load time)
     uint32_t lengthTicks = parser.getFileLengthTicks();
     return ticksToMilliseconds(lengthTicks);
 }
 
-void MidiPlayer::fastForward(uint32_t milliseconds) {
-    // Pause playback during seeking to prevent MIDI leakage and SD card conflicts
-    bool wasPlaying = (state == STATE_PLAYING);
-    if (wasPlaying) {
-        pause();  // Pause playback
-        delay(10);  // Brief delay to ensure update() has exited
-    }
-
-    // Stop all notes before seeking to prevent stuck notes
-    stopAllNotes();
-
-    // Convert to ticks and calculate target
-    uint32_t targetTicks = ticksElapsed + millisecondsToTicks(milliseconds);
-    uint32_t maxTicks = parser.getFileLengthTicks();
-
-    // Clamp to file length
-    if (targetTicks > maxTicks) {
-        targetTicks = maxTicks;
+template <class Sink>
+bool MidiPlayerT<Sink>::seekToTicks(uint32_t targetTicks) {
+    preloadedStart = false;  // Position moves - play() rewinds from here on
+    pendingLaunch = nullptr; // Its boundary was counted from the old position
+
+    // Restart from a checkpoint when going back, or when one lies between the
+    // pending event and the target; otherwise read on from where the parser is
+    int32_t checkpointTick = parser.getCheckpointTick(targetTicks);
+    bool restart = targetTicks < ticksElapsed ||
+                   (eventReady && checkpointTick > 0 && static_cast<uint32_t>(checkpointTick) > nextEvent.absoluteTime);
+    if (restart) {
+        int32_t from = parser.seekToCheckpoint(targetTicks);
+        if (from < 0) {
+            return false;  // SD card error
+        }
+        ticksElapsed = static_cast<uint32_t>(from);
+        meterOriginTicks = 0;  // Unknown before the checkpoint - count bars from the start
+        eventReady = parser.readNextEvent(nextEvent);
     }
 
-    // Fast-forward by processing events without sending them
+    // Skip to the target silently - the parser folds skipped controllers into its chase state
     uint32_t eventsProcessed = 0;
-    const uint32_t MAX_EVENTS_PER_FF = 50000; // Safety limit: ~10 minutes of dense MIDI
-    while (eventReady && nextEvent.absoluteTime <= targetTicks && eventsProcessed < MAX_EVENTS_PER_FF) {
+    while (eventReady && nextEvent.absoluteTime <= targetTicks && eventsProcessed < MAX_EVENTS_PER_SEEK) {
+        if (nextEvent.isMetaEvent && nextEvent.data1 == META_TIME_SIGNATURE) {
+            meterOriginTicks = nextEvent.absoluteTime;
+        }
         if (nextEvent.sysexData) {
             delete[] nextEvent.sysexData;
             nextEvent.sysexData = nullptr;
@@ -588,102 +1658,116 @@ void MidiPlayer::fastForward(uint32_t milliseconds) {
         }
     }
 
-    // If we hit the safety limit, stop seeking
-    if (eventsProcessed >= MAX_EVENTS_PER_FF) {
-        // Reached safety limit
-    }
-
     ticksElapsed = targetTicks;
-    lastUpdateMicros = micros();
+    tickAccumulator = 0;
+    pendingPhaseMicros = 0;
+    stretchDebtMicros = 0;
+    clearCollapsed();  // Late controller values belong to the old position
+    calculateTickRate();  // Tempo changes skipped over are in effect now
+    lastUpdateMicros = time_us_64();
+    chasePending = true;
+    return true;
+}
 
-    // Stop all notes again after seeking to be safe
-    stopAllNotes();
+template <class Sink>
+void MidiPlayerT<Sink>::sendChase() {
+    chasePending = false;
+
+    // Through the normal event path, so mutes, overrides and routing apply as
+    // they would have if the song had played up to here
+    const ChaseState& chase = parser.getChaseState();
+    MidiEvent event;
+    event.absoluteTime = ticksElapsed;
+    uint32_t messages = 0;
+
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        event.channel = ch;
+
+        // Bank select, then program, then the remaining controllers
+        event.type = MIDI_CONTROL_CHANGE;
+        for (uint8_t i = 0; i < CHASE_CONTROLLER_COUNT; i++) {
+            if (i == 2 && chase.program[ch] != CHASE_NONE) {
+                event.type = MIDI_PROGRAM_CHANGE;
+                event.data1 = chase.program[ch];
+                event.data2 = 0;
+                sendMidiEvent(event);
+                event.type = MIDI_CONTROL_CHANGE;
+                messages++;
+            }
+            if (chase.controller[ch][i] == CHASE_NONE) continue;
+            event.data1 = CHASE_CONTROLLERS[i];
+            event.data2 = chase.controller[ch][i];
+            sendMidiEvent(event);
+            messages++;
+        }
 
-    // Resume playback if we were playing before (stay paused if already paused)
-    if (wasPlaying) {
-        play();
+        if (chase.pitchBend[ch] != CHASE_BEND_NONE) {
+            event.type = MIDI_PITCH_BEND;
+            event.data1 = chase.pitchBend[ch] & 0x7F;
+            event.data2 = (chase.pitchBend[ch] >> 7) & 0x7F;
+            sendMidiEvent(event);
+            messages++;
+        }
     }
+
+    // Notes wait until the chase is on the wire
+    reserveWireTime(messages * 3);
 }
 
-void MidiPlayer::rewind(uint32_t milliseconds) {
-    // Pause playback during seeking to prevent MIDI leakage and SD card conflicts
+template <class Sink>
+void MidiPlayerT<Sink>::moveTo(uint32_t targetTicks) {
+    // update() can't run while the caller holds the player, so no pause/resume cycle
+    // is needed - silence what is sounding and carry on from the new position
     bool wasPlaying = (state == STATE_PLAYING);
-    if (wasPlaying) {
-        pause();  // Pause playback
-        delay(10);  // Brief delay to ensure update() has exited
+    if (wasPlaying && clockEnabled) {
+        midiOut->sendStop();
     }
 
     // Stop all notes before seeking to prevent stuck notes
     stopAllNotes();
 
-    uint32_t rewindTicks = millisecondsToTicks(milliseconds);
-    uint32_t targetTicks = 0;
-
-    if (ticksElapsed > rewindTicks) {
-        // Calculate target position
-        targetTicks = ticksElapsed - rewindTicks;
-    } else {
-        // Rewind would go past beginning, go to start
-        targetTicks = 0;
+    // Clamp to file length
+    uint32_t maxTicks = parser.getFileLengthTicks();
+    if (targetTicks > maxTicks) {
+        targetTicks = maxTicks;
     }
 
-    // Reset parser and seek to target position
-    if (!parser.reset()) {
-        // Reset failed - SD card error, abort rewind
+    if (!seekToTicks(targetTicks)) {
+        // SD card error - abort the seek and leave playback paused
+        if (wasPlaying) state = STATE_PAUSED;
         return;
     }
-    ticksElapsed = 0;
-    eventReady = parser.readNextEvent(nextEvent);
-
-    // Fast-forward to target position (silently - events not sent)
-    if (targetTicks > 0) {
-        uint32_t eventsProcessed = 0;
-        const uint32_t MAX_EVENTS_PER_REWIND = 50000; // Safety limit
-        while (eventReady && nextEvent.absoluteTime <= targetTicks && eventsProcessed < MAX_EVENTS_PER_REWIND) {
-            if (nextEvent.sysexData) {
-                delete[] nextEvent.sysexData;
-                nextEvent.sysexData = nullptr;
-            }
-            eventReady = parser.readNextEvent(nextEvent);
-
-            // Yield every 100 events to prevent SD card timeout
-            eventsProcessed++;
-            if (eventsProcessed % 100 == 0) {
-                yield();
-            }
-        }
-
-        // If we hit the safety limit, stop seeking
-        if (eventsProcessed >= MAX_EVENTS_PER_REWIND) {
-            // Reached safety limit
-        }
-
-        ticksElapsed = targetTicks;
-    }
-
-    lastUpdateMicros = micros();
-
-    // Stop all notes again after seeking to be safe
-    stopAllNotes();
 
-    // Resume playback if we were playing before (stay paused if already paused)
+    // Playback continues from the new position once the chase and cleanup are on the wire
     if (wasPlaying) {
-        play();
+        sendChase();
+        if (clockEnabled) {
+            midiOut->sendContinue();
+        }
+        resumeAfterCleanup();
     }
 }
 
-void MidiPlayer::seek(uint32_t milliseconds) {
-    // Stop all notes before seeking
-    stopAllNotes();
+template <class Sink>
+void MidiPlayerT<Sink>::fastForward(uint32_t milliseconds) {
+    moveTo(ticksElapsed + millisecondsToTicks(milliseconds));
+}
 
-    // Restart and fast-forward to position
-    if (!parser.reset()) {
-        // Reset failed - SD card error, abort seek
-        return;
-    }
-    ticksElapsed = 0;
-    eventReady = parser.readNextEvent(nextEvent);
-    fastForward(milliseconds);
+template <class Sink>
+void MidiPlayerT<Sink>::rewind(uint32_t milliseconds) {
+    uint32_t rewindTicks = millisecondsToTicks(milliseconds);
+    moveTo((ticksElapsed > rewindTicks) ? ticksElapsed - rewindTicks : 0);
+}
 
-    // Note: fastForward() already calls stopAllNotes() at end
+template <class Sink>
+void MidiPlayerT<Sink>::seek(uint32_t milliseconds) {
+    moveTo(millisecondsToTicks(milliseconds));
 }
+
+// Explicit instantiations - add one here for each sink the firmware uses
+template class MidiPlayerT<MidiOutput>;
+template class MidiPlayerT<SmfWriter>;  // Offline render
+#if MIDI_DISPATCH_BENCHMARK
+template class MidiPlayerT<CountingMidiSink>;
+template class MidiPlayerT<RecordingMidiSink>;  // Host tests
+#endif
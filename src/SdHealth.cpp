@@ -0,0 +1,89 @@
+#include "SdHealth.h"
+
+SdHealth::SdHealth() {
+    reset();
+}
+
+void SdHealth::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    readCount = 0;
+    maxMicros = 0;
+    totalMicros = 0;
+    readErrors = 0;
+    recoveredReads = 0;
+    deferredEvents = 0;
+    lostTracks = 0;
+    reinitRequested = false;
+}
+
+void SdHealth::recordRead(uint32_t latencyMicros, uint32_t bytes) {
+    (void)bytes; // Refills are at most one track buffer, so latency alone tells the story
+
+    // Bucket = how many doublings above 64us
+    uint8_t bucket = 0;
+    uint32_t bound = 64;
+    while (bucket < SD_LATENCY_BUCKETS - 1 && latencyMicros >= bound) {
+        bound <<= 1;
+        bucket++;
+    }
+    buckets[bucket]++;
+
+    readCount++;
+    totalMicros += latencyMicros;
+    if (latencyMicros > maxMicros) {
+        maxMicros = latencyMicros;
+    }
+}
+
+uint32_t SdHealth::getAverageMicros() {
+    if (readCount == 0) return 0;
+    return static_cast<uint32_t>(totalMicros / readCount);
+}
+
+uint32_t SdHealth::getPercentileMicros(uint8_t percent) {
+    if (readCount == 0) return 0;
+    if (percent > 100) percent = 100;
+
+    // Smallest bucket whose cumulative count reaches the percentile
+    uint64_t target = (static_cast<uint64_t>(readCount) * percent + 99) / 100;
+    uint64_t cumulative = 0;
+    for (uint8_t bucket = 0; bucket < SD_LATENCY_BUCKETS; bucket++) {
+        cumulative += buckets[bucket];
+        if (cumulative >= target) {
+            // The last bucket is open-ended - the maximum is the honest bound
+            if (bucket == SD_LATENCY_BUCKETS - 1) return maxMicros;
+            uint32_t bound = 64UL << bucket;
+            return (bound < maxMicros) ? bound : maxMicros;
+        }
+    }
+    return maxMicros;
+}
+
+uint32_t SdHealth::getBucketCount(uint8_t bucket) {
+    if (bucket >= SD_LATENCY_BUCKETS) return 0;
+    return buckets[bucket];
+}
+
+bool SdHealth::isMarginal() {
+    if (readErrors > 0) return true;
+    if (maxMicros >= SD_MARGINAL_MAX_MICROS) return true;
+    if (readCount < SD_MARGINAL_MIN_READS) return false;
+    return getPercentileMicros(99) >= SD_MARGINAL_P99_MICROS;
+}
+
+uint16_t SdHealth::getRecommendedPrefetchBytes(uint16_t bufferSize) {
+    // Bytes a track could consume during the worst stall, with 2x headroom
+    uint64_t bytes = static_cast<uint64_t>(maxMicros) * SD_PREFETCH_BYTES_PER_SEC * 2 / 1000000;
+
+    // Leave a quarter of the buffer free so a top-up is worth the seek
+    uint16_t limit = bufferSize - bufferSize / 4;
+    if (bytes < SD_PREFETCH_MIN_BYTES) bytes = SD_PREFETCH_MIN_BYTES;
+    if (bytes > limit) bytes = limit;
+    return static_cast<uint16_t>(bytes);
+}
+
+bool SdHealth::takeReinitRequest() {
+    bool requested = reinitRequested;
+    reinitRequested = false;
+    return requested;
+}
@@ -0,0 +1,154 @@
+#include "SmfWriter.h"
+
+SmfWriter::SmfWriter() {
+    file = nullptr;
+    used = 0;
+    flushedBytes = 0;
+    trackStart = 0;
+    trackCount = 0;
+    trackPort = 0;
+    portsUsed = 0;
+    runningStatus = 0;
+    currentTick = 0;
+    lastTick = 0;
+    ok = false;
+}
+
+bool SmfWriter::begin(FatFile* f, uint16_t ticksPerQuarter) {
+    file = f;
+    used = 0;
+    flushedBytes = 0;
+    trackCount = 0;
+    portsUsed = 0;
+    ok = (file != nullptr);
+
+    // Format and track count are placeholders until finish()
+    static const uint8_t header[] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 0 };
+    for (uint8_t i = 0; i < sizeof(header); i++) put(header[i]);
+    put((uint8_t)(ticksPerQuarter >> 8));
+    put((uint8_t)ticksPerQuarter);
+    return ok;
+}
+
+void SmfWriter::beginTrack(uint8_t port) {
+    static const uint8_t chunk[] = { 'M', 'T', 'r', 'k', 0, 0, 0, 0 };
+    for (uint8_t i = 0; i < sizeof(chunk); i++) put(chunk[i]);
+    trackStart = flushedBytes + used;
+    trackPort = port;
+    runningStatus = 0;
+    currentTick = 0;
+    lastTick = 0;
+    trackCount++;
+
+    if (trackCount > 1) {
+        putMeta(SMF_META_MIDI_PORT, &port, 1);
+    }
+}
+
+bool SmfWriter::endTrack() {
+    putMeta(0x2F, nullptr, 0);  // End of Track
+    if (!flush()) return false;
+
+    uint32_t length = flushedBytes - trackStart;
+    uint8_t bytes[4] = { (uint8_t)(length >> 24), (uint8_t)(length >> 16), (uint8_t)(length >> 8), (uint8_t)length };
+    return patch(trackStart - 4, bytes, 4);
+}
+
+bool SmfWriter::finish() {
+    if (!flush()) return false;
+
+    uint8_t formatAndCount[4] = { 0, (uint8_t)(trackCount > 1 ? 1 : 0), (uint8_t)(trackCount >> 8), (uint8_t)trackCount };
+    if (!patch(8, formatAndCount, 4)) return false;
+    return ok && file->sync();
+}
+
+void SmfWriter::writeTempo(uint32_t microsPerQuarter) {
+    if (microsPerQuarter > 0xFFFFFF) microsPerQuarter = 0xFFFFFF;
+    uint8_t data[3] = { (uint8_t)(microsPerQuarter >> 16), (uint8_t)(microsPerQuarter >> 8), (uint8_t)microsPerQuarter };
+    putMeta(0x51, data, 3);
+}
+
+void SmfWriter::writeTimeSignature(uint8_t numerator, uint8_t denominator) {
+    // Denominator as a power of two; 24 clocks per click, 8 32nds per quarter
+    uint8_t power = 0;
+    while ((1 << (power + 1)) <= denominator && power < 7) power++;
+    uint8_t data[4] = { numerator, power, 24, 8 };
+    putMeta(0x58, data, 4);
+}
+
+void SmfWriter::sendSysEx(const uint8_t* data, uint16_t length, uint8_t port) {
+    portsUsed |= 1 << port;
+    if (port != trackPort || !data || length == 0) return;
+
+    // Stored as in the song: F0, length, the bytes after F0 (F7 included)
+    if (data[0] == 0xF0) {
+        data++;
+        length--;
+    }
+    putDelta();
+    put(0xF0);
+    putVarLength(length);
+    for (uint16_t i = 0; i < length; i++) put(data[i]);
+    runningStatus = 0;
+}
+
+void SmfWriter::channelMessage(uint8_t port, uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2, uint8_t length) {
+    portsUsed |= 1 << port;
+    if (port != trackPort) return;
+
+    uint8_t status = type | ((channel - 1) & 0x0F);
+    putDelta();
+    if (status != runningStatus) {
+        put(status);
+        runningStatus = status;
+    }
+    put(data1 & 0x7F);
+    if (length == 3) put(data2 & 0x7F);
+}
+
+void SmfWriter::putMeta(uint8_t type, const uint8_t* data, uint8_t length) {
+    putDelta();
+    put(0xFF);
+    put(type);
+    putVarLength(length);
+    for (uint8_t i = 0; i < length; i++) put(data[i]);
+    runningStatus = 0;
+}
+
+void SmfWriter::putDelta() {
+    putVarLength(currentTick - lastTick);
+    lastTick = currentTick;
+}
+
+void SmfWriter::putVarLength(uint32_t value) {
+    uint8_t bytes[4];
+    uint8_t count = 0;
+    do {
+        bytes[count++] = value & 0x7F;
+        value >>= 7;
+    } while (value && count < 4);
+    while (count > 1) put(bytes[--count] | 0x80);
+    put(bytes[0]);
+}
+
+void SmfWriter::put(uint8_t value) {
+    buffer[used++] = value;
+    if (used == SMF_WRITER_BUFFER_SIZE) flush();
+}
+
+bool SmfWriter::flush() {
+    if (used == 0) return ok;
+    if (ok && file->write(buffer, used) != used) ok = false;
+    flushedBytes += used;
+    used = 0;
+    return ok;
+}
+
+// Overwrite bytes already on the card, then carry on at the end
+bool SmfWriter::patch(uint32_t offset, const uint8_t* data, uint8_t length) {
+    if (!ok) return false;
+    if (!file->seekSet(offset) || file->write(data, length) != length || !file->seekSet(flushedBytes)) {
+        ok = false;
+    }
+    return ok;
+}
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <SdFat.h>
 #include <pico/mutex.h>
+#include <pico/time.h>
 #include "pins.h"
 #include "MidiOutput.h"
 #include "MidiInput.h"
@@ -9,6 +10,11 @@
 #include "DisplayManager.h"
 #include "InputHandler.h"
 #include "RAII.h"
+#include "LengthCache.h"
+#include "SdHealth.h"
+#include "Crc32.h"
+#include "MidiSinks.h"
+#include "SmfWriter.h"
 
 // Global objects
 SdFat sd;
@@ -18,6 +24,11 @@ MidiPlayer player(&midiOut);
 FileBrowser browser;
 DisplayManager display;
 InputHandler input;
+SdHealth sdHealth;     // Read latency profile of the inserted card
+char sdCardName[6] = "?";  // Product name from the card's CID register
+char sdCardId[11] = "";     // Manufacturer ID + serial number (hex), key for the remembered clock
+uint8_t sdClockStep = 0;   // Index into SD_CLOCK_STEPS_HZ
+uint32_t sdBenchBytesPerSec = 0;  // Raw read throughput measured at the chosen clock
 
 // Mutex for thread-safe access to player object (shared between Core 0 and Core 1)
 mutex_t playerMutex;
@@ -37,6 +48,7 @@ constexpr unsigned long BUTTON_HOLD_JUMP_MS = 2000;   // Hold MODE for 2 seconds
 constexpr unsigned long VISUALIZER_REFRESH_MS = 16;   // 60Hz refresh for visualizer (playing)
 constexpr unsigned long VISUALIZER_IDLE_REFRESH_MS = 500;  // 2Hz refresh when stopped (prevent I2C lockup)
 constexpr unsigned long UI_REFRESH_MS = 100;          // 10Hz refresh for other UI modes
+constexpr unsigned long MESSAGE_HOLD_MS = 2000;       // A message from a background check stays up this long
 
 // Visualizer decay timing
 constexpr unsigned long VISUALIZER_DECAY_CHECK_MS = 8;  // Check decay every 8ms (120Hz)
@@ -46,15 +58,47 @@ constexpr unsigned long VISUALIZER_PEAK_HOLD_MS = 800;   // Peak hold duration
 constexpr uint8_t VISUALIZER_PEAK_THRESHOLD = 10;     // Minimum increase to trigger new peak hold
 constexpr uint8_t VISUALIZER_DECAY_FLOOR = 3;         // Activity floor before zeroing
 
+// Shuttle: holding LEFT/RIGHT on TIME scrubs the song, faster the longer it is held
+constexpr unsigned long SHUTTLE_HOLD_MS = 200;        // Hold before the shuttle takes over from 1s skips
+constexpr unsigned long SHUTTLE_STEP_MS = 100;        // Position and display update interval
+constexpr uint16_t SHUTTLE_SPEEDS[] = { 4, 8, 16, 32, 64 };  // Song seconds per second, one step up per second held
+constexpr uint8_t SHUTTLE_SPEED_COUNT = sizeof(SHUTTLE_SPEEDS) / sizeof(SHUTTLE_SPEEDS[0]);
+
 // File operation limits
 constexpr uint32_t MAX_FF_EVENTS_SAFETY = 50000;      // Max events to process during fast-forward seek
 
 // MIDI timing
-constexpr unsigned long SYSEX_DELAY_MS = 35;          // Delay after SysEx (MT-32 compatibility)
-constexpr unsigned long MIDI_SETTLE_DELAY_MS = 10;    // General MIDI settling delay
+constexpr unsigned long SYSEX_DELAY_MS = 35;          // Delay after SysEx (MT-32 compatibility), default .syx message gap
+
+// Setting values as they are written in /settings.cfg
+// CATCHUP_POLICY (indexed by CatchUpPolicy)
+const char* const CATCHUP_POLICY_NAMES[CATCHUP_POLICY_COUNT] = { "SEND_ALL", "DROP_STALE", "COLLAPSE", "STRETCH" };
+// LAUNCH, also shown on the clock menu (indexed by LaunchQuantize)
+const char* const LAUNCH_QUANTIZE_NAMES[LAUNCH_QUANTIZE_COUNT] = { "NOW", "BEAT", "BAR" };
 
 // SD card timing
-constexpr unsigned long SD_CLOSE_DELAY_MS = 20;       // Delay after closing files before opening new ones
+constexpr unsigned long SD_HEALTH_CHECK_MS = 500;     // How often Core 0 looks for new SD read errors
+
+// SD clock steps - boot negotiates the fastest one that reads back cleanly,
+// and the card drops to the next one when a read fails every retry
+constexpr uint32_t SD_CLOCK_STEPS_HZ[] = { 25000000, 20000000, 16000000, 12000000, 8000000, 4000000 };
+constexpr uint8_t SD_CLOCK_STEP_COUNT = sizeof(SD_CLOCK_STEPS_HZ) / sizeof(SD_CLOCK_STEPS_HZ[0]);
+constexpr uint8_t SD_BENCH_SECTORS = 64;              // 32 KB of the FAT read per benchmark pass
+constexpr uint8_t SD_BENCH_SECTORS_PER_READ = 4;
+const char* const SD_CLOCK_FILE_PATH = "/.cache/sdclock";  // <card id>,<clock Hz>
+
+// .syx sending
+constexpr uint16_t SYSEX_CHUNK_SIZE = MIDI_PORT_TX_QUEUE_SIZE / 2;  // Card read and largest single send (fits a PIO port queue)
+constexpr uint8_t SYSEX_GAP_STEP_MS = 5;
+constexpr uint8_t SYSEX_GAP_MAX_MS = 250;
+
+// Setlists: songs kept in RAM while a .set file is open in the browser
+constexpr uint8_t MAX_SETLIST_SONGS = 32;             // Later songs load from the card as usual
+constexpr uint32_t SETLIST_HEAP_RESERVE = 48 * 1024;  // Free heap kept for SysEx, the SD library and the display
+
+// Audition: the highlighted file starts once the cursor has rested this long,
+// so scrolling through a folder opens none of the files passed over
+constexpr unsigned long AUDITION_SETTLE_MS = 150;
 
 // Transpose cooldown (prevent rapid changes that cause hung notes)
 constexpr unsigned long TRANSPOSE_COOLDOWN_MS = 200;  // Minimum time between transpose changes
@@ -70,6 +114,13 @@ constexpr uint32_t MAX_TARGET_BPM = 30000;            // 300.00 BPM
 constexpr uint32_t DEFAULT_TARGET_BPM = 12000;        // 120.00 BPM
 constexpr unsigned long BPM_HOLD_THRESHOLD_MS = 500;  // Hold time to switch to coarse adjustment
 
+// Tap tempo
+constexpr uint8_t TAP_WINDOW_SIZE = 8;                // Taps kept for the tempo estimate (7 intervals)
+constexpr uint64_t TAP_TIMEOUT_MICROS = 2000000;      // 2s without a tap starts a new sequence
+constexpr uint32_t TAP_MIN_INTERVAL_MICROS = 200000;  // 300 BPM
+constexpr uint32_t TAP_MAX_INTERVAL_MICROS = 1500000; // 40 BPM
+constexpr uint8_t TAP_OUTLIER_PERCENT = 20;           // Reject intervals more than 20% away from the median
+
 constexpr uint8_t DEFAULT_VELOCITY_SCALE = 50;        // 50 = normal MIDI velocity
 constexpr uint8_t USE_FILE_DEFAULT_VELOCITY = 0;      // 0 = use file default (50)
 constexpr uint8_t MIN_VELOCITY_SCALE = 1;             // Minimum velocity scale
@@ -97,7 +148,8 @@ enum AppMode {
     APP_MODE_ROUTING,
     APP_MODE_MIDI_SETTINGS,
     APP_MODE_CLOCK_SETTINGS,
-    APP_MODE_VISUALIZER
+    APP_MODE_VISUALIZER,
+    APP_MODE_DIAGNOSTICS
 };
 
 enum ChannelMenuOption {
@@ -116,9 +168,13 @@ enum ChannelMenuOption {
 enum TrackMenuOption {
     TRACK_OPTION_SAVE,
     TRACK_OPTION_DELETE,
+    TRACK_OPTION_PART,       // Track (MTrk) picked for part mute/solo
+    TRACK_OPTION_PART_MUTE,
     TRACK_OPTION_BPM,
     TRACK_OPTION_VELOCITY,
     TRACK_OPTION_SYSEX,
+    TRACK_OPTION_SCENE,
+    TRACK_OPTION_RENDER,     // Export the song with the live settings applied
     TRACK_OPTION_COUNT
 };
 
@@ -132,6 +188,8 @@ enum MidiSettingsOption {
 
 enum ClockSettingsOption {
     CLOCK_OPTION_ENABLED,
+    CLOCK_OPTION_TAP_SYNC,
+    CLOCK_OPTION_LAUNCH,
     CLOCK_OPTION_COUNT
 };
 
@@ -146,7 +204,8 @@ enum RoutingMenuOption {
 enum ConfirmAction {
     CONFIRM_NONE,
     CONFIRM_SAVE,
-    CONFIRM_DELETE
+    CONFIRM_DELETE,
+    CONFIRM_RENDER
 };
 
 // Simple visualizer state (GENaJam-Pi style, adapted for 16 channels)
@@ -161,7 +220,8 @@ struct VisualizerState {
 struct ApplicationState {
     // Current mode and file
     AppMode currentMode;
-    FatFile currentFile;
+    FatFile songFiles[2];       // The loaded song, and the next one while a quantized launch is queued
+    uint8_t currentFileIndex;   // Which of songFiles the player reads
     FileEntry* lastPlayedFile;
 
     // Playback menu state
@@ -185,9 +245,9 @@ struct ApplicationState {
     bool sysexEnabled;          // True = send SysEx messages, False = skip them
 
     // Tap tempo state
-    uint32_t tapTimes[4];       // Last 4 tap timestamps (milliseconds)
-    uint8_t tapCount;           // Number of taps recorded (0-4)
-    uint32_t lastTapTime;       // Time of last tap
+    uint64_t tapTimes[TAP_WINDOW_SIZE];  // Recent tap timestamps (hardware microseconds, circular)
+    uint8_t tapCount;           // Number of taps recorded in this sequence
+    uint64_t lastTapTime;       // Time of last tap (microseconds)
     uint16_t calculatedBPM;     // Current calculated BPM from taps
 
     // Channel settings (per-channel configuration)
@@ -201,9 +261,16 @@ struct ApplicationState {
     uint16_t channelSolos;  // Bitmask for 16 channels (like channelMutes)
 
     // Routing settings (per-channel routing)
-    uint8_t channelRouting[16];   // 255 = use original channel, 0-15 = route to that channel
+    uint8_t channelRouting[16];   // 255 = use original channel, else (port << 4) | channel
     uint8_t selectedRoutingChannel;
     uint8_t originalRouting;      // Track original routing value before editing (for CC 123)
+    uint64_t channelLayers[16];   // Extra fan-out destinations per channel, bit (port << 4) | channel
+
+    // Scenes (stored in the player, this is only the menu cursor)
+    uint8_t selectedScene;        // 0 to MAX_SCENES-1
+
+    // Part mute/solo (stored in the player, this is only the menu cursor)
+    uint8_t selectedPart;         // Track (MTrk) index, 0 to numTracks-1
 
     // MIDI IN Settings
     bool midiThruEnabled;
@@ -213,6 +280,22 @@ struct ApplicationState {
 
     // MIDI Clock Settings
     bool midiClockEnabled;
+    bool tapPhaseAlign;         // True = tap tempo also nudges song phase onto the tap grid
+    LaunchQuantize launchQuantize;  // PREV/NEXT while playing: switch at once, or on the next beat/bar
+
+    // Playback overload handling
+    CatchUpPolicy catchUpPolicy;
+
+    // .syx sending
+    uint8_t sysexGapMs;         // Pause after each message, for receivers that need time to store it
+
+    // SD diagnostics screen
+    uint8_t diagnosticsPage;    // 0 = read latency, 1 = bus clock, throughput and MIDI drops
+
+    // Shuttle (hold LEFT/RIGHT on TIME)
+    int8_t shuttleDirection;    // -1/+1 while shuttling, 0 = not
+    unsigned long shuttleHoldStart;
+    unsigned long lastShuttleStep;
 
     // Visualizer state (simple velocity tracking)
     VisualizerState vizChannels[16];     // Visualizer state per channel
@@ -242,6 +325,7 @@ struct ApplicationState {
     // Constructor: Initialize with default values
     ApplicationState()
         : currentMode(APP_MODE_BROWSE)
+        , currentFileIndex(0)
         , lastPlayedFile(nullptr)
         , currentPlaybackOption(MENU_TRACK)
         , playbackOptionActive(false)
@@ -266,11 +350,21 @@ struct ApplicationState {
         , channelSolos(0)
         , selectedRoutingChannel(0)
         , originalRouting(255)
+        , selectedScene(0)
+        , selectedPart(0)
         , midiThruEnabled(false)
         , midiKeyboardEnabled(false)
         , midiKeyboardChannel(1)
         , midiKeyboardVelocity(50)
         , midiClockEnabled(false)
+        , tapPhaseAlign(false)
+        , launchQuantize(LAUNCH_NOW)
+        , catchUpPolicy(CATCHUP_SEND_ALL)
+        , sysexGapMs(SYSEX_DELAY_MS)
+        , diagnosticsPage(0)
+        , shuttleDirection(0)
+        , shuttleHoldStart(0)
+        , lastShuttleStep(0)
         , currentChannelOption(CH_OPTION_CHANNEL)
         , channelOptionActive(false)
         , currentTrackOption(TRACK_OPTION_SAVE)
@@ -287,7 +381,7 @@ struct ApplicationState {
         , justActivatedOption(false)
     {
         // Initialize tap tempo timestamps
-        for (int i = 0; i < 4; i++) {
+        for (int i = 0; i < TAP_WINDOW_SIZE; i++) {
             tapTimes[i] = 0;
         }
 
@@ -299,6 +393,7 @@ struct ApplicationState {
             channelTranspose[i] = 0;  // No transpose by default
             channelVelocity[i] = 0;   // 0 = use MIDI file default
             channelRouting[i] = 255;  // 255 = use original channel (no routing)
+            channelLayers[i] = 0;     // No layered copies
             channelActivity[i] = 0;
             channelPeak[i] = 0;
 
@@ -319,10 +414,14 @@ ApplicationState appState;
 // Protects concurrent access to vizChannels[], channelActivity[], channelPeak[]
 spin_lock_t* visualizerSpinLock = nullptr;
 
+// The periodic refresh leaves a message shown by a background check up until this time (millis)
+unsigned long messageHoldUntil = 0;
+
 // Convenience references to appState members (for easier migration)
 // These avoid having to change every variable reference throughout the code
 AppMode& currentMode = appState.currentMode;
-FatFile& currentFile = appState.currentFile;
+FatFile* songFiles = appState.songFiles;
+uint8_t& currentFileIndex = appState.currentFileIndex;
 FileEntry*& lastPlayedFile = appState.lastPlayedFile;
 PlaybackMenuOption& currentPlaybackOption = appState.currentPlaybackOption;
 bool& playbackOptionActive = appState.playbackOptionActive;
@@ -340,9 +439,9 @@ bool& bpmEditingWhole = appState.bpmEditingWhole;
 uint8_t& velocityScale = appState.velocityScale;
 uint8_t& velocityScaleDefault = appState.velocityScaleDefault;
 bool& sysexEnabled = appState.sysexEnabled;
-uint32_t* tapTimes = appState.tapTimes;
+uint64_t* tapTimes = appState.tapTimes;
 uint8_t& tapCount = appState.tapCount;
-uint32_t& lastTapTime = appState.lastTapTime;
+uint64_t& lastTapTime = appState.lastTapTime;
 uint16_t& calculatedBPM = appState.calculatedBPM;
 uint8_t& selectedChannel = appState.selectedChannel;
 uint8_t* channelPrograms = appState.channelPrograms;
@@ -355,11 +454,22 @@ uint16_t& channelSolos = appState.channelSolos;
 uint8_t* channelRouting = appState.channelRouting;
 uint8_t& selectedRoutingChannel = appState.selectedRoutingChannel;
 uint8_t& originalRouting = appState.originalRouting;
+uint64_t* channelLayers = appState.channelLayers;
+uint8_t& selectedScene = appState.selectedScene;
+uint8_t& selectedPart = appState.selectedPart;
 bool& midiThruEnabled = appState.midiThruEnabled;
 bool& midiKeyboardEnabled = appState.midiKeyboardEnabled;
 uint8_t& midiKeyboardChannel = appState.midiKeyboardChannel;
 uint8_t& midiKeyboardVelocity = appState.midiKeyboardVelocity;
 bool& midiClockEnabled = appState.midiClockEnabled;
+bool& tapPhaseAlign = appState.tapPhaseAlign;
+LaunchQuantize& launchQuantize = appState.launchQuantize;
+CatchUpPolicy& catchUpPolicy = appState.catchUpPolicy;
+uint8_t& sysexGapMs = appState.sysexGapMs;
+uint8_t& diagnosticsPage = appState.diagnosticsPage;
+int8_t& shuttleDirection = appState.shuttleDirection;
+unsigned long& shuttleHoldStart = appState.shuttleHoldStart;
+unsigned long& lastShuttleStep = appState.lastShuttleStep;
 VisualizerState* vizChannels = appState.vizChannels;
 uint8_t* channelActivity = appState.channelActivity;
 uint8_t* channelPeak = appState.channelPeak;
@@ -378,6 +488,19 @@ ConfirmAction& pendingConfirmAction = appState.pendingConfirmAction;
 bool& confirmSelection = appState.confirmSelection;
 bool& justActivatedOption = appState.justActivatedOption;
 
+// Everything a song's .cfg file sets, as loadTrackSettings() applies it
+struct SongSettings {
+    ChannelScene channels;      // Live mutes, solos, overrides and routing
+    uint16_t trackMutes;
+    uint16_t trackSolos;
+    uint8_t velocityScale;
+    bool sysexEnabled;
+    bool useTargetBPM;
+    uint32_t targetBPM;
+    uint32_t savedConfigBPM;
+    uint8_t sceneMask;          // Bit n = scene n is stored
+};
+
 // Function declarations
 void handleBrowseMode(Button btn);
 void handlePlayMode(Button btn);
@@ -388,6 +511,7 @@ void handleRoutingMode(Button btn);
 void handleMidiSettingsMode(Button btn);
 void handleClockSettingsMode(Button btn);
 void handleVisualizerMode(Button btn);
+void handleDiagnosticsMode(Button btn);
 void updateDisplay();
 void onNoteOn(uint8_t channel, uint8_t note, uint8_t velocity);
 void onNoteOff(uint8_t channel, uint8_t note);
@@ -396,24 +520,62 @@ void updateChannelLevels();
 void resetVisualizer();
 bool loadAndPlayFile();
 bool loadFileOnly();
-void sendProgramChanges();
-void sendChannelVolumes();
-void sendChannelPan();
+void sendOverrideSetup();  // Program/volume/pan overrides to every destination of their channel
 bool saveTrackSettings(const char* midiFilename);
 void resetChannelSettingsToDefaults();
 bool loadTrackSettings(const char* midiFilename);
+void resetScene(ChannelScene& scene);
+void writeSceneSection(FatFile& file, uint8_t index, const ChannelScene& scene);
+void parseSceneLine(char* line, ChannelScene& scene);
 int deleteTrackSettings(const char* midiFilename);
 void buildConfigPath(const char* midiFilename, char* configPath, size_t configPathSize);
 bool saveGlobalSettings();
 bool loadGlobalSettings();
 void applySoloLogic();  // Apply solo logic to mutes
+void stepPartMute(bool forward);  // Cycle the selected part: unmuted, muted, solo
+void captureScene(ChannelScene& scene);  // Snapshot current channel settings
+void syncSceneToUi();  // Copy the player's active scene into the menu arrays
+bool selectScene(uint8_t index);  // Recall a scene and update the menus
 void handleTapTempo();  // Handle tap tempo input
+void stepSong(int8_t direction);  // Previous (-1) / next (+1) song, keeping play state
+bool loadRemoteMappings();  // Load MIDI IN remote-control mapping table
+void handleRemoteRequests();  // Complete remote-control commands that need Core 0
+void checkSdHealth();  // Log SD read errors and slow the card down after a hard failure
+void updateShuttle();  // Scrub while LEFT/RIGHT is held on the TIME option
+bool negotiateSdClock();  // Mount the card at the fastest clock that passes the benchmark
+bool benchmarkSd(uint32_t& crc, uint32_t& bytesPerSec);  // Timed raw read of the start of the FAT
+int8_t loadSdClock();  // Remembered clock step for this card (-1 = none)
+void saveSdClock();
 void setTargetBPM(uint32_t bpmHundredths);  // Set target BPM and calculate tempo percent
+void applyFileTempo();  // Read the loaded song's BPM and apply the target BPM to it
+bool stepSequence(int8_t direction);  // Format 2: previous/next sequence in the file (false = none)
+void preloadSetlist();  // Keep the open setlist's songs in RAM, then load the first one
+void releaseSetlist();  // Free the RAM copies (browser left the setlist)
+void updateSetlistSettings(bool deleted);  // Settings of the current song were saved or deleted
+bool readSongSettings(const char* midiFilename, SongSettings& settings, ChannelScene* scenes);  // Parse a .cfg, live state untouched (scenes: MAX_SCENES)
+void applySongSettings(const SongSettings& settings, const ChannelScene* scenes);  // Make them live and send the device setup
+void cancelSongLaunch();  // Drop a queued quantized launch (or finish it if the player already switched)
+void updateSongLaunch();  // Take over a quantized launch the player has carried out
+bool isAuditioning();  // Browser is in audition mode
+void beginAudition();  // Preview the highlighted file, and each one the cursor stops on
+void endAudition();  // Stop the preview and leave audition mode
+void scheduleAudition();  // Cursor moved: stop the preview, start the new file once it rests
+void updateAudition();  // Start a preview that has come due
+bool renderSong(FileEntry* entry);  // Write the song with the live settings applied to <name>_R.mid
+bool isSysExSendOpen();  // The .syx send screen is up (it has the output and the buttons)
+void openSysExSend(FileEntry* entry);  // Show the send screen for a .syx file
+void handleSysExSendMode(Button btn);  // Buttons and screen refresh while the send screen is up
+void showSysExSend();  // Draw the send screen
+void updateSysExSend();  // Post the next paced piece of a running send
 
 // File length cache system (max 200 entries, LRU eviction)
-uint32_t getCachedFileLength(const char* filename, uint32_t modtime, uint16_t* outSysexCount = nullptr);
-void cacheFileLength(const char* filename, uint32_t modtime, uint32_t lengthTicks, uint16_t sysexCount);
-void calculateAndCacheFileLength(const char* fullPath, MidiFileParser& fileParser);
+uint32_t getCachedFileLength(const FileIdentity& identity, uint16_t* outSysexCount = nullptr);
+void cacheFileLength(const FileIdentity& identity, uint32_t lengthTicks, uint16_t sysexCount);
+void calculateAndCacheFileLength(const FileIdentity& identity, MidiFileParser& fileParser);
+
+#if MIDI_DISPATCH_BENCHMARK
+void runDispatchBenchmark(const char* path);  // Time the player's per-event work on a counting sink
+#endif
 
 void setup1();  // Core 1 setup
 void loop1();   // Core 1 loop
@@ -452,15 +614,15 @@ void setup() {
     pinMode(SD_CS_PIN, OUTPUT);
     digitalWrite(SD_CS_PIN, HIGH);
 
-    // Try 12 MHz for balance of speed and stability
-    // Falls back to slower speeds if initialization fails
-    if (!sd.begin(SD_CS_PIN, SD_SCK_HZ(12000000))) {
+    // Fastest clock the card reads back cleanly, stepping down from 25 MHz
+    if (!negotiateSdClock()) {
         display.showError("SD Card Failed!");
         Serial.println("ERROR: SD card initialization failed!");
         while (1) {
             delay(1000);
         }
     }
+    player.getParser().setHealthMonitor(&sdHealth);
 
     // Create MIDI folder if it doesn't exist
     if (!sd.exists("/MIDI")) {
@@ -497,12 +659,22 @@ void setup() {
     display.showMessage("Loading", "Settings...");
     loadGlobalSettings();
 
+    // MIDI IN remote control (foot controller / pads) - commands run on Core 1
+    midiIn.setRemoteTarget(&player, &playerMutex);
+    loadRemoteMappings();
+
     // Show ready message
     display.showMessage("Ready!", "");
     delay(500);
 
     // Load the first file (so time/duration is visible)
     FileEntry* firstFile = browser.getCurrentFile();
+
+#if MIDI_DISPATCH_BENCHMARK
+    if (firstFile && !firstFile->isDirectory) {
+        runDispatchBenchmark(firstFile->fullPath);
+    }
+#endif
     if (firstFile && !firstFile->isDirectory) {
         if (loadFileOnly()) {
             lastPlayedFile = firstFile;
@@ -529,6 +701,33 @@ void loop() {
         btn = input.readButtonWithRepeat(); // Normal acceleration
     }
 
+    // Follow a quantized song launch the player has carried out
+    updateSongLaunch();
+
+    // Start the previewed file once the browser cursor rests
+    updateAudition();
+
+    // Feed a running .syx send to the output, paced to the receiver
+    updateSysExSend();
+
+    // Finish any MIDI IN remote-control commands that need the UI core
+    // (held while a .syx send has the output)
+    if (!isSysExSendOpen()) {
+        handleRemoteRequests();
+    }
+
+    // Report SD read errors seen by the playback core
+    checkSdHealth();
+
+    // Held LEFT/RIGHT on TIME scrubs instead of repeating 1s skips
+    updateShuttle();
+
+    // The .syx send screen has the buttons until it is closed
+    if (isSysExSendOpen()) {
+        handleSysExSendMode(btn);
+        return;
+    }
+
     // Check for MODE button hold (2 seconds) to jump to playback screen
     if (currentMode != APP_MODE_PLAY) {
         if (input.isButtonHeld(BTN_MODE)) {
@@ -629,20 +828,113 @@ void loop() {
         } else {
             okButtonHoldStart = 0;
         }
+    } else if (currentMode == APP_MODE_TRACK_SETTINGS && currentTrackOption == TRACK_OPTION_PART_MUTE
+               && trackOptionActive && !justActivatedOption) {
+        // Hold OK on the part mute: unmute and unsolo every part
+        if (input.isButtonHeld(BTN_OK)) {
+            if (okButtonHoldStart == 0) {
+                okButtonHoldStart = millis();
+            } else {
+                unsigned long holdDuration = millis() - okButtonHoldStart;
+                if (holdDuration >= BUTTON_HOLD_RESET_MS) {
+                    {
+                        ScopedMutex lock(&playerMutex);
+                        player.setTrackSolos(0);
+                        player.setTrackMutes(0);
+                    }
+                    trackOptionActive = false;
+                    okButtonHoldStart = 0;
+                    updateDisplay();
+                    return;
+                }
+            }
+        } else {
+            okButtonHoldStart = 0;
+        }
+    } else if (currentMode == APP_MODE_TRACK_SETTINGS && currentTrackOption == TRACK_OPTION_SCENE
+               && trackOptionActive && !justActivatedOption) {
+        // Hold OK on the scene option: store the current settings into the selected scene
+        if (input.isButtonHeld(BTN_OK)) {
+            if (okButtonHoldStart == 0) {
+                okButtonHoldStart = millis();
+            } else {
+                unsigned long holdDuration = millis() - okButtonHoldStart;
+                if (holdDuration >= BUTTON_HOLD_RESET_MS) {
+                    ChannelScene scene;
+                    captureScene(scene);
+                    {
+                        ScopedMutex lock(&playerMutex);
+                        player.storeScene(selectedScene, scene);
+                    }
+                    char sceneText[12];
+                    sprintf(sceneText, "Scene %u", selectedScene + 1);
+                    display.showMessage(sceneText, "Stored");
+                    delay(1000);
+                    trackOptionActive = false;
+                    okButtonHoldStart = 0;
+                    updateDisplay();
+                    return;
+                }
+            }
+        } else {
+            okButtonHoldStart = 0;
+        }
     } else {
         okButtonHoldStart = 0;
     }
 
+    // Transport buttons only queue the request - Core 1 applies it between events,
+    // so neither core waits for the All Notes Off cleanup
     if (btn == BTN_STOP) {
+        // In the browser, STOP with nothing playing switches audition on and off
+        if (currentMode == APP_MODE_BROWSE) {
+            PlayerState currentState;
+            {
+                ScopedMutex lock(&playerMutex);
+                currentState = player.getState();
+            }
+            if (isAuditioning()) {
+                endAudition();
+                updateDisplay();
+                return;
+            }
+            if (currentState == STATE_STOPPED) {
+                beginAudition();
+                updateDisplay();
+                return;
+            }
+        }
+
         {
             ScopedMutex lock(&playerMutex);
-            player.stop();
+            player.requestTransport(TRANSPORT_STOP);
         }
         resetVisualizer();
         return;
     }
 
     if (btn == BTN_PLAY) {
+        // A .syx file is sent, not played
+        if (currentMode == APP_MODE_BROWSE) {
+            FileEntry* currentSelection = browser.getCurrentFile();
+            if (currentSelection && !currentSelection->isDirectory && browser.isSysExFile(currentSelection->filename)) {
+                openSysExSend(currentSelection);
+                return;
+            }
+        }
+
+        // Audition: PLAY loads the previewed file the normal way
+        if (currentMode == APP_MODE_BROWSE && isAuditioning()) {
+            FileEntry* currentSelection = browser.getCurrentFile();
+            if (currentSelection && !currentSelection->isDirectory && loadAndPlayFile()) {
+                lastPlayedFile = currentSelection;
+                currentMode = APP_MODE_PLAY;
+                display.setMode(MODE_PLAYBACK);
+                updateDisplay();
+            }
+            return;
+        }
+
         PlayerState currentState;
         {
             ScopedMutex lock(&playerMutex);
@@ -652,13 +944,13 @@ void loop() {
         if (currentState == STATE_PLAYING) {
             {
                 ScopedMutex lock(&playerMutex);
-                player.pause();
+                player.requestTransport(TRANSPORT_PAUSE);
             }
             resetVisualizer();
         } else if (currentState == STATE_PAUSED) {
             {
                 ScopedMutex lock(&playerMutex);
-                player.play();
+                player.requestTransport(TRANSPORT_PLAY);
             }
         } else {
             FileEntry* currentSelection = browser.getCurrentFile();
@@ -676,7 +968,7 @@ void loop() {
                 {
                     ScopedMutex lock(&playerMutex);
                     player.setChannelPrograms(channelPrograms);
-                    player.play();
+                    player.requestTransport(TRANSPORT_PLAY);
                 }
             }
         }
@@ -729,6 +1021,10 @@ void loop() {
         case APP_MODE_VISUALIZER:
             handleVisualizerMode(btn);
             break;
+
+        case APP_MODE_DIAGNOSTICS:
+            handleDiagnosticsMode(btn);
+            break;
     }
 
     updateChannelLevels();
@@ -747,7 +1043,7 @@ void loop() {
         refreshInterval = UI_REFRESH_MS;
     }
 
-    if (millis() - lastDisplayUpdate > refreshInterval) {
+    if (millis() - lastDisplayUpdate > refreshInterval && (long)(millis() - messageHoldUntil) >= 0) {
         updateDisplay();
         lastDisplayUpdate = millis();
     }
@@ -761,7 +1057,67 @@ void loop() {
         hasReachedEnd = player.hasReachedEnd();
     }
 
-    if (lastPlayerState == STATE_PLAYING && currentPlayerState == STATE_STOPPED && hasReachedEnd) {
+    if (ENABLE_VERBOSE_DEBUG && lastPlayerState != currentPlayerState) {
+        uint32_t lastLatency, maxLatency;
+        {
+            ScopedMutex lock(&playerMutex);
+            lastLatency = player.getLastTransportLatencyMicros();
+            maxLatency = player.getMaxTransportLatencyMicros();
+        }
+        Serial.print("Transport press-to-sound (us): ");
+        Serial.print(lastLatency);
+        Serial.print(", max ");
+        Serial.println(maxLatency);
+    }
+
+    if (ENABLE_VERBOSE_DEBUG && lastPlayerState == STATE_PLAYING && currentPlayerState != STATE_PLAYING) {
+        CatchUpStats stats;
+        {
+            ScopedMutex lock(&playerMutex);
+            stats = player.getCatchUpStats();
+        }
+        Serial.print("Catch-up policy: ");
+        Serial.println(CATCHUP_POLICY_NAMES[catchUpPolicy]);
+        Serial.print("  Stalls: ");
+        Serial.print(stats.stallCount);
+        Serial.print(", budget breaks: ");
+        Serial.println(stats.budgetBreaks);
+        Serial.print("  Lag last/max (us): ");
+        Serial.print(stats.lastLagMicros);
+        Serial.print("/");
+        Serial.println(stats.maxLagMicros);
+        Serial.print("  Dropped: ");
+        Serial.print(stats.droppedEvents);
+        Serial.print(", collapsed: ");
+        Serial.print(stats.collapsedEvents);
+        Serial.print(", stretched (ms): ");
+        Serial.println((unsigned long)(stats.stretchedMicros / 1000));
+    }
+
+    // Warn once per boot when the card's read latency looks unsafe for playback
+    static bool marginalCardReported = false;
+    if (!marginalCardReported && lastPlayerState == STATE_PLAYING && currentPlayerState != STATE_PLAYING) {
+        bool marginal;
+        uint32_t p99Micros, maxMicros;
+        {
+            ScopedMutex lock(&playerMutex);
+            marginal = sdHealth.isMarginal();
+            p99Micros = sdHealth.getPercentileMicros(99);
+            maxMicros = sdHealth.getMaxMicros();
+        }
+        if (marginal) {
+            marginalCardReported = true;
+            Serial.print("WARNING: SD card ");
+            Serial.print(sdCardName);
+            Serial.print(" is marginal - read p99/max (us): ");
+            Serial.print(p99Micros);
+            Serial.print("/");
+            Serial.println(maxMicros);
+        }
+    }
+
+    // End of song: the playback mode picks what comes next (a preview just stops)
+    if (lastPlayerState == STATE_PLAYING && currentPlayerState == STATE_STOPPED && hasReachedEnd && !isAuditioning()) {
         FileEntry* fileEntry = nullptr;
 
         switch (playbackMode) {
@@ -770,6 +1126,11 @@ void loop() {
                 break;
 
             case PLAYBACK_AUTO_NEXT:
+                if (stepSequence(1)) {
+                    ScopedMutex lock(&playerMutex);
+                    player.requestTransport(TRANSPORT_PLAY);
+                    break;
+                }
                 browser.selectNext();
                 fileEntry = browser.getCurrentFile();
                 if (fileEntry && !fileEntry->isDirectory) {
@@ -780,6 +1141,14 @@ void loop() {
                 break;
 
             case PLAYBACK_LOOP_ONE:
+                {
+                    // Format 2: loop the sequence, not the file (a reload starts at the first one)
+                    ScopedMutex lock(&playerMutex);
+                    if (player.getParser().isMultiSequence()) {
+                        player.requestTransport(TRANSPORT_PLAY);
+                        break;
+                    }
+                }
                 fileEntry = browser.getCurrentFile();
                 if (fileEntry && !fileEntry->isDirectory) {
                     if (loadAndPlayFile()) {
@@ -789,6 +1158,11 @@ void loop() {
                 break;
 
             case PLAYBACK_LOOP_ALL:
+                if (stepSequence(1)) {
+                    ScopedMutex lock(&playerMutex);
+                    player.requestTransport(TRANSPORT_PLAY);
+                    break;
+                }
                 browser.selectNext();
                 fileEntry = browser.getCurrentFile();
                 if (fileEntry && !fileEntry->isDirectory) {
@@ -819,12 +1193,14 @@ void handleBrowseMode(Button btn) {
         case BTN_LEFT:
             // Previous file/folder
             browser.selectPrevious();
+            scheduleAudition();
             updateDisplay();
             break;
 
         case BTN_RIGHT:
             // Next file/folder
             browser.selectNext();
+            scheduleAudition();
             updateDisplay();
             break;
 
@@ -834,8 +1210,17 @@ void handleBrowseMode(Button btn) {
                 FileEntry* current = browser.getCurrentFile();
                 if (current) {
                     if (current->isDirectory) {
+                        cancelSongLaunch();  // Its browser index is about to change meaning
+                        scheduleAudition();  // Preview the first file of the new folder
                         browser.enterDirectory();
+                        if (browser.isSetlist()) {
+                            preloadSetlist();
+                        } else {
+                            releaseSetlist();
+                        }
                         updateDisplay();
+                    } else if (browser.isSysExFile(current->filename)) {
+                        openSysExSend(current);
                     } else {
                         // Load file only (don't play)
                         if (loadFileOnly()) {
@@ -854,7 +1239,8 @@ void handleBrowseMode(Button btn) {
         // BTN_STOP is handled globally - not here
 
         case BTN_MODE:
-            // Return to player screen
+            // Return to player screen (a preview ends with the browser)
+            endAudition();
             currentMode = APP_MODE_PLAY;
             display.setMode(MODE_PLAYBACK);
             updateDisplay();
@@ -897,10 +1283,11 @@ void handlePlayMode(Button btn) {
                         break;
 
                     case MENU_TIME:
-                        // Rewind 1 second
+                        // Rewind 1 second (repeats while held are the shuttle's job)
+                        if (shuttleDirection != 0) break;
                         {
                             ScopedMutex lock(&playerMutex);
-                            player.rewind(1000);
+                            player.requestTransport(TRANSPORT_SKIP, -1000);
                         }
                         break;
 
@@ -951,10 +1338,11 @@ void handlePlayMode(Button btn) {
                         break;
 
                     case MENU_TIME:
-                        // Fast forward 1 second
+                        // Fast forward 1 second (repeats while held are the shuttle's job)
+                        if (shuttleDirection != 0) break;
                         {
                             ScopedMutex lock(&playerMutex);
-                            player.fastForward(1000);
+                            player.requestTransport(TRANSPORT_SKIP, 1000);
                         }
                         break;
 
@@ -987,54 +1375,10 @@ void handlePlayMode(Button btn) {
                 updateDisplay();
             } else if (currentPlaybackOption == MENU_PREV) {
                 // Previous song
-                bool wasPlaying;
-                {
-                    ScopedMutex lock(&playerMutex);
-                    wasPlaying = (player.getState() == STATE_PLAYING);
-                }
-
-                browser.selectPrevious();
-                FileEntry* fileEntry = browser.getCurrentFile();
-                if (fileEntry && !fileEntry->isDirectory) {
-                    resetVisualizer();
-                    // Load and optionally play previous song (unloadFile handles stop with proper delay)
-                    if (wasPlaying) {
-                        // Was playing - load and auto-play
-                        if (loadAndPlayFile()) {
-                            lastPlayedFile = fileEntry;
-                        }
-                    } else {
-                        // Was stopped - load only, don't play
-                        if (loadFileOnly()) {
-                            lastPlayedFile = fileEntry;
-                        }
-                    }
-                }
+                stepSong(-1);
             } else if (currentPlaybackOption == MENU_NEXT) {
                 // Next song
-                bool wasPlaying;
-                {
-                    ScopedMutex lock(&playerMutex);
-                    wasPlaying = (player.getState() == STATE_PLAYING);
-                }
-
-                browser.selectNext();
-                FileEntry* fileEntry = browser.getCurrentFile();
-                if (fileEntry && !fileEntry->isDirectory) {
-                    resetVisualizer();
-                    // Load and optionally play next song (unloadFile handles stop with proper delay)
-                    if (wasPlaying) {
-                        // Was playing - load and auto-play
-                        if (loadAndPlayFile()) {
-                            lastPlayedFile = fileEntry;
-                        }
-                    } else {
-                        // Was stopped - load only, don't play
-                        if (loadFileOnly()) {
-                            lastPlayedFile = fileEntry;
-                        }
-                    }
-                }
+                stepSong(1);
             } else {
                 // For BPM - special handling for whole/decimal toggle cycle
                 // Cycle: inactive (whole) → active whole → inactive (decimal) → active decimal → inactive (whole)
@@ -1092,11 +1436,8 @@ void handlePlayMode(Button btn) {
             break;
 
         case BTN_PANIC:
-            // Send MIDI panic - All Notes Off on all channels
-            for (uint8_t ch = 1; ch <= 16; ch++) {
-                midiOut.sendControlChange(ch, 123, 0); // All Notes Off
-                midiOut.sendControlChange(ch, 120, 0); // All Sound Off
-            }
+            // Send MIDI panic - All Notes Off and All Sound Off on every channel of every port
+            midiOut.allSoundOff();
             break;
 
         default:
@@ -1521,10 +1862,7 @@ void handleChannelMenuMode(Button btn) {
 
         case BTN_PANIC:
             // Send MIDI panic from channel menu too
-            for (uint8_t ch = 1; ch <= 16; ch++) {
-                midiOut.sendControlChange(ch, 123, 0); // All Notes Off
-                midiOut.sendControlChange(ch, 120, 0); // All Sound Off
-            }
+            midiOut.allSoundOff();
             break;
 
         default:
@@ -1585,6 +1923,28 @@ void handleTrackSettingsMode(Button btn) {
                         }
                         break;
 
+                    case TRACK_OPTION_SCENE:
+                        // Switch immediately - one press per scene change
+                        selectedScene = (selectedScene + 1) % MAX_SCENES;
+                        selectScene(selectedScene);
+                        break;
+
+                    case TRACK_OPTION_PART:
+                        {
+                            uint8_t partCount;
+                            {
+                                ScopedMutex lock(&playerMutex);
+                                partCount = player.getFileInfo().numTracks;
+                            }
+                            if (partCount > MAX_TRACKS) partCount = MAX_TRACKS;
+                            if (partCount > 0) selectedPart = (selectedPart + 1) % partCount;
+                        }
+                        break;
+
+                    case TRACK_OPTION_PART_MUTE:
+                        stepPartMute(true);
+                        break;
+
                     default:
                         break;
                 }
@@ -1642,6 +2002,27 @@ void handleTrackSettingsMode(Button btn) {
                         }
                         break;
 
+                    case TRACK_OPTION_SCENE:
+                        selectedScene = (selectedScene + MAX_SCENES - 1) % MAX_SCENES;
+                        selectScene(selectedScene);
+                        break;
+
+                    case TRACK_OPTION_PART:
+                        {
+                            uint8_t partCount;
+                            {
+                                ScopedMutex lock(&playerMutex);
+                                partCount = player.getFileInfo().numTracks;
+                            }
+                            if (partCount > MAX_TRACKS) partCount = MAX_TRACKS;
+                            if (partCount > 0) selectedPart = (selectedPart + partCount - 1) % partCount;
+                        }
+                        break;
+
+                    case TRACK_OPTION_PART_MUTE:
+                        stepPartMute(false);
+                        break;
+
                     default:
                         break;
                 }
@@ -1682,6 +2063,8 @@ void handleTrackSettingsMode(Button btn) {
                                 display.showError("Delete Failed!");
                                 delay(1000);
                             }
+                        } else if (pendingConfirmAction == CONFIRM_RENDER) {
+                            renderSong(entry);
                         }
                     }
                 }
@@ -1711,6 +2094,13 @@ void handleTrackSettingsMode(Button btn) {
                     updateDisplay();
                     break;
 
+                case TRACK_OPTION_RENDER:
+                    showingConfirmation = true;
+                    pendingConfirmAction = CONFIRM_RENDER;
+                    confirmSelection = true;  // Default to Yes
+                    updateDisplay();
+                    break;
+
                 case TRACK_OPTION_BPM:
                     // Special handling for BPM whole/decimal toggle cycle
                     if (trackOptionActive) {
@@ -1757,10 +2147,7 @@ void handleTrackSettingsMode(Button btn) {
 
         case BTN_PANIC:
             // Send MIDI panic
-            for (uint8_t ch = 1; ch <= 16; ch++) {
-                midiOut.sendControlChange(ch, 123, 0);
-                midiOut.sendControlChange(ch, 120, 0);
-            }
+            midiOut.allSoundOff();
             break;
 
         default:
@@ -1787,16 +2174,17 @@ void handleRoutingMode(Button btn) {
                         break;
 
                     case ROUTING_OPTION_ROUTE_TO:
-                        // Cycle through routing options: --, 1, 2, ..., 16
-                        if (channelRouting[selectedRoutingChannel] == 255) {
-                            // Currently "--" (no routing), change to 1
+                        // Cycle through routing options: --, A1..A16, B1..B16, C1..C16
+                        // (route values are contiguous: (port << 4) | channel)
+                        if (channelRouting[selectedRoutingChannel] == MIDI_ROUTE_ORIGINAL) {
+                            // Currently "--" (no routing), change to A1
                             channelRouting[selectedRoutingChannel] = 0;
-                        } else if (channelRouting[selectedRoutingChannel] < 15) {
-                            // Increment channel
+                        } else if (channelRouting[selectedRoutingChannel] < MIDI_ROUTE_MAX) {
+                            // Next channel, rolling over onto the next port
                             channelRouting[selectedRoutingChannel]++;
                         } else {
-                            // At 16, wrap to "--"
-                            channelRouting[selectedRoutingChannel] = 255;
+                            // At last port's channel 16, wrap to "--"
+                            channelRouting[selectedRoutingChannel] = MIDI_ROUTE_ORIGINAL;
                         }
                         // Note: Routing is applied when OK is pressed to deactivate
                         break;
@@ -1828,16 +2216,16 @@ void handleRoutingMode(Button btn) {
                         break;
 
                     case ROUTING_OPTION_ROUTE_TO:
-                        // Cycle through routing options: 16, 15, ..., 1, --
-                        if (channelRouting[selectedRoutingChannel] == 255) {
-                            // Currently "--", change to 16
-                            channelRouting[selectedRoutingChannel] = 15;
+                        // Cycle through routing options: C16, ..., A1, --
+                        if (channelRouting[selectedRoutingChannel] == MIDI_ROUTE_ORIGINAL) {
+                            // Currently "--", change to last port's channel 16
+                            channelRouting[selectedRoutingChannel] = MIDI_ROUTE_MAX;
                         } else if (channelRouting[selectedRoutingChannel] > 0) {
-                            // Decrement channel
+                            // Previous channel, rolling back onto the previous port
                             channelRouting[selectedRoutingChannel]--;
                         } else {
-                            // At 1, wrap to "--"
-                            channelRouting[selectedRoutingChannel] = 255;
+                            // At A1, wrap to "--"
+                            channelRouting[selectedRoutingChannel] = MIDI_ROUTE_ORIGINAL;
                         }
                         // Note: Routing is applied when OK is pressed to deactivate
                         break;
@@ -1919,14 +2307,16 @@ void handleRoutingMode(Button btn) {
                             // Deactivating - apply the routing change
                             // Send All Notes Off to the OLD routing destination to prevent stuck notes
                             uint8_t outputChannel;
-                            if (originalRouting == 255) {
+                            uint8_t outputPort = 0;
+                            if (originalRouting == MIDI_ROUTE_ORIGINAL) {
                                 // Was using original channel
                                 outputChannel = selectedRoutingChannel + 1;
                             } else {
-                                // Was routed to different channel
-                                outputChannel = originalRouting + 1;
+                                // Was routed to a different port/channel
+                                outputPort = midiRoutePort(originalRouting);
+                                outputChannel = midiRouteChannel(originalRouting) + 1;
                             }
-                            midiOut.sendControlChange(outputChannel, 123, 0);
+                            midiOut.sendControlChange(outputChannel, 123, 0, outputPort);
                             delay(20);
 
                             // Now apply the new routing
@@ -1968,10 +2358,7 @@ void handleRoutingMode(Button btn) {
 
         case BTN_PANIC:
             // Send MIDI panic from routing mode too
-            for (uint8_t ch = 1; ch <= 16; ch++) {
-                midiOut.sendControlChange(ch, 123, 0); // All Notes Off
-                midiOut.sendControlChange(ch, 120, 0); // All Sound Off
-            }
+            midiOut.allSoundOff();
             break;
 
         default:
@@ -2103,10 +2490,7 @@ void handleMidiSettingsMode(Button btn) {
 
         case BTN_PANIC:
             // Send MIDI panic from MIDI settings too
-            for (uint8_t ch = 1; ch <= 16; ch++) {
-                midiOut.sendControlChange(ch, 123, 0); // All Notes Off
-                midiOut.sendControlChange(ch, 120, 0); // All Sound Off
-            }
+            midiOut.allSoundOff();
             break;
 
         default:
@@ -2117,26 +2501,38 @@ void handleMidiSettingsMode(Button btn) {
 void handleClockSettingsMode(Button btn) {
     switch (btn) {
         case BTN_RIGHT:
-            if (clockOptionActive) {
-                // Active - toggle clock enabled
-                midiClockEnabled = !midiClockEnabled;
-                player.setClockEnabled(midiClockEnabled);
-                // Save settings after change
-                saveGlobalSettings();
-            }
-            // No menu navigation needed - only one option
-            updateDisplay();
-            break;
-
         case BTN_LEFT:
             if (clockOptionActive) {
-                // Active - toggle clock enabled
-                midiClockEnabled = !midiClockEnabled;
-                player.setClockEnabled(midiClockEnabled);
+                // Active - ON/OFF toggles, Launch cycles NOW/BEAT/BAR
+                switch (currentClockOption) {
+                    case CLOCK_OPTION_ENABLED:
+                        midiClockEnabled = !midiClockEnabled;
+                        {
+                            ScopedMutex lock(&playerMutex);
+                            player.setClockEnabled(midiClockEnabled);
+                        }
+                        break;
+
+                    case CLOCK_OPTION_TAP_SYNC:
+                        tapPhaseAlign = !tapPhaseAlign;
+                        break;
+
+                    case CLOCK_OPTION_LAUNCH:
+                        launchQuantize = (LaunchQuantize)((launchQuantize + (btn == BTN_RIGHT ? 1 : LAUNCH_QUANTIZE_COUNT - 1)) % LAUNCH_QUANTIZE_COUNT);
+                        break;
+
+                    default:
+                        break;
+                }
                 // Save settings after change
                 saveGlobalSettings();
+            } else if (btn == BTN_RIGHT) {
+                // Navigate menu right
+                currentClockOption = (ClockSettingsOption)((currentClockOption + 1) % CLOCK_OPTION_COUNT);
+            } else {
+                // Navigate menu left
+                currentClockOption = (ClockSettingsOption)((currentClockOption - 1 + CLOCK_OPTION_COUNT) % CLOCK_OPTION_COUNT);
             }
-            // No menu navigation needed - only one option
             updateDisplay();
             break;
 
@@ -2155,6 +2551,7 @@ void handleClockSettingsMode(Button btn) {
                 break; // Ignore this MODE press
             }
             // Cycle to Visualizer
+            currentClockOption = CLOCK_OPTION_ENABLED;
             clockOptionActive = false;
             currentMode = APP_MODE_VISUALIZER;
             display.setMode(MODE_SETTINGS);
@@ -2163,10 +2560,7 @@ void handleClockSettingsMode(Button btn) {
 
         case BTN_PANIC:
             // Send MIDI panic from Clock settings too
-            for (uint8_t ch = 1; ch <= 16; ch++) {
-                midiOut.sendControlChange(ch, 123, 0); // All Notes Off
-                midiOut.sendControlChange(ch, 120, 0); // All Sound Off
-            }
+            midiOut.allSoundOff();
             break;
 
         default:
@@ -2176,6 +2570,46 @@ void handleClockSettingsMode(Button btn) {
 
 void handleVisualizerMode(Button btn) {
     switch (btn) {
+        case BTN_MODE:
+            // Check if we should ignore this release (after hold-jump)
+            if (ignoreModeRelease) {
+                ignoreModeRelease = false; // Clear flag
+                break; // Ignore this MODE press
+            }
+            // Cycle to SD diagnostics
+            currentMode = APP_MODE_DIAGNOSTICS;
+            display.setMode(MODE_SETTINGS);
+            updateDisplay();
+            break;
+
+        case BTN_PANIC:
+            // Send MIDI panic from Visualizer too
+            midiOut.allSoundOff();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void handleDiagnosticsMode(Button btn) {
+    switch (btn) {
+        case BTN_LEFT:
+        case BTN_RIGHT:
+            // Two pages - latency profile and bus clock
+            diagnosticsPage = !diagnosticsPage;
+            updateDisplay();
+            break;
+
+        case BTN_OK:
+            // Start a fresh latency profile (e.g. after the card has warmed up)
+            {
+                ScopedMutex lock(&playerMutex);
+                sdHealth.reset();
+            }
+            updateDisplay();
+            break;
+
         case BTN_MODE:
             // Check if we should ignore this release (after hold-jump)
             if (ignoreModeRelease) {
@@ -2189,11 +2623,8 @@ void handleVisualizerMode(Button btn) {
             break;
 
         case BTN_PANIC:
-            // Send MIDI panic from Visualizer too
-            for (uint8_t ch = 1; ch <= 16; ch++) {
-                midiOut.sendControlChange(ch, 123, 0); // All Notes Off
-                midiOut.sendControlChange(ch, 120, 0); // All Sound Off
-            }
+            // Send MIDI panic from diagnostics too
+            midiOut.allSoundOff();
             break;
 
         default:
@@ -2344,6 +2775,8 @@ void updateDisplay() {
             message = "Save settings?";
         } else if (pendingConfirmAction == CONFIRM_DELETE) {
             message = "Delete settings?";
+        } else if (pendingConfirmAction == CONFIRM_RENDER) {
+            message = "Render to file?";
         }
         display.showConfirmation(message, confirmSelection);
         return;
@@ -2351,7 +2784,11 @@ void updateDisplay() {
 
     switch (currentMode) {
         case APP_MODE_BROWSE:
-            display.showFileBrowser(&browser);
+            if (isSysExSendOpen()) {
+                showSysExSend();
+                break;
+            }
+            display.showFileBrowser(&browser, isAuditioning());
             break;
 
         case APP_MODE_PLAY:
@@ -2365,6 +2802,17 @@ void updateDisplay() {
                     strcpy(info.songName, "Unknown");
                 }
 
+                {
+                    // Format 2: show which of the file's sequences is playing
+                    ScopedMutex lock(&playerMutex);
+                    MidiFileParser& parser = player.getParser();
+                    if (parser.isMultiSequence()) {
+                        size_t nameLength = strlen(info.songName);
+                        snprintf(info.songName + nameLength, sizeof(info.songName) - nameLength, " [%u/%u]",
+                                 parser.getActiveSequence() + 1, parser.getSequenceCount());
+                    }
+                }
+
                 {
                     ScopedMutex lock(&playerMutex);
                     info.currentTime = player.getCurrentTimeMs();
@@ -2377,6 +2825,7 @@ void updateDisplay() {
 
                     info.isPlaying = (player.getState() == STATE_PLAYING);
                     info.isPaused = (player.getState() == STATE_PAUSED);
+                    info.shuttle = player.isShuttling() ? shuttleDirection : 0;
                     info.channelMutes = player.getChannelMutes();
                 }
 
@@ -2423,20 +2872,54 @@ void updateDisplay() {
 
         case APP_MODE_TRACK_SETTINGS:
             {
-                display.showTrackSettingsMenu(targetBPM, useDefaultTempo, velocityScale, sysexEnabled, currentTrackOption, trackOptionActive, bpmEditingWhole);
+                uint8_t definedScenes;
+                int8_t activeScene;
+                uint8_t partState;  // 0 = unmuted, 1 = muted, 2 = solo
+                {
+                    ScopedMutex lock(&playerMutex);
+                    definedScenes = player.getDefinedScenes();
+                    activeScene = player.getActiveScene();
+                    partState = (player.getTrackSolos() & (1 << selectedPart)) ? 2
+                              : (player.getTrackMutes() & (1 << selectedPart)) ? 1 : 0;
+                }
+                display.showTrackSettingsMenu(targetBPM, useDefaultTempo, velocityScale, sysexEnabled, currentTrackOption, trackOptionActive, bpmEditingWhole,
+                                              selectedScene, definedScenes, activeScene, selectedPart, partState);
             }
             break;
 
         case APP_MODE_ROUTING:
-            display.showRoutingMenu(selectedRoutingChannel, channelRouting, currentRoutingOption, routingOptionActive);
-            break;
-
-        case APP_MODE_MIDI_SETTINGS:
-            display.showMidiSettingsMenu(midiThruEnabled, midiKeyboardEnabled, midiKeyboardChannel, midiKeyboardVelocity, currentMidiOption, midiOptionActive);
-            break;
-
+            {
+                uint8_t portLoad[MIDI_OUT_PORT_COUNT];
+                uint8_t saturatedPorts = 0;
+                {
+                    ScopedMutex lock(&playerMutex);
+                    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+                        portLoad[port] = midiOut.getPortStats(port).utilizationPercent;
+                        if (player.isPortSaturating(port)) {
+                            saturatedPorts |= (1 << port);
+                        }
+                    }
+                }
+                uint8_t layerCount = __builtin_popcountll(channelLayers[selectedRoutingChannel]);
+                display.showRoutingMenu(selectedRoutingChannel, channelRouting, currentRoutingOption, routingOptionActive,
+                                        portLoad, MIDI_OUT_PORT_COUNT, saturatedPorts, layerCount);
+            }
+            break;
+
+        case APP_MODE_MIDI_SETTINGS:
+            display.showMidiSettingsMenu(midiThruEnabled, midiKeyboardEnabled, midiKeyboardChannel, midiKeyboardVelocity, currentMidiOption, midiOptionActive);
+            break;
+
         case APP_MODE_CLOCK_SETTINGS:
-            display.showClockSettingsMenu(midiClockEnabled, clockOptionActive);
+            {
+                uint32_t launchErrorMicros;
+                {
+                    ScopedMutex lock(&playerMutex);
+                    launchErrorMicros = player.getLastLaunchErrorMicros();
+                }
+                display.showClockSettingsMenu(midiClockEnabled, tapPhaseAlign, LAUNCH_QUANTIZE_NAMES[launchQuantize],
+                                              launchErrorMicros, currentClockOption, clockOptionActive);
+            }
             break;
 
         case APP_MODE_VISUALIZER:
@@ -2455,42 +2938,39 @@ void updateDisplay() {
                 display.showVisualizer(localActivity, localPeak);
             }
             break;
-    }
-
-    // Display update timing disabled - heap monitoring now tracks performance
-}
 
-void sendProgramChanges() {
-    // Send program change messages for all channels that have been set (not 128)
-    for (uint8_t ch = 0; ch < 16; ch++) {
-        if (channelPrograms[ch] < CHANNEL_PROGRAM_USE_MIDI_FILE) {
-            // Only send if user has set a program (0-127)
-            midiOut.sendProgramChange(ch + 1, channelPrograms[ch]); // Channels are 1-based in MIDI
-            delay(MIDI_SETTLE_DELAY_MS);
-        }
+        case APP_MODE_DIAGNOSTICS:
+            {
+                // Core 1 records reads under the player mutex - snapshot before drawing
+                SdDiagnosticsInfo info;
+                {
+                    ScopedMutex lock(&playerMutex);
+                    info.readCount = sdHealth.getReadCount();
+                    info.p50Micros = sdHealth.getPercentileMicros(50);
+                    info.p99Micros = sdHealth.getPercentileMicros(99);
+                    info.maxMicros = sdHealth.getMaxMicros();
+                    info.prefetchBytes = sdHealth.getRecommendedPrefetchBytes(TRACK_BUFFER_SIZE);
+                    info.marginal = sdHealth.isMarginal();
+                    info.readErrors = sdHealth.getReadErrors();
+                }
+                info.cardName = sdCardName;
+                info.clockHz = SD_CLOCK_STEPS_HZ[sdClockStep];
+                info.benchBytesPerSec = sdBenchBytesPerSec;
+                info.midiDropped = midiOut.getSubmitDropped();
+                info.page = diagnosticsPage;
+                display.showDiagnostics(info);
+            }
+            break;
     }
-}
 
-void sendChannelVolumes() {
-    // Send CC 7 (Volume) for all channels that have been set (not 255)
-    for (uint8_t ch = 0; ch < 16; ch++) {
-        if (channelVolume[ch] < CHANNEL_VOLUME_USE_MIDI_FILE) {
-            // Only send if user has set a volume (0-127)
-            midiOut.sendControlChange(ch + 1, 7, channelVolume[ch]); // CC 7 = Volume
-            delay(MIDI_SETTLE_DELAY_MS);
-        }
-    }
+    // Display update timing disabled - heap monitoring now tracks performance
 }
 
-void sendChannelPan() {
-    // Send CC 10 (Pan) for all channels that have been set (not 255)
-    for (uint8_t ch = 0; ch < 16; ch++) {
-        if (channelPan[ch] < CHANNEL_VOLUME_USE_MIDI_FILE) {
-            // Only send if user has set a pan (0-127)
-            midiOut.sendControlChange(ch + 1, 10, channelPan[ch]); // CC 10 = Pan
-            delay(MIDI_SETTLE_DELAY_MS);
-        }
-    }
+void sendOverrideSetup() {
+    // The player knows where each channel goes (routing and layers) and paces
+    // playback behind the messages, so load, scene recall and render all agree
+    ScopedMutex lock(&playerMutex);
+    player.sendOverrideSetup();
 }
 
 void buildConfigPath(const char* midiFilename, char* configPath, size_t configPathSize) {
@@ -2505,9 +2985,10 @@ void buildConfigPath(const char* midiFilename, char* configPath, size_t configPa
     // Build path: /MIDI/config/filename.cfg
     snprintf(configPath, configPathSize, "/MIDI/config/%s", baseFilename);
 
-    // Find .mid extension and replace with .cfg
+    // Find the song extension and replace with .cfg (a packed song.mlz shares song.mid's settings)
     char* ext = strrchr(configPath, '.');
-    if (ext && (strcasecmp(ext, ".mid") == 0 || strcasecmp(ext, ".midi") == 0)) {
+    if (ext && (strcasecmp(ext, ".mid") == 0 || strcasecmp(ext, ".midi") == 0 ||
+                strcasecmp(ext, ".rmi") == 0 || strcasecmp(ext, ".mlz") == 0)) {
         strcpy(ext, ".cfg");
     } else {
         strcat(configPath, ".cfg");
@@ -2597,6 +3078,17 @@ bool saveTrackSettings(const char* midiFilename) {
     strcat(line, "\n");
     settingsFileObj.write(line);
 
+    // Write fan-out layers (hex destination masks, bit (port << 4) | channel)
+    strcpy(line, "LAYERS=");
+    for (int i = 0; i < 16; i++) {
+        char num[20];
+        sprintf(num, "%llX", (unsigned long long)channelLayers[i]);
+        strcat(line, num);
+        if (i < 15) strcat(line, ",");
+    }
+    strcat(line, "\n");
+    settingsFileObj.write(line);
+
     // Write channel velocity scales
     strcpy(line, "CH_VELOCITY=");
     for (int i = 0; i < 16; i++) {
@@ -2624,11 +3116,32 @@ bool saveTrackSettings(const char* midiFilename) {
     sprintf(line, "SOLOS=%u\n", channelSolos);
     settingsFileObj.write(line);
 
+    // Write part (track) mutes and solos (as bitmasks)
+    uint16_t partMutes, partSolos;
+    {
+        ScopedMutex lock(&playerMutex);
+        partMutes = player.getTrackMutes();
+        partSolos = player.getTrackSolos();
+    }
+    sprintf(line, "TRACK_MUTES=%u\nTRACK_SOLOS=%u\n", partMutes, partSolos);
+    settingsFileObj.write(line);
+
     // Write SysEx enabled/disabled
     sprintf(line, "SYSEX_ENABLED=%u\n", sysexEnabled ? 1 : 0);
     settingsFileObj.write(line);
 
+    // Write scenes, one section each (same keys as above)
+    for (uint8_t index = 0; index < MAX_SCENES; index++) {
+        ChannelScene scene;
+        {
+            ScopedMutex lock(&playerMutex);
+            if (!player.getScene(index, scene)) continue;
+        }
+        writeSceneSection(settingsFileObj, index, scene);
+    }
+
     // File automatically closed by ScopedFile destructor
+    updateSetlistSettings(false);
     return true;
 }
 
@@ -2643,12 +3156,13 @@ void resetChannelSettingsToDefaults() {
             channelTranspose[ch] = 0;   // No transpose by default
             channelVelocity[ch] = 0;    // Use global velocity scale (no per-channel override)
             channelRouting[ch] = 255;   // Use original channel (no routing)
+            channelLayers[ch] = 0;      // No layered copies
             player.unmuteChannel(ch);   // Unmute all channels
-
-            // Send All Sound Off to reset the channel
-            midiOut.sendControlChange(ch + 1, 120, 0);  // All Sound Off
         }
 
+        // Silence every channel on every port (routing and layers may have used them all)
+        midiOut.allSoundOff();
+
         // Tell player to use MIDI file defaults (no overrides)
         player.setChannelPrograms(channelPrograms);
         player.setChannelVolumes(channelVolume);
@@ -2656,6 +3170,7 @@ void resetChannelSettingsToDefaults() {
         player.setChannelTranspose(channelTranspose);
         player.setChannelVelocityScales(channelVelocity);
         player.setChannelRouting(channelRouting);
+        player.setChannelLayers(channelLayers);
 
         // Reset global velocity scale to default
         velocityScale = DEFAULT_VELOCITY_SCALE;
@@ -2665,7 +3180,14 @@ void resetChannelSettingsToDefaults() {
         // Reset SysEx to enabled (default)
         sysexEnabled = true;
         player.setSysexEnabled(sysexEnabled);
+
+        // Scenes and part mutes belong to the song
+        player.clearScenes();
+        player.setTrackSolos(0);
+        player.setTrackMutes(0);
     }
+    selectedScene = 0;
+    selectedPart = 0;
 
     // Clear all solos
     channelSolos = 0;
@@ -2677,8 +3199,26 @@ void resetChannelSettingsToDefaults() {
 }
 
 bool loadTrackSettings(const char* midiFilename) {
-    // Reset to defaults first (will be overridden if .cfg file exists)
-    resetChannelSettingsToDefaults();
+    static ChannelScene scenes[MAX_SCENES];  // Core 0 only - kept off the stack
+    SongSettings settings;
+    bool found = readSongSettings(midiFilename, settings, scenes);
+
+    // Reset to defaults, then apply what the file set (defaults alone if there is none)
+    applySongSettings(settings, scenes);
+    return found;
+}
+
+bool readSongSettings(const char* midiFilename, SongSettings& settings, ChannelScene* scenes) {
+    // Defaults, as resetChannelSettingsToDefaults() leaves them
+    resetScene(settings.channels);
+    settings.trackMutes = 0;
+    settings.trackSolos = 0;
+    settings.velocityScale = DEFAULT_VELOCITY_SCALE;
+    settings.sysexEnabled = true;
+    settings.useTargetBPM = false;
+    settings.targetBPM = targetBPM;  // Replaced by the file's BPM in applyFileTempo() unless the file sets one
+    settings.savedConfigBPM = 0;
+    settings.sceneMask = 0;
 
     // Build config file path
     char settingsFilename[128];
@@ -2693,7 +3233,9 @@ bool loadTrackSettings(const char* midiFilename) {
 
     // Read and parse settings
     char line[256];
-    int lineNum = 0;
+    int8_t sceneIndex = -1;  // Scene section being read (-1 = song settings)
+    ChannelScene scene;
+    ChannelScene& channels = settings.channels;
 
     while (settingsFileObj.available()) {
         int len = settingsFileObj.fgets(line, sizeof(line));
@@ -2703,102 +3245,234 @@ bool loadTrackSettings(const char* midiFilename) {
         if (line[len-1] == '\n') line[len-1] = '\0';
         if (len > 1 && line[len-2] == '\r') line[len-2] = '\0';
 
-        if (strncmp(line, "MUTES=", 6) == 0) {
-            uint16_t mutes = atoi(line + 6);
-            for (int ch = 0; ch < 16; ch++) {
-                if (mutes & (1 << ch)) {
-                    player.muteChannel(ch);
-                } else {
-                    player.unmuteChannel(ch);
-                }
+        if (strncmp(line, "[SCENE ", 7) == 0) {
+            // Commit the previous scene, then start a new one from defaults
+            if (sceneIndex >= 0) {
+                scenes[sceneIndex] = scene;
+                settings.sceneMask |= 1 << sceneIndex;
             }
+            int number = atoi(line + 7);
+            sceneIndex = (number >= 1 && number <= MAX_SCENES) ? number - 1 : -1;
+            resetScene(scene);
+            continue;
+        }
+        if (sceneIndex >= 0) {
+            parseSceneLine(line, scene);
+            continue;
+        }
+
+        if (strncmp(line, "MUTES=", 6) == 0) {
+            channels.mutes = atoi(line + 6);
         } else if (strncmp(line, "PROGRAMS=", 9) == 0) {
             char* token = strtok(line + 9, ",");
             for (int i = 0; i < 16 && token; i++) {
-                channelPrograms[i] = atoi(token);
+                channels.programs[i] = atoi(token);
                 token = strtok(NULL, ",");
             }
         } else if (strncmp(line, "VOLUMES=", 8) == 0) {
             char* token = strtok(line + 8, ",");
             for (int i = 0; i < 16 && token; i++) {
-                channelVolume[i] = atoi(token);
+                channels.volumes[i] = atoi(token);
                 token = strtok(NULL, ",");
             }
         } else if (strncmp(line, "PAN=", 4) == 0) {
             char* token = strtok(line + 4, ",");
             for (int i = 0; i < 16 && token; i++) {
-                channelPan[i] = atoi(token);
+                channels.pan[i] = atoi(token);
                 token = strtok(NULL, ",");
             }
         } else if (strncmp(line, "TRANSPOSE=", 10) == 0) {
             char* token = strtok(line + 10, ",");
             for (int i = 0; i < 16 && token; i++) {
-                channelTranspose[i] = atoi(token);
+                channels.transpose[i] = atoi(token);
                 token = strtok(NULL, ",");
             }
         } else if (strncmp(line, "ROUTING=", 8) == 0) {
             char* token = strtok(line + 8, ",");
             for (int i = 0; i < 16 && token; i++) {
-                channelRouting[i] = atoi(token);
+                int route = atoi(token);
+                // (port << 4) | channel, or 255 for the original channel
+                channels.routing[i] = (route >= 0 && route <= MIDI_ROUTE_MAX) ? route : MIDI_ROUTE_ORIGINAL;
+                token = strtok(NULL, ",");
+            }
+        } else if (strncmp(line, "LAYERS=", 7) == 0) {
+            char* token = strtok(line + 7, ",");
+            for (int i = 0; i < 16 && token; i++) {
+                channels.layers[i] = strtoull(token, NULL, 16) & MIDI_ROUTE_ALL_MASK;
                 token = strtok(NULL, ",");
             }
         } else if (strncmp(line, "CH_VELOCITY=", 12) == 0) {
             char* token = strtok(line + 12, ",");
             for (int i = 0; i < 16 && token; i++) {
-                channelVelocity[i] = atoi(token);
+                channels.velocities[i] = atoi(token);
                 token = strtok(NULL, ",");
             }
         } else if (strncmp(line, "VELOCITY_SCALE=", 15) == 0) {
-            velocityScale = atoi(line + 15);
-            if (velocityScale < MIN_VELOCITY_SCALE) velocityScale = MIN_VELOCITY_SCALE;
-            if (velocityScale > MAX_VELOCITY_SCALE) velocityScale = MAX_VELOCITY_SCALE;
-            velocityScaleDefault = velocityScale; // Remember loaded value as default
-            {
-                ScopedMutex lock(&playerMutex);
-                player.setVelocityScale(velocityScale);
-            }
+            int scale = atoi(line + 15);
+            if (scale < MIN_VELOCITY_SCALE) scale = MIN_VELOCITY_SCALE;
+            if (scale > MAX_VELOCITY_SCALE) scale = MAX_VELOCITY_SCALE;
+            settings.velocityScale = scale;
         } else if (strncmp(line, "TARGET_BPM=", 11) == 0) {
-            targetBPM = atoi(line + 11);
-            if (targetBPM < MIN_TARGET_BPM) targetBPM = MIN_TARGET_BPM;
-            if (targetBPM > MAX_TARGET_BPM) targetBPM = MAX_TARGET_BPM;
+            uint32_t bpm = atoi(line + 11);
+            if (bpm < MIN_TARGET_BPM) bpm = MIN_TARGET_BPM;
+            if (bpm > MAX_TARGET_BPM) bpm = MAX_TARGET_BPM;
+            settings.targetBPM = bpm;
             // Save this as the config's BPM for reset functionality
-            savedConfigBPM = targetBPM;
-            // NOTE: Don't call setTargetBPM() here - file isn't loaded yet!
-            // It will be applied in loadFileOnly() after the file is loaded
+            settings.savedConfigBPM = bpm;
+            // NOTE: Applied in applyFileTempo() once the file's own BPM is known
         } else if (strncmp(line, "USE_TARGET_BPM=", 15) == 0) {
-            useTargetBPM = (atoi(line + 15) != 0);
+            settings.useTargetBPM = (atoi(line + 15) != 0);
         } else if (strncmp(line, "TEMPO_PERCENT=", 14) == 0) {
             // Backward compatibility: Old config files used TEMPO_PERCENT
             // For now, we'll ignore old TEMPO_PERCENT values and use file's default BPM
             // User can re-save config to migrate to new TARGET_BPM format
         } else if (strncmp(line, "SOLOS=", 6) == 0) {
-            channelSolos = atoi(line + 6);
-            applySoloLogic();  // Apply solo logic after loading
+            channels.solos = atoi(line + 6);
+        } else if (strncmp(line, "TRACK_MUTES=", 12) == 0) {
+            settings.trackMutes = atoi(line + 12);
+        } else if (strncmp(line, "TRACK_SOLOS=", 12) == 0) {
+            settings.trackSolos = atoi(line + 12);
         } else if (strncmp(line, "SYSEX_ENABLED=", 14) == 0) {
-            sysexEnabled = (atoi(line + 14) != 0);
+            settings.sysexEnabled = (atoi(line + 14) != 0);
+        }
+    }
+    if (sceneIndex >= 0) {
+        scenes[sceneIndex] = scene;
+        settings.sceneMask |= 1 << sceneIndex;
+    }
+
+    // Solo logic as applySoloLogic() applies it: any solo mutes every other channel
+    if (channels.solos) {
+        channels.mutes |= static_cast<uint16_t>(~channels.solos);
+    }
+
+    // Stored scenes in index order, one per bit of sceneMask
+    uint8_t stored = 0;
+    for (uint8_t index = 0; index < MAX_SCENES; index++) {
+        if (settings.sceneMask & (1 << index)) {
+            if (stored != index) scenes[stored] = scenes[index];
+            stored++;
         }
     }
 
     // File automatically closed by ScopedFile destructor
+    return true;
+}
 
-    // Tell player about the loaded settings so it can filter MIDI file messages
-    {
-        ScopedMutex lock(&playerMutex);
-        player.setChannelPrograms(channelPrograms);
-        player.setChannelVolumes(channelVolume);
-        player.setChannelPan(channelPan);
-        player.setChannelTranspose(channelTranspose);
-        player.setChannelVelocityScales(channelVelocity);
-        player.setChannelRouting(channelRouting);
-        player.setSysexEnabled(sysexEnabled);
+void resetScene(ChannelScene& scene) {
+    // Same defaults as resetChannelSettingsToDefaults()
+    scene.mutes = 0;
+    scene.solos = 0;
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        scene.programs[ch] = CHANNEL_PROGRAM_USE_MIDI_FILE;
+        scene.volumes[ch] = CHANNEL_VOLUME_USE_MIDI_FILE;
+        scene.pan[ch] = CHANNEL_PAN_USE_MIDI_FILE;
+        scene.transpose[ch] = 0;
+        scene.velocities[ch] = 0;
+        scene.routing[ch] = MIDI_ROUTE_ORIGINAL;
+        scene.layers[ch] = 0;
+    }
+}
+
+static void writeSceneList(FatFile& file, const char* key, const uint8_t* values) {
+    char line[96];
+    strcpy(line, key);
+    for (int i = 0; i < 16; i++) {
+        char num[8];
+        sprintf(num, "%u", values[i]);
+        strcat(line, num);
+        if (i < 15) strcat(line, ",");
     }
+    strcat(line, "\n");
+    file.write(line);
+}
 
-    // Send loaded settings to MIDI output immediately
-    sendProgramChanges();
-    sendChannelVolumes();
-    sendChannelPan();
+void writeSceneSection(FatFile& file, uint8_t index, const ChannelScene& scene) {
+    char line[256];
 
-    return true;
+    sprintf(line, "[SCENE %u]\n", index + 1);
+    file.write(line);
+    sprintf(line, "MUTES=%u\n", scene.mutes);
+    file.write(line);
+    sprintf(line, "SOLOS=%u\n", scene.solos);
+    file.write(line);
+    writeSceneList(file, "PROGRAMS=", scene.programs);
+    writeSceneList(file, "VOLUMES=", scene.volumes);
+    writeSceneList(file, "PAN=", scene.pan);
+    writeSceneList(file, "ROUTING=", scene.routing);
+    writeSceneList(file, "CH_VELOCITY=", scene.velocities);
+
+    strcpy(line, "TRANSPOSE=");
+    for (int i = 0; i < 16; i++) {
+        char num[8];
+        sprintf(num, "%d", scene.transpose[i]);
+        strcat(line, num);
+        if (i < 15) strcat(line, ",");
+    }
+    strcat(line, "\n");
+    file.write(line);
+
+    strcpy(line, "LAYERS=");
+    for (int i = 0; i < 16; i++) {
+        char num[20];
+        sprintf(num, "%llX", (unsigned long long)scene.layers[i]);
+        strcat(line, num);
+        if (i < 15) strcat(line, ",");
+    }
+    strcat(line, "\n");
+    file.write(line);
+}
+
+void parseSceneLine(char* line, ChannelScene& scene) {
+    // Keys inside a [SCENE n] section use the same format as the song settings
+    if (strncmp(line, "MUTES=", 6) == 0) {
+        scene.mutes = atoi(line + 6);
+    } else if (strncmp(line, "SOLOS=", 6) == 0) {
+        scene.solos = atoi(line + 6);
+    } else if (strncmp(line, "PROGRAMS=", 9) == 0) {
+        char* token = strtok(line + 9, ",");
+        for (int i = 0; i < 16 && token; i++) {
+            scene.programs[i] = atoi(token);
+            token = strtok(NULL, ",");
+        }
+    } else if (strncmp(line, "VOLUMES=", 8) == 0) {
+        char* token = strtok(line + 8, ",");
+        for (int i = 0; i < 16 && token; i++) {
+            scene.volumes[i] = atoi(token);
+            token = strtok(NULL, ",");
+        }
+    } else if (strncmp(line, "PAN=", 4) == 0) {
+        char* token = strtok(line + 4, ",");
+        for (int i = 0; i < 16 && token; i++) {
+            scene.pan[i] = atoi(token);
+            token = strtok(NULL, ",");
+        }
+    } else if (strncmp(line, "TRANSPOSE=", 10) == 0) {
+        char* token = strtok(line + 10, ",");
+        for (int i = 0; i < 16 && token; i++) {
+            scene.transpose[i] = atoi(token);
+            token = strtok(NULL, ",");
+        }
+    } else if (strncmp(line, "ROUTING=", 8) == 0) {
+        char* token = strtok(line + 8, ",");
+        for (int i = 0; i < 16 && token; i++) {
+            int route = atoi(token);
+            scene.routing[i] = (route >= 0 && route <= MIDI_ROUTE_MAX) ? route : MIDI_ROUTE_ORIGINAL;
+            token = strtok(NULL, ",");
+        }
+    } else if (strncmp(line, "LAYERS=", 7) == 0) {
+        char* token = strtok(line + 7, ",");
+        for (int i = 0; i < 16 && token; i++) {
+            scene.layers[i] = strtoull(token, NULL, 16) & MIDI_ROUTE_ALL_MASK;
+            token = strtok(NULL, ",");
+        }
+    } else if (strncmp(line, "CH_VELOCITY=", 12) == 0) {
+        char* token = strtok(line + 12, ",");
+        for (int i = 0; i < 16 && token; i++) {
+            scene.velocities[i] = atoi(token);
+            token = strtok(NULL, ",");
+        }
+    }
 }
 
 int deleteTrackSettings(const char* midiFilename) {
@@ -2815,6 +3489,7 @@ int deleteTrackSettings(const char* midiFilename) {
         return -1; // Return -1 = delete failed
     }
 
+    updateSetlistSettings(true);
     return 1; // Return 1 = deleted successfully
 }
 
@@ -2851,6 +3526,20 @@ bool saveGlobalSettings() {
     sprintf(line, "MIDI_CLOCK=%d\n", midiClockEnabled ? 1 : 0);
     settingsFileObj.write(line);
 
+    sprintf(line, "TAP_PHASE_ALIGN=%d\n", tapPhaseAlign ? 1 : 0);
+    settingsFileObj.write(line);
+
+    sprintf(line, "LAUNCH=%s\n", LAUNCH_QUANTIZE_NAMES[launchQuantize]);
+    settingsFileObj.write(line);
+
+    // Write playback overload policy
+    sprintf(line, "CATCHUP_POLICY=%s\n", CATCHUP_POLICY_NAMES[catchUpPolicy]);
+    settingsFileObj.write(line);
+
+    // Write .syx message gap
+    sprintf(line, "SYSEX_GAP_MS=%u\n", sysexGapMs);
+    settingsFileObj.write(line);
+
     // File automatically closed by ScopedFile destructor
     return true;
 }
@@ -2899,6 +3588,29 @@ bool loadGlobalSettings() {
                 ScopedMutex lock(&playerMutex);
                 player.setClockEnabled(midiClockEnabled);
             }
+        } else if (strncmp(line, "TAP_PHASE_ALIGN=", 16) == 0) {
+            tapPhaseAlign = (atoi(line + 16) != 0);
+        } else if (strncmp(line, "LAUNCH=", 7) == 0) {
+            for (uint8_t i = 0; i < LAUNCH_QUANTIZE_COUNT; i++) {
+                if (strcmp(line + 7, LAUNCH_QUANTIZE_NAMES[i]) == 0) {
+                    launchQuantize = static_cast<LaunchQuantize>(i);
+                    break;
+                }
+            }
+        } else if (strncmp(line, "CATCHUP_POLICY=", 15) == 0) {
+            for (uint8_t i = 0; i < CATCHUP_POLICY_COUNT; i++) {
+                if (strcmp(line + 15, CATCHUP_POLICY_NAMES[i]) == 0) {
+                    catchUpPolicy = static_cast<CatchUpPolicy>(i);
+                    ScopedMutex lock(&playerMutex);
+                    player.setCatchUpPolicy(catchUpPolicy);
+                    break;
+                }
+            }
+        } else if (strncmp(line, "SYSEX_GAP_MS=", 13) == 0) {
+            int gap = atoi(line + 13);
+            if (gap < 0) gap = 0;
+            if (gap > SYSEX_GAP_MAX_MS) gap = SYSEX_GAP_MAX_MS;
+            sysexGapMs = gap;
         }
     }
 
@@ -2906,216 +3618,1612 @@ bool loadGlobalSettings() {
     return true;
 }
 
-bool loadFileOnly() {
-    unsigned long startTime = millis();
+// ============================================================================
+// SETLISTS
+// Entering a .set file lists its songs (FileBrowser). Each one is loaded once
+// the normal way, and what that load produced - settings, length and tempo,
+// track table and the first bytes of every track - is kept in RAM, so later
+// song changes parse no settings file, look nothing up in the length cache
+// and start from the preloaded heads. Songs that don't fit stay on the card.
+// ============================================================================
 
-    // CRITICAL: Prevent re-entrant calls during rapid file switching
-    static bool isLoading = false;
-    if (isLoading) {
-        return false;
+// One allocation per song: this struct, the scenes, then the track heads
+struct SetlistSong {
+    SongSettings settings;
+    ParserPreload preload;
+    ChannelScene* scenes;       // One per bit of settings.sceneMask, in order
+    uint8_t sceneCapacity;
+    uint32_t bytes;             // RAM held, including scenes and heads
+};
+
+static SetlistSong* setlistSongs[MAX_SETLIST_SONGS];  // Index = position in the setlist
+
+static SetlistSong* setlistSongAt(uint16_t index) {
+    if (!browser.isSetlist() || index >= MAX_SETLIST_SONGS) return nullptr;
+    return setlistSongs[index];
+}
+
+SetlistSong* currentSetlistSong() {
+    return setlistSongAt(browser.getCurrentIndex());
+}
+
+static uint8_t storedSceneMask() {
+    uint8_t mask = 0;
+    ChannelScene scene;
+    ScopedMutex lock(&playerMutex);
+    for (uint8_t index = 0; index < MAX_SCENES; index++) {
+        if (player.getScene(index, scene)) mask |= 1 << index;
     }
-    isLoading = true;
+    return mask;
+}
 
-    // CRITICAL: Stop playback FIRST, outside mutex, so Core 1 can exit cleanly
-    // Core 1 needs to complete any in-progress SD card reads before we close files
-    {
-        ScopedMutex lock(&playerMutex);
-        player.stop(false);  // Stop without reset
+static uint8_t countBits(uint8_t mask) {
+    uint8_t count = 0;
+    for (; mask; mask &= mask - 1) count++;
+    return count;
+}
+
+// Settings of the loaded song, as loadTrackSettings() and the menus left them
+static void captureSongSettings(SetlistSong& song) {
+    SongSettings& settings = song.settings;
+    captureScene(settings.channels);
+    settings.velocityScale = velocityScale;
+    settings.sysexEnabled = sysexEnabled;
+    settings.useTargetBPM = useTargetBPM;
+    settings.targetBPM = targetBPM;
+    settings.savedConfigBPM = savedConfigBPM;
+    settings.sceneMask = 0;
+
+    ScopedMutex lock(&playerMutex);
+    settings.trackMutes = player.getTrackMutes();
+    settings.trackSolos = player.getTrackSolos();
+    uint8_t stored = 0;
+    for (uint8_t index = 0; index < MAX_SCENES && stored < song.sceneCapacity; index++) {
+        if (player.getScene(index, song.scenes[stored])) {
+            settings.sceneMask |= 1 << index;
+            stored++;
+        }
     }
+}
+
+// Menu and tempo state of a song's settings (the player's copy is set separately)
+static void setSongSettingsUi(const SongSettings& settings) {
+    channelSolos = settings.channels.solos;
+    memcpy(channelPrograms, settings.channels.programs, sizeof(settings.channels.programs));
+    memcpy(channelVolume, settings.channels.volumes, sizeof(settings.channels.volumes));
+    memcpy(channelPan, settings.channels.pan, sizeof(settings.channels.pan));
+    memcpy(channelTranspose, settings.channels.transpose, sizeof(settings.channels.transpose));
+    memcpy(channelVelocity, settings.channels.velocities, sizeof(settings.channels.velocities));
+    memcpy(channelRouting, settings.channels.routing, sizeof(settings.channels.routing));
+    memcpy(channelLayers, settings.channels.layers, sizeof(settings.channels.layers));
+    velocityScale = settings.velocityScale;
+    velocityScaleDefault = settings.velocityScale;
+    sysexEnabled = settings.sysexEnabled;
+    useTargetBPM = settings.useTargetBPM;
+    targetBPM = settings.targetBPM;
+    savedConfigBPM = settings.savedConfigBPM;
+}
 
-    // Wait for Core 1 to fully exit update() - critical for parser access safety
-    // Must wait for any in-progress SD card reads to complete
-    // 100ms is conservative but necessary for slow SD cards and large MIDI events
-    delay(100);  // Increased from 50ms for better safety margin
+void applySongSettings(const SongSettings& settings, const ChannelScene* scenes) {
+    resetChannelSettingsToDefaults();
+    setSongSettingsUi(settings);
 
-    // Now safe to acquire mutex and close everything
     {
         ScopedMutex lock(&playerMutex);
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            if (settings.channels.mutes & (1 << ch)) {
+                player.muteChannel(ch);
+            } else {
+                player.unmuteChannel(ch);
+            }
+        }
+        player.setChannelPrograms(channelPrograms);
+        player.setChannelVolumes(channelVolume);
+        player.setChannelPan(channelPan);
+        player.setChannelTranspose(channelTranspose);
+        player.setChannelVelocityScales(channelVelocity);
+        player.setChannelRouting(channelRouting);
+        player.setChannelLayers(channelLayers);
+        player.setVelocityScale(velocityScale);
+        player.setSysexEnabled(sysexEnabled);
+        player.setTrackMutes(settings.trackMutes);
+        player.setTrackSolos(settings.trackSolos);
 
-        // Reset MIDI device to clean state (inside mutex for thread safety)
-        // This stops all notes and resets controllers
-        player.resetMidiDevice();
-
-        // Unload player (Core 1 is done with it - no delay needed here)
-        player.unloadFile();
-
-        // Then close our file handle
-        if (currentFile.isOpen()) {
-            currentFile.close();
+        uint8_t stored = 0;
+        for (uint8_t index = 0; index < MAX_SCENES; index++) {
+            if (settings.sceneMask & (1 << index)) {
+                player.storeScene(index, scenes[stored++]);
+            }
         }
     }
 
-    // Extra delay to ensure SD card file handles are fully released
-    delay(SD_CLOSE_DELAY_MS);
+    // Device setup for the overrides (only channels that have one)
+    sendOverrideSetup();
+}
 
-    // Get the current file entry
-    FileEntry* entry = browser.getCurrentFile();
-    if (!entry || entry->isDirectory) {
-        isLoading = false;
-        return false;
+void releaseSetlist() {
+    cancelSongLaunch();  // It may be queued from one of the copies
+    for (uint8_t i = 0; i < MAX_SETLIST_SONGS; i++) {
+        delete[] reinterpret_cast<uint8_t*>(setlistSongs[i]);
+        setlistSongs[i] = nullptr;
     }
+}
 
-    // Reset tempo to default for new file
-    tempoPercent = DEFAULT_TEMPO_PERCENT;
-    useDefaultTempo = false;  // Start with explicit tempo control
+void preloadSetlist() {
+    releaseSetlist();
+
+    uint16_t songCount = browser.getSetlistSongCount();
+    uint8_t residentCount = 0;
+    uint32_t totalBytes = 0;
+
+    Serial.print("Setlist ");
+    Serial.print(browser.getCurrentPath());
+    Serial.print(": ");
+    Serial.print(songCount);
+    Serial.println(" songs");
+
+    for (uint16_t i = 0; i < songCount; i++) {
+        FileEntry* entry = browser.getCurrentFile();
+        char progress[17];
+        snprintf(progress, sizeof(progress), "%u/%u", i + 1, songCount);
+        display.showMessage("Setlist", progress);
+
+        // The normal load, so the RAM copy is exactly what it produces
+        bool loaded = (i < MAX_SETLIST_SONGS) && loadFileOnly();
+        if (!loaded) {
+            Serial.print("  ");
+            Serial.print(entry->filename);
+            Serial.println(i < MAX_SETLIST_SONGS ? ": failed to load" : ": from card (setlist too long)");
+            browser.selectNext();
+            continue;
+        }
 
-    // Try to load saved settings for this file (may override tempoPercent)
-    loadTrackSettings(entry->filename);
+        uint16_t headBytes;
+        {
+            ScopedMutex lock(&playerMutex);
+            headBytes = player.getParser().getPreloadHeadBytes();
+        }
+        uint8_t sceneCount = countBits(storedSceneMask());
+        uint32_t bytes = sizeof(SetlistSong) + sceneCount * sizeof(ChannelScene) + headBytes;
 
-    // Open the selected file (no mutex needed - player not accessing yet)
-    if (!browser.openFile(&currentFile)) {
-        display.showError("Failed to open!");
-        delay(2000);
-        isLoading = false;
-        return false;
-    }
+        // Keep headroom for the player - a song that doesn't fit loads from the card
+        uint8_t* block = nullptr;
+        if ((uint32_t)rp2040.getFreeHeap() >= bytes + SETLIST_HEAP_RESERVE) {
+            block = new (std::nothrow) uint8_t[bytes];
+        }
 
-    // Load the file into the player (protected with mutex)
-    {
-        ScopedMutex lock(&playerMutex);
-        if (!player.loadFile(&currentFile)) {
-            display.showError("Invalid MIDI!");
-            currentFile.close();
-            delay(2000);
-            isLoading = false;
-            return false;
+        bool captured = false;
+        if (block) {
+            SetlistSong* song = reinterpret_cast<SetlistSong*>(block);
+            song->scenes = reinterpret_cast<ChannelScene*>(block + sizeof(SetlistSong));
+            song->sceneCapacity = sceneCount;
+            song->bytes = bytes;
+            captureSongSettings(*song);
+            {
+                ScopedMutex lock(&playerMutex);
+                captured = player.getParser().capturePreload(song->preload, block + sizeof(SetlistSong) + sceneCount * sizeof(ChannelScene));
+            }
+            if (captured) {
+                setlistSongs[i] = song;
+                residentCount++;
+                totalBytes += bytes;
+            } else {
+                delete[] block;  // Format 2 - its sequences need the scan
+            }
+        }
+
+        Serial.print("  ");
+        Serial.print(entry->filename);
+        if (captured) {
+            Serial.print(": ");
+            Serial.print(bytes);
+            Serial.print(" bytes (");
+            Serial.print(headBytes);
+            Serial.println(" track heads)");
+        } else {
+            Serial.println(block ? ": from card (format 2)" : ": from card (low RAM)");
         }
+
+        browser.selectNext();
     }
 
-    // CRITICAL: Scan for initial tempo BEFORE cache check
-    // This ensures parser has correct tempo even if file length is cached
-    // NOTE: This is safe without mutex because player is stopped and Core 1 has exited update()
-    player.getParser().scanForInitialTempo();
+    Serial.print("Setlist in RAM: ");
+    Serial.print(residentCount);
+    Serial.print("/");
+    Serial.print(songCount);
+    Serial.print(" songs, ");
+    Serial.print(totalBytes);
+    Serial.print(" bytes, ");
+    Serial.print(rp2040.getFreeHeap());
+    Serial.println(" bytes free");
+
+    char summary[17];
+    snprintf(summary, sizeof(summary), "%u/%u %luKB", residentCount, songCount, (unsigned long)((totalBytes + 1023) / 1024));
+    display.showMessage("Setlist in RAM", summary);
+    delay(1000);
+
+    // Back to the first song, loaded from its RAM copy
+    while (browser.getCurrentIndex() > 0) {
+        browser.selectPrevious();
+    }
+    FileEntry* first = browser.getCurrentFile();
+    if (songCount > 0 && loadFileOnly()) {
+        lastPlayedFile = first;
+    }
+}
 
-    // Calculate and cache file length (first time only, uses cache afterward)
-    // This is done OUTSIDE mutex to avoid blocking Core 1, but player must be fully stopped first
-    // WARNING: For large files not in cache, this can take several seconds and will freeze UI!
-    // Check if file is in cache to decide whether to show loading message
-    const char* filename = strrchr(entry->fullPath, '/');
-    filename = filename ? filename + 1 : entry->fullPath;
-    FatFile tempFile;
-    if (tempFile.open(entry->fullPath, O_RDONLY)) {
-        uint16_t date, time;
-        tempFile.getModifyDateTime(&date, &time);
-        uint32_t modtime = ((uint32_t)date << 16) | time;
-        tempFile.close();
+void updateSetlistSettings(bool deleted) {
+    // Keep the RAM copy of the current song in step with its .cfg file
+    SetlistSong* song = currentSetlistSong();
+    if (!song) return;
 
-        // Check if in cache - if not, show loading message
-        if (getCachedFileLength(filename, modtime) == 0) {
-            display.showMessage("Scanning", "MIDI file...");
-            delay(100);  // Brief delay so message is visible
-        }
+    if (!deleted && countBits(storedSceneMask()) <= song->sceneCapacity) {
+        captureSongSettings(*song);
+        return;
     }
 
-    calculateAndCacheFileLength(entry->fullPath, player.getParser());
+    // Settings now come from the card (defaults after a delete, or more scenes than allocated)
+    uint16_t index = browser.getCurrentIndex();
+    cancelSongLaunch();
+    delete[] reinterpret_cast<uint8_t*>(setlistSongs[index]);
+    setlistSongs[index] = nullptr;
+}
 
-    // NOW apply tempo and channel settings AFTER file scanning - with mutex protection
-    // We temporarily set tempo to 100% so we can read the file's actual BPM
+// ============================================================================
+// QUANTIZED LAUNCH
+// With Launch at BEAT or BAR, PREV/NEXT during playback keep the current song
+// playing and queue the next one in the player, which switches to it on the
+// next beat or bar (MidiPlayer::queueLaunch). Everything the switch needs is
+// ready in RAM beforehand: the setlist copy when the song has one, otherwise
+// the same kind of copy built here from its .cfg, the length cache and its
+// track heads. The browser and menus follow once the player has switched.
+// Songs that can't be prepared change at once, as before.
+// ============================================================================
+
+static SongLaunch songLaunch;                 // What the player switches to
+static SetlistSong* launchSource = nullptr;   // Settings of the queued song
+static SetlistSong* launchCopy = nullptr;     // Built for a song without a setlist copy
+static int16_t launchIndex = -1;              // Browser index of the queued song (-1 = none)
+
+static void releaseLaunchCopy() {
+    delete[] reinterpret_cast<uint8_t*>(launchCopy);
+    launchCopy = nullptr;
+}
+
+// Build the RAM copy a setlist would hold for this song while the current
+// one plays on. The card is shared with Core 1, so the player mutex is taken
+// around each card step only (a few blocks of the song, the length cache,
+// the .cfg); the allocations happen between them. Songs not yet in the length
+// cache (their first load scans the whole file) and format 2 files are left
+// to a normal load.
+static SetlistSong* prepareLaunchCopy(FileEntry* entry, FatFile& file) {
+    FileIdentity identity;
+    uint16_t sysexCount = 0;
+    uint32_t lengthTicks;
     {
         ScopedMutex lock(&playerMutex);
-        player.setTempoPercent(DEFAULT_TEMPO_PERCENT);  // Set to 100% (1000 in tenth-percent)
-        player.setChannelPrograms(channelPrograms);
+        if (!computeFileIdentity(&file, identity)) return nullptr;
     }
-
-    // Store file's base BPM for all tempo calculations (always do this)
-    // Read the current BPM from the player (at 100% tempo)
-    uint16_t fileBPM;
     {
         ScopedMutex lock(&playerMutex);
-        fileBPM = player.getCurrentBPM();
+        lengthTicks = getCachedFileLength(identity, &sysexCount);
     }
+    if (lengthTicks == 0) return nullptr;
 
-    if (fileBPM > 0) {
-        // Store file's base BPM in hundredths for tempo percent calculations
+    if ((uint32_t)rp2040.getFreeHeap() < sizeof(MidiFileParser) + SETLIST_HEAP_RESERVE) return nullptr;
+    MidiFileParser* parser = new (std::nothrow) MidiFileParser();
+    if (!parser) return nullptr;
+
+    SetlistSong* song = nullptr;
+    bool opened;
+    {
+        ScopedMutex lock(&playerMutex);
+        opened = parser->open(entry->fullPath, &file) && !parser->isMultiSequence();
+    }
+    if (opened) {
+        {
+            ScopedMutex lock(&playerMutex);
+            parser->scanForInitialTempo();
+        }
+        parser->setFileLengthTicks(lengthTicks);
+        parser->setSysexCount(sysexCount);
+
+        // Room for every scene - the .cfg is only read once the block exists
+        uint32_t scenesBytes = MAX_SCENES * sizeof(ChannelScene);
+        uint32_t bytes = sizeof(SetlistSong) + scenesBytes + parser->getPreloadHeadBytes();
+        uint8_t* block = nullptr;
+        if ((uint32_t)rp2040.getFreeHeap() >= bytes + SETLIST_HEAP_RESERVE) {
+            block = new (std::nothrow) uint8_t[bytes];
+        }
+        if (block) {
+            song = reinterpret_cast<SetlistSong*>(block);
+            song->scenes = reinterpret_cast<ChannelScene*>(block + sizeof(SetlistSong));
+            song->bytes = bytes;
+            {
+                ScopedMutex lock(&playerMutex);
+                readSongSettings(entry->filename, song->settings, song->scenes);
+            }
+            song->sceneCapacity = countBits(song->settings.sceneMask);
+            if (!parser->capturePreload(song->preload, block + sizeof(SetlistSong) + scenesBytes)) {
+                delete[] block;
+                song = nullptr;
+            }
+        }
+    }
+
+    parser->close();
+    delete parser;
+    return song;
+}
+
+// Base BPM of the song in hundredths, as applyFileTempo() would find it
+static uint32_t songFileBPM(const SetlistSong& song) {
+    uint32_t tempo = song.preload.fileInfo.tempo;
+    uint32_t bpm = tempo ? 60000000 / tempo : 120;
+    return bpm ? bpm * 100 : DEFAULT_TARGET_BPM;
+}
+
+// Tempo percent the song's settings ask for
+static uint16_t songTempoPercent(const SetlistSong& song) {
+    if (!song.settings.useTargetBPM) return DEFAULT_TEMPO_PERCENT;
+
+    uint32_t target = song.settings.targetBPM;
+    if (target < MIN_TARGET_BPM) target = MIN_TARGET_BPM;
+    if (target > MAX_TARGET_BPM) target = MAX_TARGET_BPM;
+    uint32_t percent = (uint32_t)(((uint64_t)target * 1000) / songFileBPM(song));
+    if (percent < MIN_TEMPO_PERCENT) percent = MIN_TEMPO_PERCENT;
+    if (percent > MAX_TEMPO_PERCENT) percent = MAX_TEMPO_PERCENT;
+    return (uint16_t)percent;
+}
+
+// Core 0 side of a launch the player has carried out. moveBrowser = select
+// the new song (false when the caller is about to move the browser itself).
+static void finishSongLaunch(bool moveBrowser) {
+    bool loaded;
+    uint32_t errorMicros, maxErrorMicros;
+    {
+        ScopedMutex lock(&playerMutex);
+        loaded = player.isLoaded();
+        errorMicros = player.getLastLaunchErrorMicros();
+        maxErrorMicros = player.getMaxLaunchErrorMicros();
+    }
+
+    // The prepared file is the one playing now
+    songFiles[currentFileIndex].close();
+    currentFileIndex = 1 - currentFileIndex;
+
+    SetlistSong* song = launchSource;
+    uint16_t index = (uint16_t)launchIndex;
+    launchSource = nullptr;
+    launchIndex = -1;
+
+    if (loaded) {
+        // What loadFileOnly() would have left for the menus
+        setSongSettingsUi(song->settings);
+        selectedScene = 0;
+        selectedPart = 0;
+        {
+            ScopedMutex lock(&playerMutex);
+            player.clearScenes();
+            uint8_t stored = 0;
+            for (uint8_t scene = 0; scene < MAX_SCENES; scene++) {
+                if (song->settings.sceneMask & (1 << scene)) {
+                    player.storeScene(scene, song->scenes[stored++]);
+                }
+            }
+        }
+        fileBPM_hundredths = songFileBPM(*song);
+        tempoPercent = songLaunch.tempoPercent;
+        useDefaultTempo = false;
+        if (!useTargetBPM) targetBPM = fileBPM_hundredths;
+        if (targetBPM < MIN_TARGET_BPM) targetBPM = MIN_TARGET_BPM;
+        if (targetBPM > MAX_TARGET_BPM) targetBPM = MAX_TARGET_BPM;
+        resetVisualizer();
+
+        Serial.print("Launch: switched ");
+        Serial.print(errorMicros);
+        Serial.print("us after the ");
+        Serial.print(LAUNCH_QUANTIZE_NAMES[launchQuantize]);
+        Serial.print(" (max ");
+        Serial.print(maxErrorMicros);
+        Serial.println("us)");
+    }
+    releaseLaunchCopy();
+
+    if (!moveBrowser) return;
+    while (browser.getCurrentIndex() < index) browser.selectNext();
+    while (browser.getCurrentIndex() > index) browser.selectPrevious();
+    if (loaded) {
+        lastPlayedFile = browser.getCurrentFile();
+    } else if (loadAndPlayFile()) {
+        // The prepared copy was rejected at the boundary - load it from the card
+        lastPlayedFile = browser.getCurrentFile();
+    }
+    updateDisplay();
+}
+
+// PREV/NEXT while playing with Launch on: queue the song after the one playing
+// (or after the one already queued). False = change songs the usual way.
+static bool queueSongLaunch(int8_t direction) {
+    updateSongLaunch();  // A launch that has just happened moves the browser first
+
+    uint16_t count = browser.getFileCount();
+    if (count == 0) return false;
+    int16_t from = (launchIndex >= 0) ? launchIndex : (int16_t)browser.getCurrentIndex();
+    uint16_t target = (uint16_t)((from + direction + count) % count);
+    cancelSongLaunch();
+
+    FileEntry* entry = browser.getFile(target);
+    if (!entry || entry->isDirectory || browser.isSysExFile(entry->filename)) return false;
+
+    uint32_t startMicros = micros();
+    SetlistSong* song = setlistSongAt(target);
+    bool fromSetlist = (song != nullptr);
+    FatFile& file = songFiles[1 - currentFileIndex];
+    bool opened;
+    {
+        ScopedMutex lock(&playerMutex);
+        opened = file.open(entry->fullPath, O_RDONLY);
+    }
+    if (opened && !song) {
+        song = launchCopy = prepareLaunchCopy(entry, file);
+    }
+    if (!song) {
+        file.close();
+        return false;
+    }
+
+    songLaunch.file = &file;
+    songLaunch.preload = song->preload;
+    songLaunch.channels = song->settings.channels;
+    songLaunch.trackMutes = song->settings.trackMutes;
+    songLaunch.trackSolos = song->settings.trackSolos;
+    songLaunch.velocityScale = song->settings.velocityScale;
+    songLaunch.sysexEnabled = song->settings.sysexEnabled;
+    songLaunch.tempoPercent = songTempoPercent(*song);
+
+    bool queued;
+    {
+        ScopedMutex lock(&playerMutex);
+        queued = player.queueLaunch(&songLaunch, launchQuantize);
+    }
+    if (!queued) {
+        file.close();
+        releaseLaunchCopy();
+        return false;
+    }
+    launchSource = song;
+    launchIndex = (int16_t)target;
+
+    Serial.print("Launch: ");
+    Serial.print(entry->filename);
+    Serial.print(" on the next ");
+    Serial.print(LAUNCH_QUANTIZE_NAMES[launchQuantize]);
+    Serial.print(fromSetlist ? " (setlist copy, " : " (prepared in ");
+    Serial.print(micros() - startMicros);
+    Serial.println("us)");
+    return true;
+}
+
+void cancelSongLaunch() {
+    if (launchIndex < 0) return;
+
+    bool launched;
+    {
+        ScopedMutex lock(&playerMutex);
+        player.cancelLaunch();
+        launched = player.takeLaunched();
+    }
+    if (launched) {
+        finishSongLaunch(false);
+        return;
+    }
+
+    songFiles[1 - currentFileIndex].close();
+    releaseLaunchCopy();
+    launchSource = nullptr;
+    launchIndex = -1;
+}
+
+void updateSongLaunch() {
+    if (launchIndex < 0) return;
+
+    bool launched, pending;
+    {
+        ScopedMutex lock(&playerMutex);
+        launched = player.takeLaunched();
+        pending = player.isLaunchPending();
+    }
+    if (launched) {
+        finishSongLaunch(true);
+    } else if (!pending) {
+        cancelSongLaunch();  // Paused, stopped or moved before the boundary
+    }
+}
+
+// ============================================================================
+// AUDITION
+// STOP in the browser with no song playing previews the highlighted file.
+// A preview opens the file and reads its header and track heads - no settings
+// file, no length or tempo scan - and plays with the mixer at defaults, so it
+// starts within a few card reads. Moving the cursor stops it at once and the
+// next file starts once the cursor rests (AUDITION_SETTLE_MS). OK and PLAY
+// load the previewed file the normal way.
+// ============================================================================
+
+static bool auditionOn = false;         // Browser is in audition mode
+static bool auditionLoaded = false;     // The player holds a preview, not a loaded song
+static bool auditionDue = false;        // The highlighted file starts at auditionDueMs
+static unsigned long auditionDueMs = 0;
+
+bool isAuditioning() {
+    return auditionOn;
+}
+
+// Take the preview out of the player (not the audition mode)
+static void stopAudition() {
+    auditionDue = false;
+    if (!auditionLoaded) return;
+    auditionLoaded = false;
+
+    ScopedMutex lock(&playerMutex);
+    player.unloadFile();
+    songFiles[currentFileIndex].close();
+}
+
+static void startAudition() {
+    auditionDue = false;
+    FileEntry* entry = browser.getCurrentFile();
+    if (!entry || entry->isDirectory || browser.isSysExFile(entry->filename)) return;
+
+    unsigned long startMicros = micros();
+    bool started = false;
+    {
+        // Whatever the player held goes - the song a preview replaced, or the last preview
+        ScopedMutex lock(&playerMutex);
+        player.unloadFile();
+        FatFile& file = songFiles[currentFileIndex];
+        file.close();
+        if (browser.openFile(&file)) {
+            if (player.loadPreview(&file)) {
+                player.setTempoPercent(DEFAULT_TEMPO_PERCENT);
+                player.play();
+                started = true;
+            } else {
+                file.close();
+            }
+        }
+    }
+    auditionLoaded = started;
+    resetVisualizer();
+
+    Serial.print("Audition: ");
+    Serial.print(entry->filename);
+    if (started) {
+        Serial.print(" started in ");
+        Serial.print(micros() - startMicros);
+        Serial.println("us");
+    } else {
+        Serial.println(" is not a playable MIDI file");
+    }
+}
+
+void beginAudition() {
+    cancelSongLaunch();
+
+    // The preview replaces the loaded song: menus and mixer go back to defaults
+    resetChannelSettingsToDefaults();
+    tempoPercent = DEFAULT_TEMPO_PERCENT;
+    lastPlayedFile = nullptr;
+
+    auditionOn = true;
+    startAudition();
+}
+
+void endAudition() {
+    if (!auditionOn) return;
+    auditionOn = false;
+    stopAudition();
+    resetVisualizer();
+}
+
+void scheduleAudition() {
+    if (!auditionOn) return;
+    stopAudition();
+    auditionDue = true;
+    auditionDueMs = millis() + AUDITION_SETTLE_MS;
+}
+
+void updateAudition() {
+    if (!auditionDue || (long)(millis() - auditionDueMs) < 0) return;
+    if (auditionOn && currentMode == APP_MODE_BROWSE) {
+        startAudition();
+    } else {
+        auditionDue = false;
+    }
+}
+
+// ============================================================================
+// SYSEX SEND
+// OK or PLAY on a .syx file in the browser opens the send screen, and PLAY
+// sends the file to every output port. It is read SYSEX_CHUNK_SIZE bytes at a
+// time into the only buffer and posted through the Core 0 submission queue
+// from loop(), so the UI keeps running. A piece is posted once the one before
+// has had time to go out on the wire, and every complete message is followed
+// by sysexGapMs for receivers that need time to store it (MT-32, SC-55).
+// Messages longer than a chunk go out in pieces, so playback stops and MIDI
+// Thru, keyboard and remote control are held off while the screen is up:
+// nothing else may reach the output between the pieces of a message.
+// ============================================================================
+
+static bool sysexSendOpen = false;
+static SysExSendState sysexSendState = SYSEX_SEND_READY;
+static FileEntry* sysexEntry = nullptr;
+static FatFile sysexFile;
+static uint8_t sysexChunk[SYSEX_CHUNK_SIZE];
+static uint16_t sysexChunkLength = 0;
+static uint16_t sysexChunkPos = 0;       // Next byte to send
+static bool sysexInMessage = false;      // An F0 went out, its F7 has not
+static uint32_t sysexBytesSent = 0;
+static uint32_t sysexMessages = 0;
+static unsigned long sysexStartMs = 0;
+static unsigned long sysexElapsedMs = 0; // Of the last send that ended
+static uint32_t sysexNextMicros = 0;     // Earliest time for the next piece
+static bool sysexGapChanged = false;     // Saved to /settings.cfg on close
+
+bool isSysExSendOpen() {
+    return sysexSendOpen;
+}
+
+// Same bytes to every output port
+static void postSysExPiece(const uint8_t* data, uint16_t length) {
+    for (uint8_t port = 0; port < MIDI_OUT_PORT_COUNT; port++) {
+        midiOut.sendSysEx(data, length, port);
+    }
+}
+
+static void rewindSysExSend() {
+    sysexFile.seekSet(0);
+    sysexChunkLength = 0;
+    sysexChunkPos = 0;
+    sysexInMessage = false;
+    sysexBytesSent = 0;
+    sysexMessages = 0;
+}
+
+static void startSysExSend() {
+    rewindSysExSend();
+    midiIn.setThruEnabled(false);
+    midiIn.setKeyboardEnabled(false);
+    midiIn.setRemoteEnabled(false);
+    sysexStartMs = millis();
+    sysexNextMicros = micros();
+    sysexSendState = SYSEX_SEND_RUNNING;
+}
+
+// Completed: the whole file went out. Otherwise aborted or failed, and PLAY sends it again.
+static void endSysExSend(bool completed) {
+    // A message cut off by an abort or by the end of the file is closed, so receivers drop it
+    if (sysexInMessage) {
+        static const uint8_t endOfExclusive = 0xF7;
+        postSysExPiece(&endOfExclusive, 1);
+        sysexInMessage = false;
+    }
+    midiIn.setThruEnabled(midiThruEnabled);
+    midiIn.setKeyboardEnabled(midiKeyboardEnabled);
+    midiIn.setRemoteEnabled(true);
+
+    sysexElapsedMs = millis() - sysexStartMs;
+    sysexSendState = completed ? SYSEX_SEND_DONE : SYSEX_SEND_READY;
+
+    Serial.print("SysEx: ");
+    Serial.print(sysexEntry ? sysexEntry->filename : "");
+    Serial.print(completed ? " sent " : " stopped after ");
+    Serial.print(sysexBytesSent);
+    Serial.print(" bytes, ");
+    Serial.print(sysexMessages);
+    Serial.print(" messages in ");
+    Serial.print(sysexElapsedMs);
+    Serial.print("ms, gap ");
+    Serial.print(sysexGapMs);
+    Serial.println("ms");
+}
+
+static void closeSysExSend() {
+    if (sysexSendState == SYSEX_SEND_RUNNING) {
+        endSysExSend(false);
+    }
+    sysexFile.close();
+    sysexSendOpen = false;
+    sysexEntry = nullptr;
+    if (sysexGapChanged) {
+        saveGlobalSettings();
+    }
+    updateDisplay();
+}
+
+void openSysExSend(FileEntry* entry) {
+    // Playback and previews stay stopped while the screen is up
+    cancelSongLaunch();
+    endAudition();
+    {
+        ScopedMutex lock(&playerMutex);
+        player.stop();
+    }
+    resetVisualizer();
+
+    sysexFile.close();
+    if (!sysexFile.open(entry->fullPath, O_RDONLY)) {
+        display.showError("Failed to open!");
+        delay(1000);
+        updateDisplay();
+        return;
+    }
+    sysexEntry = entry;
+    sysexSendState = SYSEX_SEND_READY;
+    sysexGapChanged = false;
+    sysexSendOpen = true;
+    rewindSysExSend();
+    showSysExSend();
+}
+
+void updateSysExSend() {
+    if (!sysexSendOpen || sysexSendState != SYSEX_SEND_RUNNING) return;
+    if ((int32_t)(micros() - sysexNextMicros) < 0) return;
+
+    // Room for the largest piece on every port, or wait for the writer (Core 1)
+    if (midiOut.getSubmitRoom() < MIDI_OUT_PORT_COUNT * (SYSEX_CHUNK_SIZE + 4)) return;
+
+    if (sysexChunkPos == sysexChunkLength) {
+        int count = sysexFile.read(sysexChunk, SYSEX_CHUNK_SIZE);
+        if (count <= 0) {
+            endSysExSend(count == 0);
+            if (count < 0) {
+                display.showError("SD read error!");
+                delay(1000);
+            }
+            showSysExSend();
+            return;
+        }
+        sysexChunkLength = count;
+        sysexChunkPos = 0;
+    }
+
+    // Bytes between messages are not SysEx - skipped
+    if (!sysexInMessage) {
+        while (sysexChunkPos < sysexChunkLength && sysexChunk[sysexChunkPos] != 0xF0) {
+            sysexChunkPos++;
+        }
+        if (sysexChunkPos == sysexChunkLength) return;
+        sysexInMessage = true;
+    }
+
+    // One piece: up to the end of the message or of the chunk, whichever comes first
+    uint16_t start = sysexChunkPos;
+    bool messageEnded = false;
+    while (sysexChunkPos < sysexChunkLength && !messageEnded) {
+        messageEnded = (sysexChunk[sysexChunkPos++] == 0xF7);
+    }
+    uint16_t length = sysexChunkPos - start;
+    postSysExPiece(sysexChunk + start, length);
+    sysexBytesSent += length;
+
+    // The next piece once this one is on the wire, after the gap if a message ended
+    uint32_t waitMicros = (uint32_t)length * 1000000UL / MIDI_PORT_BYTES_PER_SEC;
+    if (messageEnded) {
+        sysexInMessage = false;
+        sysexMessages++;
+        waitMicros += sysexGapMs * 1000UL;
+    }
+    sysexNextMicros = micros() + waitMicros;
+}
+
+void showSysExSend() {
+    SysExSendInfo info;
+    info.filename = sysexEntry ? sysexEntry->filename : "";
+    info.state = sysexSendState;
+    info.totalBytes = sysexFile.fileSize();
+    info.bytesDone = sysexFile.curPosition() - (sysexChunkLength - sysexChunkPos);
+    info.gapMs = sysexGapMs;
+
+    bool running = (sysexSendState == SYSEX_SEND_RUNNING);
+    unsigned long elapsed = running ? millis() - sysexStartMs : sysexElapsedMs;
+    info.bytesPerSec = elapsed ? (uint32_t)((uint64_t)sysexBytesSent * 1000 / elapsed) : 0;
+    if (running) {
+        info.seconds = info.bytesPerSec ? (info.totalBytes - info.bytesDone) / info.bytesPerSec : 0;
+    } else {
+        info.seconds = elapsed / 1000;
+    }
+    display.showSysExSend(info);
+}
+
+void handleSysExSendMode(Button btn) {
+    switch (btn) {
+        case BTN_LEFT:
+            // The gap applies from the next message, also during a send
+            sysexGapMs = (sysexGapMs > SYSEX_GAP_STEP_MS) ? sysexGapMs - SYSEX_GAP_STEP_MS : 0;
+            sysexGapChanged = true;
+            showSysExSend();
+            break;
+
+        case BTN_RIGHT:
+            sysexGapMs = (sysexGapMs < SYSEX_GAP_MAX_MS - SYSEX_GAP_STEP_MS) ? sysexGapMs + SYSEX_GAP_STEP_MS : SYSEX_GAP_MAX_MS;
+            sysexGapChanged = true;
+            showSysExSend();
+            break;
+
+        case BTN_PLAY:
+            if (sysexSendState != SYSEX_SEND_RUNNING) {
+                startSysExSend();
+                showSysExSend();
+            }
+            break;
+
+        case BTN_STOP:
+        case BTN_MODE:
+        case BTN_PANIC:
+            // Abort a running send; otherwise back to the browser
+            if (sysexSendState == SYSEX_SEND_RUNNING) {
+                endSysExSend(false);
+                showSysExSend();
+            } else {
+                closeSysExSend();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    // Progress at the UI refresh rate
+    static unsigned long lastDraw = 0;
+    if (sysexSendOpen && millis() - lastDraw > UI_REFRESH_MS) {
+        showSysExSend();
+        lastDraw = millis();
+    }
+}
+
+bool loadFileOnly() {
+    unsigned long startTime = millis();
+
+    // CRITICAL: Prevent re-entrant calls during rapid file switching
+    static bool isLoading = false;
+    if (isLoading) {
+        return false;
+    }
+    isLoading = true;
+
+    // Remote PLAY/STOP would run the parser on Core 1 while the scans below use
+    // it without the mutex - held off until the load is done
+    bool remoteWasEnabled = midiIn.isRemoteEnabled();
+    midiIn.setRemoteEnabled(false);
+
+    // Stop playback first. Core 1 only touches the parser and the file inside
+    // update(), under this mutex, so once it is ours no SD read is in progress
+    {
+        ScopedMutex lock(&playerMutex);
+        player.stop(false);  // Stop without reset
+    }
+
+    // A queued quantized launch belonged to the song being replaced, and a
+    // preview is over once a file is loaded for real
+    cancelSongLaunch();
+    endAudition();
+    FatFile& currentFile = songFiles[currentFileIndex];
+
+    // Close everything - no waiting: the player is stopped, and the reset is
+    // paced by wire time (the next play() starts once it has been sent)
+    {
+        ScopedMutex lock(&playerMutex);
+
+        // Reset MIDI device to clean state (inside mutex for thread safety)
+        // This stops all notes and resets controllers
+        player.resetMidiDevice();
+
+        player.unloadFile();
+
+        // Then close our file handle (SdFat's close is finished when it returns)
+        if (currentFile.isOpen()) {
+            currentFile.close();
+        }
+    }
+
+    // Get the current file entry (a .syx file has nothing to play - song changes stop on it)
+    FileEntry* entry = browser.getCurrentFile();
+    if (!entry || entry->isDirectory || browser.isSysExFile(entry->filename)) {
+        midiIn.setRemoteEnabled(remoteWasEnabled);
+        isLoading = false;
+        return false;
+    }
+
+    // Setlist songs held in RAM skip the settings file, the length cache and the track header reads
+    SetlistSong* resident = currentSetlistSong();
+
+    // Reset tempo to default for new file
+    tempoPercent = DEFAULT_TEMPO_PERCENT;
+    useDefaultTempo = false;  // Start with explicit tempo control
+
+    // Try to load saved settings for this file (may override tempoPercent)
+    if (resident) {
+        applySongSettings(resident->settings, resident->scenes);
+    } else {
+        loadTrackSettings(entry->filename);
+    }
+
+    // Open the selected file (no mutex needed - player not accessing yet)
+    if (!browser.openFile(&currentFile)) {
+        display.showError("Failed to open!");
+        delay(2000);
+        midiIn.setRemoteEnabled(remoteWasEnabled);
+        isLoading = false;
+        return false;
+    }
+
+    // Load the file into the player (protected with mutex)
+    {
+        ScopedMutex lock(&playerMutex);
+        bool loaded = resident ? player.loadPreloaded(&currentFile, resident->preload) : player.loadFile(&currentFile);
+        if (!loaded) {
+            display.showError("Invalid MIDI!");
+            currentFile.close();
+            delay(2000);
+            midiIn.setRemoteEnabled(remoteWasEnabled);
+            isLoading = false;
+            return false;
+        }
+    }
+
+    if (!resident) {
+        // CRITICAL: Scan for initial tempo BEFORE cache check
+        // This ensures parser has correct tempo even if file length is cached
+        // NOTE: This is safe without mutex because player is stopped and Core 1 has exited update()
+        player.getParser().scanForInitialTempo();
+
+        // Calculate and cache file length (first time only, uses cache afterward)
+        // This is done OUTSIDE mutex to avoid blocking Core 1, but player must be fully stopped first
+        // WARNING: For large files not in cache, this can take several seconds and will freeze UI!
+        // Check if file is in cache to decide whether to show loading message
+        // Cache entries are keyed on content (size + sampled sectors), not on the name
+        FileIdentity identity;
+        bool haveIdentity = false;
+        FatFile tempFile;
+        if (tempFile.open(entry->fullPath, O_RDONLY)) {
+            haveIdentity = computeFileIdentity(&tempFile, identity);
+            tempFile.close();
+        }
+
+        if (haveIdentity) {
+            // Check if in cache - if not, show loading message
+            if (getCachedFileLength(identity) == 0 || player.getParser().isMultiSequence()) {
+                display.showMessage("Scanning", "MIDI file...");
+                delay(100);  // Brief delay so message is visible
+            }
+            calculateAndCacheFileLength(identity, player.getParser());
+        } else {
+            // Unreadable for hashing - measure it anyway, just don't cache the result
+            player.getParser().calculateFileLengthNow();
+        }
+    }
+
+    // NOW apply tempo and channel settings AFTER file scanning - with mutex protection
+    {
+        ScopedMutex lock(&playerMutex);
+        player.setChannelPrograms(channelPrograms);
+    }
+    applyFileTempo();
+
+    // File is loaded, player is stopped at position 0
+    midiIn.setRemoteEnabled(remoteWasEnabled);
+    isLoading = false;
+
+    return true;
+}
+
+void applyFileTempo() {
+    // Store file's base BPM for all tempo calculations (always do this)
+    // We temporarily set tempo to 100% so we can read the file's actual BPM
+    uint16_t fileBPM;
+    {
+        ScopedMutex lock(&playerMutex);
+        player.setTempoPercent(DEFAULT_TEMPO_PERCENT);  // Set to 100% (1000 in tenth-percent)
+        fileBPM = player.getCurrentBPM();
+    }
+
+    if (fileBPM > 0) {
+        // Store file's base BPM in hundredths for tempo percent calculations
         fileBPM_hundredths = (uint32_t)fileBPM * 100;
     } else {
         // Fallback to 120.00 BPM
         fileBPM_hundredths = DEFAULT_TARGET_BPM;
     }
 
-    // Initialize targetBPM from file's base tempo (if not already set by config)
-    if (!useTargetBPM) {
-        // Use file's base BPM as target
-        targetBPM = fileBPM_hundredths;
-        // Clamp to valid range
-        if (targetBPM < MIN_TARGET_BPM) targetBPM = MIN_TARGET_BPM;
-        if (targetBPM > MAX_TARGET_BPM) targetBPM = MAX_TARGET_BPM;
-        // Keep tempo at file's default (100%)
-        tempoPercent = DEFAULT_TEMPO_PERCENT;
+    // Initialize targetBPM from file's base tempo (if not already set by config)
+    if (!useTargetBPM) {
+        // Use file's base BPM as target
+        targetBPM = fileBPM_hundredths;
+        // Clamp to valid range
+        if (targetBPM < MIN_TARGET_BPM) targetBPM = MIN_TARGET_BPM;
+        if (targetBPM > MAX_TARGET_BPM) targetBPM = MAX_TARGET_BPM;
+        // Keep tempo at file's default (100%)
+        tempoPercent = DEFAULT_TEMPO_PERCENT;
+    } else {
+        // Config loaded a target BPM - apply it now that file is loaded
+        setTargetBPM(targetBPM);
+    }
+}
+
+bool stepSequence(int8_t direction) {
+    // Format 2 files: PREV/NEXT and the end of a sequence move between the
+    // file's sequences first, and only leave the file past the first/last one
+    bool switched = false;
+    {
+        ScopedMutex lock(&playerMutex);
+        MidiFileParser& parser = player.getParser();
+        if (player.isLoaded() && parser.isMultiSequence()) {
+            int16_t target = (int16_t)parser.getActiveSequence() + direction;
+            if (target >= 0 && target < parser.getSequenceCount()) {
+                switched = player.selectSequence((uint8_t)target);
+            }
+        }
+    }
+    if (switched) {
+        resetVisualizer();
+        applyFileTempo();  // Every sequence has its own tempo
+    }
+    return switched;
+}
+
+bool loadAndPlayFile() {
+    // Load the file
+    if (!loadFileOnly()) {
+        return false;
+    }
+
+    // Reset visualizer for new song
+    resetVisualizer();
+
+    // NOTE: MIDI device reset and the override setup (applySongSettings) already done in loadFileOnly()
+
+    // Start playback - Core 1 runs it from its next update()
+    {
+        ScopedMutex lock(&playerMutex);
+        player.requestTransport(TRANSPORT_PLAY);
+    }
+
+    return true;
+}
+
+void applySoloLogic() {
+    // Apply solo logic:
+    // If ANY channel has solo enabled, mute all NON-solo channels
+    // If NO channels have solo enabled, use normal mute state
+
+    bool anySoloActive = (channelSolos != 0);
+
+    if (anySoloActive) {
+        // Solo mode active: mute all channels that are NOT soloed
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            bool isSolo = (channelSolos & (1 << ch)) != 0;
+            if (isSolo) {
+                // Unmute solo channels (unless explicitly muted)
+                // Note: We don't touch explicitly muted channels
+            } else {
+                // Mute non-solo channels
+                player.muteChannel(ch);
+            }
+        }
+    } else {
+        // No solos active: restore normal mute state
+        // The mute state is already managed by player, so nothing to do here
+    }
+}
+
+void stepPartMute(bool forward) {
+    // Same cycle as the channel mute: unmuted (X) -> muted (O) -> solo (S), LEFT goes back
+    uint16_t bit = 1 << selectedPart;
+    ScopedMutex lock(&playerMutex);
+    uint16_t mutes = player.getTrackMutes();
+    uint16_t solos = player.getTrackSolos();
+    uint8_t partState = (solos & bit) ? 2 : (mutes & bit) ? 1 : 0;
+    partState = (partState + (forward ? 1 : 2)) % 3;
+    player.setTrackMutes(partState == 1 ? (mutes | bit) : (mutes & ~bit));
+    player.setTrackSolos(partState == 2 ? (solos | bit) : (solos & ~bit));
+}
+
+void captureScene(ChannelScene& scene) {
+    {
+        ScopedMutex lock(&playerMutex);
+        scene.mutes = player.getChannelMutes();
+    }
+    scene.solos = channelSolos;
+    memcpy(scene.programs, channelPrograms, sizeof(scene.programs));
+    memcpy(scene.volumes, channelVolume, sizeof(scene.volumes));
+    memcpy(scene.pan, channelPan, sizeof(scene.pan));
+    memcpy(scene.transpose, channelTranspose, sizeof(scene.transpose));
+    memcpy(scene.velocities, channelVelocity, sizeof(scene.velocities));
+    memcpy(scene.routing, channelRouting, sizeof(scene.routing));
+    memcpy(scene.layers, channelLayers, sizeof(scene.layers));
+}
+
+void syncSceneToUi() {
+    ChannelScene scene;
+    {
+        ScopedMutex lock(&playerMutex);
+        int8_t active = player.getActiveScene();
+        if (active < 0 || !player.getScene(active, scene)) return;
+        selectedScene = active;
+    }
+    channelSolos = scene.solos;
+    memcpy(channelPrograms, scene.programs, sizeof(scene.programs));
+    memcpy(channelVolume, scene.volumes, sizeof(scene.volumes));
+    memcpy(channelPan, scene.pan, sizeof(scene.pan));
+    memcpy(channelTranspose, scene.transpose, sizeof(scene.transpose));
+    memcpy(channelVelocity, scene.velocities, sizeof(scene.velocities));
+    memcpy(channelRouting, scene.routing, sizeof(scene.routing));
+    memcpy(channelLayers, scene.layers, sizeof(scene.layers));
+}
+
+bool selectScene(uint8_t index) {
+    // The player swaps all tables and sends the differences in one locked step,
+    // so Core 1 never plays an event with half a scene applied
+    bool recalled;
+    {
+        ScopedMutex lock(&playerMutex);
+        recalled = player.recallScene(index);
+    }
+    if (recalled) {
+        syncSceneToUi();
+    }
+    return recalled;
+}
+
+void stepSong(int8_t direction) {
+    if (stepSequence(direction)) {
+        return;  // Play state is kept by the player
+    }
+
+    bool wasPlaying;
+    {
+        ScopedMutex lock(&playerMutex);
+        wasPlaying = (player.getState() == STATE_PLAYING);
+    }
+
+    // Quantized launch: this song plays on and the next starts on the beat/bar
+    if (wasPlaying && launchQuantize != LAUNCH_NOW && queueSongLaunch(direction)) {
+        return;
+    }
+
+    if (direction < 0) {
+        browser.selectPrevious();
     } else {
-        // Config loaded a target BPM - apply it now that file is loaded
-        setTargetBPM(targetBPM);
+        browser.selectNext();
     }
 
-    // File is loaded, player is stopped at position 0
-    isLoading = false;
+    FileEntry* fileEntry = browser.getCurrentFile();
+    if (fileEntry && !fileEntry->isDirectory) {
+        resetVisualizer();
+        // Load and optionally play the song (unloadFile handles stop with proper delay)
+        if (wasPlaying) {
+            // Was playing - load and auto-play
+            if (loadAndPlayFile()) {
+                lastPlayedFile = fileEntry;
+            }
+        } else {
+            // Was stopped - load only, don't play
+            if (loadFileOnly()) {
+                lastPlayedFile = fileEntry;
+            }
+        }
+    }
+}
+
+void handleRemoteRequests() {
+    // Next/previous song from MIDI IN - the only remote commands that need the file browser
+    uint32_t requestMicros = 0;
+    int8_t step = midiIn.takeSongStepRequest(requestMicros);
+    if (step != 0) {
+        stepSong(step);
+        midiIn.recordRemoteLatency(time_us_32() - requestMicros);
+        if (ENABLE_VERBOSE_DEBUG) {
+            Serial.print("Remote song change latency (us): ");
+            Serial.println(midiIn.getLastRemoteLatencyMicros());
+        }
+        updateDisplay();
+    }
+
+    // Scene was recalled on Core 1 - show its settings in the menus
+    if (midiIn.takeSceneChanged()) {
+        syncSceneToUi();
+        if (ENABLE_VERBOSE_DEBUG) {
+            Serial.print("Remote scene latency (us): ");
+            Serial.println(midiIn.getLastRemoteLatencyMicros());
+        }
+        updateDisplay();
+    }
+
+    // Tempo was nudged on Core 1 - bring the BPM shown in the UI back in sync
+    if (midiIn.takeTempoChanged()) {
+        uint16_t percent;
+        {
+            ScopedMutex lock(&playerMutex);
+            percent = player.getTempoPercent();
+        }
+        tempoPercent = percent;
+        if (fileBPM_hundredths > 0) {
+            targetBPM = static_cast<uint32_t>((static_cast<uint64_t>(fileBPM_hundredths) * percent) / 1000);
+            useTargetBPM = true;
+            useDefaultTempo = false;
+        }
+        if (ENABLE_VERBOSE_DEBUG) {
+            Serial.print("Remote tempo latency (us): ");
+            Serial.println(midiIn.getLastRemoteLatencyMicros());
+        }
+    }
+}
+
+void updateShuttle() {
+    // Only the TIME option (active) shuttles
+    int8_t held = 0;
+    if (currentMode == APP_MODE_PLAY && playbackOptionActive && currentPlaybackOption == MENU_TIME) {
+        if (input.isButtonHeld(BTN_LEFT)) {
+            held = -1;
+        } else if (input.isButtonHeld(BTN_RIGHT)) {
+            held = 1;
+        }
+    }
+
+    unsigned long now = millis();
+
+    if (held == 0 || (shuttleDirection != 0 && held != shuttleDirection)) {
+        if (shuttleDirection != 0) {
+            // Released - Core 1 chases the controller state and resumes at the landing point
+            {
+                ScopedMutex lock(&playerMutex);
+                player.requestTransport(TRANSPORT_SHUTTLE_END);
+            }
+            shuttleDirection = 0;
+            updateDisplay();
+        }
+        shuttleHoldStart = 0;
+        return;
+    }
+
+    if (shuttleHoldStart == 0) {
+        shuttleHoldStart = now | 1;  // Never 0 while held
+        return;
+    }
+
+    unsigned long heldMs = now - shuttleHoldStart;
+    if (shuttleDirection == 0) {
+        if (heldMs < SHUTTLE_HOLD_MS) return;  // Still a tap - the press already skipped 1s
+
+        {
+            ScopedMutex lock(&playerMutex);
+            player.requestTransport(TRANSPORT_SHUTTLE_START);
+        }
+        shuttleDirection = held;
+        lastShuttleStep = now;
+        return;
+    }
+
+    unsigned long elapsed = now - lastShuttleStep;
+    if (elapsed < SHUTTLE_STEP_MS) return;
+    lastShuttleStep = now;
+
+    uint32_t speedIndex = (heldMs - SHUTTLE_HOLD_MS) / 1000;
+    if (speedIndex >= SHUTTLE_SPEED_COUNT) speedIndex = SHUTTLE_SPEED_COUNT - 1;
+    int32_t stepMs = (int32_t)(elapsed * SHUTTLE_SPEEDS[speedIndex]) * shuttleDirection;
+
+    // Each step reads forward from the current position, or back from the nearest
+    // parser checkpoint - never from the start of the song
+    {
+        ScopedMutex lock(&playerMutex);
+        player.requestTransport(TRANSPORT_SKIP, stepMs);
+    }
+    updateDisplay();
+}
+
+void checkSdHealth() {
+    static unsigned long lastCheck = 0;
+    static uint32_t loggedErrors = 0;
+    static uint32_t loggedLostTracks = 0;
+
+    if (millis() - lastCheck < SD_HEALTH_CHECK_MS) return;
+    lastCheck = millis();
+
+    uint32_t readErrors, recoveredReads, deferredEvents, lostTracks;
+    bool reinit;
+    {
+        ScopedMutex lock(&playerMutex);
+        readErrors = sdHealth.getReadErrors();
+        recoveredReads = sdHealth.getRecoveredReads();
+        deferredEvents = sdHealth.getDeferredEvents();
+        lostTracks = sdHealth.getLostTracks();
+        reinit = sdHealth.takeReinitRequest();
+    }
+
+    // Counters restart when the diagnostics screen clears the profile
+    if (readErrors < loggedErrors) loggedErrors = 0;
+    if (lostTracks < loggedLostTracks) loggedLostTracks = 0;
+
+    if (readErrors != loggedErrors || lostTracks != loggedLostTracks) {
+        Serial.print("WARNING: SD read errors: ");
+        Serial.print(readErrors);
+        Serial.print(" (recovered by retry: ");
+        Serial.print(recoveredReads);
+        Serial.print(", events deferred: ");
+        Serial.print(deferredEvents);
+        Serial.print(", tracks lost: ");
+        Serial.print(lostTracks);
+        Serial.println(")");
+        loggedErrors = readErrors;
+        loggedLostTracks = lostTracks;
+    }
+
+    // Every retry failed - bring the card up again at a lower clock. The lower
+    // step is only kept once the card answers there. Only the card is restarted
+    // (cardBegin, not begin): the volume is not mounted again, so the FAT cache
+    // and the song files the player and a queued launch hold open stay valid.
+    if (reinit) {
+        int8_t restarted = -1;
+        {
+            ScopedMutex lock(&playerMutex);
+            for (uint8_t step = sdClockStep + 1; step < SD_CLOCK_STEP_COUNT && restarted < 0; step++) {
+                if (sd.cardBegin(SdSpiConfig(SD_CS_PIN, SHARED_SPI, SD_SCK_HZ(SD_CLOCK_STEPS_HZ[step])))) {
+                    restarted = (int8_t)step;
+                }
+            }
+            // Nothing slower works (or the card is already at the slowest) - try where it was
+            if (restarted < 0 && sd.cardBegin(SdSpiConfig(SD_CS_PIN, SHARED_SPI, SD_SCK_HZ(SD_CLOCK_STEPS_HZ[sdClockStep])))) {
+                restarted = (int8_t)sdClockStep;
+            }
+            if (restarted < 0) {
+                player.stop(false);  // Nothing left to read from - don't touch the card
+            }
+        }
+
+        if (restarted >= 0) {
+            bool slower = (restarted != sdClockStep);
+            sdClockStep = (uint8_t)restarted;
+            Serial.print("SD card re-initialized at ");
+            Serial.print(SD_CLOCK_STEPS_HZ[sdClockStep] / 1000000);
+            Serial.println(" MHz");
+
+            // Next boot starts here instead of rediscovering the failure
+            if (slower) {
+                saveSdClock();
+            }
+        } else {
+            Serial.println("ERROR: SD card re-init failed at every clock - playback stopped");
+            // Shown without blocking: Core 0 keeps serving the buttons and the output
+            display.showError("SD card lost!");
+            messageHoldUntil = millis() + MESSAGE_HOLD_MS;
+        }
+    }
+}
+
+// ============================================================================
+// SD clock negotiation
+// ============================================================================
+
+bool benchmarkSd(uint32_t& crc, uint32_t& bytesPerSec) {
+    static uint8_t buffer[SD_BENCH_SECTORS_PER_READ * 512];
+
+    // The FAT is varied, card-specific data; the sectors before the first
+    // partition are mostly zeros and would hide bit errors
+    uint32_t first = sd.vol()->fatStartSector();
 
+    crc = 0;
+    uint32_t start = micros();
+    for (uint8_t sector = 0; sector < SD_BENCH_SECTORS; sector += SD_BENCH_SECTORS_PER_READ) {
+        if (!sd.card()->readSectors(first + sector, buffer, SD_BENCH_SECTORS_PER_READ)) {
+            return false;
+        }
+        crc = crc32Update(crc, buffer, sizeof(buffer));
+    }
+    uint32_t elapsed = micros() - start;
+
+    bytesPerSec = (uint32_t)((uint64_t)SD_BENCH_SECTORS * 512 * 1000000 / (elapsed > 0 ? elapsed : 1));
     return true;
 }
 
-bool loadAndPlayFile() {
-    // Load the file
-    if (!loadFileOnly()) {
+bool negotiateSdClock() {
+    // Reference pass at the slowest clock - faster clocks must read the same bytes
+    uint8_t slowest = SD_CLOCK_STEP_COUNT - 1;
+    if (!sd.begin(SD_CS_PIN, SD_SCK_HZ(SD_CLOCK_STEPS_HZ[slowest]))) {
         return false;
     }
 
-    // Reset visualizer for new song
-    resetVisualizer();
+    // Identify the card - the clock is remembered per card, the name is shown on the diagnostics screen
+    cid_t cid;
+    if (sd.card()->readCID(&cid)) {
+        memcpy(sdCardName, cid.pnm, 5);
+        sdCardName[5] = '\0';
+        snprintf(sdCardId, sizeof(sdCardId), "%02X%08lX", cid.mid, (unsigned long)cid.psn);
+    }
 
-    // NOTE: MIDI device reset already done in loadFileOnly()
+    uint32_t referenceCrc, bytesPerSec;
+    if (!benchmarkSd(referenceCrc, bytesPerSec)) {
+        return false;
+    }
+    sdClockStep = slowest;
+    sdBenchBytesPerSec = bytesPerSec;
+
+    // A known card starts at its remembered clock, which is still verified
+    int8_t remembered = loadSdClock();
+    uint8_t firstStep = (remembered >= 0) ? remembered : 0;
+
+    for (uint8_t step = firstStep; step < slowest; step++) {
+        uint32_t crc;
+        if (sd.begin(SD_CS_PIN, SD_SCK_HZ(SD_CLOCK_STEPS_HZ[step])) &&
+            benchmarkSd(crc, bytesPerSec) && crc == referenceCrc) {
+            sdClockStep = step;
+            sdBenchBytesPerSec = bytesPerSec;
+            break;
+        }
+        if (ENABLE_VERBOSE_DEBUG) {
+            Serial.print("SD clock ");
+            Serial.print(SD_CLOCK_STEPS_HZ[step] / 1000000);
+            Serial.println(" MHz failed, stepping down");
+        }
+    }
 
-    // Send program changes to set instruments on all channels
-    sendProgramChanges();
+    // Nothing faster worked - mount again at the clock that did
+    if (sdClockStep == slowest && firstStep < slowest) {
+        if (!sd.begin(SD_CS_PIN, SD_SCK_HZ(SD_CLOCK_STEPS_HZ[slowest]))) {
+            return false;
+        }
+    }
 
-    // Send channel volumes
-    sendChannelVolumes();
+    Serial.print("SD card ");
+    Serial.print(sdCardName);
+    Serial.print(" at ");
+    Serial.print(SD_CLOCK_STEPS_HZ[sdClockStep] / 1000000);
+    Serial.print(" MHz, ");
+    Serial.print(sdBenchBytesPerSec / 1024);
+    Serial.println(" KB/s");
 
-    // Send channel pan
-    sendChannelPan();
+    if (remembered != (int8_t)sdClockStep) {
+        saveSdClock();
+    }
+    return true;
+}
 
-    // Start playback
-    player.play();
+int8_t loadSdClock() {
+    FatFile clockFileObj;
+    ScopedFile clockFile(&clockFileObj);
+    if (!clockFile.open(SD_CLOCK_FILE_PATH, O_RDONLY)) {
+        return -1;
+    }
 
-    return true;
+    char line[48];
+    if (clockFileObj.fgets(line, sizeof(line)) <= 0) {
+        return -1;
+    }
+
+    // Parse: card_id,clock_hz - a card cloned from another starts over
+    char* id = strtok(line, ",");
+    char* hzStr = strtok(NULL, ",\r\n");
+    if (!id || !hzStr || strcmp(id, sdCardId) != 0) {
+        return -1;
+    }
+
+    uint32_t hz = strtoul(hzStr, NULL, 10);
+    for (uint8_t step = 0; step < SD_CLOCK_STEP_COUNT; step++) {
+        if (SD_CLOCK_STEPS_HZ[step] == hz) {
+            return step;
+        }
+    }
+    return -1;
 }
 
-void applySoloLogic() {
-    // Apply solo logic:
-    // If ANY channel has solo enabled, mute all NON-solo channels
-    // If NO channels have solo enabled, use normal mute state
+void saveSdClock() {
+    if (sdCardId[0] == '\0') return;  // Card without a readable CID - nothing to key on
 
-    bool anySoloActive = (channelSolos != 0);
+    if (!sd.exists(CACHE_DIR_PATH)) {
+        sd.mkdir(CACHE_DIR_PATH);
+    }
 
-    if (anySoloActive) {
-        // Solo mode active: mute all channels that are NOT soloed
-        for (uint8_t ch = 0; ch < 16; ch++) {
-            bool isSolo = (channelSolos & (1 << ch)) != 0;
-            if (isSolo) {
-                // Unmute solo channels (unless explicitly muted)
-                // Note: We don't touch explicitly muted channels
-            } else {
-                // Mute non-solo channels
-                player.muteChannel(ch);
-            }
+    FatFile clockFileObj;
+    ScopedFile clockFile(&clockFileObj);
+    if (!clockFile.open(SD_CLOCK_FILE_PATH, O_WRONLY | O_CREAT | O_TRUNC)) {
+        return;
+    }
+
+    char line[48];
+    snprintf(line, sizeof(line), "%s,%lu\n", sdCardId, (unsigned long)SD_CLOCK_STEPS_HZ[sdClockStep]);
+    clockFileObj.write(line);
+}
+
+bool loadRemoteMappings() {
+    // Load remote-control mapping table from /remote.cfg
+    // Format (one mapping per line, channel 0 = any):
+    //   NOTE=<channel>,<note>,<action>[,<param>]
+    //   CC=<channel>,<controller>,<action>[,<param>]
+    //   PC=<channel>,<program>,<action>[,<param>]
+    // Actions: PLAY_PAUSE, STOP, NEXT, PREV, MUTE (param = channel 1-16), TEMPO (param = tenth-percent step),
+    //          SCENE (param = scene 1-8)
+    const char* remoteFilename = "/remote.cfg";
+
+    FatFile remoteFileObj;
+    ScopedFile remoteFile(&remoteFileObj);
+    if (!remoteFile.open(remoteFilename, O_RDONLY)) {
+        return false; // No mapping file - remote control disabled
+    }
+
+    midiIn.clearRemoteMappings();
+
+    char line[64];
+    while (remoteFileObj.available()) {
+        int len = remoteFileObj.fgets(line, sizeof(line));
+        if (len <= 0) break;
+
+        // Remove newline
+        if (line[len-1] == '\n') line[len-1] = '\0';
+        if (len > 1 && line[len-2] == '\r') line[len-2] = '\0';
+
+        uint8_t trigger;
+        char* values;
+        if (strncmp(line, "NOTE=", 5) == 0) {
+            trigger = REMOTE_TRIGGER_NOTE;
+            values = line + 5;
+        } else if (strncmp(line, "CC=", 3) == 0) {
+            trigger = REMOTE_TRIGGER_CC;
+            values = line + 3;
+        } else if (strncmp(line, "PC=", 3) == 0) {
+            trigger = REMOTE_TRIGGER_PROGRAM;
+            values = line + 3;
+        } else {
+            continue; // Header, comment or unknown key
         }
-    } else {
-        // No solos active: restore normal mute state
-        // The mute state is already managed by player, so nothing to do here
+
+        char* channelToken = strtok(values, ",");
+        char* numberToken = strtok(nullptr, ",");
+        char* actionToken = strtok(nullptr, ",");
+        char* paramToken = strtok(nullptr, ",");
+        if (!channelToken || !numberToken || !actionToken) continue;
+
+        uint8_t action = REMOTE_ACTION_NONE;
+        if (strcmp(actionToken, "PLAY_PAUSE") == 0) action = REMOTE_ACTION_PLAY_PAUSE;
+        else if (strcmp(actionToken, "STOP") == 0) action = REMOTE_ACTION_STOP;
+        else if (strcmp(actionToken, "NEXT") == 0) action = REMOTE_ACTION_NEXT;
+        else if (strcmp(actionToken, "PREV") == 0) action = REMOTE_ACTION_PREV;
+        else if (strcmp(actionToken, "MUTE") == 0) action = REMOTE_ACTION_MUTE;
+        else if (strcmp(actionToken, "TEMPO") == 0) action = REMOTE_ACTION_TEMPO;
+        else if (strcmp(actionToken, "SCENE") == 0) action = REMOTE_ACTION_SCENE;
+
+        int16_t param = paramToken ? static_cast<int16_t>(atoi(paramToken)) : 0;
+        midiIn.addRemoteMapping(trigger, atoi(channelToken), atoi(numberToken), action, param);
+    }
+
+    if (ENABLE_VERBOSE_DEBUG) {
+        Serial.print("Remote mappings loaded: ");
+        Serial.println(midiIn.getRemoteMappingCount());
     }
+
+    // File automatically closed by ScopedFile destructor
+    return true;
 }
 
 void handleTapTempo() {
-    // Record tap timestamp
-    uint32_t now = millis();
+    // Use the hardware timestamp captured by the button interrupt, not the time
+    // the loop got around to handling the press (can be many ms late)
+    uint64_t now = input.getLastPressMicros();
+    if (now == 0) now = time_us_64();
 
-    // Timeout check: if more than 2000ms since last tap, reset buffer
-    if (tapCount > 0 && (now - lastTapTime) > 2000) {
+    // Held-button repeats carry the original press timestamp - not a new tap
+    if (tapCount > 0 && now == lastTapTime) {
+        return;
+    }
+
+    // Timeout check: if more than 2 seconds since last tap, reset buffer
+    if (tapCount > 0 && (now - lastTapTime) > TAP_TIMEOUT_MICROS) {
         tapCount = 0;
     }
 
     // Store timestamp in circular buffer
-    tapTimes[tapCount % 4] = now;
-    tapCount++;
+    tapTimes[tapCount % TAP_WINDOW_SIZE] = now;
+    if (tapCount < 255) tapCount++;
     lastTapTime = now;
 
     // Need at least 2 taps to calculate BPM
@@ -3123,21 +5231,19 @@ void handleTapTempo() {
         return;
     }
 
-    // Calculate BPM from intervals
-    uint8_t tapsToUse = (tapCount < 4) ? tapCount : 4;
-    uint32_t totalInterval = 0;
+    // Collect valid intervals between consecutive taps in the window
+    uint8_t tapsToUse = (tapCount < TAP_WINDOW_SIZE) ? tapCount : TAP_WINDOW_SIZE;
+    uint32_t intervals[TAP_WINDOW_SIZE - 1];
     uint8_t intervalCount = 0;
 
-    // Calculate intervals between consecutive taps
     for (uint8_t i = 1; i < tapsToUse; i++) {
-        uint8_t prevIdx = (tapCount - tapsToUse + i - 1) % 4;
-        uint8_t currIdx = (tapCount - tapsToUse + i) % 4;
-        uint32_t interval = tapTimes[currIdx] - tapTimes[prevIdx];
+        uint8_t prevIdx = (tapCount - tapsToUse + i - 1) % TAP_WINDOW_SIZE;
+        uint8_t currIdx = (tapCount - tapsToUse + i) % TAP_WINDOW_SIZE;
+        uint64_t interval = tapTimes[currIdx] - tapTimes[prevIdx];
 
-        // Validate interval (40 BPM = 1500ms, 300 BPM = 200ms)
-        if (interval >= 200 && interval <= 1500) {
-            totalInterval += interval;
-            intervalCount++;
+        // Validate interval (40 BPM = 1.5s, 300 BPM = 200ms)
+        if (interval >= TAP_MIN_INTERVAL_MICROS && interval <= TAP_MAX_INTERVAL_MICROS) {
+            intervals[intervalCount++] = static_cast<uint32_t>(interval);
         }
     }
 
@@ -3145,11 +5251,40 @@ void handleTapTempo() {
         return; // No valid intervals
     }
 
-    // Average interval in milliseconds
-    uint32_t avgInterval = totalInterval / intervalCount;
+    // Robust estimate: median of the window, then average only the intervals close to it
+    // A single late or double tap no longer drags the tempo
+    uint32_t sorted[TAP_WINDOW_SIZE - 1];
+    for (uint8_t i = 0; i < intervalCount; i++) {
+        uint32_t value = intervals[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    uint32_t median = (intervalCount % 2) ? sorted[intervalCount / 2]
+                                          : (sorted[intervalCount / 2 - 1] + sorted[intervalCount / 2]) / 2;
+    uint32_t tolerance = (median / 100) * TAP_OUTLIER_PERCENT;
+
+    uint64_t totalInterval = 0;
+    uint8_t keptCount = 0;
+    for (uint8_t i = 0; i < intervalCount; i++) {
+        uint32_t deviation = (intervals[i] > median) ? intervals[i] - median : median - intervals[i];
+        if (deviation <= tolerance) {
+            totalInterval += intervals[i];
+            keptCount++;
+        }
+    }
+    if (keptCount == 0) {
+        return;
+    }
+
+    // Average interval in microseconds
+    uint32_t avgInterval = static_cast<uint32_t>(totalInterval / keptCount);
 
-    // Convert to BPM: BPM = 60000 / interval_ms (in hundredths for precision)
-    uint32_t bpm_hundredths = (60000UL * 100) / avgInterval;
+    // Convert to BPM: BPM = 60,000,000 / interval_us (in hundredths for precision)
+    uint32_t bpm_hundredths = static_cast<uint32_t>((60000000ULL * 100) / avgInterval);
 
     // Clamp to reasonable range (40.00 - 300.00 BPM)
     if (bpm_hundredths < MIN_TARGET_BPM) bpm_hundredths = MIN_TARGET_BPM;
@@ -3158,7 +5293,16 @@ void handleTapTempo() {
     calculatedBPM = bpm_hundredths / 100;  // Store whole BPM for reference
 
     // Set target BPM (this handles all the tempo percent calculation internally)
+    // The player keeps its fractional tick position across the rate change
     setTargetBPM(bpm_hundredths);
+
+    // Optionally pull the song phase onto the tap grid (needs a confident estimate: 2+ agreeing intervals)
+    if (tapPhaseAlign && keptCount >= 2) {
+        ScopedMutex lock(&playerMutex);
+        if (player.getState() == STATE_PLAYING) {
+            player.alignBeatPhase(now);
+        }
+    }
 }
 
 // Set target BPM (user-facing, in hundredths) and calculate tempo percent in background
@@ -3200,16 +5344,7 @@ void setTargetBPM(uint32_t bpmHundredths) {
 // Max 500 entries with FIFO eviction when full
 // ============================================================================
 
-#define MAX_CACHE_ENTRIES 500
-#define CACHE_FILE_PATH "/.cache/cache"
-#define CACHE_VERSION 3  // Increment this when cache format changes or calculation logic improves
-
-struct FileLengthCacheEntry {
-    char filename[64];
-    uint32_t modtime;        // File modification time (unix timestamp)
-    uint32_t lengthTicks;
-    uint16_t sysexCount;     // Number of SysEx messages (for MT-32 detection)
-};
+// Format definitions live in LengthCache.h (shared with tools/cache_prebuilder)
 
 static FileLengthCacheEntry lengthCache[MAX_CACHE_ENTRIES];
 static uint16_t cacheSize = 0;
@@ -3250,16 +5385,15 @@ void loadLengthCache() {
         len = cacheFile.fgets(line, sizeof(line));
         if (len <= 0) break;
 
-        // Parse: filename,modtime,length_ticks,sysex_count
-        char* filename = strtok(line, ",");
-        char* modtimeStr = strtok(NULL, ",");
+        // Parse: size,hash,length_ticks,sysex_count
+        char* sizeStr = strtok(line, ",");
+        char* hashStr = strtok(NULL, ",");
         char* lengthStr = strtok(NULL, ",");
         char* sysexStr = strtok(NULL, ",\r\n");
 
-        if (filename && modtimeStr && lengthStr && sysexStr) {
-            strncpy(lengthCache[cacheSize].filename, filename, 63);
-            lengthCache[cacheSize].filename[63] = '\0';
-            lengthCache[cacheSize].modtime = strtoul(modtimeStr, NULL, 10);
+        if (sizeStr && hashStr && lengthStr && sysexStr) {
+            lengthCache[cacheSize].identity.size = strtoul(sizeStr, NULL, 10);
+            lengthCache[cacheSize].identity.hash = strtoul(hashStr, NULL, 16);
             lengthCache[cacheSize].lengthTicks = strtoul(lengthStr, NULL, 10);
             lengthCache[cacheSize].sysexCount = (uint16_t)strtoul(sysexStr, NULL, 10);
             cacheSize++;
@@ -3271,8 +5405,8 @@ void loadLengthCache() {
 
 void saveLengthCache() {
     // Ensure cache directory exists
-    if (!sd.exists("/.cache")) {
-        sd.mkdir("/.cache");
+    if (!sd.exists(CACHE_DIR_PATH)) {
+        sd.mkdir(CACHE_DIR_PATH);
     }
 
     FatFile cacheFile;
@@ -3288,9 +5422,9 @@ void saveLengthCache() {
     // Write cache entries
     for (uint16_t i = 0; i < cacheSize; i++) {
         char line[256];
-        sprintf(line, "%s,%lu,%lu,%u\n",
-                lengthCache[i].filename,
-                lengthCache[i].modtime,
+        sprintf(line, "%lu,%08lX,%lu,%u\n",
+                (unsigned long)lengthCache[i].identity.size,
+                (unsigned long)lengthCache[i].identity.hash,
                 lengthCache[i].lengthTicks,
                 lengthCache[i].sysexCount);
         cacheFile.write(line);
@@ -3299,38 +5433,32 @@ void saveLengthCache() {
     cacheFile.close();
 }
 
-uint32_t getCachedFileLength(const char* filename, uint32_t modtime, uint16_t* outSysexCount) {
+uint32_t getCachedFileLength(const FileIdentity& identity, uint16_t* outSysexCount) {
     if (!cacheLoaded) {
         loadLengthCache();
     }
 
-    // Search for matching entry
+    // Search for matching entry - a modified file has a new identity, so no staleness check
     for (uint16_t i = 0; i < cacheSize; i++) {
-        if (strcmp(lengthCache[i].filename, filename) == 0) {
-            // Found entry - check if file was modified
-            if (lengthCache[i].modtime == modtime) {
-                if (outSysexCount) {
-                    *outSysexCount = lengthCache[i].sysexCount;
-                }
-                return lengthCache[i].lengthTicks;
-            } else {
-                return 0;  // File modified, cache stale
+        if (lengthCache[i].identity == identity) {
+            if (outSysexCount) {
+                *outSysexCount = lengthCache[i].sysexCount;
             }
+            return lengthCache[i].lengthTicks;
         }
     }
 
     return 0;  // Not in cache
 }
 
-void cacheFileLength(const char* filename, uint32_t modtime, uint32_t lengthTicks, uint16_t sysexCount) {
+void cacheFileLength(const FileIdentity& identity, uint32_t lengthTicks, uint16_t sysexCount) {
     if (!cacheLoaded) {
         loadLengthCache();
     }
 
     // Check if entry exists - update it
     for (uint16_t i = 0; i < cacheSize; i++) {
-        if (strcmp(lengthCache[i].filename, filename) == 0) {
-            lengthCache[i].modtime = modtime;
+        if (lengthCache[i].identity == identity) {
             lengthCache[i].lengthTicks = lengthTicks;
             lengthCache[i].sysexCount = sysexCount;
             saveLengthCache();
@@ -3340,9 +5468,7 @@ void cacheFileLength(const char* filename, uint32_t modtime, uint32_t lengthTick
 
     // Add new entry
     if (cacheSize < MAX_CACHE_ENTRIES) {
-        strncpy(lengthCache[cacheSize].filename, filename, 63);
-        lengthCache[cacheSize].filename[63] = '\0';
-        lengthCache[cacheSize].modtime = modtime;
+        lengthCache[cacheSize].identity = identity;
         lengthCache[cacheSize].lengthTicks = lengthTicks;
         lengthCache[cacheSize].sysexCount = sysexCount;
         cacheSize++;
@@ -3353,39 +5479,19 @@ void cacheFileLength(const char* filename, uint32_t modtime, uint32_t lengthTick
             lengthCache[i] = lengthCache[i + 1];
         }
         // Add new entry at end
-        strncpy(lengthCache[MAX_CACHE_ENTRIES - 1].filename, filename, 63);
-        lengthCache[MAX_CACHE_ENTRIES - 1].filename[63] = '\0';
-        lengthCache[MAX_CACHE_ENTRIES - 1].modtime = modtime;
+        lengthCache[MAX_CACHE_ENTRIES - 1].identity = identity;
         lengthCache[MAX_CACHE_ENTRIES - 1].lengthTicks = lengthTicks;
         lengthCache[MAX_CACHE_ENTRIES - 1].sysexCount = sysexCount;
         saveLengthCache();
     }
 }
 
-void calculateAndCacheFileLength(const char* fullPath, MidiFileParser& fileParser) {
-    // Extract just the filename from the full path for cache storage
-    const char* filename = strrchr(fullPath, '/');
-    if (filename) {
-        filename++;  // Skip the '/'
-    } else {
-        filename = fullPath;  // No '/' found, use full string
-    }
-
-    // Get file modification time using full path
-    FatFile file;
-    if (!file.open(fullPath, O_RDONLY)) {
-        return;
-    }
-
-    uint16_t date, time;
-    file.getModifyDateTime(&date, &time);
-    uint32_t modtime = ((uint32_t)date << 16) | time;  // Combine date/time into single value
-    file.close();
-
-    // Check cache first using just the filename
+void calculateAndCacheFileLength(const FileIdentity& identity, MidiFileParser& fileParser) {
+    // Check cache first
     uint16_t cachedSysexCount = 0;
-    uint32_t cachedLength = getCachedFileLength(filename, modtime, &cachedSysexCount);
-    if (cachedLength > 0) {
+    uint32_t cachedLength = getCachedFileLength(identity, &cachedSysexCount);
+    // Format 2 needs the per-sequence lengths and tempos only the scan produces
+    if (cachedLength > 0 && !fileParser.isMultiSequence()) {
         fileParser.setFileLengthTicks(cachedLength);
         fileParser.setSysexCount(cachedSysexCount);
         return;
@@ -3399,9 +5505,234 @@ void calculateAndCacheFileLength(const char* fullPath, MidiFileParser& fileParse
 
     // Cache the result
     if (lengthTicks > 0) {
-        cacheFileLength(filename, modtime, lengthTicks, sysexCount);
+        cacheFileLength(identity, lengthTicks, sysexCount);
+    }
+}
+
+// ============================================================================
+// OFFLINE RENDER
+// EXP in Track Settings writes the loaded song with the live settings baked
+// in, as <name>_R.mid next to it. A second player on an SmfWriter sink runs
+// the song through the same sendMidiEvent() path as playback - channel and
+// part mutes/solos, transpose, velocity, overrides, routing and layers -
+// without waiting for event times, so it goes as fast as the card reads and
+// writes. The tempo percent (target BPM) is folded into the tempo map.
+// ============================================================================
+
+static uint32_t renderTempo(uint32_t microsPerQuarter, uint16_t percent) {
+    return (uint32_t)(((uint64_t)microsPerQuarter * DEFAULT_TEMPO_PERCENT) / percent);
+}
+
+bool renderSong(FileEntry* entry) {
+    if (!entry || entry->isDirectory) return false;
+
+    // <song>_R.mid beside the song, replacing an earlier render
+    char outPath[MAX_PATH_LENGTH];
+    const char* dot = strrchr(entry->fullPath, '.');
+    size_t baseLength = dot ? (size_t)(dot - entry->fullPath) : strlen(entry->fullPath);
+    if (baseLength + 7 > sizeof(outPath)) {
+        display.showError("Name too long!");
+        delay(1000);
+        return false;
+    }
+    memcpy(outPath, entry->fullPath, baseLength);
+    strcpy(outPath + baseLength, "_R.mid");
+
+    // The live settings, as the player applies them now. Playback stops:
+    // the render has the card to itself.
+    uint16_t percent, trackMutes, trackSolos, channelMuteMask = 0;
+    uint32_t lengthTicks;
+    {
+        ScopedMutex lock(&playerMutex);
+        player.stop();
+        percent = player.getTempoPercent();
+        trackMutes = player.getTrackMutes();
+        trackSolos = player.getTrackSolos();
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            if (player.isChannelMuted(ch)) channelMuteMask |= 1 << ch;
+        }
+        lengthTicks = player.getParser().getFileLengthTicks();
+    }
+    if (percent == 0) percent = DEFAULT_TEMPO_PERCENT;
+    resetVisualizer();
+
+    SmfWriter* writer = new (std::nothrow) SmfWriter();
+    MidiPlayerT<SmfWriter>* renderer = writer ? new (std::nothrow) MidiPlayerT<SmfWriter>(writer) : nullptr;
+    FatFile in, out;
+    bool ok = renderer && in.open(entry->fullPath, O_RDONLY) && out.open(outPath, O_WRONLY | O_CREAT | O_TRUNC);
+    if (!ok) {
+        delete renderer;
+        delete writer;
+        in.close();
+        display.showError(renderer ? "Can't write file" : "Out of memory");
+        delay(1000);
+        return false;
+    }
+
+    renderer->setChannelPrograms(channelPrograms);
+    renderer->setChannelVolumes(channelVolume);
+    renderer->setChannelPan(channelPan);
+    renderer->setChannelTranspose(channelTranspose);
+    renderer->setChannelVelocityScales(channelVelocity);
+    renderer->setChannelRouting(channelRouting);
+    renderer->setChannelLayers(channelLayers);
+    renderer->setVelocityScale(velocityScale);
+    renderer->setSysexEnabled(sysexEnabled);
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        if (channelMuteMask & (1 << ch)) renderer->muteChannel(ch);
+    }
+
+    Serial.print("Render: ");
+    Serial.print(entry->filename);
+    Serial.print(" -> ");
+    Serial.println(outPath);
+    display.showMessage("Rendering", "0%");
+
+    // One pass per output port in use; the first finds out which ports those are
+    uint64_t startMicros = time_us_64();
+    uint64_t songMicros = 0;
+    uint32_t events = 0;
+    unsigned long lastProgressMs = millis();
+    for (uint8_t port = 0; ok && port < MIDI_OUT_PORT_COUNT; port++) {
+        if (port > 0 && !(writer->getPortsUsed() & (1 << port))) continue;
+
+        // Part mutes go in before the load - the parser applies them while priming the tracks
+        renderer->setTrackSolos(trackSolos);
+        renderer->setTrackMutes(trackMutes);
+        if (!renderer->loadFile(&in)) {
+            ok = false;
+            break;
+        }
+        // loadFile() read the first event ahead for playback - start the render before it
+        MidiFileParser& parser = renderer->getParser();
+        if (!parser.reset()) {
+            ok = false;
+            renderer->unloadFile();
+            break;
+        }
+        uint16_t ticksPerQuarter = parser.getFileInfo().ticksPerQuarter;
+        if (port == 0) writer->begin(&out, ticksPerQuarter);
+        writer->beginTrack(port);
+
+        // The first track holds the tempo map, from the SMF default of 120 BPM
+        bool conductor = (port == 0);
+        uint32_t tempo = 500000;
+        uint32_t lastTick = 0;
+        if (conductor) writer->writeTempo(renderTempo(tempo, percent));
+        renderer->sendOverrideSetup();
+
+        MidiEvent event;
+        while (parser.readNextEvent(event)) {
+            writer->setTick(event.absoluteTime);
+            if (conductor) {
+                if (ticksPerQuarter > 0 && event.absoluteTime > lastTick) {
+                    songMicros += (uint64_t)(event.absoluteTime - lastTick) * renderTempo(tempo, percent) / ticksPerQuarter;
+                    lastTick = event.absoluteTime;
+                }
+                if (event.isMetaEvent && event.data1 == META_TEMPO) {
+                    tempo = parser.getFileInfo().tempo;
+                    writer->writeTempo(renderTempo(tempo, percent));
+                } else if (event.isMetaEvent && event.data1 == META_TIME_SIGNATURE) {
+                    MidiFileInfo info = parser.getFileInfo();
+                    writer->writeTimeSignature(info.numerator, info.denominator);
+                }
+                events++;
+            }
+            renderer->dispatch(event);
+
+            if (millis() - lastProgressMs >= 500 && lengthTicks > 0) {
+                lastProgressMs = millis();
+                char progress[17];
+                uint32_t done = (uint32_t)((uint64_t)event.absoluteTime * 100 / lengthTicks);
+                snprintf(progress, sizeof(progress), "Port %u  %lu%%", port + 1, (unsigned long)(done > 100 ? 100 : done));
+                display.showMessage("Rendering", progress);
+            }
+        }
+
+        // A song that ends with notes still on ends them, as stopping playback would
+        renderer->releaseHeldNotes();
+        ok = writer->endTrack();
+        renderer->unloadFile();
     }
+    ok = ok && writer->finish();
+    uint64_t renderMicros = time_us_64() - startMicros;
+    uint32_t bytes = writer->getBytesWritten();
+    uint16_t tracks = writer->getTrackCount();
+
+    out.close();
+    in.close();
+    delete renderer;
+    delete writer;
+
+    if (!ok) {
+        sd.remove(outPath);  // No half-written file left behind
+        Serial.println("Render failed");
+        display.showError("Render failed!");
+        delay(1000);
+        return false;
+    }
+
+    // Speed as a multiple of realtime (tenths)
+    uint32_t speedTenths = renderMicros ? (uint32_t)(songMicros * 10 / renderMicros) : 0;
+    Serial.print("Render: ");
+    Serial.print(events);
+    Serial.print(" events, ");
+    Serial.print(tracks);
+    Serial.print(tracks == 1 ? " track, " : " tracks, ");
+    Serial.print(bytes);
+    Serial.print(" bytes in ");
+    Serial.print((uint32_t)(renderMicros / 1000));
+    Serial.print("ms (");
+    Serial.print(speedTenths / 10);
+    Serial.print(".");
+    Serial.print(speedTenths % 10);
+    Serial.println("x realtime)");
+
+    char speedText[17];
+    snprintf(speedText, sizeof(speedText), "%lu.%lux realtime", (unsigned long)(speedTenths / 10), (unsigned long)(speedTenths % 10));
+    display.showMessage("Rendered", speedText);
+    delay(1500);
+    return true;
+}
+
+#if MIDI_DISPATCH_BENCHMARK
+// Runs a whole song through the player's event path (mutes, overrides, routing,
+// fan-out) into a sink that only counts, and reports the cost per event.
+// Timestamps are ignored, so this is pure CPU time without the wire.
+void runDispatchBenchmark(const char* path) {
+    FatFile file;
+    if (!file.open(path, O_RDONLY)) return;
+
+    CountingMidiSink sink;
+    MidiPlayerT<CountingMidiSink>* bench = new MidiPlayerT<CountingMidiSink>(&sink);
+    if (bench->loadFile(&file)) {
+        MidiFileParser& parser = bench->getParser();
+        parser.reset();  // Include the event loadFile() read ahead
+        MidiEvent event;
+        uint32_t events = 0;
+        uint64_t dispatchMicros = 0;
+
+        // Parsing is timed separately so only the dispatch is counted
+        while (parser.readNextEvent(event)) {
+            uint64_t start = time_us_64();
+            bench->dispatch(event);
+            dispatchMicros += time_us_64() - start;
+            events++;
+        }
+
+        Serial.print("Dispatch benchmark: ");
+        Serial.print(events);
+        Serial.print(" events, ");
+        Serial.print(sink.messages);
+        Serial.print(" messages, ");
+        Serial.print(events ? (uint32_t)(dispatchMicros * 1000 / events) : 0);
+        Serial.println(" ns/event");
+    }
+    bench->unloadFile();
+    delete bench;
+    file.close();
 }
+#endif
 
 // ============================================================================
 // CORE 1 - Dedicated to MIDI processing for accurate timing
@@ -3417,15 +5748,24 @@ void loop1() {
     // This runs in parallel with Core 0 (UI, display, file I/O)
 
     // Update MIDI player - must be called frequently for accurate timing
-    // Protected with mutex to prevent race conditions with Core 0
-    {
-        ScopedMutex lock(&playerMutex);
-        player.update();
-    } // Mutex automatically released here
+    // Protected with mutex to prevent race conditions with Core 0. While Core 0
+    // holds it, keep writing what Core 0 submits so its bursts (device reset,
+    // scene recall across layers) never back up into dropped messages.
+    uint32_t owner;
+    if (!mutex_try_enter(&playerMutex, &owner)) {
+        midiOut.service();
+        return;
+    }
+    player.update();
+    mutex_exit(&playerMutex);
 
     // Update MIDI input - process incoming MIDI messages
     midiIn.update();
 
+    // Write messages submitted by Core 0, then feed the extra PIO MIDI OUT ports
+    // (Core 1 is the only writer to the MIDI ports)
+    midiOut.service();
+
     // No delay needed - MIDI timing is critical and these operations are very fast
-    // The player.update() internally handles timing with micros()
+    // The player.update() internally handles timing with the 64-bit hardware timer (time_us_64)
 }
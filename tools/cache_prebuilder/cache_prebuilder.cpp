@@ -0,0 +1,270 @@
+// ============================================================================
+// MIDI-PI cache prebuilder
+//
+// Host-side tool that scans a mounted SD card (or a copy of one) and writes
+// the same /.cache/cache file the firmware would build one song at a time on
+// the device. It compiles the firmware's own MidiFileParser against small
+// POSIX shims (host/Arduino.h, host/SdFat.h), so the lengths and SysEx counts
+// it records are exactly what the player would compute. Entries are keyed
+// on FileIdentity (size + sampled-sector hash), the same as on the device.
+//
+// Usage: cache_prebuilder [-j threads] [-n] <sd-root>
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <dirent.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MidiFileParser.h"
+#include "FileBrowser.h"
+#include "LengthCache.h"
+
+struct ScanJob {
+    std::string hostPath;   // Path on the host filesystem
+    std::string cardPath;   // Path as the firmware sees it (/MIDI/...)
+    FileIdentity identity;  // Cache key: content identity
+    uint32_t lengthTicks;
+    uint16_t sysexCount;
+    bool ok;
+};
+
+// Same test as FileBrowser::isMidiFile()
+static bool isMidiFile(const char* filename) {
+    size_t len = strlen(filename);
+    if (len >= 4 && strcasecmp(filename + len - 4, ".mid") == 0) return true;
+    if (len >= 4 && strcasecmp(filename + len - 4, ".rmi") == 0) return true;
+    if (len >= 4 && strcasecmp(filename + len - 4, ".mlz") == 0) return true;
+    if (len >= 5 && strcasecmp(filename + len - 5, ".midi") == 0) return true;
+    return false;
+}
+
+struct DirEntry {
+    std::string name;
+    bool isDirectory;
+};
+
+// Walk a directory with the browser's filtering and ordering rules so the
+// cache is filled in the order a user would reach the files on the device
+static void collectFiles(const std::string& hostDir, const std::string& cardDir,
+                         std::vector<ScanJob>& jobs) {
+    DIR* dir = opendir(hostDir.c_str());
+    if (!dir) {
+        fprintf(stderr, "warning: cannot open %s\n", hostDir.c_str());
+        return;
+    }
+
+    std::vector<DirEntry> entries;
+    struct dirent* de;
+    while ((de = readdir(dir)) != nullptr) {
+        // Skip hidden files and current directory marker
+        if (de->d_name[0] == '.') continue;
+
+        std::string hostPath = hostDir + "/" + de->d_name;
+        struct stat st;
+        if (stat(hostPath.c_str(), &st) != 0) continue;
+        bool isDirectory = S_ISDIR(st.st_mode);
+
+        // Skip config directory
+        if (isDirectory && strcasecmp(de->d_name, "config") == 0) continue;
+
+        if (isDirectory || (S_ISREG(st.st_mode) && isMidiFile(de->d_name))) {
+            entries.push_back({de->d_name, isDirectory});
+        }
+    }
+    closedir(dir);
+
+    if (entries.size() > MAX_FILES) {
+        fprintf(stderr, "warning: %s has %zu entries, the browser only lists %d\n",
+                cardDir.c_str(), entries.size(), MAX_FILES);
+    }
+
+    // Directories first, then case-insensitive alphabetical (FileBrowser::sortFiles)
+    std::stable_sort(entries.begin(), entries.end(), [](const DirEntry& a, const DirEntry& b) {
+        if (a.isDirectory != b.isDirectory) return a.isDirectory;
+        return strcasecmp(a.name.c_str(), b.name.c_str()) < 0;
+    });
+
+    for (const DirEntry& entry : entries) {
+        std::string hostPath = hostDir + "/" + entry.name;
+        std::string cardPath = cardDir + "/" + entry.name;
+
+        if (entry.isDirectory) {
+            collectFiles(hostPath, cardPath, jobs);
+            continue;
+        }
+
+        // Names that do not fit the browser/cache buffers can never produce a cache hit
+        if (entry.name.size() >= MAX_FILENAME_LENGTH || cardPath.size() >= MAX_PATH_LENGTH) {
+            fprintf(stderr, "warning: skipping %s (name too long for the browser)\n", cardPath.c_str());
+            continue;
+        }
+
+        ScanJob job;
+        job.hostPath = hostPath;
+        job.cardPath = cardPath;
+        job.identity = FileIdentity();
+        job.lengthTicks = 0;
+        job.sysexCount = 0;
+        job.ok = false;
+        jobs.push_back(job);
+    }
+}
+
+// Mirrors calculateAndCacheFileLength() in main.cpp
+static void scanFile(ScanJob& job, MidiFileParser& parser) {
+    FatFile file;
+    if (!file.open(job.hostPath.c_str(), O_RDONLY)) {
+        return;
+    }
+
+    if (!computeFileIdentity(&file, job.identity) || !file.seekSet(0)) {
+        file.close();
+        return;
+    }
+
+    if (parser.open(job.cardPath.c_str(), &file)) {
+        parser.calculateFileLengthNow();
+        job.lengthTicks = parser.getFileLengthTicks();
+        job.sysexCount = parser.getSysexCount();
+        job.ok = job.lengthTicks > 0;  // Firmware never caches a zero length
+    }
+
+    parser.close();
+    file.close();
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [-j threads] [-n] <sd-root>\n"
+            "  -j N    worker threads (default: all CPU cores)\n"
+            "  -n      dry run, scan and report without writing the cache\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    unsigned threadCount = std::thread::hardware_concurrency();
+    bool dryRun = false;
+    const char* root = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threadCount = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            dryRun = true;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            root = argv[i];
+        }
+    }
+    if (!root) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (threadCount == 0) threadCount = 1;
+
+    std::string rootPath = root;
+    while (rootPath.size() > 1 && rootPath.back() == '/') rootPath.pop_back();
+
+    std::vector<ScanJob> jobs;
+    collectFiles(rootPath + "/MIDI", "/MIDI", jobs);
+    if (jobs.empty()) {
+        fprintf(stderr, "No MIDI files found under %s/MIDI\n", rootPath.c_str());
+        return 1;
+    }
+
+    // Parse in parallel - each worker owns a parser (about 9 KB of track buffers)
+    auto startTime = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextJob(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; t++) {
+        workers.emplace_back([&]() {
+            std::unique_ptr<MidiFileParser> parser(new MidiFileParser());
+            size_t index;
+            while ((index = nextJob.fetch_add(1)) < jobs.size()) {
+                scanFile(jobs[index], *parser);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // The firmware looks entries up by identity - copies of one song share an entry
+    std::vector<FileLengthCacheEntry> entries;
+    size_t failed = 0;
+    for (const ScanJob& job : jobs) {
+        if (!job.ok) {
+            fprintf(stderr, "warning: could not parse %s\n", job.cardPath.c_str());
+            failed++;
+            continue;
+        }
+
+        bool duplicate = false;
+        for (const FileLengthCacheEntry& e : entries) {
+            if (job.identity == e.identity) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            continue;
+        }
+
+        FileLengthCacheEntry e;
+        e.identity = job.identity;
+        e.lengthTicks = job.lengthTicks;
+        e.sysexCount = job.sysexCount;
+        entries.push_back(e);
+    }
+
+    if (entries.size() > MAX_CACHE_ENTRIES) {
+        fprintf(stderr, "warning: %zu files, cache holds %d - the rest will be scanned on the device\n",
+                entries.size(), MAX_CACHE_ENTRIES);
+        entries.resize(MAX_CACHE_ENTRIES);
+    }
+
+    printf("Scanned %zu files in %.3f s (%.1f files/sec, %u threads), %zu failed, %zu cached\n",
+           jobs.size(), seconds, seconds > 0 ? jobs.size() / seconds : 0.0,
+           threadCount, failed, entries.size());
+
+    if (dryRun) {
+        return 0;
+    }
+
+    std::string cacheDir = rootPath + CACHE_DIR_PATH;
+    mkdir(cacheDir.c_str(), 0755);
+
+    std::string cachePath = rootPath + CACHE_FILE_PATH;
+    FILE* out = fopen(cachePath.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "error: cannot write %s\n", cachePath.c_str());
+        return 1;
+    }
+
+    // Same layout as saveLengthCache() in main.cpp
+    fprintf(out, "VERSION,%d\n", CACHE_VERSION);
+    for (const FileLengthCacheEntry& e : entries) {
+        fprintf(out, "%lu,%08lX,%lu,%u\n", (unsigned long)e.identity.size,
+                (unsigned long)e.identity.hash, (unsigned long)e.lengthTicks, e.sysexCount);
+    }
+
+    if (fclose(out) != 0) {
+        fprintf(stderr, "error: write failed for %s\n", cachePath.c_str());
+        return 1;
+    }
+
+    printf("Wrote %s\n", cachePath.c_str());
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Minimal Arduino.h replacement for building the shared firmware sources on a
+// Linux host. MidiFileParser only needs the fixed-width types, <string.h>
+// and the timing calls used to profile and retry its reads.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+inline unsigned long micros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    usleep(us);
+}
+
+#endif // HOST_ARDUINO_H
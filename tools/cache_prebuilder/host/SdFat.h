@@ -0,0 +1,90 @@
+#ifndef HOST_SDFAT_H
+#define HOST_SDFAT_H
+
+// Minimal SdFat replacement for building the shared firmware sources on a
+// Linux host. Only the FatFile calls made by MidiFileParser, SmfWriter and
+// the prebuilder are provided, backed by a POSIX file descriptor. The host
+// tests use failRead to make chosen reads fail the way a bad card does.
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef int oflag_t;
+
+class SdFat;  // Declared only, so FileBrowser.h can be included for its limits
+
+class FatFile {
+public:
+    FatFile() : fd(-1), position(0), size(0) {}
+    ~FatFile() { close(); }
+
+    FatFile(const FatFile&) = delete;
+    FatFile& operator=(const FatFile&) = delete;
+
+    bool open(const char* path, oflag_t oflag = O_RDONLY) {
+        close();
+        fd = ::open(path, oflag);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            close();
+            return false;
+        }
+        position = 0;
+        size = (uint32_t)st.st_size;
+        return true;
+    }
+
+    bool close() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    int read(void* buf, size_t count) {
+        if (fd < 0) return -1;
+        if (failRead && failRead(position, count)) return -1;
+        ssize_t n = pread(fd, buf, count, position);
+        if (n < 0) return -1;
+        position += (uint32_t)n;
+        return (int)n;
+    }
+
+    size_t write(const void* buf, size_t count) {
+        if (fd < 0) return 0;
+        ssize_t n = pwrite(fd, buf, count, position);
+        if (n < 0) return 0;
+        position += (uint32_t)n;
+        if (position > size) size = position;
+        return (size_t)n;
+    }
+
+    bool sync() { return fd >= 0 && fsync(fd) == 0; }
+
+    bool seekSet(uint32_t pos) {
+        if (fd < 0 || pos > size) return false;
+        position = pos;
+        return true;
+    }
+
+    uint32_t curPosition() const { return position; }
+    uint32_t fileSize() const { return size; }
+    int available() const { return (fd >= 0 && position < size) ? (int)(size - position) : 0; }
+
+    // Called before every read (any file); returning true fails it like an SD error
+    static inline bool (*failRead)(uint32_t position, size_t count) = nullptr;
+
+private:
+    int fd;
+    uint32_t position;
+    uint32_t size;
+};
+
+#endif // HOST_SDFAT_H
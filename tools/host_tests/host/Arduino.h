@@ -0,0 +1,88 @@
+#ifndef HOST_TEST_ARDUINO_H
+#define HOST_TEST_ARDUINO_H
+
+// Arduino core replacement for the host tests. Time only moves when a test
+// (or a delay) moves hostClockMicros, serial ports keep every byte written to
+// them, and rp2040.cpuid() reports the core the test says it is running on.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <vector>
+
+inline uint64_t hostClockMicros = 0;
+
+// 32 bits wide, like the RP2040, so they wrap where the device does
+inline unsigned long micros() { return (uint32_t)hostClockMicros; }
+inline unsigned long millis() { return (uint32_t)(hostClockMicros / 1000); }
+inline void delay(unsigned long ms) { hostClockMicros += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { hostClockMicros += us; }
+inline void yield() {}
+
+template <class T> T constrain(T value, T low, T high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+// UART: unlimited room, everything written is kept
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    void setTX(int) {}
+    void setRX(int) {}
+    size_t write(uint8_t b) { written.push_back(b); return 1; }
+    size_t write(const uint8_t* data, size_t length) { written.insert(written.end(), data, data + length); return length; }
+    int availableForWrite() { return 1 << 20; }
+
+    std::vector<uint8_t> written;
+};
+
+inline HardwareSerial Serial1;
+
+// PIO UART: the test sets how much TX FIFO room there is (0 = stalled)
+class SerialPIO {
+public:
+    static constexpr int NOPIN = -1;
+    static constexpr int MAX_PORTS = 4;
+
+    SerialPIO(int txPin, int) : tx(txPin), room(1 << 20) {
+        if (count < MAX_PORTS) ports[count++] = this;
+    }
+    void begin(unsigned long) {}
+    int availableForWrite() { return room; }
+    size_t write(uint8_t b) { written.push_back(b); return 1; }
+
+    static SerialPIO* onPin(int txPin) {
+        for (int i = 0; i < count; i++) {
+            if (ports[i]->tx == txPin) return ports[i];
+        }
+        return nullptr;
+    }
+
+    int tx;
+    int room;
+    std::vector<uint8_t> written;
+
+private:
+    static inline SerialPIO* ports[MAX_PORTS];
+    static inline int count = 0;
+};
+
+// One core at a time, so a spin lock only has to exist
+struct spin_lock_t {
+    bool held;
+};
+inline spin_lock_t hostSpinLocks[32];
+inline unsigned spin_lock_claim_unused(bool) { return 0; }
+inline spin_lock_t* spin_lock_init(unsigned index) { return &hostSpinLocks[index]; }
+inline uint32_t spin_lock_blocking(spin_lock_t* lock) { lock->held = true; return 0; }
+inline void spin_unlock(spin_lock_t* lock, uint32_t) { lock->held = false; }
+
+struct HostRp2040 {
+    int core = 1;
+    int cpuid() { return core; }
+};
+inline HostRp2040 rp2040;
+
+#endif // HOST_TEST_ARDUINO_H
@@ -0,0 +1,73 @@
+#ifndef HOST_TEST_MIDI_H
+#define HOST_TEST_MIDI_H
+
+// The calls MidiOutput makes on the Arduino MIDI Library, writing each
+// message whole (no running status, the library's default) to its serial port.
+
+#include <Arduino.h>
+
+#define MIDI_NAMESPACE midi
+#define MIDI_CHANNEL_OMNI 0
+
+namespace midi {
+
+enum MidiType {
+    InvalidType = 0x00,
+    NoteOff = 0x80,
+    NoteOn = 0x90,
+    AfterTouchPoly = 0xA0,
+    ControlChange = 0xB0,
+    ProgramChange = 0xC0,
+    AfterTouchChannel = 0xD0,
+    PitchBend = 0xE0,
+    SystemExclusive = 0xF0,
+    Clock = 0xF8,
+    Start = 0xFA,
+    Continue = 0xFB,
+    Stop = 0xFC
+};
+
+template <class SerialPort>
+class SerialMIDI {
+public:
+    explicit SerialMIDI(SerialPort& serialPort) : port(serialPort) {}
+    SerialPort& port;
+};
+
+template <class Transport>
+class MidiInterface {
+public:
+    explicit MidiInterface(Transport& midiTransport) : transport(midiTransport) {}
+
+    void begin(int) {}
+    void turnThruOff() {}
+
+    void sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel) { send(NoteOn, channel, note, velocity, 3); }
+    void sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel) { send(NoteOff, channel, note, velocity, 3); }
+    void sendControlChange(uint8_t number, uint8_t value, uint8_t channel) { send(ControlChange, channel, number, value, 3); }
+    void sendProgramChange(uint8_t number, uint8_t channel) { send(ProgramChange, channel, number, 0, 2); }
+    void sendAfterTouch(uint8_t pressure, uint8_t channel) { send(AfterTouchChannel, channel, pressure, 0, 2); }
+    void sendAfterTouch(uint8_t note, uint8_t pressure, uint8_t channel) { send(AfterTouchPoly, channel, note, pressure, 3); }
+    void sendPitchBend(int bend, uint8_t channel) {
+        unsigned value = (unsigned)(bend + 8192);
+        send(PitchBend, channel, value & 0x7F, (value >> 7) & 0x7F, 3);
+    }
+    void sendSysEx(unsigned length, const uint8_t* data, bool) { transport.port.write(data, length); }
+    void sendRealTime(MidiType type) { transport.port.write((uint8_t)type); }
+
+private:
+    void send(MidiType type, uint8_t channel, uint8_t data1, uint8_t data2, uint8_t length) {
+        uint8_t msg[3] = { (uint8_t)(type | ((channel - 1) & 0x0F)), data1, data2 };
+        transport.port.write(msg, length);
+    }
+
+    Transport& transport;
+};
+
+} // namespace midi
+
+#define MIDI_CREATE_INSTANCE(Type, SerialPort, Name) \
+    midi::SerialMIDI<Type> serial##Name(SerialPort); \
+    midi::MidiInterface<midi::SerialMIDI<Type>> Name(serial##Name);
+
+#endif // HOST_TEST_MIDI_H
@@ -0,0 +1,10 @@
+#ifndef HOST_TEST_PICO_TIME_H
+#define HOST_TEST_PICO_TIME_H
+
+// The Pico SDK's 64-bit timer, on the host test clock
+
+#include <Arduino.h>
+
+inline uint64_t time_us_64() { return hostClockMicros; }
+
+#endif // HOST_TEST_PICO_TIME_H
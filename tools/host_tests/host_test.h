@@ -0,0 +1,55 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Checks shared by the host tests: a failed check prints where and why and
+// the test keeps going, so one run reports everything that is wrong.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+inline int hostTestFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        unsigned long long actual_ = (unsigned long long)(actual); \
+        unsigned long long expected_ = (unsigned long long)(expected); \
+        if (actual_ != expected_) { \
+            printf("%s:%d: %s is %llu, expected %llu\n", __FILE__, __LINE__, #actual, actual_, expected_); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_BYTES(actual, ...) checkBytes(__FILE__, __LINE__, #actual, actual, { __VA_ARGS__ })
+
+inline void checkBytes(const char* file, int line, const char* name,
+                       const std::vector<uint8_t>& actual, std::initializer_list<uint8_t> expected) {
+    if (actual.size() == expected.size() && std::equal(actual.begin(), actual.end(), expected.begin())) return;
+    printf("%s:%d: %s is", file, line, name);
+    for (uint8_t b : actual) printf(" %02X", b);
+    printf(", expected");
+    for (uint8_t b : expected) printf(" %02X", b);
+    printf("\n");
+    hostTestFailures++;
+}
+
+inline int finishTests(const char* name) {
+    if (hostTestFailures) {
+        printf("%s: %d check(s) failed\n", name, hostTestFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,238 @@
+// ============================================================================
+// Song containers on the host
+//
+// Opens the same song as a plain SMF, wrapped in an RMID "data" chunk and
+// packed by mlz_pack, through the firmware's MidiContainer and MidiFileParser,
+// and checks that every container gives back the SMF bytes and events exactly
+// (in order and after seeks). Then feeds the LZ4 block decoder truncated and
+// over-long literal and match lengths, which must fail without writing past
+// the output, and checks a packed file with a corrupt block reads as an error.
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "MidiContainer.h"
+#include "MidiFileParser.h"
+#include "host_test.h"
+
+#include <stdio.h>
+
+// The packer's own block compressor and frame writer, without its command line
+#define main mlzPackMain
+#include "../mlz_pack/mlz_pack.cpp"
+#undef main
+
+static char smfPath[] = "/tmp/midi_pi_smfXXXXXX";
+static char rmidPath[] = "/tmp/midi_pi_rmidXXXXXX";
+static char mlzPath[] = "/tmp/midi_pi_mlzXXXXXX";
+static std::vector<uint8_t> smf;
+static MidiContainer container;  // Large - kept off the stack
+static MidiFileParser parser;
+
+static bool writeTemp(char* path, const std::vector<uint8_t>& data) {
+    int fd = mkstemp(path);
+    if (fd < 0) return false;
+    bool ok = write(fd, data.data(), data.size()) == (ssize_t)data.size();
+    ::close(fd);
+    return ok;
+}
+
+static void putChunk(std::vector<uint8_t>& file, const char* id, const std::vector<uint8_t>& data) {
+    file.insert(file.end(), id, id + 4);
+    putLE32(file, (uint32_t)data.size());
+    file.insert(file.end(), data.begin(), data.end());
+    if (data.size() & 1) file.push_back(0);  // RIFF pad byte
+}
+
+// Format 0, several MLZ blocks: a long run of notes (compresses well) with a
+// SysEx of pseudo-random bytes in the middle (a block stored uncompressed)
+static void buildSmf() {
+    std::vector<uint8_t> track = { 0x00, 0x90 };
+    for (uint16_t i = 0; i < 300; i++) {
+        const uint8_t note[] = { (uint8_t)(48 + i % 24), 100, 0x30, (uint8_t)(48 + i % 24), 0, 0x30 };
+        track.insert(track.end(), note, note + sizeof(note) - (i == 299 ? 1 : 0));
+        if (i == 150) {
+            track.push_back(0xF0);
+            track.push_back(0x85);  // 700 = 0x85 0x3C
+            track.push_back(0x3C);
+            uint32_t seed = 12345;
+            for (uint16_t j = 0; j < 699; j++) {
+                seed = seed * 1103515245 + 12345;
+                track.push_back((seed >> 16) & 0x7F);
+            }
+            track.push_back(0xF7);
+            track.push_back(0x30);
+            track.push_back(0x90);  // SysEx cancels running status
+        }
+    }
+    const uint8_t endOfTrack[] = { 0x00, 0xFF, 0x2F, 0x00 };
+    track.insert(track.end(), endOfTrack, endOfTrack + 4);
+
+    smf = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96, 'M', 'T', 'r', 'k' };
+    uint32_t length = track.size();
+    for (int shift = 24; shift >= 0; shift -= 8) smf.push_back((length >> shift) & 0xFF);
+    smf.insert(smf.end(), track.begin(), track.end());
+}
+
+// The container at path gives back the SMF: whole, and from seeks across blocks
+static bool readsBackSmf(const char* path, MidiContainerType type) {
+    FatFile file;
+    if (!file.open(path) || !container.open(&file) || container.getType() != type ||
+        container.fileSize() != smf.size()) {
+        return false;
+    }
+
+    std::vector<uint8_t> whole(smf.size());
+    if (container.read(whole.data(), whole.size()) != (int)whole.size() || whole != smf) return false;
+    if (container.read(whole.data(), 1) != 0) return false;  // Nothing past the SMF
+
+    const uint32_t seeks[] = { 1000, 5, MLZ_BLOCK_SIZE - 3, (uint32_t)smf.size() - 10, 2 * MLZ_BLOCK_SIZE };
+    for (uint32_t pos : seeks) {
+        uint8_t bytes[16];
+        if (!container.seekSet(pos) || container.read(bytes, sizeof(bytes)) != (int)std::min<size_t>(16, smf.size() - pos) ||
+            memcmp(bytes, &smf[pos], std::min<size_t>(16, smf.size() - pos)) != 0) {
+            return false;
+        }
+    }
+    container.close();
+    return true;
+}
+
+static uint32_t eventsIn(const char* path, MidiContainerType& type) {
+    FatFile file;
+    uint32_t events = 0;
+    if (!file.open(path) || !parser.open(path, &file)) return 0;
+    type = parser.getContainerType();
+    MidiEvent event;
+    while (parser.readNextEvent(event)) events++;
+    parser.close();
+    return events;
+}
+
+static void testRmidDataChunk() {
+    // An odd-sized chunk (padded) before "data", and one after it that isn't the song
+    std::vector<uint8_t> riff = { 'R', 'M', 'I', 'D' };
+    putChunk(riff, "LIST", { 'I', 'N', 'F', 'O', 'x' });
+    putChunk(riff, "data", smf);
+    putChunk(riff, "DISP", { 1, 0, 0, 0, 'a', 'b' });
+    std::vector<uint8_t> file;
+    putChunk(file, "RIFF", riff);
+    CHECK(writeTemp(rmidPath, file));
+
+    CHECK(readsBackSmf(rmidPath, CONTAINER_RMID));
+    MidiContainerType type = CONTAINER_NONE;
+    CHECK_EQ(eventsIn(rmidPath, type), eventsIn(smfPath, type));
+    CHECK_EQ(type, CONTAINER_SMF);
+    eventsIn(rmidPath, type);
+    CHECK_EQ(type, CONTAINER_RMID);
+
+    // No "data" chunk: not a song
+    std::vector<uint8_t> empty;
+    putChunk(empty, "RIFF", { 'R', 'M', 'I', 'D', 'L', 'I', 'S', 'T', 0, 0, 0, 0 });
+    char emptyPath[] = "/tmp/midi_pi_rmid_emptyXXXXXX";
+    CHECK(writeTemp(emptyPath, empty));
+    FatFile emptyFile;
+    CHECK(emptyFile.open(emptyPath));
+    CHECK(!container.open(&emptyFile));
+    unlink(emptyPath);
+}
+
+static void testMlzRoundTrip() {
+    std::vector<uint8_t> packed = packSmf(smf);
+    CHECK(packed.size() < smf.size());
+    CHECK(writeTemp(mlzPath, packed));
+
+    CHECK(readsBackSmf(mlzPath, CONTAINER_MLZ));
+    MidiContainerType type = CONTAINER_NONE;
+    uint32_t events = eventsIn(mlzPath, type);
+    CHECK_EQ(type, CONTAINER_MLZ);
+    CHECK(events > 600);
+    CHECK_EQ(events, eventsIn(smfPath, type));
+
+    // The random SysEx block didn't compress and is stored as is
+    bool storedBlock = false;
+    for (size_t pos = 15; pos + 4 < packed.size() && !storedBlock; ) {
+        uint32_t header = readLE32(&packed[pos]);
+        if (header == 0) break;  // EndMark
+        storedBlock = header & LZ4_BLOCK_UNCOMPRESSED;
+        pos += 4 + (header & ~LZ4_BLOCK_UNCOMPRESSED);
+    }
+    CHECK(storedBlock);
+}
+
+static void testMalformedBlocks() {
+    uint8_t out[64];
+    memset(out, 0xAA, sizeof(out));
+
+    // A valid block: 4 literals, then an overlapping match of 8 (offset 4), then 5 literals
+    const uint8_t valid[] = { 0x44, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x50, 'v', 'w', 'x', 'y', 'z' };
+    CHECK_EQ(lz4DecodeBlock(valid, sizeof(valid), out, sizeof(out)), 17);
+    CHECK(memcmp(out, "abcdabcdabcdvwxyz", 17) == 0);
+
+    // Literal length: its extension bytes run past the input
+    const uint8_t literalExtensionCut[] = { 0xF0, 0xFF, 0xFF };
+    CHECK_EQ(lz4DecodeBlock(literalExtensionCut, sizeof(literalExtensionCut), out, sizeof(out)), -1);
+
+    // Literal length longer than the input left
+    const uint8_t literalsCut[] = { 0x80, 'a', 'b', 'c' };
+    CHECK_EQ(lz4DecodeBlock(literalsCut, sizeof(literalsCut), out, sizeof(out)), -1);
+
+    // Literal length longer than the output (75 literals, all present, into 32 bytes)
+    std::vector<uint8_t> literalsTooLong = { 0xF0, 60 };
+    literalsTooLong.insert(literalsTooLong.end(), 75, 'l');
+    memset(out, 0xAA, sizeof(out));
+    CHECK_EQ(lz4DecodeBlock(literalsTooLong.data(), literalsTooLong.size(), out, 32), -1);
+    CHECK_EQ(out[0], 0xAA);  // Nothing written
+
+    // Match offset cut short, and offsets of 0 or before the output start
+    const uint8_t offsetCut[] = { 0x10, 'a', 0x01 };
+    CHECK_EQ(lz4DecodeBlock(offsetCut, sizeof(offsetCut), out, sizeof(out)), -1);
+    const uint8_t offsetZero[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+    CHECK_EQ(lz4DecodeBlock(offsetZero, sizeof(offsetZero), out, sizeof(out)), -1);
+    const uint8_t offsetBeforeStart[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+    CHECK_EQ(lz4DecodeBlock(offsetBeforeStart, sizeof(offsetBeforeStart), out, sizeof(out)), -1);
+
+    // Match length: extension cut off, and longer than the output
+    const uint8_t matchExtensionCut[] = { 0x1F, 'a', 0x01, 0x00, 0xFF };
+    CHECK_EQ(lz4DecodeBlock(matchExtensionCut, sizeof(matchExtensionCut), out, sizeof(out)), -1);
+    const uint8_t matchTooLong[] = { 0x1F, 'a', 0x01, 0x00, 0x30, 0x00 };  // 4 + 15 + 48 = 67
+    uint8_t guarded[80];
+    memset(guarded, 0xAA, sizeof(guarded));
+    CHECK_EQ(lz4DecodeBlock(matchTooLong, sizeof(matchTooLong), guarded, 64), -1);
+    CHECK_EQ(guarded[64], 0xAA);
+
+    // A packed file whose first block lies about its literal length reads as an error
+    std::vector<uint8_t> packed = packSmf(smf);
+    packed[15 + 4] = 0xF0;
+    packed[15 + 5] = 0xFF;
+    char corruptPath[] = "/tmp/midi_pi_mlz_corruptXXXXXX";
+    CHECK(writeTemp(corruptPath, packed));
+    FatFile file;
+    CHECK(file.open(corruptPath));
+    CHECK(container.open(&file));
+    uint8_t bytes[16];
+    CHECK_EQ(container.read(bytes, sizeof(bytes)), -1);
+    CHECK_EQ(container.getBlocksDecoded(), 0);
+    CHECK(container.seekSet(MLZ_BLOCK_SIZE));  // Other blocks still read
+    CHECK_EQ(container.read(bytes, sizeof(bytes)), (int)sizeof(bytes));
+    CHECK(memcmp(bytes, &smf[MLZ_BLOCK_SIZE], sizeof(bytes)) == 0);
+    container.close();
+    unlink(corruptPath);
+}
+
+int main() {
+    buildSmf();
+    if (!writeTemp(smfPath, smf)) {
+        printf("test_containers: can't write %s\n", smfPath);
+        return 1;
+    }
+
+    testRmidDataChunk();
+    testMlzRoundTrip();
+    testMalformedBlocks();
+
+    unlink(smfPath);
+    unlink(rmidPath);
+    unlink(mlzPath);
+    return finishTests("test_containers");
+}
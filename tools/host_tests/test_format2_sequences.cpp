@@ -0,0 +1,228 @@
+// ============================================================================
+// Format 2 sequences on the host
+//
+// Loads a three-sequence format 2 song through the firmware's MidiFileParser
+// and checks each sequence on its own: the lengths and first tempos the scan
+// finds, that a selected sequence plays its own track from tick 0 to its end
+// and nothing else, that a rewind reuses a start still in the buffer, and
+// that indexes past the last sequence are refused. Then switches sequence in
+// MidiPlayer while a note sounds.
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "MidiPlayer.h"
+#include "MidiSinks.h"
+#include "host_test.h"
+
+#include <stdio.h>
+
+static const uint16_t TICKS_PER_QUARTER = 96;
+static const uint16_t LONG_NOTES = 150;       // Sequence 1 is several track buffers long
+static const uint32_t LENGTH_0 = 384;
+static const uint32_t LENGTH_1 = (LONG_NOTES * 2 - 1) * 10 + 7;
+static const uint32_t LENGTH_2 = 50;
+static char songPath[] = "/tmp/midi_pi_format2XXXXXX";
+static MidiFileParser parser;  // Large - kept off the stack
+static RecordingMidiSink sink;
+static MidiPlayerT<RecordingMidiSink> player(&sink);
+
+static void putVarLen(std::vector<uint8_t>& out, uint32_t value) {
+    uint8_t bytes[4];
+    int count = 0;
+    do {
+        bytes[count++] = value & 0x7F;
+        value >>= 7;
+    } while (value);
+    while (count > 1) out.push_back(bytes[--count] | 0x80);
+    out.push_back(bytes[0]);
+}
+
+static void putTrack(std::vector<uint8_t>& file, const std::vector<uint8_t>& data) {
+    const uint8_t header[] = { 'M', 'T', 'r', 'k' };
+    file.insert(file.end(), header, header + 4);
+    uint32_t length = data.size();
+    for (int shift = 24; shift >= 0; shift -= 8) file.push_back((length >> shift) & 0xFF);
+    file.insert(file.end(), data.begin(), data.end());
+}
+
+// Sequence 0: tempo 600000, a program change and one note, ends at LENGTH_0.
+// Sequence 1: no tempo, LONG_NOTES notes on channel 2 (running status), ends
+// 7 ticks after the last one. Sequence 2: tempo 300000 then 250000, one note.
+static bool writeSong() {
+    std::vector<uint8_t> first = { 0x00, 0xFF, 0x51, 0x03, 0x09, 0x27, 0xC0,
+                                   0x00, 0xC0, 5, 0x00, 0x90, 60, 100,
+                                   0x60, 60, 0, 0x82, 0x20, 0xFF, 0x2F, 0x00 };  // 96 + 288 = 384
+    std::vector<uint8_t> second = { 0x00, 0x91 };
+    for (uint16_t i = 0; i < LONG_NOTES; i++) {
+        if (i > 0) putVarLen(second, 10);
+        second.push_back(40 + i % 40);
+        second.push_back(90);
+        putVarLen(second, 10);
+        second.push_back(40 + i % 40);
+        second.push_back(0);
+    }
+    const uint8_t endOfTrack[] = { 0x07, 0xFF, 0x2F, 0x00 };
+    second.insert(second.end(), endOfTrack, endOfTrack + 4);
+    std::vector<uint8_t> third = { 0x00, 0xFF, 0x51, 0x03, 0x04, 0x93, 0xE0,
+                                   0x00, 0x92, 72, 80,
+                                   0x30, 0xFF, 0x51, 0x03, 0x03, 0xD0, 0x90,
+                                   0x00, 72, 0, 0x02, 0xFF, 0x2F, 0x00 };      // 48 + 2 = 50
+
+    std::vector<uint8_t> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 2, 0, 3,
+                                  TICKS_PER_QUARTER >> 8, TICKS_PER_QUARTER & 0xFF };
+    putTrack(file, first);
+    putTrack(file, second);
+    putTrack(file, third);
+
+    int fd = mkstemp(songPath);
+    if (fd < 0) return false;
+    bool ok = write(fd, file.data(), file.size()) == (ssize_t)file.size();
+    ::close(fd);
+    return ok;
+}
+
+struct SequenceRead {
+    uint32_t events;
+    uint32_t firstTime;
+    uint32_t lastTime;
+    uint16_t tracks;  // Bit n = an event came from track n
+};
+
+static SequenceRead readToEnd() {
+    SequenceRead read = { 0, 0, 0, 0 };
+    MidiEvent event;
+    while (parser.readNextEvent(event)) {
+        if (read.events == 0) read.firstTime = event.absoluteTime;
+        read.events++;
+        read.lastTime = event.absoluteTime;
+        read.tracks |= 1 << event.trackNumber;
+    }
+    return read;
+}
+
+static void testScanFindsEachSequence() {
+    CHECK(parser.isMultiSequence());
+    CHECK_EQ(parser.getSequenceCount(), 3);
+    CHECK_EQ(parser.getActiveSequence(), 0);
+    CHECK_EQ(parser.getSequenceLengthTicks(1), 0);  // Not scanned yet
+
+    parser.calculateFileLengthNow();
+    CHECK_EQ(parser.getSequenceLengthTicks(0), LENGTH_0);
+    CHECK_EQ(parser.getSequenceLengthTicks(1), LENGTH_1);
+    CHECK_EQ(parser.getSequenceLengthTicks(2), LENGTH_2);
+    CHECK_EQ(parser.getSequenceLengthTicks(MAX_TRACKS), 0);
+    CHECK_EQ(parser.getFileLengthTicks(), LENGTH_0);  // The active sequence, not the longest
+
+    // First tempo of each; none means 120 BPM
+    CHECK_EQ(parser.getSequenceTempo(0), 600000);
+    CHECK_EQ(parser.getSequenceTempo(1), 500000);
+    CHECK_EQ(parser.getSequenceTempo(2), 300000);
+}
+
+static void testSelectedSequencePlaysAlone() {
+    // Sequence 0 as opened: its own events only, to its last one
+    SequenceRead read = readToEnd();
+    CHECK_EQ(read.tracks, 1 << 0);
+    CHECK_EQ(read.events, 4);  // Tempo, program change, Note On and Note Off
+    CHECK_EQ(read.lastTime, 96);
+    CHECK(parser.isEndOfFile());
+
+    // Sequence 1 starts at 0 with the default tempo, nothing chased from sequence 0
+    CHECK(parser.selectSequence(1));
+    CHECK_EQ(parser.getActiveSequence(), 1);
+    CHECK_EQ(parser.getFileLengthTicks(), LENGTH_1);
+    CHECK_EQ(parser.getFileInfo().tempo, 500000);
+    CHECK_EQ(parser.getChaseState().program[0], CHASE_NONE);
+    CHECK_EQ(parser.getCheckpointCount(), 0);
+    read = readToEnd();
+    CHECK_EQ(read.tracks, 1 << 1);
+    CHECK_EQ(read.events, LONG_NOTES * 2);
+    CHECK_EQ(read.firstTime, 0);
+    CHECK_EQ(read.lastTime, LENGTH_1 - 7);
+
+    // Rewinding it reads its start from the card again - the buffer has moved on
+    uint32_t cardBytes = parser.getCardBytesRead();
+    CHECK(parser.selectSequence(1));
+    CHECK(parser.getCardBytesRead() > cardBytes);
+    SequenceRead again = readToEnd();
+    CHECK_EQ(again.events, read.events);
+    CHECK_EQ(again.lastTime, read.lastTime);
+
+    // Past the last sequence: refused, and the active one is left alone
+    CHECK(!parser.selectSequence(3));
+    CHECK(!parser.selectSequence(MAX_TRACKS));
+    CHECK_EQ(parser.getActiveSequence(), 1);
+
+    // Sequence 2 starts on its own first tempo and changes it itself
+    CHECK(parser.selectSequence(2));
+    CHECK_EQ(parser.getFileInfo().tempo, 300000);
+    read = readToEnd();
+    CHECK_EQ(read.tracks, 1 << 2);
+    CHECK_EQ(read.lastTime, 48);
+    CHECK_EQ(parser.getFileInfo().tempo, 250000);
+    CHECK_EQ(parser.getFileLengthTicks(), LENGTH_2);
+
+    // Sequence 0 fits one buffer: once read back in, a rewind needs no card read
+    CHECK(parser.selectSequence(0));
+    readToEnd();
+    cardBytes = parser.getCardBytesRead();
+    CHECK(parser.selectSequence(0));
+    CHECK_EQ(parser.getCardBytesRead(), cardBytes);
+    CHECK_EQ(readToEnd().events, 4);
+}
+
+// Channel 1 on the main port was sent All Notes Off, and no note started
+static bool channelOneSilenced() {
+    bool allNotesOff = false;
+    for (uint8_t i = 0; i < sink.getCount(); i++) {
+        const RecordedMidiMessage& m = sink.get(i);
+        if ((m.status & 0xF0) == 0x90) return false;
+        allNotesOff |= m.port == 0 && m.status == 0xB0 && m.data1 == 123;
+    }
+    return allNotesOff;
+}
+
+static void testPlayerSwitchesWhilePlaying() {
+    FatFile file;
+    if (!file.open(songPath) || !player.loadFile(&file)) {
+        CHECK(!"song loads");
+        return;
+    }
+    player.getParser().calculateFileLengthNow();
+    player.setTempoPercent(1000);
+    player.play();
+    for (int i = 0; i < 100 && player.getPositionTicks() < 10; i++) {
+        hostClockMicros += 1000;
+        player.update();
+    }
+    sink.clear();
+
+    // The sequence 0 note is silenced, and sequence 1 plays from its start at its length
+    CHECK(player.selectSequence(1));
+    CHECK(channelOneSilenced());
+    CHECK_EQ(player.getState(), STATE_PLAYING);
+    CHECK_EQ(player.getPositionTicks(), 0);
+    CHECK_EQ(player.getTotalTimeMs(), LENGTH_1 * 500 / TICKS_PER_QUARTER);
+    CHECK(!player.selectSequence(3));
+    player.unloadFile();
+}
+
+int main() {
+    if (!writeSong()) {
+        printf("test_format2_sequences: can't write %s\n", songPath);
+        return 1;
+    }
+
+    FatFile file;
+    CHECK(file.open(songPath));
+    CHECK(parser.open(songPath, &file));
+    testScanFindsEachSequence();
+    testSelectedSequencePlaysAlone();
+    parser.close();
+
+    testPlayerSwitchesWhilePlaying();
+
+    unlink(songPath);
+    return finishTests("test_format2_sequences");
+}
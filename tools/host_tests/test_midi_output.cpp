@@ -0,0 +1,242 @@
+// ============================================================================
+// MidiOutput port layer on the host
+//
+// Runs the firmware's MidiOutput against recording serial ports: running
+// status on the PIO ports, whole-message drops when a port stalls, per-port
+// utilization windows and the Core 0 submission queue (order, waiting for a
+// full port, counted drops, SysEx records that wrap and a bounded flush).
+// ============================================================================
+
+#include <Arduino.h>
+#include "MidiOutput.h"
+#include "pins.h"
+#include "host_test.h"
+
+static SerialPIO& portB() { return *SerialPIO::onPin(MIDI_OUT2_TX_PIN); }
+static SerialPIO& portC() { return *SerialPIO::onPin(MIDI_OUT3_TX_PIN); }
+
+// A fresh output on empty wires, sending from Core 1
+static MidiOutput* freshOutput() {
+    Serial1.written.clear();
+    portB().written.clear();
+    portC().written.clear();
+    portB().room = 1 << 20;
+    portC().room = 1 << 20;
+    rp2040.core = 1;
+    MidiOutput* out = new MidiOutput();
+    out->begin();
+    return out;
+}
+
+static void testRunningStatus() {
+    MidiOutput* out = freshOutput();
+
+    out->sendNoteOn(1, 60, 100, 1);
+    out->sendNoteOn(1, 62, 90, 1);         // Same status - data bytes only
+    out->sendControlChange(1, 7, 100, 1);
+    out->sendControlChange(1, 10, 64, 1);
+    out->sendClock();                      // Real-time leaves running status alone
+    out->sendControlChange(1, 11, 127, 1);
+    CHECK_BYTES(portB().written, 0x90, 60, 100, 62, 90, 0xB0, 7, 100, 10, 64, 0xF8, 11, 127);
+
+    // SysEx cancels it, so the next channel message carries its status again
+    portB().written.clear();
+    static const uint8_t identity[] = { 0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7 };
+    out->sendSysEx(identity, sizeof(identity), 1);
+    out->sendControlChange(1, 11, 0, 1);
+    out->sendProgramChange(2, 5, 1);
+    out->sendProgramChange(2, 6, 1);
+    CHECK_BYTES(portB().written, 0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7, 0xB0, 11, 0, 0xC1, 5, 6);
+
+    // Each port keeps its own state; the clock went to every port
+    CHECK_BYTES(portC().written, 0xF8);
+    CHECK_BYTES(Serial1.written, 0xF8);
+    delete out;
+}
+
+static void testStalledPortDropsWholeMessages() {
+    MidiOutput* out = freshOutput();
+    portB().room = 0;
+
+    // Alternate channels so every message is 3 bytes: 85 fit in the 255 usable bytes
+    for (uint8_t i = 0; i < 90; i++) {
+        out->sendNoteOn((i & 1) ? 2 : 1, i, 100, 1);
+    }
+    CHECK(portB().written.empty());
+    CHECK_EQ(out->getPortStats(1).bytesDropped, 5 * 3);
+    CHECK_EQ(out->getPortStats(2).bytesDropped, 0);
+
+    // The port drains in order, and the first message after a drop resends its status
+    portB().room = 1 << 20;
+    out->service();
+    CHECK_EQ(portB().written.size(), 85 * 3);
+    CHECK_EQ(portB().written[252], 0x90);
+    CHECK_EQ(portB().written[253], 84);
+    portB().written.clear();
+    out->sendNoteOn(1, 1, 100, 1);
+    CHECK_BYTES(portB().written, 0x90, 1, 100);
+    CHECK_EQ(out->getPortStats(1).bytesSent, 85 * 3 + 3);
+    delete out;
+}
+
+static void testUtilizationWindow() {
+    MidiOutput* out = freshOutput();
+
+    // 1560 bytes in one second on port B is 49% of 3125 bytes/s
+    for (uint16_t i = 0; i < 520; i++) {
+        out->sendNoteOn((i & 1) ? 2 : 1, i & 0x7F, 100, 1);
+    }
+    out->sendControlChange(1, 7, 100, 0);
+    hostClockMicros += 1000000;
+    out->service();
+    CHECK_EQ(out->getPortStats(0).utilizationPercent, 0);  // 3 bytes round down
+    CHECK_EQ(out->getPortStats(1).utilizationPercent, 49);
+    CHECK_EQ(out->getPortStats(1).peakUtilizationPercent, 49);
+    CHECK_EQ(out->getPortStats(2).utilizationPercent, 0);
+    CHECK_EQ(out->getPortStats(1).bytesSent, 1560);
+
+    // An overloaded window reads 100%, a quiet one 0% with the peak kept
+    for (uint16_t i = 0; i < 1100; i++) {
+        out->sendNoteOn((i & 1) ? 2 : 1, i & 0x7F, 100, 2);
+    }
+    hostClockMicros += 1000000;
+    out->service();
+    CHECK_EQ(out->getPortStats(2).utilizationPercent, 100);
+    hostClockMicros += 1000000;
+    out->service();
+    CHECK_EQ(out->getPortStats(1).utilizationPercent, 0);
+    CHECK_EQ(out->getPortStats(1).peakUtilizationPercent, 49);
+    CHECK_EQ(out->getPortStats(2).peakUtilizationPercent, 100);
+    delete out;
+}
+
+static void testCore0Submissions() {
+    MidiOutput* out = freshOutput();
+    uint16_t room = out->getSubmitRoom();
+    CHECK_EQ(room, MIDI_SUBMIT_QUEUE_SIZE - 1);
+
+    // Core 0 only queues; nothing reaches a wire until Core 1 services
+    rp2040.core = 0;
+    out->sendNoteOn(1, 60, 100, 2);
+    out->sendControlChange(1, 7, 1, 0);
+    static const uint8_t reset[] = { 0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7 };
+    out->sendSysEx(reset, sizeof(reset), 1);
+    CHECK_EQ(out->getSubmitRoom(), room - 4 - 4 - (4 + sizeof(reset)));
+    CHECK(Serial1.written.empty());
+    CHECK(portB().written.empty());
+    CHECK(portC().written.empty());
+
+    rp2040.core = 1;
+    out->service();
+    CHECK_BYTES(portC().written, 0x90, 60, 100);
+    CHECK_BYTES(Serial1.written, 0xB0, 7, 1);
+    CHECK_BYTES(portB().written, 0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7);
+    CHECK_EQ(out->getSubmitRoom(), room);
+
+    // A Core 1 send writes anything Core 0 queued before it first
+    rp2040.core = 0;
+    out->sendNoteOff(1, 60, 0, 2);
+    rp2040.core = 1;
+    out->sendNoteOn(1, 64, 100, 2);
+    CHECK_BYTES(portC().written, 0x90, 60, 100, 0x80, 60, 0, 0x90, 64, 100);
+    delete out;
+}
+
+static void testSubmissionsWaitForAFullPort() {
+    MidiOutput* out = freshOutput();
+    portB().room = 0;
+
+    // The port queue takes 85 messages; the rest wait in the submission queue
+    rp2040.core = 0;
+    for (uint8_t i = 0; i < 200; i++) {
+        out->sendNoteOn((i & 1) ? 2 : 1, i & 0x7F, 100, 1);
+    }
+    rp2040.core = 1;
+    out->service();
+    CHECK_EQ(out->getPortStats(1).bytesDropped, 0);
+    CHECK_EQ(out->getSubmitRoom(), MIDI_SUBMIT_QUEUE_SIZE - 1 - 115 * 4);
+
+    // Only a full submission queue drops, and each dropped message is counted
+    rp2040.core = 0;
+    for (uint8_t i = 200; i < 250; i++) {
+        out->sendNoteOn((i & 1) ? 2 : 1, i & 0x7F, 100, 1);
+    }
+    for (uint8_t i = 0; i < 100; i++) {
+        out->sendNoteOn((i & 1) ? 2 : 1, i, 100, 1);
+    }
+    CHECK_EQ(out->getSubmitDropped(), 10);
+    rp2040.core = 1;
+
+    portB().room = 1 << 20;
+    for (uint8_t i = 0; i < 10; i++) {
+        out->service();
+    }
+    CHECK_EQ(portB().written.size(), 340 * 3);
+    CHECK_EQ(out->getPortStats(1).bytesDropped, 10 * 3);  // The port's count includes them
+    CHECK_EQ(out->getSubmitRoom(), MIDI_SUBMIT_QUEUE_SIZE - 1);
+    bool inOrder = true;
+    for (uint16_t i = 0; i < 340 && inOrder; i++) {
+        uint8_t expected = (i < 250) ? (i & 0x7F) : (i - 250);
+        inOrder = portB().written[i * 3 + 1] == expected;
+    }
+    CHECK(inOrder);
+    delete out;
+}
+
+static void testWrappedSysExSubmission() {
+    MidiOutput* out = freshOutput();
+
+    // Move the queue position to 24 bytes before the end, then submit a SysEx across it
+    rp2040.core = 0;
+    for (uint8_t i = 0; i < 250; i++) {
+        out->sendControlChange(1, 7, i & 0x7F, 0);
+    }
+    rp2040.core = 1;
+    out->service();
+    Serial1.written.clear();
+
+    uint8_t dump[50];
+    dump[0] = 0xF0;
+    for (uint8_t i = 1; i < sizeof(dump) - 1; i++) dump[i] = i;
+    dump[sizeof(dump) - 1] = 0xF7;
+    rp2040.core = 0;
+    out->sendSysEx(dump, sizeof(dump), 0);
+    rp2040.core = 1;
+    out->service();
+    CHECK_EQ(Serial1.written.size(), sizeof(dump));
+    CHECK(memcmp(Serial1.written.data(), dump, sizeof(dump)) == 0);
+    delete out;
+}
+
+static void testPanicGivesUpOnAStalledWriter() {
+    MidiOutput* out = freshOutput();
+
+    // Core 1 never drains: each port waits out one flush, then its remaining
+    // 2046 messages (of 2080) are counted as dropped instead of hanging Core 0
+    rp2040.core = 0;
+    uint64_t start = hostClockMicros;
+    out->panic();
+    uint64_t waited = hostClockMicros - start;
+    CHECK(waited >= MIDI_OUT_PORT_COUNT * MIDI_FLUSH_TIMEOUT_MS * 1000ULL);
+    CHECK(waited < MIDI_OUT_PORT_COUNT * (MIDI_FLUSH_TIMEOUT_MS + 1) * 1000ULL);
+    CHECK_EQ(out->getSubmitDropped(), MIDI_OUT_PORT_COUNT * 2046);
+    CHECK_EQ(out->getPortStats(2).bytesDropped, 2046 * 3);
+
+    // What was queued still goes out once the writer runs
+    rp2040.core = 1;
+    out->service();
+    CHECK_EQ(Serial1.written.size(), 34 * 3);
+    CHECK_EQ(out->getSubmitRoom(), MIDI_SUBMIT_QUEUE_SIZE - 1);
+    delete out;
+}
+
+int main() {
+    testRunningStatus();
+    testStalledPortDropsWholeMessages();
+    testUtilizationWindow();
+    testCore0Submissions();
+    testSubmissionsWaitForAFullPort();
+    testWrappedSysExSubmission();
+    testPanicGivesUpOnAStalledWriter();
+    return finishTests("test_midi_output");
+}
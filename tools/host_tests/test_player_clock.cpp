@@ -0,0 +1,130 @@
+// ============================================================================
+// Player clock soak on the host
+//
+// Runs MidiPlayer on a counting sink against the fake 64-bit timer, across
+// the point where the 32-bit microsecond counter wraps and over several days
+// of updates, and checks ticksElapsed and the MIDI clock pulses sent against
+// the exact values for the elapsed time (no drift, no overflow).
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "MidiPlayer.h"
+#include "MidiSinks.h"
+#include "host_test.h"
+
+#include <stdio.h>
+
+static const uint16_t TICKS_PER_QUARTER = 480;
+static const uint64_t TEMPO_MICROS = 500000;  // No tempo event - the file default, 120 BPM
+static const uint16_t TEMPO_PERCENT = 1130;   // 113.0%, so ticks never land on whole microseconds
+static const uint64_t DAY_MICROS = 24ULL * 3600 * 1000000;
+static const uint64_t WRAP_MICROS = 1ULL << 32;
+
+static char songPath[] = "/tmp/midi_pi_player_clockXXXXXX";
+static CountingMidiSink sink;
+static MidiPlayerT<CountingMidiSink> player(&sink);  // Large - kept off the stack
+
+// Format 0: a note, then controllers the longest delta apart (over 14 days in all at 113%)
+static bool writeSong() {
+    std::vector<uint8_t> track = { 0x00, 0x90, 60, 100 };
+    for (uint8_t i = 0; i < 5; i++) {
+        const uint8_t event[] = { 0xFF, 0xFF, 0xFF, 0x7F, 0xB0, 1, i };
+        track.insert(track.end(), event, event + sizeof(event));
+    }
+    const uint8_t endOfTrack[] = { 0x00, 0xFF, 0x2F, 0x00 };
+    track.insert(track.end(), endOfTrack, endOfTrack + 4);
+
+    std::vector<uint8_t> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1,
+                                  TICKS_PER_QUARTER >> 8, TICKS_PER_QUARTER & 0xFF,
+                                  'M', 'T', 'r', 'k' };
+    uint32_t length = track.size();
+    for (int shift = 24; shift >= 0; shift -= 8) file.push_back((length >> shift) & 0xFF);
+    file.insert(file.end(), track.begin(), track.end());
+
+    int fd = mkstemp(songPath);
+    if (fd < 0) return false;
+    bool ok = write(fd, file.data(), file.size()) == (ssize_t)file.size();
+    ::close(fd);
+    return ok;
+}
+
+// Plays from the current clock; returns when the song clock starts (after
+// the All Notes Off cleanup is on the wire)
+static uint64_t startSong(FatFile& file) {
+    if (!file.open(songPath) || !player.loadFile(&file)) {
+        CHECK(!"song loads");
+        return 0;
+    }
+    sink.reset();
+    player.setTempoPercent(TEMPO_PERCENT);
+    player.setClockEnabled(true);
+    player.play();
+    return hostClockMicros + 16 * 3 * 1000000ULL / MIDI_PORT_BYTES_PER_SEC;
+}
+
+static uint64_t expectedTicks(uint64_t elapsed) {
+    return elapsed * TEMPO_PERCENT * TICKS_PER_QUARTER / (TEMPO_MICROS * 1000);
+}
+
+static uint64_t expectedPulses(uint64_t elapsed) {
+    return elapsed * TEMPO_PERCENT * 24 / (TEMPO_MICROS * 1000) + 1;  // Plus the one at 0
+}
+
+// Updates every stepMicros until the clock reaches endMicros; false (and a
+// report) at the first update where the position is off
+static bool runTo(uint64_t songStart, uint64_t endMicros, uint64_t stepMicros) {
+    while (hostClockMicros < endMicros) {
+        hostClockMicros += stepMicros;
+        player.update();
+        uint64_t elapsed = hostClockMicros - songStart;
+        if (player.getPositionTicks() != expectedTicks(elapsed) ||
+            player.getClockPulsesSent() != expectedPulses(elapsed)) {
+            printf("after %llu us: %lu ticks, %llu pulses\n", (unsigned long long)elapsed,
+                   (unsigned long)player.getPositionTicks(), (unsigned long long)player.getClockPulsesSent());
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testAcrossTimerWrap() {
+    // micros() wraps 2^32us after boot; the song clock must not notice
+    FatFile file;
+    hostClockMicros = WRAP_MICROS - 10000000;
+    uint64_t songStart = startSong(file);
+    hostClockMicros = songStart;
+    CHECK(runTo(songStart, WRAP_MICROS + 10000000, 997));
+    CHECK_EQ(player.getState(), STATE_PLAYING);
+    player.unloadFile();
+}
+
+static void testMultiDaySpan() {
+    // Four days of once-a-second updates, then a whole day in one update
+    FatFile file;
+    hostClockMicros = 3 * DAY_MICROS + 12345;
+    uint64_t songStart = startSong(file);
+    hostClockMicros = songStart;
+    CHECK(runTo(songStart, songStart + 4 * DAY_MICROS, 1000007));
+    CHECK(runTo(songStart, songStart + 5 * DAY_MICROS, DAY_MICROS));
+    CHECK_EQ(player.getState(), STATE_PLAYING);
+
+    // Cleanup, Start, the note, the first controller (2.9 days in) and every pulse
+    uint64_t elapsed = hostClockMicros - songStart;
+    CHECK_EQ(sink.noteOns, 1);
+    CHECK_EQ(sink.messages, MIDI_OUT_PORT_COUNT * 16 + 1 + 2 + expectedPulses(elapsed));
+    player.unloadFile();
+}
+
+int main() {
+    if (!writeSong()) {
+        printf("test_player_clock: can't write %s\n", songPath);
+        return 1;
+    }
+
+    testAcrossTimerWrap();
+    testMultiDaySpan();
+
+    unlink(songPath);
+    return finishTests("test_player_clock");
+}
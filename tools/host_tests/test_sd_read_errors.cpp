@@ -0,0 +1,270 @@
+// ============================================================================
+// SD read errors on the host
+//
+// Plays a two-track song through the firmware's MidiFileParser while the
+// FatFile shim fails chosen reads, and checks the recovery the player relies
+// on: retries with doubling backoff, a stalled track deferred while the other
+// plays on, its events delivered unchanged once the card answers, and a track
+// that never comes back ended after SD_READ_GIVE_UP_MS.
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "MidiFileParser.h"
+#include "SdHealth.h"
+#include "host_test.h"
+
+#include <stdio.h>
+
+struct PlayedEvent {
+    uint32_t time;
+    uint8_t track;
+    uint8_t type;
+    uint8_t channel;
+    uint8_t data1;
+    uint8_t data2;
+
+    bool operator==(const PlayedEvent& other) const {
+        return time == other.time && track == other.track && type == other.type &&
+               channel == other.channel && data1 == other.data1 && data2 == other.data2;
+    }
+};
+
+static const uint16_t SONG_STEPS = 400;
+static char songPath[] = "/tmp/midi_pi_sd_errorsXXXXXX";
+static uint32_t track2DataStart;
+static MidiFileParser parser;  // Large - kept off the stack
+
+static void putVarLen(std::vector<uint8_t>& out, uint32_t value) {
+    uint8_t bytes[4];
+    int count = 0;
+    do {
+        bytes[count++] = value & 0x7F;
+        value >>= 7;
+    } while (value);
+    while (count > 1) out.push_back(bytes[--count] | 0x80);
+    out.push_back(bytes[0]);
+}
+
+static void putTrack(std::vector<uint8_t>& file, const std::vector<uint8_t>& data) {
+    const uint8_t header[] = { 'M', 'T', 'r', 'k' };
+    file.insert(file.end(), header, header + 4);
+    uint32_t length = data.size();
+    for (int shift = 24; shift >= 0; shift -= 8) file.push_back((length >> shift) & 0xFF);
+    file.insert(file.end(), data.begin(), data.end());
+}
+
+// Format 1, two tracks of several buffers each: notes on channel 1 (running
+// status), and a controller and note on channel 2 between them
+static bool writeSong() {
+    std::vector<uint8_t> first, second;
+    const uint8_t tempo[] = { 0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20 };
+    first.insert(first.end(), tempo, tempo + sizeof(tempo));
+    first.push_back(0x00);
+    first.push_back(0x90);
+    for (uint16_t i = 0; i < SONG_STEPS; i++) {
+        if (i > 0) putVarLen(first, 60);
+        first.push_back(60 + i % 12);
+        first.push_back(100);
+        putVarLen(first, 60);
+        first.push_back(60 + i % 12);
+        first.push_back(0);
+    }
+    second.push_back(0x1E);
+    for (uint16_t i = 0; i < SONG_STEPS; i++) {
+        if (i > 0) putVarLen(second, 60);
+        second.push_back(0xB1);
+        second.push_back(1);
+        second.push_back(i & 0x7F);
+        putVarLen(second, 60);
+        second.push_back(0x91);
+        second.push_back(40 + i % 8);
+        second.push_back(i % 4 ? 90 : 0);
+    }
+    const uint8_t endOfTrack[] = { 0x00, 0xFF, 0x2F, 0x00 };
+    first.insert(first.end(), endOfTrack, endOfTrack + 4);
+    second.insert(second.end(), endOfTrack, endOfTrack + 4);
+
+    std::vector<uint8_t> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 2, 0x01, 0xE0 };
+    putTrack(file, first);
+    track2DataStart = file.size() + 8;
+    putTrack(file, second);
+
+    int fd = mkstemp(songPath);
+    if (fd < 0) return false;
+    bool ok = write(fd, file.data(), file.size()) == (ssize_t)file.size();
+    ::close(fd);
+    return ok;
+}
+
+static PlayedEvent played(const MidiEvent& event) {
+    PlayedEvent result = { event.absoluteTime, event.trackNumber, event.type, event.channel, event.data1, event.data2 };
+    return result;
+}
+
+static std::vector<PlayedEvent> ofTrack(const std::vector<PlayedEvent>& events, uint8_t track) {
+    std::vector<PlayedEvent> result;
+    for (const PlayedEvent& event : events) {
+        if (event.track == track) result.push_back(event);
+    }
+    return result;
+}
+
+// Plays the whole song, moving the clock as the player would between events;
+// onRead is told how far the clock moved inside each readNextEvent()
+static std::vector<PlayedEvent> playSong(FatFile& file, SdHealth& health,
+                                         void (*onRead)(uint64_t callMicros, bool gotEvent) = nullptr) {
+    std::vector<PlayedEvent> events;
+    if (!file.open(songPath)) return events;
+    parser.setHealthMonitor(&health);
+    if (!parser.open(songPath, &file)) return events;
+
+    MidiEvent event;
+    for (uint32_t calls = 0; calls < 100000; calls++) {
+        uint64_t before = hostClockMicros;
+        bool got = parser.readNextEvent(event);
+        if (onRead) onRead(hostClockMicros - before, got);
+        if (got) {
+            if (!event.isMetaEvent) events.push_back(played(event));
+            hostClockMicros += 100;
+        } else if (parser.isWaitingForCard()) {
+            hostClockMicros += 500;
+        } else {
+            break;
+        }
+    }
+    parser.close();
+    file.close();
+    return events;
+}
+
+static std::vector<PlayedEvent> reference;
+
+static int failuresLeft;
+static bool failNextReads(uint32_t, size_t) {
+    if (failuresLeft == 0) return false;
+    failuresLeft--;
+    return true;
+}
+
+static uint64_t failingCallMicros;
+static void recordFailingCall(uint64_t callMicros, bool) {
+    if (callMicros > failingCallMicros) failingCallMicros = callMicros;
+}
+
+static void testRetryRecovers() {
+    // Fewer failures than SD_READ_RETRIES: the refill waits 250 + 500us and succeeds
+    FatFile file;
+    SdHealth health;
+    failuresLeft = 0;
+    FatFile::failRead = failNextReads;
+    failingCallMicros = 0;
+
+    if (!file.open(songPath) || !parser.open(songPath, &file)) {
+        CHECK(!"song opens");
+        return;
+    }
+    parser.setHealthMonitor(&health);
+    std::vector<PlayedEvent> events;
+    MidiEvent event;
+    while (events.size() < 100 && parser.readNextEvent(event)) {
+        if (!event.isMetaEvent) events.push_back(played(event));
+    }
+    failuresLeft = SD_READ_RETRIES - 2;
+    for (;;) {
+        uint64_t before = hostClockMicros;
+        bool got = parser.readNextEvent(event);
+        recordFailingCall(hostClockMicros - before, got);
+        if (!got) break;
+        if (!event.isMetaEvent) events.push_back(played(event));
+    }
+    parser.close();
+    file.close();
+    FatFile::failRead = nullptr;
+
+    CHECK(events == reference);
+    CHECK_EQ(health.getReadErrors(), SD_READ_RETRIES - 2);
+    CHECK_EQ(health.getRecoveredReads(), 1);
+    CHECK_EQ(health.getDeferredEvents(), 0);
+    CHECK(!health.takeReinitRequest());
+    CHECK_EQ(failingCallMicros, SD_RETRY_BACKOFF_MICROS * 3);
+}
+
+// Fails the first failuresLeft reads of track 1's second buffer
+static const uint32_t TRACK1_REFILL = 14 + 8 + TRACK_BUFFER_SIZE;
+static bool failTrack1Refill(uint32_t position, size_t count) {
+    return position == TRACK1_REFILL && failNextReads(position, count);
+}
+
+static void testDeferredTrackCatchesUp() {
+    // Every retry of one refill fails: that track waits while the other plays
+    // on, then delivers its events unchanged
+    FatFile file;
+    SdHealth health;
+    failingCallMicros = 0;
+    failuresLeft = SD_READ_RETRIES;
+    FatFile::failRead = failTrack1Refill;
+    std::vector<PlayedEvent> events = playSong(file, health, recordFailingCall);
+    FatFile::failRead = nullptr;
+
+    CHECK_EQ(events.size(), reference.size());
+    CHECK(ofTrack(events, 0) == ofTrack(reference, 0));
+    CHECK(ofTrack(events, 1) == ofTrack(reference, 1));
+    CHECK(events != reference);  // The stalled track's events came late
+    CHECK_EQ(health.getReadErrors(), SD_READ_RETRIES);
+    CHECK_EQ(health.getDeferredEvents(), 1);
+    CHECK_EQ(health.getLostTracks(), 0);
+    CHECK(health.takeReinitRequest());
+    CHECK_EQ(failingCallMicros, SD_RETRY_BACKOFF_MICROS * 7);  // 250 + 500 + 1000
+
+    // Track 2 moved ahead in song time while track 1 waited
+    size_t late = 0;
+    for (size_t i = 1; i < events.size(); i++) {
+        if (events[i].time < events[i - 1].time) late++;
+    }
+    CHECK(late > 0);
+}
+
+static bool failTrack2Refills(uint32_t position, size_t) {
+    return position > track2DataStart;
+}
+
+static void testLostTrackIsEnded() {
+    // Track 2 never reads again after its first buffer: it is ended after
+    // SD_READ_GIVE_UP_MS and track 1 plays to the end
+    FatFile file;
+    SdHealth health;
+    FatFile::failRead = failTrack2Refills;
+    uint64_t start = hostClockMicros;
+    std::vector<PlayedEvent> events = playSong(file, health);
+    FatFile::failRead = nullptr;
+
+    CHECK(ofTrack(events, 0) == ofTrack(reference, 0));
+    std::vector<PlayedEvent> second = ofTrack(events, 1);
+    std::vector<PlayedEvent> expected = ofTrack(reference, 1);
+    CHECK(!second.empty() && second.size() < expected.size());
+    CHECK(std::equal(second.begin(), second.end(), expected.begin()));
+    CHECK_EQ(health.getLostTracks(), 1);
+    CHECK(health.getDeferredEvents() >= 1);
+    CHECK(hostClockMicros - start >= (uint64_t)SD_READ_GIVE_UP_MS * 1000);
+}
+
+int main() {
+    if (!writeSong()) {
+        printf("test_sd_read_errors: can't write %s\n", songPath);
+        return 1;
+    }
+
+    FatFile file;
+    SdHealth health;
+    reference = playSong(file, health);
+    CHECK_EQ(reference.size(), SONG_STEPS * 4);
+    CHECK_EQ(health.getReadErrors(), 0);
+
+    testRetryRecovers();
+    testDeferredTrackCatchesUp();
+    testLostTrackIsEnded();
+
+    unlink(songPath);
+    return finishTests("test_sd_read_errors");
+}
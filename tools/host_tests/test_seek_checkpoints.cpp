@@ -0,0 +1,234 @@
+// ============================================================================
+// Checkpoint seeks on the host
+//
+// Reads a two-track song through the firmware's MidiFileParser once from the
+// start, then seeks to ticks all over it the way the player does (restore the
+// nearest checkpoint, read on silently to the target) and checks that every
+// seek stands where the linear read stood: the same next event and everything
+// after it, the same tempo, and the same chased programs, controllers and bend.
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "MidiFileParser.h"
+#include "host_test.h"
+
+#include <stdio.h>
+
+struct ReadEvent {
+    uint32_t time;
+    uint8_t track;
+    uint8_t type;
+    uint8_t channel;
+    uint8_t data1;
+    uint8_t data2;
+    bool meta;
+
+    bool operator==(const ReadEvent& other) const {
+        return time == other.time && track == other.track && type == other.type &&
+               channel == other.channel && data1 == other.data1 && data2 == other.data2 &&
+               meta == other.meta;
+    }
+};
+
+// What the linear read saw when each event came out
+struct LinearStep {
+    ReadEvent event;
+    uint32_t tempo;
+    ChaseState chase;
+};
+
+static const uint16_t TICKS_PER_QUARTER = 96;
+static const uint16_t SONG_QUARTERS = 300;  // Enough checkpoints to fill the table and thin it out
+static char songPath[] = "/tmp/midi_pi_seekXXXXXX";
+static MidiFileParser parser;  // Large - kept off the stack
+static std::vector<LinearStep> linear;
+
+static void putVarLen(std::vector<uint8_t>& out, uint32_t value) {
+    uint8_t bytes[4];
+    int count = 0;
+    do {
+        bytes[count++] = value & 0x7F;
+        value >>= 7;
+    } while (value);
+    while (count > 1) out.push_back(bytes[--count] | 0x80);
+    out.push_back(bytes[0]);
+}
+
+static void putTrack(std::vector<uint8_t>& file, const std::vector<uint8_t>& data) {
+    const uint8_t header[] = { 'M', 'T', 'r', 'k' };
+    file.insert(file.end(), header, header + 4);
+    uint32_t length = data.size();
+    for (int shift = 24; shift >= 0; shift -= 8) file.push_back((length >> shift) & 0xFF);
+    file.insert(file.end(), data.begin(), data.end());
+}
+
+// Format 1. Track 0: a note every quarter on channel 1 (running status), a
+// tempo change every 16 quarters and a program change every 10. Track 1:
+// volume, pan, sustain, bank select and bend on channel 2, offset by an eighth,
+// with a Reset All Controllers every 50 quarters.
+static bool writeSong() {
+    std::vector<uint8_t> first, second;
+    uint8_t lastStatus = 0;
+    for (uint16_t q = 0; q < SONG_QUARTERS; q++) {
+        uint32_t delta = q ? TICKS_PER_QUARTER / 2 : 0;
+        if (q % 16 == 0) {
+            uint32_t tempo = 400000 + q * 1000;
+            const uint8_t meta[] = { 0xFF, 0x51, 0x03, (uint8_t)(tempo >> 16), (uint8_t)(tempo >> 8), (uint8_t)tempo };
+            putVarLen(first, delta);
+            first.insert(first.end(), meta, meta + sizeof(meta));
+            delta = 0;
+            lastStatus = 0;  // Meta events cancel running status
+        }
+        if (q % 10 == 0) {
+            putVarLen(first, delta);
+            first.push_back(0xC0);
+            first.push_back(q / 10 % 128);
+            delta = 0;
+            lastStatus = 0xC0;
+        }
+        putVarLen(first, delta);
+        if (lastStatus != 0x90) first.push_back(0x90);
+        first.push_back(48 + q % 24);
+        first.push_back(100);
+        putVarLen(first, TICKS_PER_QUARTER / 2);
+        first.push_back(48 + q % 24);
+        first.push_back(0);
+        lastStatus = 0x90;
+    }
+    const uint8_t endOfTrack[] = { 0x00, 0xFF, 0x2F, 0x00 };
+    first.insert(first.end(), endOfTrack, endOfTrack + 4);
+
+    for (uint16_t q = 0; q < SONG_QUARTERS; q++) {
+        putVarLen(second, q ? TICKS_PER_QUARTER - 1 : TICKS_PER_QUARTER / 2);
+        const uint8_t volume[] = { 0xB1, 7, (uint8_t)(q % 128) };
+        second.insert(second.end(), volume, volume + 3);
+        second.push_back(0x00);
+        second.push_back(10);                      // Pan, running status
+        second.push_back((q * 3) % 128);
+        if (q % 7 == 0) {
+            second.push_back(0x00);
+            second.push_back(64);                  // Sustain
+            second.push_back((q / 7) % 2 ? 0 : 127);
+            second.push_back(0x00);
+            second.push_back(0);                   // Bank select
+            second.push_back(q / 7 % 128);
+        }
+        if (q % 50 == 49) {
+            second.push_back(0x00);
+            second.push_back(121);                 // Reset All Controllers
+            second.push_back(0);
+        }
+        const uint8_t bend[] = { 0x01, 0xE1, (uint8_t)(q % 128), (uint8_t)(64 + q % 32) };
+        second.insert(second.end(), bend, bend + sizeof(bend));
+    }
+    second.insert(second.end(), endOfTrack, endOfTrack + 4);
+
+    std::vector<uint8_t> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 2,
+                                  TICKS_PER_QUARTER >> 8, TICKS_PER_QUARTER & 0xFF };
+    putTrack(file, first);
+    putTrack(file, second);
+
+    int fd = mkstemp(songPath);
+    if (fd < 0) return false;
+    bool ok = write(fd, file.data(), file.size()) == (ssize_t)file.size();
+    ::close(fd);
+    return ok;
+}
+
+static ReadEvent describe(const MidiEvent& event) {
+    ReadEvent read = { event.absoluteTime, event.trackNumber, event.type, event.channel,
+                       event.data1, event.data2, event.isMetaEvent };
+    return read;
+}
+
+static bool sameChase(const ChaseState& a, const ChaseState& b) {
+    return memcmp(a.program, b.program, sizeof(a.program)) == 0 &&
+           memcmp(a.controller, b.controller, sizeof(a.controller)) == 0 &&
+           memcmp(a.pitchBend, b.pitchBend, sizeof(a.pitchBend)) == 0;
+}
+
+static void readLinear() {
+    MidiEvent event;
+    while (parser.readNextEvent(event)) {
+        LinearStep step = { describe(event), parser.getFileInfo().tempo, parser.getChaseState() };
+        linear.push_back(step);
+    }
+    CHECK(parser.isEndOfFile());
+}
+
+// Seek like MidiPlayer::seekToTicks, then read the rest of the song; false
+// (and a report) where it stops matching the linear read
+static bool seekMatchesLinear(uint32_t target) {
+    int32_t from = parser.seekToCheckpoint(target);
+    if (from < 0 || (uint32_t)from > target || from != parser.getCheckpointTick(target)) {
+        printf("seek to %lu: restarted from %ld\n", (unsigned long)target, (long)from);
+        return false;
+    }
+
+    MidiEvent event;
+    bool ready = parser.readNextEvent(event);
+    while (ready && event.absoluteTime <= target) {
+        ready = parser.readNextEvent(event);
+    }
+
+    size_t index = 0;
+    while (index < linear.size() && linear[index].event.time <= target) index++;
+    if (index == linear.size()) return !ready;
+
+    // Chase describes everything before the pending event, as in the linear read
+    if (!ready || !(describe(event) == linear[index].event) ||
+        parser.getFileInfo().tempo != linear[index].tempo || !sameChase(parser.getChaseState(), linear[index].chase)) {
+        printf("seek to %lu (from %ld): differs at event %zu\n", (unsigned long)target, (long)from, index);
+        return false;
+    }
+    while (++index < linear.size()) {
+        if (!parser.readNextEvent(event) || !(describe(event) == linear[index].event) ||
+            !sameChase(parser.getChaseState(), linear[index].chase)) {
+            printf("seek to %lu: read on differs at event %zu\n", (unsigned long)target, index);
+            return false;
+        }
+    }
+    return !parser.readNextEvent(event);
+}
+
+static void testSeeksMatchLinearRead() {
+    // Targets forward and back, on event times, between them and past the end
+    const uint32_t quarter = TICKS_PER_QUARTER;
+    const uint32_t targets[] = { 250 * quarter + 17, 3 * quarter, 0, 8 * quarter, 8 * quarter - 1,
+                                 49 * quarter + quarter / 2, 120 * quarter, 64 * quarter + 1,
+                                 199 * quarter + quarter - 1, 299 * quarter, 1000 * quarter };
+    for (uint32_t target : targets) {
+        CHECK(seekMatchesLinear(target));
+    }
+}
+
+static void testCheckpointsCoverTheSong() {
+    // The table filled and was thinned out, so the spacing doubled at least once
+    CHECK(parser.getCheckpointCount() > 1);
+    CHECK(parser.getCheckpointCount() <= MAX_CHECKPOINTS);
+    CHECK_EQ(parser.getCheckpointTick(0), 0);
+    int32_t last = parser.getCheckpointTick(SONG_QUARTERS * TICKS_PER_QUARTER);
+    CHECK(last > (int32_t)(SONG_QUARTERS * TICKS_PER_QUARTER / 2));
+    CHECK(last - parser.getCheckpointTick(last - 1) > (int32_t)(CHECKPOINT_SPACING_QUARTERS * TICKS_PER_QUARTER));
+}
+
+int main() {
+    if (!writeSong()) {
+        printf("test_seek_checkpoints: can't write %s\n", songPath);
+        return 1;
+    }
+
+    FatFile file;
+    CHECK(file.open(songPath));
+    CHECK(parser.open(songPath, &file));
+    readLinear();
+    CHECK(linear.size() > 4 * SONG_QUARTERS);
+
+    testCheckpointsCoverTheSong();
+    testSeeksMatchLinearRead();
+
+    parser.close();
+    unlink(songPath);
+    return finishTests("test_seek_checkpoints");
+}
@@ -0,0 +1,208 @@
+// ============================================================================
+// Offline render on the host
+//
+// Renders a small song through MidiPlayer on an SmfWriter sink, the way the
+// EXP render in main.cpp does, with a channel muted, a transpose and velocity
+// scales set and the tempo at 200%. Then checks the file byte for byte
+// (delta times, running status, the tempo map) and reads it back with
+// MidiFileParser to check every event's time and values.
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "MidiPlayer.h"
+#include "SmfWriter.h"
+#include "host_test.h"
+
+#include <stdio.h>
+
+static const uint16_t TICKS_PER_QUARTER = 96;
+static const uint16_t RENDER_PERCENT = 2000;  // Tenths of a percent - the song at double speed
+static char songPath[] = "/tmp/midi_pi_render_inXXXXXX";
+static char renderPath[] = "/tmp/midi_pi_render_outXXXXXX";
+static SmfWriter writer;
+static MidiPlayerT<SmfWriter> renderer(&writer);  // Large - kept off the stack
+
+static void putTrack(std::vector<uint8_t>& file, const std::vector<uint8_t>& data) {
+    const uint8_t header[] = { 'M', 'T', 'r', 'k' };
+    file.insert(file.end(), header, header + 4);
+    uint32_t length = data.size();
+    for (int shift = 24; shift >= 0; shift -= 8) file.push_back((length >> shift) & 0xFF);
+    file.insert(file.end(), data.begin(), data.end());
+}
+
+// Format 1. Track 0: 120 BPM and 3/4 at 0, 150 BPM at 192. Track 1 (channel 1):
+// a program change, a two-note chord (running status) released at 96 by a
+// zero-velocity Note On and a Note Off, volume at 48, and a note at 192 the
+// song never ends. Track 2 (channel 2): a note from 24 to 120.
+static bool writeSong() {
+    std::vector<uint8_t> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 3,
+                                  TICKS_PER_QUARTER >> 8, TICKS_PER_QUARTER & 0xFF };
+    putTrack(file, { 0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+                     0x00, 0xFF, 0x58, 0x04, 0x03, 0x02, 0x18, 0x08,
+                     0x81, 0x40, 0xFF, 0x51, 0x03, 0x06, 0x1A, 0x80,
+                     0x00, 0xFF, 0x2F, 0x00 });
+    putTrack(file, { 0x00, 0xC0, 5,
+                     0x00, 0x90, 60, 100, 0x00, 64, 60,
+                     0x30, 0xB0, 7, 100,
+                     0x30, 0x90, 60, 0, 0x00, 0x80, 64, 64,
+                     0x60, 0x90, 67, 127,
+                     0x60, 0xFF, 0x2F, 0x00 });
+    putTrack(file, { 0x18, 0x91, 50, 80, 0x60, 50, 0, 0x00, 0xFF, 0x2F, 0x00 });
+
+    int fd = mkstemp(songPath);
+    if (fd < 0) return false;
+    bool ok = write(fd, file.data(), file.size()) == (ssize_t)file.size();
+    ::close(fd);
+    fd = mkstemp(renderPath);
+    if (fd < 0) return false;
+    ::close(fd);
+    return ok;
+}
+
+static uint32_t renderTempo(uint32_t microsPerQuarter) {
+    return (uint32_t)(((uint64_t)microsPerQuarter * 1000) / RENDER_PERCENT);
+}
+
+// The port 0 pass of renderSong(): tempo map on the first track, every event
+// from the first one through dispatch(), notes left sounding released at the end
+static bool render() {
+    FatFile in, out;
+    if (!in.open(songPath) || !out.open(renderPath, O_WRONLY | O_TRUNC)) return false;
+
+    const int8_t transpose[16] = { 2 };
+    uint8_t velocities[16];
+    memset(velocities, 0, sizeof(velocities));
+    velocities[0] = 50;
+    renderer.setChannelTranspose(transpose);
+    renderer.setChannelVelocityScales(velocities);
+    renderer.muteChannel(1);
+    if (!renderer.loadFile(&in)) return false;
+
+    // The player read the first event ahead - the render starts before it
+    MidiFileParser& parser = renderer.getParser();
+    if (!parser.reset()) return false;
+    writer.begin(&out, parser.getFileInfo().ticksPerQuarter);
+    writer.beginTrack(0);
+    writer.writeTempo(renderTempo(500000));
+    renderer.sendOverrideSetup();
+
+    MidiEvent event;
+    while (parser.readNextEvent(event)) {
+        writer.setTick(event.absoluteTime);
+        if (event.isMetaEvent && event.data1 == META_TEMPO) {
+            writer.writeTempo(renderTempo(parser.getFileInfo().tempo));
+        } else if (event.isMetaEvent && event.data1 == META_TIME_SIGNATURE) {
+            MidiFileInfo info = parser.getFileInfo();
+            writer.writeTimeSignature(info.numerator, info.denominator);
+        }
+        renderer.dispatch(event);
+    }
+    renderer.releaseHeldNotes();
+    bool ok = writer.endTrack();
+    renderer.unloadFile();
+    return ok && writer.finish() && writer.getPortsUsed() == 1;
+}
+
+static std::vector<uint8_t> readRender() {
+    std::vector<uint8_t> bytes;
+    FatFile file;
+    if (!file.open(renderPath)) return bytes;
+    bytes.resize(file.fileSize());
+    if (file.read(bytes.data(), bytes.size()) != (int)bytes.size()) bytes.clear();
+    return bytes;
+}
+
+static void testRenderedBytes() {
+    // Format 0, one track. Channel 1 is transposed up 2 with velocities halved,
+    // channel 2 is muted, tempos are halved (200%), and the status byte is
+    // written only when it changes
+    std::vector<uint8_t> rendered = readRender();
+    CHECK_BYTES(rendered,
+        'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, TICKS_PER_QUARTER,
+        'M', 'T', 'r', 'k', 0, 0, 0, 62,
+        0x00, 0xFF, 0x51, 0x03, 0x03, 0xD0, 0x90,        // Conductor start: 250000
+        0x00, 0xFF, 0x51, 0x03, 0x03, 0xD0, 0x90,        // The song's own 120 BPM
+        0x00, 0xFF, 0x58, 0x04, 0x03, 0x02, 0x18, 0x08,
+        0x00, 0xC0, 5,
+        0x00, 0x90, 62, 50, 0x00, 66, 30,
+        0x30, 0xB0, 7, 100,
+        0x30, 0x80, 62, 0, 0x00, 66, 64,
+        0x60, 0xFF, 0x51, 0x03, 0x03, 0x0D, 0x40,        // 150 BPM at 200%: 200000
+        0x00, 0x90, 69, 63,
+        0x00, 0x80, 69, 0,                               // Released at the song's end
+        0x00, 0xFF, 0x2F, 0x00);
+}
+
+struct ParsedEvent {
+    uint32_t delta;
+    uint32_t time;
+    uint8_t type;
+    uint8_t channel;
+    uint8_t data1;
+    uint8_t data2;
+};
+
+static void testRenderParsesBack() {
+    static MidiFileParser parser;
+    FatFile file;
+    CHECK(file.open(renderPath));
+    CHECK(parser.open(renderPath, &file));
+    CHECK_EQ(parser.getFileInfo().format, 0);
+    CHECK_EQ(parser.getFileInfo().ticksPerQuarter, TICKS_PER_QUARTER);
+
+    // Metas as (type 0xFF, meta type); channel messages as read
+    const ParsedEvent expected[] = {
+        { 0, 0, 0xFF, 0, META_TEMPO, 0 },
+        { 0, 0, 0xFF, 0, META_TEMPO, 0 },
+        { 0, 0, 0xFF, 0, META_TIME_SIGNATURE, 0 },
+        { 0, 0, MIDI_PROGRAM_CHANGE, 0, 5, 0 },
+        { 0, 0, MIDI_NOTE_ON, 0, 62, 50 },
+        { 0, 0, MIDI_NOTE_ON, 0, 66, 30 },
+        { 48, 48, MIDI_CONTROL_CHANGE, 0, 7, 100 },
+        { 48, 96, MIDI_NOTE_OFF, 0, 62, 0 },
+        { 0, 96, MIDI_NOTE_OFF, 0, 66, 64 },
+        { 96, 192, 0xFF, 0, META_TEMPO, 0 },
+        { 0, 192, MIDI_NOTE_ON, 0, 69, 63 },
+        { 0, 192, MIDI_NOTE_OFF, 0, 69, 0 },
+    };
+    const size_t count = sizeof(expected) / sizeof(expected[0]);
+
+    MidiEvent event;
+    size_t read = 0;
+    bool same = true;
+    while (parser.readNextEvent(event)) {
+        if (read < count) {
+            const ParsedEvent& want = expected[read];
+            ParsedEvent got = { event.deltaTime, event.absoluteTime,
+                                event.isMetaEvent ? (uint8_t)0xFF : event.type,
+                                event.isMetaEvent ? (uint8_t)0 : event.channel, event.data1,
+                                event.isMetaEvent ? (uint8_t)0 : event.data2 };
+            if (memcmp(&got, &want, sizeof(got)) != 0) {
+                printf("event %zu: delta %lu at %lu, %02X ch %u %u %u\n", read, (unsigned long)got.delta,
+                       (unsigned long)got.time, got.type, got.channel, got.data1, got.data2);
+                same = false;
+            }
+        }
+        read++;
+    }
+    CHECK(same);
+    CHECK_EQ(read, count);
+    CHECK_EQ(parser.getFileInfo().tempo, 200000);
+    parser.close();
+}
+
+int main() {
+    if (!writeSong()) {
+        printf("test_smf_render: can't write %s\n", songPath);
+        return 1;
+    }
+
+    CHECK(render());
+    testRenderedBytes();
+    testRenderParsesBack();
+
+    unlink(songPath);
+    unlink(renderPath);
+    return finishTests("test_smf_render");
+}
@@ -0,0 +1,140 @@
+// ============================================================================
+// Track mute and solo on the host
+//
+// Plays a three-track song (two tracks share channel 1) through MidiPlayer on
+// a recording sink and changes the track masks while notes sound: a newly
+// silenced track gets a Note Off for each note it left sounding and nothing
+// for the rest of its notes, the other tracks on its channel play on, and a
+// solo silences every track that isn't soloed, whatever the mutes say.
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "MidiPlayer.h"
+#include "MidiSinks.h"
+#include "host_test.h"
+
+#include <stdio.h>
+
+static const uint16_t TICKS_PER_QUARTER = 96;
+static char songPath[] = "/tmp/midi_pi_mutesXXXXXX";
+static RecordingMidiSink sink;
+static MidiPlayerT<RecordingMidiSink> player(&sink);  // Large - kept off the stack
+
+static void putTrack(std::vector<uint8_t>& file, const std::vector<uint8_t>& data) {
+    const uint8_t header[] = { 'M', 'T', 'r', 'k' };
+    file.insert(file.end(), header, header + 4);
+    uint32_t length = data.size();
+    for (int shift = 24; shift >= 0; shift -= 8) file.push_back((length >> shift) & 0xFF);
+    file.insert(file.end(), data.begin(), data.end());
+}
+
+// Two notes a half note each: the first at tick 0, the second at 192 (delta
+// 192 = 0x81 0x40), running status throughout; a volume change at 480 keeps
+// the song going after the last Note Off
+static std::vector<uint8_t> twoNotes(uint8_t status, uint8_t first, uint8_t second) {
+    return { 0x00, status, first, 100,
+             0x81, 0x40, first, 0, 0x00, second, 100,
+             0x81, 0x40, second, 0,
+             0x60, (uint8_t)(0xB0 | (status & 0x0F)), 7, 100,
+             0x00, 0xFF, 0x2F, 0x00 };
+}
+
+// Format 1: tracks 0 and 1 are two parts on channel 1, track 2 is on channel 2
+static bool writeSong() {
+    std::vector<uint8_t> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 3,
+                                  TICKS_PER_QUARTER >> 8, TICKS_PER_QUARTER & 0xFF };
+    putTrack(file, twoNotes(0x90, 60, 62));
+    putTrack(file, twoNotes(0x90, 64, 65));
+    putTrack(file, twoNotes(0x91, 67, 69));
+
+    int fd = mkstemp(songPath);
+    if (fd < 0) return false;
+    bool ok = write(fd, file.data(), file.size()) == (ssize_t)file.size();
+    ::close(fd);
+    return ok;
+}
+
+// Updates a millisecond at a time until the song reaches tick
+static void playTo(uint32_t tick) {
+    for (int i = 0; i < 10000 && player.getPositionTicks() < tick && player.getState() == STATE_PLAYING; i++) {
+        hostClockMicros += 1000;
+        player.update();
+    }
+}
+
+// The messages recorded since the last clear(), in order, are exactly these
+// (status, data1, data2) triples
+static bool recorded(std::initializer_list<uint8_t> expected) {
+    bool same = sink.getTotal() * 3 == expected.size();
+    const uint8_t* want = expected.begin();
+    for (uint8_t i = 0; same && i < sink.getCount(); i++) {
+        const RecordedMidiMessage& m = sink.get(i);
+        same = m.port == 0 && m.status == want[i * 3] && m.data1 == want[i * 3 + 1] && m.data2 == want[i * 3 + 2];
+    }
+    if (!same) {
+        printf("recorded:");
+        for (uint8_t i = 0; i < sink.getCount(); i++) {
+            const RecordedMidiMessage& m = sink.get(i);
+            printf(" %u:%02X %u %u", m.port, m.status, m.data1, m.data2);
+        }
+        printf("\n");
+    }
+    sink.clear();
+    return same;
+}
+
+static void testMuteAndSolo() {
+    FatFile file;
+    if (!file.open(songPath) || !player.loadFile(&file)) {
+        CHECK(!"song loads");
+        return;
+    }
+    player.setTempoPercent(1000);
+    player.play();
+    sink.clear();  // The All Notes Off cleanup
+
+    playTo(10);
+    CHECK(recorded({ 0x90, 60, 100, 0x90, 64, 100, 0x91, 67, 100 }));
+
+    // Muting track 1 releases its note at once; track 0 shares the channel and keeps sounding
+    player.setTrackMutes(1 << 1);
+    CHECK_EQ(player.getTrackMutes(), 1 << 1);
+    CHECK(recorded({ 0x80, 64, 0 }));
+
+    // Its Note Off and next note are skipped in the file; the other parts go on
+    playTo(200);
+    CHECK(recorded({ 0x80, 60, 0, 0x90, 62, 100, 0x81, 67, 0, 0x91, 69, 100 }));
+
+    // Soloing track 2 silences track 0 as well - only its sounding note is released
+    player.setTrackSolos(1 << 2);
+    CHECK_EQ(player.getTrackSolos(), 1 << 2);
+    CHECK(recorded({ 0x80, 62, 0 }));
+
+    // Mutes don't apply while anything is soloed, even to the soloed track
+    player.setTrackMutes((1 << 1) | (1 << 2));
+    CHECK(recorded({}));
+
+    // Only track 2's Note Off is heard. The parser stepped over track 1's last
+    // three notes; track 0's Note Off had already been read and is dropped too
+    playTo(390);
+    CHECK(recorded({ 0x81, 69, 0 }));
+    CHECK_EQ(player.getParser().getSkippedNoteCount(), 3);
+
+    // Without the solo the mutes apply again
+    player.setTrackSolos(0);
+    CHECK_EQ(player.getParser().getSilencedTracks(), (1 << 1) | (1 << 2));
+    player.unloadFile();
+}
+
+int main() {
+    if (!writeSong()) {
+        printf("test_track_mutes: can't write %s\n", songPath);
+        return 1;
+    }
+
+    testMuteAndSolo();
+
+    unlink(songPath);
+    return finishTests("test_track_mutes");
+}
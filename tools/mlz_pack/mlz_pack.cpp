@@ -0,0 +1,315 @@
+// ============================================================================
+// MIDI-PI song packer
+//
+// Host-side tool that compresses songs into the .mlz container the firmware
+// plays directly from the card (see include/MidiContainer.h): a standard LZ4
+// frame with independent 512-byte blocks, plus a skippable frame at the end
+// that indexes the blocks so the player can seek without decoding from the
+// start. `lz4 -d` still unpacks the files on a PC.
+//
+// Inputs are read through the firmware's own MidiContainer, so .rmi files are
+// unwrapped on the way. Every packed file is read back with the firmware
+// decoder and compared with the original, then both are parsed with
+// MidiFileParser to report card bytes per play and parse throughput.
+//
+// Usage: mlz_pack [-n] [-r passes] <song.mid|song.rmi>...
+// ============================================================================
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MidiContainer.h"
+#include "MidiFileParser.h"
+
+// LZ4 block format limits: the last 5 bytes are literals and the last match
+// starts at least 12 bytes before the end of the block
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_FIND_LIMIT 12
+#define LZ4_HASH_BITS 12
+
+static uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void putLE32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+static void putLength(std::vector<uint8_t>& out, uint32_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back((uint8_t)length);
+}
+
+static void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, uint32_t literalLength,
+                        uint16_t offset, uint32_t matchLength) {
+    uint8_t token = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+    if (matchLength) {
+        uint32_t code = matchLength - LZ4_MIN_MATCH;
+        token |= (uint8_t)(code < 15 ? code : 15);
+    }
+    out.push_back(token);
+    if (literalLength >= 15) putLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+
+    if (matchLength) {
+        out.push_back((uint8_t)offset);
+        out.push_back((uint8_t)(offset >> 8));
+        if (matchLength - LZ4_MIN_MATCH >= 15) putLength(out, matchLength - LZ4_MIN_MATCH - 15);
+    }
+}
+
+// Greedy single-probe LZ4 block compressor - blocks are small and packing is
+// done once on a PC, so ratio matters more than speed, but the decoder on the
+// device is what has to be cheap
+static std::vector<uint8_t> compressBlock(const uint8_t* src, uint32_t size) {
+    std::vector<uint8_t> out;
+    int32_t table[1 << LZ4_HASH_BITS];
+    for (int32_t& entry : table) entry = -1;
+
+    uint32_t ip = 0;
+    uint32_t anchor = 0;
+    if (size > LZ4_MATCH_FIND_LIMIT) {
+        uint32_t lastMatchStart = size - LZ4_MATCH_FIND_LIMIT;
+        uint32_t matchEnd = size - LZ4_LAST_LITERALS;
+
+        while (ip <= lastMatchStart) {
+            uint32_t sequence = readLE32(src + ip);
+            uint32_t hash = (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+            int32_t ref = table[hash];
+            table[hash] = (int32_t)ip;
+
+            if (ref < 0 || readLE32(src + ref) != sequence) {
+                ip++;
+                continue;
+            }
+
+            uint32_t length = LZ4_MIN_MATCH;
+            while (ip + length < matchEnd && src[ref + length] == src[ip + length]) length++;
+
+            putSequence(out, src + anchor, ip - anchor, (uint16_t)(ip - ref), length);
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    putSequence(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+static uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+// xxHash32 for inputs under 16 bytes - only the frame descriptor checksum needs it
+static uint32_t xxh32Short(const uint8_t* p, uint32_t length) {
+    const uint32_t P1 = 2654435761U, P2 = 2246822519U, P3 = 3266489917U, P4 = 668265263U, P5 = 374761393U;
+    uint32_t h = P5 + length;
+    const uint8_t* end = p + length;
+    while (p + 4 <= end) {
+        h += readLE32(p) * P3;
+        h = rotl32(h, 17) * P4;
+        p += 4;
+    }
+    while (p < end) {
+        h += (*p++) * P5;
+        h = rotl32(h, 11) * P1;
+    }
+    h ^= h >> 15;
+    h *= P2;
+    h ^= h >> 13;
+    h *= P3;
+    h ^= h >> 16;
+    return h;
+}
+
+static std::vector<uint8_t> packSmf(const std::vector<uint8_t>& smf) {
+    std::vector<uint8_t> out;
+
+    // Frame header: version 1, independent blocks, content size; 64 KB block maximum
+    putLE32(out, LZ4_FRAME_MAGIC);
+    size_t descriptor = out.size();
+    out.push_back(0x40 | 0x20 | 0x08);
+    out.push_back(0x40);
+    putLE32(out, (uint32_t)smf.size());
+    putLE32(out, 0);
+    out.push_back((uint8_t)(xxh32Short(&out[descriptor], (uint32_t)(out.size() - descriptor)) >> 8));
+
+    std::vector<uint32_t> index;
+    for (size_t start = 0; start < smf.size(); start += MLZ_BLOCK_SIZE) {
+        uint32_t size = (uint32_t)std::min<size_t>(MLZ_BLOCK_SIZE, smf.size() - start);
+        std::vector<uint8_t> block = compressBlock(&smf[start], size);
+
+        index.push_back((uint32_t)out.size());
+        if (block.size() < size) {
+            putLE32(out, (uint32_t)block.size());
+            out.insert(out.end(), block.begin(), block.end());
+        } else {
+            putLE32(out, size | LZ4_BLOCK_UNCOMPRESSED);
+            out.insert(out.end(), smf.begin() + start, smf.begin() + start + size);
+        }
+    }
+    putLE32(out, 0);  // EndMark
+
+    putLE32(out, MLZ_INDEX_MAGIC);
+    putLE32(out, (uint32_t)(index.size() * 4 + 4));
+    for (uint32_t offset : index) putLE32(out, offset);
+    putLE32(out, (uint32_t)index.size());
+    return out;
+}
+
+// The SMF bytes of any container the firmware can open
+static bool readSmf(const std::string& path, std::vector<uint8_t>& smf, MidiContainerType& type) {
+    FatFile file;
+    if (!file.open(path.c_str(), O_RDONLY)) return false;
+
+    MidiContainer container;
+    if (!container.open(&file)) return false;
+    type = container.getType();
+
+    smf.resize(container.fileSize());
+    if (smf.empty() || container.read(smf.data(), smf.size()) != (int)smf.size()) return false;
+    return memcmp(smf.data(), "MThd", 4) == 0;
+}
+
+struct ParseStats {
+    bool ok;
+    uint32_t cardBytes;   // Card bytes for one length scan plus one play
+    double seconds;       // Per pass
+};
+
+// Same work as loading and playing the song once: length scan, then every event
+static ParseStats parseSong(const std::string& path, MidiFileParser& parser, int passes) {
+    ParseStats stats = { false, 0, 0.0 };
+    FatFile file;
+    if (!file.open(path.c_str(), O_RDONLY)) return stats;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        if (!parser.open(path.c_str(), &file)) {
+            parser.close();
+            return stats;
+        }
+        parser.calculateFileLengthNow();
+        parser.reset();
+        MidiEvent event;
+        while (parser.readNextEvent(event)) {
+        }
+        if (pass == 0) stats.cardBytes = parser.getCardBytesRead();
+        parser.close();
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / passes;
+    stats.ok = true;
+    return stats;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [-n] [-r passes] <song.mid|song.rmi>...\n"
+            "  -n      dry run, report sizes without writing .mlz files\n"
+            "  -r N    parse passes per file for the throughput figures (default 20)\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    bool dryRun = false;
+    int passes = 20;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0) {
+            dryRun = true;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            passes = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (passes < 1) passes = 1;
+
+    std::unique_ptr<MidiFileParser> parser(new MidiFileParser());
+    uint64_t totalPlain = 0, totalPacked = 0, totalPlainCard = 0, totalPackedCard = 0;
+    double totalPlainSeconds = 0, totalPackedSeconds = 0;
+    int failed = 0;
+
+    for (const std::string& input : inputs) {
+        std::vector<uint8_t> smf;
+        MidiContainerType type;
+        if (!readSmf(input, smf, type)) {
+            fprintf(stderr, "warning: %s is not a MIDI file\n", input.c_str());
+            failed++;
+            continue;
+        }
+        if (type == CONTAINER_MLZ) {
+            fprintf(stderr, "warning: %s is already packed\n", input.c_str());
+            continue;
+        }
+
+        std::vector<uint8_t> packed = packSmf(smf);
+        std::string output = input.substr(0, input.rfind('.')) + ".mlz";
+        if (dryRun) {
+            printf("%s: %zu -> %zu bytes (%.1f%%)\n", input.c_str(), smf.size(), packed.size(),
+                   100.0 * packed.size() / smf.size());
+            continue;
+        }
+
+        FILE* out = fopen(output.c_str(), "wb");
+        if (!out || fwrite(packed.data(), 1, packed.size(), out) != packed.size() || fclose(out) != 0) {
+            fprintf(stderr, "error: cannot write %s\n", output.c_str());
+            return 1;
+        }
+
+        // Round trip through the firmware decoder
+        std::vector<uint8_t> check;
+        MidiContainerType checkType;
+        if (!readSmf(output, check, checkType) || checkType != CONTAINER_MLZ || check != smf) {
+            fprintf(stderr, "error: %s does not decode back to %s\n", output.c_str(), input.c_str());
+            return 1;
+        }
+
+        ParseStats plain = parseSong(input, *parser, passes);
+        ParseStats compressed = parseSong(output, *parser, passes);
+        if (!plain.ok || !compressed.ok) {
+            fprintf(stderr, "warning: parser rejected %s\n", input.c_str());
+            failed++;
+            continue;
+        }
+
+        printf("%s: %zu -> %zu bytes (%.1f%%), card %u -> %u bytes/play, parse %.2f -> %.2f ms\n",
+               output.c_str(), smf.size(), packed.size(), 100.0 * packed.size() / smf.size(),
+               plain.cardBytes, compressed.cardBytes, plain.seconds * 1000, compressed.seconds * 1000);
+
+        totalPlain += smf.size();
+        totalPacked += packed.size();
+        totalPlainCard += plain.cardBytes;
+        totalPackedCard += compressed.cardBytes;
+        totalPlainSeconds += plain.seconds;
+        totalPackedSeconds += compressed.seconds;
+    }
+
+    if (totalPlain > 0) {
+        printf("Total: %llu -> %llu bytes (%.1f%%), card reads %.1f%% of plain, "
+               "parse %.1f MB/s plain, %.1f MB/s packed (SMF bytes)\n",
+               (unsigned long long)totalPlain, (unsigned long long)totalPacked,
+               100.0 * totalPacked / totalPlain, 100.0 * totalPackedCard / totalPlainCard,
+               totalPlain / totalPlainSeconds / 1e6, totalPlain / totalPackedSeconds / 1e6);
+    }
+
+    return failed ? 1 : 0;
+}